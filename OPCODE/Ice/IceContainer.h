@@ -12,7 +12,8 @@
 #ifndef __ICECONTAINER_H__
 #define __ICECONTAINER_H__
 
-	#define CONTAINER_STATS
+	// Global container counters aren't thread-safe, leave them out now that queries can run concurrently
+//	#define CONTAINER_STATS
 
 	enum FindMode
 	{
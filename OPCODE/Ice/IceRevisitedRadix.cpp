@@ -12,9 +12,9 @@
  *	Revisited Radix Sort.
  *	This is my new radix routine:
  *  - it uses indices and doesn't recopy the values anymore, hence wasting less ram
- *  - it creates all the histograms in one run instead of four
+ *  - it creates all the histograms in one run instead of three
  *  - it sorts words faster than dwords and bytes faster than words
- *  - it correctly sorts negative floating-point values by patching the offsets
+ *  - it correctly sorts negative floating-point values by flipping their bits
  *  - it automatically takes advantage of temporal coherence
  *  - multiple keys support is a side effect of temporal coherence
  *  - it may be worth recoding in asm... (mainly to use FCOMI, FCMOV, etc) [it's probably memory-bound anyway]
@@ -30,10 +30,12 @@
  *				- ranks are not "reset" anymore, but implicit on first calls
  *	- 07.05.02:	- offsets rewritten with one less indirection.
  *	- 11.03.02:	- "bool" replaced with RadixHint enum
+ *	- 10.18.26:	- 11 bits trick & 3 passes, keys flipped to unsigned integers so that all types share a code path
+ *				- parallel passes on a TaskPool for big inputs
  *
  *	\class		RadixSort
  *	\author		Pierre Terdiman
- *	\version	1.4
+ *	\version	1.5
  *	\date		August, 15, 1998
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,7 +44,6 @@
 To do:
 	- add an offset parameter between two input values (avoid some data recopy sometimes)
 	- unroll ? asm ?
-	- 11 bits trick & 3 passes as Michael did
 	- prefetch stuff the day I have a P3
 	- make a version with 16-bits indices ?
 */
@@ -58,121 +59,163 @@ using namespace IceCore;
 #define CURRENT_SIZE		(mCurrentSize&0x7fffffff)
 #define INVALID_RANKS		(mCurrentSize&0x80000000)
 
-#define CHECK_RESIZE(n)																		\
-	if(n!=mPreviousSize)																	\
-	{																						\
-				if(n>mCurrentSize)	Resize(n);												\
-		else						ResetRanks();											\
-		mPreviousSize = n;																	\
-	}
+// Keys are flipped so that all inputs sort as unsigned integers:
+// - unsigned values are left as they are (both masks are 0)
+// - signed values get their sign bit flipped (sign mask is 0x80000000)
+// - positive floats get their sign bit flipped, negative floats get all their bits flipped, which reverses their order (flip mask is 0x7fffffff)
+#define RADIX_KEY(x)		((x) ^ ((udword(sdword(x)>>31) & flip_mask) | sign_mask))
 
-#define CREATE_HISTOGRAMS(type, buffer)														\
-	/* Clear counters/histograms */															\
-	ZeroMemory(mHistogram, 256*4*sizeof(udword));											\
-																							\
-	/* Prepare to count */																	\
-	ubyte* p = (ubyte*)input;																\
-	ubyte* pe = &p[nb*4];																	\
-	udword* h0= &mHistogram[0];		/* Histogram for first pass (LSB)	*/					\
-	udword* h1= &mHistogram[256];	/* Histogram for second pass		*/					\
-	udword* h2= &mHistogram[512];	/* Histogram for third pass			*/					\
-	udword* h3= &mHistogram[768];	/* Histogram for last pass (MSB)	*/					\
-																							\
+#define UPDATE_HISTOGRAMS_8(key)	h0[(key) & 0xff]++;	h1[((key)>>8) & 0xff]++;	h2[((key)>>16) & 0xff]++;	h3[(key)>>24]++;
+
+#define UPDATE_HISTOGRAMS_11(key)	h0[(key) & 0x7ff]++;	h1[((key)>>11) & 0x7ff]++;	h2[(key)>>22]++;
+
+#define CREATE_HISTOGRAMS(update)															\
+	/* Check for temporal coherence while counting: read the input in previous sorted */	\
+	/* order, and stop checking at the first value out of order. Flipped keys compare */	\
+	/* as unsigned integers whatever the input type. */										\
 	bool AlreadySorted = true;	/* Optimism... */											\
-																							\
-	if(INVALID_RANKS)																		\
+	udword PrevKey = RADIX_KEY(input[Ranks ? Ranks[0] : 0]);								\
+	for(;i<nb;i++)																			\
 	{																						\
-		/* Prepare for temporal coherence */												\
-		type* Running = (type*)buffer;														\
-		type PrevVal = *Running;															\
-																							\
-		while(p!=pe)																		\
-		{																					\
-			/* Read input buffer in previous sorted order */								\
-			type Val = *Running++;															\
-			/* Check whether already sorted or not */										\
-			if(Val<PrevVal)	{ AlreadySorted = false; break; } /* Early out */				\
-			/* Update for next iteration */													\
-			PrevVal = Val;																	\
+		udword Key = RADIX_KEY(input[Ranks ? Ranks[i] : i]);								\
+		/* Check whether already sorted or not */											\
+		if(Key<PrevKey)	{ AlreadySorted = false; break; } /* Early out */					\
+		/* Update for next iteration */														\
+		PrevKey = Key;																		\
 																							\
-			/* Create histograms */															\
-			h0[*p++]++;	h1[*p++]++;	h2[*p++]++;	h3[*p++]++;									\
-		}																					\
-																							\
-		/* If all input values are already sorted, we just have to return and leave the */	\
-		/* previous list unchanged. That way the routine may take advantage of temporal */	\
-		/* coherence, for example when used to sort transparent faces.					*/	\
-		if(AlreadySorted)																	\
-		{																					\
-			mNbHits++;																		\
-			for(udword i=0;i<nb;i++)	mRanks[i] = i;										\
-			return *this;																	\
-		}																					\
+		/* Create histograms. Counters don't care about the order: read sequentially. */	\
+		udword Val = RADIX_KEY(input[i]);													\
+		update(Val);																		\
 	}																						\
-	else																					\
-	{																						\
-		/* Prepare for temporal coherence */												\
-		udword* Indices = mRanks;															\
-		type PrevVal = (type)buffer[*Indices];												\
 																							\
-		while(p!=pe)																		\
+	/* If all input values are already sorted, we just have to return and leave the */		\
+	/* previous list unchanged. That way the routine may take advantage of temporal */		\
+	/* coherence, for example when used to sort transparent faces.					*/		\
+	if(AlreadySorted)																		\
+	{																						\
+		mNbHits++;																			\
+		if(!Ranks)																			\
 		{																					\
-			/* Read input buffer in previous sorted order */								\
-			type Val = (type)buffer[*Indices++];											\
-			/* Check whether already sorted or not */										\
-			if(Val<PrevVal)	{ AlreadySorted = false; break; } /* Early out */				\
-			/* Update for next iteration */													\
-			PrevVal = Val;																	\
-																							\
-			/* Create histograms */															\
-			h0[*p++]++;	h1[*p++]++;	h2[*p++]++;	h3[*p++]++;									\
+			for(udword j=0;j<nb;j++)	mRanks[j] = j;										\
+			VALIDATE_RANKS;																	\
 		}																					\
-																							\
-		/* If all input values are already sorted, we just have to return and leave the */	\
-		/* previous list unchanged. That way the routine may take advantage of temporal */	\
-		/* coherence, for example when used to sort transparent faces.					*/	\
-		if(AlreadySorted)	{ mNbHits++; return *this;	}									\
+		return *this;																		\
 	}																						\
 																							\
 	/* Else there has been an early out and we must finish computing the histograms */		\
-	while(p!=pe)																			\
+	for(;i<nb;i++)																			\
 	{																						\
 		/* Create histograms without the previous overhead */								\
-		h0[*p++]++;	h1[*p++]++;	h2[*p++]++;	h3[*p++]++;										\
+		udword Val = RADIX_KEY(input[i]);													\
+		update(Val);																		\
 	}
 
-#define CHECK_PASS_VALIDITY(pass)															\
-	/* Shortcut to current counters */														\
-	udword* CurCount = &mHistogram[pass<<8];												\
-																							\
-	/* Reset flag. The sorting pass is supposed to be performed. (default) */				\
-	bool PerformPass = true;																\
-																							\
-	/* Check pass validity */																\
-																							\
-	/* If all values have the same byte, sorting is useless. */								\
-	/* It may happen when sorting bytes or words instead of dwords. */						\
-	/* This routine actually sorts words faster than dwords, and bytes */					\
-	/* faster than words. Standard running time (O(4*n))is reduced to O(2*n) */				\
-	/* for words and O(n) for bytes. Running time for floats depends on actual values... */	\
-																							\
-	/* Get first byte */																	\
-	ubyte UniqueVal = *(((ubyte*)input)+pass);												\
-																							\
-	/* Check that byte's counter */															\
-	if(CurCount[UniqueVal]==nb)	PerformPass=false;
+//! Data shared by the chunks of a parallel pass
+struct RadixChunks
+{
+	const udword*	mInput;			//!< Input values
+	const udword*	mRanks;			//!< Current ranks, or null if they're implicit
+	udword*			mRanks2;		//!< Destination ranks
+	udword*			mCounts;		//!< RADIX_MAX_DIGITS counters per chunk, then offsets
+	udword			mNb;			//!< Number of values
+	udword			mChunkSize;		//!< Number of values per chunk
+	udword			mShift;			//!< Position of the pass' digit
+	udword			mMask;			//!< Mask of the pass' digit
+	udword			mFlipMask;		//!< Key flipping masks, see RADIX_KEY
+	udword			mSignMask;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Counts the digits of some chunks, for a parallel pass.
+ *	\param		first		[in] first chunk
+ *	\param		last		[in] last chunk + 1
+ *	\param		user_data	[in] the RadixChunks
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _CountChunks(udword first, udword last, void* user_data)
+{
+	const RadixChunks* Chunks = (const RadixChunks*)user_data;
+	const udword* input		= Chunks->mInput;
+	const udword flip_mask	= Chunks->mFlipMask;
+	const udword sign_mask	= Chunks->mSignMask;
+	const udword Shift		= Chunks->mShift;
+	const udword Mask		= Chunks->mMask;
+
+	for(udword c=first;c<last;c++)
+	{
+		udword* Count = &Chunks->mCounts[c*RADIX_MAX_DIGITS];
+		ZeroMemory(Count, (Mask+1)*sizeof(udword));
+
+		udword Start = c*Chunks->mChunkSize;
+		udword End = Start + Chunks->mChunkSize;
+		if(End>Chunks->mNb)	End = Chunks->mNb;
+
+		if(!Chunks->mRanks)
+		{
+			for(udword i=Start;i<End;i++)	Count[(RADIX_KEY(input[i])>>Shift) & Mask]++;
+		}
+		else
+		{
+			const udword* Ranks = Chunks->mRanks;
+			for(udword i=Start;i<End;i++)	Count[(RADIX_KEY(input[Ranks[i]])>>Shift) & Mask]++;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Scatters the ranks of some chunks, for a parallel pass. Counters have been turned into offsets.
+ *	\param		first		[in] first chunk
+ *	\param		last		[in] last chunk + 1
+ *	\param		user_data	[in] the RadixChunks
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _ScatterChunks(udword first, udword last, void* user_data)
+{
+	const RadixChunks* Chunks = (const RadixChunks*)user_data;
+	const udword* input		= Chunks->mInput;
+	udword* Ranks2			= Chunks->mRanks2;
+	const udword flip_mask	= Chunks->mFlipMask;
+	const udword sign_mask	= Chunks->mSignMask;
+	const udword Shift		= Chunks->mShift;
+	const udword Mask		= Chunks->mMask;
+
+	for(udword c=first;c<last;c++)
+	{
+		udword* Offset = &Chunks->mCounts[c*RADIX_MAX_DIGITS];
+
+		udword Start = c*Chunks->mChunkSize;
+		udword End = Start + Chunks->mChunkSize;
+		if(End>Chunks->mNb)	End = Chunks->mNb;
+
+		if(!Chunks->mRanks)
+		{
+			for(udword i=Start;i<End;i++)	Ranks2[Offset[(RADIX_KEY(input[i])>>Shift) & Mask]++] = i;
+		}
+		else
+		{
+			const udword* Ranks = Chunks->mRanks;
+			for(udword i=Start;i<End;i++)
+			{
+				udword id = Ranks[i];
+				Ranks2[Offset[(RADIX_KEY(input[id])>>Shift) & Mask]++] = id;
+			}
+		}
+	}
+}
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Constructor.
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-RadixSort::RadixSort() : mRanks(null), mRanks2(null), mCurrentSize(0), mTotalCalls(0), mNbHits(0)
+RadixSort::RadixSort() : mCurrentSize(0), mRanks(null), mRanks2(null), mPool(null), mChunkCounts(null), mNbChunks(0), mTotalCalls(0), mNbHits(0)
 {
 #ifndef RADIX_LOCAL_RAM
 	// Allocate input-independent ram
-	mHistogram	= new udword[256*4];
-	mOffset		= new udword[256];
+	mHistogram	= new udword[RADIX_MAX_DIGITS*RADIX_WIDE_PASSES];
+	mOffset		= new udword[RADIX_MAX_DIGITS];
 #endif
 	// Initialize indices
 	INVALIDATE_RANKS;
@@ -190,6 +233,7 @@ RadixSort::~RadixSort()
 	DELETEARRAY(mOffset);
 	DELETEARRAY(mHistogram);
 #endif
+	DELETEARRAY(mChunkCounts);
 	DELETEARRAY(mRanks2);
 	DELETEARRAY(mRanks);
 }
@@ -236,6 +280,39 @@ inline_ void RadixSort::CheckResize(udword nb)
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 RadixSort& RadixSort::Sort(const udword* input, udword nb, RadixHint hint)
+{
+	// Signed values only need their sign bit flipped to sort as unsigned ones
+	return _Sort(input, nb, 0, hint==RADIX_UNSIGNED ? 0 : 0x80000000);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Main sort routine.
+ *	This one is for floating-point values. After the call, mRanks contains a list of indices in sorted order, i.e. in the order you may process your data.
+ *	\param		input			[in] a list of floating-point values to sort
+ *	\param		nb				[in] number of values to sort, must be < 2^31
+ *	\return		Self-Reference
+ *	\warning	only sorts IEEE floating-point values
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+RadixSort& RadixSort::Sort(const float* input, udword nb)
+{
+	// Negative floats are sorted in the wrong order as integers: all their bits are flipped, which reverses it.
+	// -0.0 goes before 0.0, and contrary to the 4-pass version, equal negative values keep their order.
+	return _Sort((const udword*)input, nb, 0x7fffffff, 0x80000000);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Sorts flipped keys, see RADIX_KEY.
+ *	\param		input		[in] a list of values to sort
+ *	\param		nb			[in] number of values to sort, must be < 2^31
+ *	\param		flip_mask	[in] bits flipped in negative values
+ *	\param		sign_mask	[in] bits flipped in all values
+ *	\return		Self-Reference
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+RadixSort& RadixSort::_Sort(const udword* input, udword nb, udword flip_mask, udword sign_mask)
 {
 	// Checkings
 	if(!input || !nb || nb&0x80000000)	return *this;
@@ -248,258 +325,131 @@ RadixSort& RadixSort::Sort(const udword* input, udword nb, RadixHint hint)
 
 #ifdef RADIX_LOCAL_RAM
 	// Allocate histograms & offsets on the stack
-	udword mHistogram[256*4];
-//	udword mOffset[256];
-	udword* mLink[256];
+	udword mHistogram[RADIX_MAX_DIGITS*RADIX_WIDE_PASSES];
+	udword* mLink[RADIX_MAX_DIGITS];
 #endif
 
+	// Big inputs use 3 passes of 11 bits. Smaller ones keep 4 passes of 8 bits, whose histograms are quicker to clear
+	// and to turn into offsets, and stay in cache.
+	const bool Wide		= nb>=RADIX_WIDE_LIMIT;
+	const udword NbBits		= Wide ? RADIX_WIDE_BITS : 8;
+	const udword NbPasses	= Wide ? RADIX_WIDE_PASSES : 4;
+	const udword NbDigits	= 1<<NbBits;
+	const udword Mask		= NbDigits-1;
+
 	// Create histograms (counters). Counters for all passes are created in one run.
-	// Pros:	read input buffer once instead of four times
-	// Cons:	mHistogram is 4Kb instead of 1Kb
-	// We must take care of signed/unsigned values for temporal coherence.... I just
-	// have 2 code paths even if just a single opcode changes. Self-modifying code, someone?
-	if(hint==RADIX_UNSIGNED)	{ CREATE_HISTOGRAMS(udword, input);	}
-	else						{ CREATE_HISTOGRAMS(sdword, input);	}
-
-	// Compute #negative values involved if needed
-	udword NbNegativeValues = 0;
-	if(hint==RADIX_SIGNED)
+	// Pros:	read input buffer once instead of three or four times
+	// Cons:	mHistogram is 24Kb instead of 8Kb for big inputs
+	ZeroMemory(mHistogram, NbPasses*NbDigits*sizeof(udword));
+	udword* h0 = &mHistogram[0];			// Histogram for first pass (LSB)
+	udword* h1 = &mHistogram[NbDigits];		// Histogram for second pass
+	udword* h2 = &mHistogram[NbDigits*2];	// Histogram for third pass (MSB for big inputs)
+	udword* h3 = &mHistogram[NbDigits*3];	// Histogram for last pass (MSB for small inputs)
+
+	udword i = 0;
+	const udword* Ranks = INVALID_RANKS ? null : mRanks;
+	if(Wide)	{ CREATE_HISTOGRAMS(UPDATE_HISTOGRAMS_11);	}
+	else		{ CREATE_HISTOGRAMS(UPDATE_HISTOGRAMS_8);	}
+
+	// Big inputs are scattered by all the threads of the pool
+	const bool Parallel = mPool && mPool->GetNbThreads()>1 && nb>=RADIX_PARALLEL_LIMIT;
+
+	// Radix sort, j is the pass number (0=LSB)
+	const udword FirstKey = RADIX_KEY(input[0]);
+	for(udword j=0;j<NbPasses;j++)
 	{
-		// An efficient way to compute the number of negatives values we'll have to deal with is simply to sum the 128
-		// last values of the last histogram. Last histogram because that's the one for the Most Significant Byte,
-		// responsible for the sign. 128 last values because the 128 first ones are related to positive numbers.
-		udword* h3= &mHistogram[768];
-		for(udword i=128;i<256;i++)	NbNegativeValues += h3[i];	// 768 for last histogram, 128 for negative part
-	}
+		const udword Shift = j*NbBits;
 
-	// Radix sort, j is the pass number (0=LSB, 3=MSB)
-	for(udword j=0;j<4;j++)
-	{
-		CHECK_PASS_VALIDITY(j);
+		// If all values have the same digit, sorting is useless. It may happen when sorting words instead of dwords, or
+		// bytes, or floats in a small range. Running time is then reduced to O(2*n) or O(n).
+		udword* CurCount = &mHistogram[j*NbDigits];
+		if(CurCount[(FirstKey>>Shift) & Mask]==nb)	continue;
 
-		// Sometimes the fourth (negative) pass is skipped because all numbers are negative and the MSB is 0xFF (for example). This is
-		// not a problem, numbers are correctly sorted anyway.
-		if(PerformPass)
+		if(Parallel)
 		{
-			// Should we care about negative values?
-			if(j!=3 || hint==RADIX_UNSIGNED)
-			{
-				// Here we deal with positive values only
-
-				// Create offsets
-//				mOffset[0] = 0;
-//				for(udword i=1;i<256;i++)		mOffset[i] = mOffset[i-1] + CurCount[i-1];
-				mLink[0] = mRanks2;
-				for(udword i=1;i<256;i++)		mLink[i] = mLink[i-1] + CurCount[i-1];
-			}
-			else
-			{
-				// This is a special case to correctly handle negative integers. They're sorted in the right order but at the wrong place.
-
-				// Create biased offsets, in order for negative numbers to be sorted as well
-//				mOffset[0] = NbNegativeValues;												// First positive number takes place after the negative ones
-				mLink[0] = &mRanks2[NbNegativeValues];										// First positive number takes place after the negative ones
-//				for(udword i=1;i<128;i++)		mOffset[i] = mOffset[i-1] + CurCount[i-1];	// 1 to 128 for positive numbers
-				for(udword i=1;i<128;i++)		mLink[i] = mLink[i-1] + CurCount[i-1];		// 1 to 128 for positive numbers
-
-				// Fixing the wrong place for negative values
-//				mOffset[128] = 0;
-				mLink[128] = mRanks2;
-//				for(i=129;i<256;i++)			mOffset[i] = mOffset[i-1] + CurCount[i-1];
-				for(udword i=129;i<256;i++)		mLink[i] = mLink[i-1] + CurCount[i-1];
-			}
+			_ParallelPass(input, nb, Shift, Mask, flip_mask, sign_mask);
+		}
+		else
+		{
+			// Create offsets
+			mLink[0] = mRanks2;
+			for(udword k=1;k<NbDigits;k++)	mLink[k] = mLink[k-1] + CurCount[k-1];
 
 			// Perform Radix Sort
-			ubyte* InputBytes	= (ubyte*)input;
-			InputBytes += j;
 			if(INVALID_RANKS)
 			{
-//				for(udword i=0;i<nb;i++)	mRanks2[mOffset[InputBytes[i<<2]]++] = i;
-				for(udword i=0;i<nb;i++)	*mLink[InputBytes[i<<2]]++ = i;
-				VALIDATE_RANKS;
+				for(udword k=0;k<nb;k++)	*mLink[(RADIX_KEY(input[k])>>Shift) & Mask]++ = k;
 			}
 			else
 			{
-				udword* Indices		= mRanks;
-				udword* IndicesEnd	= &mRanks[nb];
+				const udword* Indices		= mRanks;
+				const udword* IndicesEnd	= &mRanks[nb];
 				while(Indices!=IndicesEnd)
 				{
 					udword id = *Indices++;
-//					mRanks2[mOffset[InputBytes[id<<2]]++] = id;
-					*mLink[InputBytes[id<<2]]++ = id;
+					*mLink[(RADIX_KEY(input[id])>>Shift) & Mask]++ = id;
 				}
 			}
-
-			// Swap pointers for next pass. Valid indices - the most recent ones - are in mRanks after the swap.
-			udword* Tmp	= mRanks;	mRanks = mRanks2; mRanks2 = Tmp;
 		}
+		VALIDATE_RANKS;
+
+		// Swap pointers for next pass. Valid indices - the most recent ones - are in mRanks after the swap.
+		udword* Tmp	= mRanks;	mRanks = mRanks2; mRanks2 = Tmp;
 	}
 	return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- *	Main sort routine.
- *	This one is for floating-point values. After the call, mRanks contains a list of indices in sorted order, i.e. in the order you may process your data.
- *	\param		input			[in] a list of floating-point values to sort
- *	\param		nb				[in] number of values to sort, must be < 2^31
- *	\return		Self-Reference
- *	\warning	only sorts IEEE floating-point values
+ *	Performs a pass on all the threads of the pool, from mRanks to mRanks2.
+ *	The input is split into one chunk per thread. Each chunk counts its own digits, then chunks are given consecutive
+ *	places for each digit, in order, so that the pass remains stable. Each chunk finally scatters its own ranks.
+ *	\param		input		[in] a list of values to sort
+ *	\param		nb			[in] number of values to sort
+ *	\param		shift		[in] position of the pass' digit
+ *	\param		mask		[in] mask of the pass' digit
+ *	\param		flip_mask	[in] bits flipped in negative values
+ *	\param		sign_mask	[in] bits flipped in all values
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-RadixSort& RadixSort::Sort(const float* input2, udword nb)
+void RadixSort::_ParallelPass(const udword* input, udword nb, udword shift, udword mask, udword flip_mask, udword sign_mask)
 {
-	// Checkings
-	if(!input2 || !nb || nb&0x80000000)	return *this;
-
-	// Stats
-	mTotalCalls++;
-
-	udword* input = (udword*)input2;
-
-	// Resize lists if needed
-	CheckResize(nb);
-
-#ifdef RADIX_LOCAL_RAM
-	// Allocate histograms & offsets on the stack
-	udword mHistogram[256*4];
-//	udword mOffset[256];
-	udword* mLink[256];
-#endif
-
-	// Create histograms (counters). Counters for all passes are created in one run.
-	// Pros:	read input buffer once instead of four times
-	// Cons:	mHistogram is 4Kb instead of 1Kb
-	// Floating-point values are always supposed to be signed values, so there's only one code path there.
-	// Please note the floating point comparison needed for temporal coherence! Although the resulting asm code
-	// is dreadful, this is surprisingly not such a performance hit - well, I suppose that's a big one on first
-	// generation Pentiums....We can't make comparison on integer representations because, as Chris said, it just
-	// wouldn't work with mixed positive/negative values....
-	{ CREATE_HISTOGRAMS(float, input2); }
-
-	// Compute #negative values involved if needed
-	udword NbNegativeValues = 0;
-	// An efficient way to compute the number of negatives values we'll have to deal with is simply to sum the 128
-	// last values of the last histogram. Last histogram because that's the one for the Most Significant Byte,
-	// responsible for the sign. 128 last values because the 128 first ones are related to positive numbers.
-	udword* h3= &mHistogram[768];
-	for(udword i=128;i<256;i++)	NbNegativeValues += h3[i];	// 768 for last histogram, 128 for negative part
-
-	// Radix sort, j is the pass number (0=LSB, 3=MSB)
-	for(udword j=0;j<4;j++)
+	udword NbChunks = mPool->GetNbThreads();
+	if(NbChunks>mNbChunks)
 	{
-		// Should we care about negative values?
-		if(j!=3)
-		{
-			// Here we deal with positive values only
-			CHECK_PASS_VALIDITY(j);
-
-			if(PerformPass)
-			{
-				// Create offsets
-//				mOffset[0] = 0;
-				mLink[0] = mRanks2;
-//				for(udword i=1;i<256;i++)		mOffset[i] = mOffset[i-1] + CurCount[i-1];
-				for(udword i=1;i<256;i++)		mLink[i] = mLink[i-1] + CurCount[i-1];
-
-				// Perform Radix Sort
-				ubyte* InputBytes = (ubyte*)input;
-				InputBytes += j;
-				if(INVALID_RANKS)
-				{
-//					for(i=0;i<nb;i++)	mRanks2[mOffset[InputBytes[i<<2]]++] = i;
-					for(udword i=0;i<nb;i++)	*mLink[InputBytes[i<<2]]++ = i;
-					VALIDATE_RANKS;
-				}
-				else
-				{
-					udword* Indices		= mRanks;
-					udword* IndicesEnd	= &mRanks[nb];
-					while(Indices!=IndicesEnd)
-					{
-						udword id = *Indices++;
-//						mRanks2[mOffset[InputBytes[id<<2]]++] = id;
-						*mLink[InputBytes[id<<2]]++ = id;
-					}
-				}
+		DELETEARRAY(mChunkCounts);
+		mChunkCounts = new udword[NbChunks*RADIX_MAX_DIGITS];
+		mNbChunks = NbChunks;
+	}
 
-				// Swap pointers for next pass. Valid indices - the most recent ones - are in mRanks after the swap.
-				udword* Tmp	= mRanks;	mRanks = mRanks2; mRanks2 = Tmp;
-			}
-		}
-		else
+	RadixChunks Chunks;
+	Chunks.mInput		= input;
+	Chunks.mRanks		= INVALID_RANKS ? null : mRanks;
+	Chunks.mRanks2		= mRanks2;
+	Chunks.mCounts		= mChunkCounts;
+	Chunks.mNb			= nb;
+	Chunks.mChunkSize	= (nb + NbChunks - 1)/NbChunks;
+	Chunks.mShift		= shift;
+	Chunks.mMask		= mask;
+	Chunks.mFlipMask	= flip_mask;
+	Chunks.mSignMask	= sign_mask;
+
+	mPool->ParallelFor(0, NbChunks, 1, _CountChunks, &Chunks);
+
+	// Turn counters into offsets: digits in order, and chunks in order within a digit
+	udword Offset = 0;
+	for(udword d=0;d<=mask;d++)
+	{
+		for(udword c=0;c<NbChunks;c++)
 		{
-			// This is a special case to correctly handle negative values
-			CHECK_PASS_VALIDITY(j);
-
-			if(PerformPass)
-			{
-				// Create biased offsets, in order for negative numbers to be sorted as well
-//				mOffset[0] = NbNegativeValues;												// First positive number takes place after the negative ones
-				mLink[0] = &mRanks2[NbNegativeValues];										// First positive number takes place after the negative ones
-//				for(udword i=1;i<128;i++)		mOffset[i] = mOffset[i-1] + CurCount[i-1];	// 1 to 128 for positive numbers
-				for(udword i=1;i<128;i++)		mLink[i] = mLink[i-1] + CurCount[i-1];		// 1 to 128 for positive numbers
-
-				// We must reverse the sorting order for negative numbers!
-//				mOffset[255] = 0;
-				mLink[255] = mRanks2;
-//				for(i=0;i<127;i++)		mOffset[254-i] = mOffset[255-i] + CurCount[255-i];	// Fixing the wrong order for negative values
-				for(udword i=0;i<127;i++)	mLink[254-i] = mLink[255-i] + CurCount[255-i];		// Fixing the wrong order for negative values
-//				for(i=128;i<256;i++)	mOffset[i] += CurCount[i];							// Fixing the wrong place for negative values
-				for(udword i=128;i<256;i++)	mLink[i] += CurCount[i];							// Fixing the wrong place for negative values
-
-				// Perform Radix Sort
-				if(INVALID_RANKS)
-				{
-					for(udword i=0;i<nb;i++)
-					{
-						udword Radix = input[i]>>24;							// Radix byte, same as above. AND is useless here (udword).
-						// ### cmp to be killed. Not good. Later.
-//						if(Radix<128)		mRanks2[mOffset[Radix]++] = i;		// Number is positive, same as above
-//						else				mRanks2[--mOffset[Radix]] = i;		// Number is negative, flip the sorting order
-						if(Radix<128)		*mLink[Radix]++ = i;		// Number is positive, same as above
-						else				*(--mLink[Radix]) = i;		// Number is negative, flip the sorting order
-					}
-					VALIDATE_RANKS;
-				}
-				else
-				{
-					for(udword i=0;i<nb;i++)
-					{
-						udword Radix = input[mRanks[i]]>>24;							// Radix byte, same as above. AND is useless here (udword).
-						// ### cmp to be killed. Not good. Later.
-//						if(Radix<128)		mRanks2[mOffset[Radix]++] = mRanks[i];		// Number is positive, same as above
-//						else				mRanks2[--mOffset[Radix]] = mRanks[i];		// Number is negative, flip the sorting order
-						if(Radix<128)		*mLink[Radix]++ = mRanks[i];		// Number is positive, same as above
-						else				*(--mLink[Radix]) = mRanks[i];		// Number is negative, flip the sorting order
-					}
-				}
-				// Swap pointers for next pass. Valid indices - the most recent ones - are in mRanks after the swap.
-				udword* Tmp	= mRanks;	mRanks = mRanks2; mRanks2 = Tmp;
-			}
-			else
-			{
-				// The pass is useless, yet we still have to reverse the order of current list if all values are negative.
-				if(UniqueVal>=128)
-				{
-					if(INVALID_RANKS)
-					{
-						// ###Possible?
-						for(udword i=0;i<nb;i++)	mRanks2[i] = nb-i-1;
-						VALIDATE_RANKS;
-					}
-					else
-					{
-						for(udword i=0;i<nb;i++)	mRanks2[i] = mRanks[nb-i-1];
-					}
-
-					// Swap pointers for next pass. Valid indices - the most recent ones - are in mRanks after the swap.
-					udword* Tmp	= mRanks;	mRanks = mRanks2; mRanks2 = Tmp;
-				}
-			}
+			udword& Count = mChunkCounts[c*RADIX_MAX_DIGITS+d];
+			udword NbValues = Count;
+			Count = Offset;
+			Offset += NbValues;
 		}
 	}
-	return *this;
+
+	mPool->ParallelFor(0, NbChunks, 1, _ScatterChunks, &Chunks);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -512,9 +462,10 @@ udword RadixSort::GetUsedRam() const
 {
 	udword UsedRam = sizeof(RadixSort);
 #ifndef RADIX_LOCAL_RAM
-	UsedRam += 256*4*sizeof(udword);			// Histograms
-	UsedRam += 256*sizeof(udword);				// Offsets
+	UsedRam += RADIX_MAX_DIGITS*RADIX_WIDE_PASSES*sizeof(udword);	// Histograms
+	UsedRam += RADIX_MAX_DIGITS*sizeof(udword);						// Offsets
 #endif
-	UsedRam += 2*CURRENT_SIZE*sizeof(udword);	// 2 lists of indices
+	UsedRam += mNbChunks*RADIX_MAX_DIGITS*sizeof(udword);			// Counters of parallel passes
+	UsedRam += 2*CURRENT_SIZE*sizeof(udword);						// 2 lists of indices
 	return UsedRam;
 }
@@ -15,6 +15,17 @@
 	//! Allocate histograms & offsets locally
 	#define RADIX_LOCAL_RAM
 
+	//! Number of bits per pass for big inputs. 3 passes of 11 bits cover a dword.
+	#define RADIX_WIDE_BITS			11
+	#define RADIX_WIDE_PASSES		3
+	#define RADIX_MAX_DIGITS		(1<<RADIX_WIDE_BITS)
+
+	//! Inputs smaller than this are sorted with 4 passes of 8 bits
+	#define RADIX_WIDE_LIMIT		8192
+
+	//! Inputs smaller than this are always sorted on the calling thread
+	#define RADIX_PARALLEL_LIMIT	65536
+
 	enum RadixHint
 	{
 		RADIX_SIGNED,		//!< Input values are signed
@@ -33,6 +44,10 @@
 				RadixSort&		Sort(const udword* input, udword nb, RadixHint hint=RADIX_SIGNED);
 				RadixSort&		Sort(const float* input, udword nb);
 
+		//! Sets the pool of threads used to scatter large inputs, or null to always sort on the calling thread
+		inline_	RadixSort&		SetTaskPool(Opcode::TaskPool* pool)	{ mPool = pool;	return *this;	}
+		inline_	Opcode::TaskPool*	GetTaskPool()		const	{ return mPool;			}
+
 		//! Access to results. mRanks is a list of indices in sorted order, i.e. in the order you may further process your data
 		inline_	const udword*	GetRanks()			const	{ return mRanks;		}
 
@@ -48,18 +63,23 @@
 
 		private:
 #ifndef RADIX_LOCAL_RAM
-				udword*			mHistogram;			//!< Counters for each byte
+				udword*			mHistogram;			//!< Counters for each digit
 				udword*			mOffset;			//!< Offsets (nearly a cumulative distribution function)
 #endif
 				udword			mCurrentSize;		//!< Current size of the indices list
 				udword*			mRanks;				//!< Two lists, swapped each pass
 				udword*			mRanks2;
+				Opcode::TaskPool*	mPool;			//!< Threads for parallel passes, or null
+				udword*			mChunkCounts;		//!< Counters for each digit of each chunk, in parallel passes
+				udword			mNbChunks;			//!< Number of chunks mChunkCounts has room for
 		// Stats
 				udword			mTotalCalls;		//!< Total number of calls to the sort routine
 				udword			mNbHits;			//!< Number of early exits due to coherence
 		// Internal methods
 				void			CheckResize(udword nb);
 				bool			Resize(udword nb);
+				RadixSort&		_Sort(const udword* input, udword nb, udword flip_mask, udword sign_mask);
+				void			_ParallelPass(const udword* input, udword nb, udword shift, udword mask, udword flip_mask, udword sign_mask);
 	};
 
 #endif // __ICERADIXSORT_H__
@@ -30,6 +30,8 @@
 // Precompiled Header
 #include "Stdafx.h"
 
+#include <xmmintrin.h>
+
 using namespace Opcode;
 
 #include "OPC_BoxBoxOverlap.h"
@@ -43,7 +45,7 @@ using namespace Opcode;
 //! AABB-triangle test
 #define AABB_PRIM(prim_index, flag)							\
 	/* Request vertices from the app */						\
-	VertexPointers VP;	mIMesh->GetTriangle(VP, prim_index);\
+	VertexPointers VP;	ConversionArea VC;	mIMesh->GetTriangle(VP, prim_index, VC);	\
 	mLeafVerts[0] = *VP.Vertex[0];							\
 	mLeafVerts[1] = *VP.Vertex[1];							\
 	mLeafVerts[2] = *VP.Vertex[2];							\
@@ -93,7 +95,15 @@ bool AABBCollider::Collide(AABBCache& cache, const CollisionAABB& box, const Mod
 	// Init collision query
 	if(InitQuery(cache, box))	return true;
 
-	if(!model.HasLeafNodes())
+	if(model.IsWide())
+	{
+		const AABBWideTree* Tree = (const AABBWideTree*)model.GetTree();
+
+		// Perform collision query
+		if(SkipPrimitiveTests())	_CollideNoPrimitiveTest(Tree->GetNodes());
+		else						_Collide(Tree->GetNodes());
+	}
+	else if(!model.HasLeafNodes())
 	{
 		if(model.IsQuantized())
 		{
@@ -307,6 +317,31 @@ inline_ BOOL AABBCollider::AABBContainsBox(const Point& bc, const Point& be)
 		return;								\
 	}
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	AABB-AABB overlap tests for the children of a wide node at once, with SSE. Same test as AABBAABBOverlap.
+ *	\param		node	[in] wide node
+ *	\return		overlapping children, bit i for child i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ udword AABBCollider::AABBWideOverlap(const AABBWideNode* node)
+{
+	// Stats
+	udword NbChildren = node->GetNbChildren();
+	mNbVolumeBVTests += NbChildren;
+
+	const __m128 SignMask = _mm_set1_ps(-0.0f);
+
+	__m128 tx = _mm_andnot_ps(SignMask, _mm_sub_ps(_mm_set1_ps(mBox.mCenter.x), _mm_loadu_ps(node->mCenterX)));
+	__m128 ty = _mm_andnot_ps(SignMask, _mm_sub_ps(_mm_set1_ps(mBox.mCenter.y), _mm_loadu_ps(node->mCenterY)));
+	__m128 tz = _mm_andnot_ps(SignMask, _mm_sub_ps(_mm_set1_ps(mBox.mCenter.z), _mm_loadu_ps(node->mCenterZ)));
+	__m128 Out =			_mm_cmpgt_ps(tx, _mm_add_ps(_mm_loadu_ps(node->mExtentsX), _mm_set1_ps(mBox.mExtents.x)));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(ty, _mm_add_ps(_mm_loadu_ps(node->mExtentsY), _mm_set1_ps(mBox.mExtents.y))));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(tz, _mm_add_ps(_mm_loadu_ps(node->mExtentsZ), _mm_set1_ps(mBox.mExtents.z))));
+
+	return ~_mm_movemask_ps(Out) & ((1<<NbChildren)-1);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive collision query for normal AABB trees.
@@ -523,6 +558,80 @@ void AABBCollider::_CollideNoPrimitiveTest(const AABBQuantizedNoLeafNode* node)
 	else					_CollideNoPrimitiveTest(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for wide AABB trees.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBCollider::_Collide(const AABBWideNode* node)
+{
+	// Perform overlap tests on all children
+	udword Overlaps = AABBWideOverlap(node);
+
+	for(udword i=0;i<OPC_WIDE_NODE_SIZE;i++)
+	{
+		if(!(Overlaps & (1<<i)))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			AABB_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+		}
+		else
+		{
+			Point Center, Extents;
+			node->GetCenter(i, Center);
+			node->GetExtents(i, Extents);
+			if(AABBContainsBox(Center, Extents))
+			{
+				// Set contact status
+				mFlags |= OPC_CONTACT;
+				_Dump(node->GetChild(i));
+			}
+			else _Collide(node->GetChild(i));
+		}
+
+		if(ContactFound()) return;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for wide AABB trees, without primitive tests.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBCollider::_CollideNoPrimitiveTest(const AABBWideNode* node)
+{
+	// Perform overlap tests on all children
+	udword Overlaps = AABBWideOverlap(node);
+
+	for(udword i=0;i<OPC_WIDE_NODE_SIZE;i++)
+	{
+		if(!(Overlaps & (1<<i)))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			SET_CONTACT(node->GetPrimitive(i), OPC_CONTACT)
+		}
+		else
+		{
+			Point Center, Extents;
+			node->GetCenter(i, Center);
+			node->GetExtents(i, Extents);
+			if(AABBContainsBox(Center, Extents))
+			{
+				// Set contact status
+				mFlags |= OPC_CONTACT;
+				_Dump(node->GetChild(i));
+			}
+			else _CollideNoPrimitiveTest(node->GetChild(i));
+		}
+
+		if(ContactFound()) return;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive collision query for vanilla AABB trees.
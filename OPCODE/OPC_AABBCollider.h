@@ -74,9 +74,12 @@
 							void			_CollideNoPrimitiveTest(const AABBNoLeafNode* node);
 							void			_CollideNoPrimitiveTest(const AABBQuantizedNode* node);
 							void			_CollideNoPrimitiveTest(const AABBQuantizedNoLeafNode* node);
+							void			_Collide(const AABBWideNode* node);
+							void			_CollideNoPrimitiveTest(const AABBWideNode* node);
 			// Overlap tests
 		inline_				BOOL			AABBContainsBox(const Point& bc, const Point& be);
 		inline_				BOOL			AABBAABBOverlap(const Point& b, const Point& Pb);
+		inline_				udword			AABBWideOverlap(const AABBWideNode* node);
 		inline_				BOOL			TriBoxOverlap();
 			// Init methods
 							BOOL			InitQuery(AABBCache& cache, const CollisionAABB& box);
@@ -46,8 +46,49 @@
 // Precompiled Header
 #include "Stdafx.h"
 
+#include <atomic>
+
 using namespace Opcode;
 
+#define PARALLEL_TASK_LIMIT		1024	//!< Subtrees of at least this many primitives are built by separate tasks [parallel build]
+#define PARALLEL_SPLIT_LIMIT	32768	//!< Nodes of at least this many primitives are split by several threads [parallel build]
+#define PARALLEL_SPLIT_GRAIN	4096	//!< Number of primitives per thread chunk when splitting a node [parallel build]
+
+//! Data shared by build tasks [parallel build]
+struct BuildTaskData
+{
+	AABBTreeBuilder*		mBuilder;
+	std::atomic<udword>		mNbNodes;
+	std::atomic<udword>		mNbInvalidSplits;
+};
+
+//! A node's primitives, split into chunks by several threads [parallel build]
+struct SplitChunks
+{
+	AABBTreeBuilder*		mBuilder;
+	const udword*			mPrimitives;
+	ubyte*					mPositive;		//!< Positive flag of each primitive
+	udword					mAxis;
+	float					mSplitValue;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Tests chunks of a node's primitives against the splitting value [parallel build].
+ *	\param		first		[in] first primitive
+ *	\param		last		[in] last primitive + 1
+ *	\param		user_data	[in] the chunks
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void ComputeChunkSplit(udword first, udword last, void* user_data)
+{
+	SplitChunks* Chunks = (SplitChunks*)user_data;
+	for(udword i=first;i<last;i++)
+	{
+		Chunks->mPositive[i] = Chunks->mBuilder->GetSplittingValue(Chunks->mPrimitives[i], Chunks->mAxis) > Chunks->mSplitValue;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Constructor.
@@ -92,16 +133,43 @@ AABBTreeNode::~AABBTreeNode()
  *	The list of indices is reorganized according to the split values.
  *	\param		axis		[in] splitting axis index
  *	\param		builder		[in] the tree builder
+ *	\param		context		[in] the build context
  *	\return		the number of primitives assigned to the first child
  *	\warning	this method reorganizes the internal list of primitives
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-udword AABBTreeNode::Split(udword axis, AABBTreeBuilder* builder)
+udword AABBTreeNode::Split(udword axis, AABBTreeBuilder* builder, BuildContext& context)
 {
 	// Get node split value
 	float SplitValue = builder->GetSplittingValue(mNodePrimitives, mNbPrimitives, mBV, axis);
 
 	udword NbPos = 0;
+	if(context.mPool && mNbPrimitives>=PARALLEL_SPLIT_LIMIT)
+	{
+		// Large node: test the primitives on all threads, then reorganize them here exactly as below [parallel build]
+		SplitChunks Chunks;
+		Chunks.mBuilder		= builder;
+		Chunks.mPrimitives	= mNodePrimitives;
+		Chunks.mPositive	= new ubyte[mNbPrimitives];
+		Chunks.mAxis		= axis;
+		Chunks.mSplitValue	= SplitValue;
+		CHECKALLOC(Chunks.mPositive);
+		context.mPool->ParallelFor(context.mWorker, mNbPrimitives, PARALLEL_SPLIT_GRAIN, ComputeChunkSplit, &Chunks);
+
+		for(udword i=0;i<mNbPrimitives;i++)
+		{
+			if(Chunks.mPositive[i])
+			{
+				udword Tmp = mNodePrimitives[i];
+				mNodePrimitives[i] = mNodePrimitives[NbPos];
+				mNodePrimitives[NbPos] = Tmp;
+				NbPos++;
+			}
+		}
+		DELETEARRAY(Chunks.mPositive);
+		return NbPos;
+	}
+
 	// Loop through all node-related primitives. Their indices range from mNodePrimitives[0] to mNodePrimitives[mNbPrimitives-1].
 	// Those indices map the global list in the tree builder.
 	for(udword i=0;i<mNbPrimitives;i++)
@@ -127,6 +195,157 @@ udword AABBTreeNode::Split(udword axis, AABBTreeBuilder* builder)
 	return NbPos;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes half the surface area of a box given by its min & max points.
+ *	\param		min			[in] min point
+ *	\param		max			[in] max point
+ *	\return		half surface area
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static inline_ float HalfArea(const Point& min, const Point& max)
+{
+	Point d = max - min;
+	return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+#define SAH_NB_BINS	16	//!< Number of bins per axis for the surface area heuristic
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Splits the node using a binned surface area heuristic (SAH).
+ *	Primitives are binned by the centers of their boxes along each axis, and the node is split between the two bins
+ *	minimizing the SAH cost, i.e. the sum over both children of (surface area * number of primitives). This is the
+ *	expected cost of a query reaching the node, assuming the probability of hitting a child is proportional to its area.
+ *	The list of indices is reorganized according to the split, as in Split().
+ *	\param		builder		[in] the tree builder
+ *	\return		the number of primitives assigned to the first child (0 if the primitive centers are all the same)
+ *	\warning	this method reorganizes the internal list of primitives
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword AABBTreeNode::SplitSAH(AABBTreeBuilder* builder)
+{
+	udword i, Axis, Bin;
+	AABB Box;
+	Point Center;
+
+	// Compute the bounds of the primitive centers
+	Point CMin(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+	Point CMax(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+	for(i=0;i<mNbPrimitives;i++)
+	{
+		builder->ComputeGlobalBox(&mNodePrimitives[i], 1, Box);
+		Box.GetCenter(Center);
+		CMin.Min(Center);
+		CMax.Max(Center);
+	}
+
+	// Setup the bins. Axes along which all centers are the same can't be split.
+	Point BinMin[3][SAH_NB_BINS];
+	Point BinMax[3][SAH_NB_BINS];
+	udword BinCount[3][SAH_NB_BINS];
+	float Scale[3];
+	for(Axis=0;Axis<3;Axis++)
+	{
+		float Extent = CMax[Axis] - CMin[Axis];
+		Scale[Axis] = Extent>0.0f ? float(SAH_NB_BINS)/Extent : 0.0f;
+		for(Bin=0;Bin<SAH_NB_BINS;Bin++)
+		{
+			BinMin[Axis][Bin].Set(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+			BinMax[Axis][Bin].Set(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+			BinCount[Axis][Bin] = 0;
+		}
+	}
+
+	// Bin the primitives along all axes at once
+	for(i=0;i<mNbPrimitives;i++)
+	{
+		builder->ComputeGlobalBox(&mNodePrimitives[i], 1, Box);
+		Box.GetCenter(Center);
+		Point Min, Max;
+		Box.GetMin(Min);
+		Box.GetMax(Max);
+		for(Axis=0;Axis<3;Axis++)
+		{
+			if(Scale[Axis]==0.0f)	continue;
+			Bin = udword((Center[Axis] - CMin[Axis])*Scale[Axis]);
+			if(Bin>=SAH_NB_BINS)	Bin = SAH_NB_BINS-1;
+			BinMin[Axis][Bin].Min(Min);
+			BinMax[Axis][Bin].Max(Max);
+			BinCount[Axis][Bin]++;
+		}
+	}
+
+	// Sweep the bins from both sides to find the cheapest split.
+	// The split "after Bin" puts bins [0, Bin] in one child and the others in the second child.
+	udword BestAxis = INVALID_ID;
+	udword BestBin = 0;
+	float BestCost = MAX_FLOAT;
+	for(Axis=0;Axis<3;Axis++)
+	{
+		if(Scale[Axis]==0.0f)	continue;
+
+		float LeftArea[SAH_NB_BINS];
+		udword LeftCount[SAH_NB_BINS];
+		Point Min(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+		Point Max(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+		udword Count = 0;
+		for(Bin=0;Bin<SAH_NB_BINS-1;Bin++)
+		{
+			if(BinCount[Axis][Bin])
+			{
+				Min.Min(BinMin[Axis][Bin]);
+				Max.Max(BinMax[Axis][Bin]);
+				Count += BinCount[Axis][Bin];
+			}
+			LeftArea[Bin] = Count ? HalfArea(Min, Max) : 0.0f;
+			LeftCount[Bin] = Count;
+		}
+
+		Min.Set(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+		Max.Set(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+		Count = 0;
+		for(Bin=SAH_NB_BINS-1;Bin>0;Bin--)
+		{
+			if(BinCount[Axis][Bin])
+			{
+				Min.Min(BinMin[Axis][Bin]);
+				Max.Max(BinMax[Axis][Bin]);
+				Count += BinCount[Axis][Bin];
+			}
+			if(!Count || !LeftCount[Bin-1])	continue;
+
+			float Cost = LeftArea[Bin-1]*float(LeftCount[Bin-1]) + HalfArea(Min, Max)*float(Count);
+			if(Cost<BestCost)
+			{
+				BestCost = Cost;
+				BestAxis = Axis;
+				BestBin = Bin-1;
+			}
+		}
+	}
+	if(BestAxis==INVALID_ID)	return 0;
+
+	// Reorganize the list of indices in this order: positive (bins after the split) - negative.
+	udword NbPos = 0;
+	for(i=0;i<mNbPrimitives;i++)
+	{
+		builder->ComputeGlobalBox(&mNodePrimitives[i], 1, Box);
+		Bin = udword((Box.GetCenter(BestAxis) - CMin[BestAxis])*Scale[BestAxis]);
+		if(Bin>=SAH_NB_BINS)	Bin = SAH_NB_BINS-1;
+		if(Bin>BestBin)
+		{
+			// Swap entries
+			udword Tmp = mNodePrimitives[i];
+			mNodePrimitives[i] = mNodePrimitives[NbPos];
+			mNodePrimitives[NbPos] = Tmp;
+			// Count primitives assigned to positive space
+			NbPos++;
+		}
+	}
+	return NbPos;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Subdivides the node.
@@ -144,10 +363,11 @@ udword AABBTreeNode::Split(udword axis, AABBTreeBuilder* builder)
  *	Note a perfectly-balanced tree is not well-suited to collision detection anyway.
  *
  *	\param		builder		[in] the tree builder
+ *	\param		context		[in] the build context
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
+bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder, BuildContext& context)
 {
 	// Checkings
 	if(!builder)	return false;
@@ -168,7 +388,7 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 		udword Axis	= Extents.LargestAxis();		// Index of largest axis
 
 		// Split along the axis
-		NbPos = Split(Axis, builder);
+		NbPos = Split(Axis, builder, context);
 
 		// Check split validity
 		if(!NbPos || NbPos==mNbPrimitives)	ValidSplit = false;
@@ -204,7 +424,7 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 		udword Axis = Vars.LargestAxis();
 
 		// Split along the axis
-		NbPos = Split(Axis, builder);
+		NbPos = Split(Axis, builder, context);
 
 		// Check split validity
 		if(!NbPos || NbPos==mNbPrimitives)	ValidSplit = false;
@@ -213,9 +433,9 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 	{
 		// Test 3 axis, take the best
 		float Results[3];
-		NbPos = Split(0, builder);	Results[0] = float(NbPos)/float(mNbPrimitives);
-		NbPos = Split(1, builder);	Results[1] = float(NbPos)/float(mNbPrimitives);
-		NbPos = Split(2, builder);	Results[2] = float(NbPos)/float(mNbPrimitives);
+		NbPos = Split(0, builder, context);	Results[0] = float(NbPos)/float(mNbPrimitives);
+		NbPos = Split(1, builder, context);	Results[1] = float(NbPos)/float(mNbPrimitives);
+		NbPos = Split(2, builder, context);	Results[2] = float(NbPos)/float(mNbPrimitives);
 		Results[0]-=0.5f;	Results[0]*=Results[0];
 		Results[1]-=0.5f;	Results[1]*=Results[1];
 		Results[2]-=0.5f;	Results[2]*=Results[2];
@@ -224,7 +444,7 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 		if(Results[2]<Results[Min])	Min = 2;
 		
 		// Split along the axis
-		NbPos = Split(Min, builder);
+		NbPos = Split(Min, builder, context);
 
 		// Check split validity
 		if(!NbPos || NbPos==mNbPrimitives)	ValidSplit = false;
@@ -255,12 +475,20 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 		ValidSplit = false;
 		while(!ValidSplit && CurAxis!=3)
 		{
-			NbPos = Split(SortedAxis[CurAxis], builder);
+			NbPos = Split(SortedAxis[CurAxis], builder, context);
 			// Check the subdivision has been successful
 			if(!NbPos || NbPos==mNbPrimitives)	CurAxis++;
 			else								ValidSplit = true;
 		}
 	}
+	else if(builder->mSettings.mRules & SPLIT_SAH)
+	{
+		// Split where the surface area heuristic is least
+		NbPos = SplitSAH(builder);
+
+		// Check split validity
+		if(!NbPos || NbPos==mNbPrimitives)	ValidSplit = false;
+	}
 	else if(builder->mSettings.mRules & SPLIT_FIFTY)
 	{
 		// Don't even bother splitting (mainly a performance test)
@@ -277,7 +505,7 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 //		if(builder->mSettings.mRules&SPLIT_COMPLETE)
 		if(builder->mSettings.mLimit==1)
 		{
-			builder->IncreaseNbInvalidSplits();
+			context.mNbInvalidSplits++;
 			NbPos = mNbPrimitives>>1;
 		}
 		else return true;
@@ -288,7 +516,7 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 	{
 		// We use a pre-allocated linear pool for complete trees [Opcode 1.3]
 		AABBTreeNode* Pool = (AABBTreeNode*)builder->mNodeBase;
-		udword Count = builder->GetCount() - 1;	// Count begins to 1...
+		udword Count = context.mCount - 1;	// Count begins to 1...
 		// Set last bit to tell it shouldn't be freed ### pretty ugly, find a better way. Maybe one bit in mNbPrimitives
 		ASSERT(!(udword(&Pool[Count+0])&1));
 		ASSERT(!(udword(&Pool[Count+1])&1));
@@ -311,7 +539,8 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 	}
 
 	// Update stats
-	builder->IncreaseCount(2);
+	context.mCount += 2;
+	context.mNbNodes += 2;
 
 	// Assign children
 	AABBTreeNode* Pos = (AABBTreeNode*)GetPos();
@@ -328,21 +557,59 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 /**
  *	Recursive hierarchy building in a top-down fashion.
  *	\param		builder		[in] the tree builder
+ *	\param		context		[in] the build context
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void AABBTreeNode::_BuildHierarchy(AABBTreeBuilder* builder)
+void AABBTreeNode::_BuildHierarchy(AABBTreeBuilder* builder, BuildContext& context)
 {
 	// 1) Compute the global box for current node. The box is stored in mBV.
 	builder->ComputeGlobalBox(mNodePrimitives, mNbPrimitives, mBV);
 
 	// 2) Subdivide current node
-	Subdivide(builder);
+	Subdivide(builder, context);
 
 	// 3) Recurse
 	AABBTreeNode* Pos = (AABBTreeNode*)GetPos();
 	AABBTreeNode* Neg = (AABBTreeNode*)GetNeg();
-	if(Pos)	Pos->_BuildHierarchy(builder);
-	if(Neg)	Neg->_BuildHierarchy(builder);
+	if(Pos && context.mPool && Pos->mNbPrimitives>=PARALLEL_TASK_LIMIT)
+	{
+		// Large subtree: build it in a task, maybe on another thread [parallel build].
+		// In complete trees its 2*N-2 descendants take the next places in the pool, as in a serial build.
+		Task Subtree;
+		Subtree.mFunction	= _BuildHierarchyTask;
+		Subtree.mObject		= Pos;
+		Subtree.mUserData	= context.mTaskData;
+		Subtree.mParams[0]	= context.mCount;
+		context.mPool->Push(context.mWorker, Subtree);
+		context.mCount += Pos->mNbPrimitives*2 - 2;
+	}
+	else if(Pos)	Pos->_BuildHierarchy(builder, context);
+	if(Neg)	Neg->_BuildHierarchy(builder, context);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds the hierarchy of a subtree in a task [parallel build].
+ *	\param		pool		[in] the pool of build threads
+ *	\param		worker		[in] index of the thread running the task
+ *	\param		task		[in] the task: root node of the subtree, shared build data, and node count
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBTreeNode::_BuildHierarchyTask(TaskPool& pool, udword worker, const Task& task)
+{
+	BuildTaskData* Data = (BuildTaskData*)task.mUserData;
+
+	BuildContext Context;
+	Context.mPool				= &pool;
+	Context.mTaskData			= Data;
+	Context.mWorker				= worker;
+	Context.mCount				= task.mParams[0];
+	Context.mNbNodes			= 0;
+	Context.mNbInvalidSplits	= 0;
+	((AABBTreeNode*)task.mObject)->_BuildHierarchy(Data->mBuilder, Context);
+
+	Data->mNbNodes			+= Context.mNbNodes;
+	Data->mNbInvalidSplits	+= Context.mNbInvalidSplits;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -398,11 +665,14 @@ void AABBTree::Release()
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Builds a generic AABB tree from a tree builder.
+ *	Large trees are built on several threads if a pool is given and the builder is thread-safe. The tree is the same
+ *	as a serial build.
  *	\param		builder		[in] the tree builder
+ *	\param		pool		[in] pool of build threads, or null
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool AABBTree::Build(AABBTreeBuilder* builder)
+bool AABBTree::Build(AABBTreeBuilder* builder, TaskPool* pool)
 {
 	// Checkings
 	if(!builder || !builder->mNbPrimitives)	return false;
@@ -410,10 +680,6 @@ bool AABBTree::Build(AABBTreeBuilder* builder)
 	// Release previous tree
 	Release();
 
-	// Init stats
-	builder->SetCount(1);
-	builder->SetNbInvalidSplits(0);
-
 	// Initialize indices. This list will be modified during build.
 	mIndices = new udword[builder->mNbPrimitives];
 	CHECKALLOC(mIndices);
@@ -435,7 +701,36 @@ bool AABBTree::Build(AABBTreeBuilder* builder)
 	}
 
 	// Build the hierarchy
-	_BuildHierarchy(builder);
+	BuildContext Context;
+	Context.mPool				= null;
+	Context.mTaskData			= null;
+	Context.mWorker				= 0;
+	Context.mCount				= 1;
+	Context.mNbNodes			= 1;
+	Context.mNbInvalidSplits	= 0;
+	if(pool && pool->GetNbThreads()>1 && builder->IsThreadSafe() && mNbPrimitives>=PARALLEL_TASK_LIMIT)
+	{
+		// Build on all threads, starting with a task for the whole tree [parallel build]
+		BuildTaskData Data;
+		Data.mBuilder			= builder;
+		Data.mNbNodes			= 0;
+		Data.mNbInvalidSplits	= 0;
+
+		Task Root;
+		Root.mFunction	= _BuildHierarchyTask;
+		Root.mObject	= this;
+		Root.mUserData	= &Data;
+		Root.mParams[0]	= Context.mCount;
+		pool->Run(Root);
+
+		Context.mNbNodes			+= Data.mNbNodes;
+		Context.mNbInvalidSplits	= Data.mNbInvalidSplits;
+	}
+	else _BuildHierarchy(builder, Context);
+
+	// Get back stats
+	builder->SetCount(Context.mNbNodes);
+	builder->SetNbInvalidSplits(Context.mNbInvalidSplits);
 
 	// Get back total number of nodes
 	mTotalNbNodes	= builder->GetCount();
@@ -74,6 +74,17 @@
 
 	typedef		void				(*CullingCallback)		(udword nb_primitives, udword* node_primitives, BOOL need_clipping, void* user_data);
 
+	//! State of a tree build, or of the part of it run by a task [parallel build]
+	struct OPCODE_API BuildContext
+	{
+		TaskPool*			mPool;				//!< Pool of build threads, null for serial builds
+		void*				mTaskData;			//!< Data shared by build tasks
+		udword				mWorker;			//!< Index of the thread running the build
+		udword				mCount;				//!< Node count in serial build order, giving the place of the next children in the pool of complete trees
+		udword				mNbNodes;			//!< Number of nodes created
+		udword				mNbInvalidSplits;	//!< Number of invalid splits
+	};
+
 	class OPCODE_API AABBTreeNode
 	{
 									IMPLEMENT_TREE(AABBTreeNode, AABB)
@@ -87,9 +98,11 @@
 				udword*				mNodePrimitives;	//!< Node-related primitives (shortcut to a position in mIndices below)
 				udword				mNbPrimitives;		//!< Number of primitives for this node
 		// Internal methods
-				udword				Split(udword axis, AABBTreeBuilder* builder);
-				bool				Subdivide(AABBTreeBuilder* builder);
-				void				_BuildHierarchy(AABBTreeBuilder* builder);
+				udword				Split(udword axis, AABBTreeBuilder* builder, BuildContext& context);
+				udword				SplitSAH(AABBTreeBuilder* builder);
+				bool				Subdivide(AABBTreeBuilder* builder, BuildContext& context);
+				void				_BuildHierarchy(AABBTreeBuilder* builder, BuildContext& context);
+		static	void				_BuildHierarchyTask(TaskPool& pool, udword worker, const Task& task);
 				void				_Refit(AABBTreeBuilder* builder);
 	};
 
@@ -111,7 +124,7 @@
 									AABBTree();
 									~AABBTree();
 		// Build
-				bool				Build(AABBTreeBuilder* builder);
+				bool				Build(AABBTreeBuilder* builder, TaskPool* pool=null);
 				void				Release();
 
 		// Data access
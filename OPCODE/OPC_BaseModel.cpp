@@ -32,6 +32,10 @@
 
 using namespace Opcode;
 
+//! Rounds a file offset up to the section alignment
+#define ALIGN_SECTION(offset)	(((offset) + OPC_MODEL_FILE_ALIGN - 1) & ~(OPC_MODEL_FILE_ALIGN - 1))
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Constructor.
@@ -44,6 +48,7 @@ OPCODECREATE::OPCODECREATE()
 	mSettings.mLimit	= 1;	// Mandatory for complete trees
 	mNoLeaf				= true;
 	mQuantized			= true;
+	mWide				= false;
 #ifdef __MESHMERIZER_H__
 	mCollisionHull		= false;
 #endif // __MESHMERIZER_H__
@@ -56,7 +61,7 @@ OPCODECREATE::OPCODECREATE()
  *	Constructor.
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-BaseModel::BaseModel() : mIMesh(null), mModelCode(0), mSource(null), mTree(null)
+BaseModel::BaseModel() : mIMesh(null), mModelCode(0), mSource(null), mTree(null), mFile(null)
 {
 }
 
@@ -79,6 +84,7 @@ void BaseModel::ReleaseBase()
 {
 	DELETESINGLE(mSource);
 	DELETESINGLE(mTree);
+	DELETESINGLE(mFile);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,22 +92,32 @@ void BaseModel::ReleaseBase()
  *	Creates an optimized tree according to user-settings, and setups mModelCode.
  *	\param		no_leaf		[in] true for "no leaf" tree
  *	\param		quantized	[in] true for quantized tree
+ *	\param		wide		[in] true for 4-wide tree
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool BaseModel::CreateTree(bool no_leaf, bool quantized)
+bool BaseModel::CreateTree(bool no_leaf, bool quantized, bool wide)
 {
 	DELETESINGLE(mTree);
 
-	// Setup model code
+	// Setup model code. Wide trees have no leaf nodes and are not quantized.
+	if(wide)		{ no_leaf = true; quantized = false; }
+
 	if(no_leaf)		mModelCode |= OPC_NO_LEAF;
 	else			mModelCode &= ~OPC_NO_LEAF;
 
 	if(quantized)	mModelCode |= OPC_QUANTIZED;
 	else			mModelCode &= ~OPC_QUANTIZED;
 
+	if(wide)		mModelCode |= OPC_WIDE;
+	else			mModelCode &= ~OPC_WIDE;
+
 	// Create the correct class
-	if(mModelCode & OPC_NO_LEAF)
+	if(mModelCode & OPC_WIDE)
+	{
+		mTree = new AABBWideTree;
+	}
+	else if(mModelCode & OPC_NO_LEAF)
 	{
 		if(mModelCode & OPC_QUANTIZED)	mTree = new AABBQuantizedNoLeafTree;
 		else							mTree = new AABBNoLeafTree;
@@ -136,3 +152,195 @@ bool BaseModel::Refit()
 //	// Ouch...
 //	return mTree->Build(mSource);
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Writes a section of a model file, padded to the section alignment.
+ *	\param		fp			[in] the file
+ *	\param		data		[in] section data
+ *	\param		size		[in] section size
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static bool WriteSection(FILE* fp, const void* data, udword size)
+{
+	static const ubyte Padding[OPC_MODEL_FILE_ALIGN] = {0};
+	if(size && fwrite(data, size, 1, fp)!=1)	return false;
+	udword PadSize = ALIGN_SECTION(size) - size;
+	if(PadSize && fwrite(Padding, PadSize, 1, fp)!=1)	return false;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Checks a section of a model file lies inside the file.
+ *	\param		offset		[in] section offset
+ *	\param		nb			[in] number of elements
+ *	\param		size		[in] size of an element
+ *	\param		file_size	[in] file size
+ *	\return		true if the section is valid
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static bool CheckSection(udword offset, udword nb, udword size, udword file_size)
+{
+	if(!nb)	return true;
+	if(offset & (OPC_MODEL_FILE_ALIGN - 1))	return false;
+	if(offset>file_size)	return false;
+	return nb <= (file_size - offset)/size;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Saves the model to a file. The header and the optimized tree are common to all models, leaf data is specific.
+ *	\param		filename	[in] the file
+ *	\param		type		[in] ModelFileType
+ *	\param		leaves		[in] leaf triangle groups, one udword each, or null
+ *	\param		nb_leaves	[in] number of leaf triangle groups
+ *	\param		indices		[in] triangle indices, or null
+ *	\param		nb_indices	[in] number of triangle indices
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool BaseModel::SaveBase(const char* filename, udword type, const void* leaves, udword nb_leaves, const udword* indices, udword nb_indices) const
+{
+	// Checkings
+	if(!filename || !mIMesh)	return false;
+
+	// Setup header
+	ModelFileHeader Header;
+	ZeroMemory(&Header, sizeof(ModelFileHeader));
+	Header.mMagic		= OPC_MODEL_FILE_MAGIC;
+	Header.mVersion		= OPC_MODEL_FILE_VERSION;
+	Header.mHeaderSize	= sizeof(ModelFileHeader);
+	Header.mModelType	= type;
+	Header.mModelCode	= mModelCode;
+	Header.mNbTriangles	= mIMesh->GetNbTriangles();
+	Header.mNbVertices	= mIMesh->GetNbVertices();
+
+	// Setup sections
+	udword Offset = ALIGN_SECTION(sizeof(ModelFileHeader));
+	udword NodesSize = 0;
+	if(mTree && mTree->GetNbNodes())
+	{
+		NodesSize				= mTree->GetUsedBytes();
+		Header.mNbNodes			= mTree->GetNbNodes();
+		Header.mNodeSize		= NodesSize / Header.mNbNodes;
+		Header.mNodesOffset		= Offset;
+		Offset += ALIGN_SECTION(NodesSize);
+
+		if(IsQuantized())
+		{
+			if(HasLeafNodes())
+			{
+				Header.mCenterCoeff		= ((const AABBQuantizedTree*)mTree)->mCenterCoeff;
+				Header.mExtentsCoeff	= ((const AABBQuantizedTree*)mTree)->mExtentsCoeff;
+			}
+			else
+			{
+				Header.mCenterCoeff		= ((const AABBQuantizedNoLeafTree*)mTree)->mCenterCoeff;
+				Header.mExtentsCoeff	= ((const AABBQuantizedNoLeafTree*)mTree)->mExtentsCoeff;
+			}
+		}
+	}
+	Header.mNbLeaves		= leaves ? nb_leaves : 0;
+	Header.mLeavesOffset	= Offset;
+	Offset += ALIGN_SECTION(Header.mNbLeaves*sizeof(udword));
+	Header.mNbIndices		= indices ? nb_indices : 0;
+	Header.mIndicesOffset	= Offset;
+	Offset += ALIGN_SECTION(Header.mNbIndices*sizeof(udword));
+	Header.mFileSize		= Offset;
+
+	// Write file
+	FILE* fp = fopen(filename, "wb");
+	if(!fp)	return false;
+	bool Status =	WriteSection(fp, &Header, sizeof(ModelFileHeader))
+				&&	WriteSection(fp, NodesSize ? mTree->GetNodeData() : null, NodesSize)
+				&&	WriteSection(fp, leaves, Header.mNbLeaves*sizeof(udword))
+				&&	WriteSection(fp, indices, Header.mNbIndices*sizeof(udword));
+	if(fclose(fp))	Status = false;
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Loads the common part of a model file: maps the file, checks it, and creates the optimized tree from the mapped nodes.
+ *	\param		filename	[in] the file
+ *	\param		type		[in] expected ModelFileType
+ *	\param		imesh		[in] mesh interface
+ *	\return		the mapped file header, to load leaf data, or null if failed
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+const ModelFileHeader* BaseModel::LoadBase(const char* filename, udword type, const MeshInterface* imesh)
+{
+	// Checkings
+	if(!imesh || !imesh->IsValid())	return null;
+
+	// Map the file
+	mFile = new MappedFile;
+	if(!mFile)	return null;
+	if(!mFile->Open(filename))	return null;
+
+	// Check the file
+	const ModelFileHeader* Header = (const ModelFileHeader*)mFile->GetData();
+	udword Size = mFile->GetSize();
+	if(Size<sizeof(ModelFileHeader)
+	|| Header->mMagic!=OPC_MODEL_FILE_MAGIC
+	|| Header->mVersion!=OPC_MODEL_FILE_VERSION
+	|| Header->mHeaderSize!=sizeof(ModelFileHeader)
+	|| Header->mFileSize!=Size
+	|| Header->mModelType!=type)
+	{
+		// Unknown model file, build the model again.
+		return null;
+	}
+	if(!CheckSection(Header->mNodesOffset, Header->mNbNodes, Header->mNodeSize, Size)
+	|| !CheckSection(Header->mLeavesOffset, Header->mNbLeaves, sizeof(udword), Size)
+	|| !CheckSection(Header->mIndicesOffset, Header->mNbIndices, sizeof(udword), Size))
+	{
+		// Corrupted model file.
+		return null;
+	}
+
+	// Check the mesh
+	if(Header->mNbTriangles!=imesh->GetNbTriangles() || Header->mNbVertices!=imesh->GetNbVertices())
+	{
+		// Model file saved for another mesh.
+		return null;
+	}
+
+	SetMeshInterface(imesh);
+	mModelCode = Header->mModelCode;
+
+	// Create the optimized tree, using the mapped nodes in place
+	if(Header->mNbNodes)
+	{
+		if(!CreateTree(!HasLeafNodes(), IsQuantized()!=0, IsWide()!=0))	return null;
+		mTree->SetExternalNodes(Header->mNbNodes, mFile->GetData() + Header->mNodesOffset);
+		if(mTree->GetUsedBytes()!=Header->mNbNodes*Header->mNodeSize)
+		{
+			// Model file nodes don't match this version.
+			return null;
+		}
+		// Walk the links once, so that corrupted nodes can't send queries out of the file. Hybrid leaves are leaf triangle groups.
+		if(!mTree->Check(type==OPC_MODEL_FILE_HYBRID ? Header->mNbLeaves : imesh->GetNbTriangles()))
+		{
+			// Corrupted model file.
+			return null;
+		}
+
+		if(IsQuantized())
+		{
+			if(HasLeafNodes())
+			{
+				((AABBQuantizedTree*)mTree)->mCenterCoeff		= Header->mCenterCoeff;
+				((AABBQuantizedTree*)mTree)->mExtentsCoeff		= Header->mExtentsCoeff;
+			}
+			else
+			{
+				((AABBQuantizedNoLeafTree*)mTree)->mCenterCoeff	= Header->mCenterCoeff;
+				((AABBQuantizedNoLeafTree*)mTree)->mExtentsCoeff	= Header->mExtentsCoeff;
+			}
+		}
+	}
+	return Header;
+}
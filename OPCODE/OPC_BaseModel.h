@@ -30,6 +30,7 @@
 		BuildSettings			mSettings;		//!< Builder's settings
 		bool					mNoLeaf;		//!< true => discard leaf nodes (else use a normal tree)
 		bool					mQuantized;		//!< true => quantize the tree (else use a normal tree)
+		bool					mWide;			//!< true => use a 4-wide tree, for SIMD queries (mNoLeaf & mQuantized are then ignored)
 #ifdef __MESHMERIZER_H__
 		bool					mCollisionHull;	//!< true => use convex hull + GJK
 #endif // __MESHMERIZER_H__
@@ -44,7 +45,8 @@
 	{
 		OPC_QUANTIZED	= (1<<0),	//!< Compressed/uncompressed tree
 		OPC_NO_LEAF		= (1<<1),	//!< Leaf/NoLeaf tree
-		OPC_SINGLE_NODE	= (1<<2)	//!< Special case for 1-node models
+		OPC_SINGLE_NODE	= (1<<2),	//!< Special case for 1-node models
+		OPC_WIDE		= (1<<3)	//!< Binary/4-wide tree
 	};
 
 	class OPCODE_API BaseModel
@@ -71,6 +73,29 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		virtual			udword				GetUsedBytes()		const			= 0;
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Saves the collision model to a file, to be loaded with Load() instead of being built again.
+		 *	The file holds the optimized tree (and hybrid leaf data) but not the mesh, nor the source tree.
+		 *	\param		filename	[in] the file
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		virtual			bool				Save(const char* filename)	const	= 0;
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Loads a collision model saved by Save(). The file is memory-mapped and its nodes are used in place, so loading
+		 *	is immediate and the pages are shared by all processes loading the same file. Files from other versions of
+		 *	OPCODE, or saved for another mesh, are rejected: build the model again in that case.
+		 *	\param		filename	[in] the file
+		 *	\param		imesh		[in] mesh interface of the mesh the model was built for, remapped if the build remapped it.
+		 *							Saved internally like OPCODECREATE::mIMesh.
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		virtual			bool				Load(const char* filename, const MeshInterface* imesh)	= 0;
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
 		 *	Refits the collision model. This can be used to handle dynamic meshes. Usage is:
@@ -138,6 +163,14 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		inline_			BOOL				HasSingleNode()		const	{ return mModelCode & OPC_SINGLE_NODE;	}
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Checks whether the tree is a 4-wide tree or not. Only the ray, sphere and AABB colliders support such trees.
+		 *	\return		true if the tree is an AABBWideTree
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline_			BOOL				IsWide()			const	{ return mModelCode & OPC_WIDE;			}
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
 		 *	Gets the model's code.
@@ -167,9 +200,12 @@
 						udword				mModelCode;		//!< Model code = combination of ModelFlag(s)
 						AABBTree*			mSource;		//!< Original source tree
 						AABBOptimizedTree*	mTree;			//!< Optimized tree owned by the model
+						MappedFile*			mFile;			//!< Model file the tree nodes are mapped from, if loaded
 		// Internal methods
 						void				ReleaseBase();
-						bool				CreateTree(bool no_leaf, bool quantized);
+						bool				CreateTree(bool no_leaf, bool quantized, bool wide=false);
+						bool				SaveBase(const char* filename, udword type, const void* leaves, udword nb_leaves, const udword* indices, udword nb_indices)	const;
+				const	ModelFileHeader*	LoadBase(const char* filename, udword type, const MeshInterface* imesh);
 	};
 
 #endif //__OPC_BASEMODEL_H__
@@ -56,19 +56,20 @@ using namespace Opcode;
 static PRUNING_SORTER* gCompletePruningSorter = null;
 static PRUNING_SORTER* gBipartitePruningSorter0 = null;
 static PRUNING_SORTER* gBipartitePruningSorter1 = null;
+static TaskPool* gPruningPool = null;
 inline_ PRUNING_SORTER* GetCompletePruningSorter()
 {
-	if(!gCompletePruningSorter)	gCompletePruningSorter = new PRUNING_SORTER;
+	if(!gCompletePruningSorter)	gCompletePruningSorter = &(new PRUNING_SORTER)->SetTaskPool(gPruningPool);
 	return gCompletePruningSorter;
 }
 inline_ PRUNING_SORTER* GetBipartitePruningSorter0()
 {
-	if(!gBipartitePruningSorter0)	gBipartitePruningSorter0 = new PRUNING_SORTER;
+	if(!gBipartitePruningSorter0)	gBipartitePruningSorter0 = &(new PRUNING_SORTER)->SetTaskPool(gPruningPool);
 	return gBipartitePruningSorter0;
 }
 inline_ PRUNING_SORTER* GetBipartitePruningSorter1()
 {
-	if(!gBipartitePruningSorter1)	gBipartitePruningSorter1 = new PRUNING_SORTER;
+	if(!gBipartitePruningSorter1)	gBipartitePruningSorter1 = &(new PRUNING_SORTER)->SetTaskPool(gPruningPool);
 	return gBipartitePruningSorter1;
 }
 void ReleasePruningSorters()
@@ -78,6 +79,20 @@ void ReleasePruningSorters()
 	DELETESINGLE(gCompletePruningSorter);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Sets the pool of threads used to sort big sets of boxes. The pool must outlive the pruning calls, or be reset to null.
+ *	\param		pool	[in] pool of threads, or null to sort on the calling thread
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void Opcode::SetBoxPruningPool(TaskPool* pool)
+{
+	gPruningPool = pool;
+	if(gCompletePruningSorter)		gCompletePruningSorter->SetTaskPool(pool);
+	if(gBipartitePruningSorter0)	gBipartitePruningSorter0->SetTaskPool(pool);
+	if(gBipartitePruningSorter1)	gBipartitePruningSorter1->SetTaskPool(pool);
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
@@ -28,4 +28,7 @@
 	FUNCTION OPCODE_API bool BruteForceCompleteBoxTest(udword nb, const AABB** array, Pairs& pairs);
 	FUNCTION OPCODE_API bool BruteForceBipartiteBoxTest(udword nb0, const AABB** array0, udword nb1, const AABB** array1, Pairs& pairs);
 
+	// Threads for the sorts of big sets
+	FUNCTION OPCODE_API void SetBoxPruningPool(TaskPool* pool);
+
 #endif //__OPC_BOXPRUNING_H__
@@ -116,6 +116,12 @@ HybridModel::~HybridModel()
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void HybridModel::Release()
 {
+	// Leaf data loaded from a file is mapped, not allocated
+	if(mFile)
+	{
+		mIndices	= null;
+		mTriangles	= null;
+	}
 	ReleaseBase();
 	DELETEARRAY(mIndices);
 	DELETEARRAY(mTriangles);
@@ -169,6 +175,9 @@ bool HybridModel::Build(const OPCODECREATE& create)
 	AABBTree* LeafTree = null;
 	Internal Data;
 
+	// Threads for large models, started on demand. Trees are the same with any number of threads.
+	TaskPool Pool(create.mSettings.mNbThreads);
+
 	// 2) Build a generic AABB Tree.
 	mSource = new AABBTree;
 	CHECKALLOC(mSource);
@@ -181,7 +190,7 @@ bool HybridModel::Build(const OPCODECREATE& create)
 		TB.mNbPrimitives	= create.mIMesh->GetNbTriangles();
 		TB.mSettings		= create.mSettings;
 		TB.mSettings.mLimit	= 16;	// ### Hardcoded, but maybe we could let the user choose 8 / 16 / 32 ...
-		if(!mSource->Build(&TB))	goto FreeAndExit;
+		if(!mSource->Build(&TB, &Pool))	goto FreeAndExit;
 	}
 
 	// 2-2) Here's the trick : create *another* AABB tree using the leaves of the first one (which are boxes, this time)
@@ -273,14 +282,14 @@ bool HybridModel::Build(const OPCODECREATE& create)
 		TB.mSettings.mLimit	= 1;	// We now want a complete tree so that we can "optimize" it
 		TB.mNbPrimitives	= Data.mNbLeaves;
 		TB.mAABBArray		= Data.mLeaves;
-		if(!LeafTree->Build(&TB))	goto FreeAndExit;
+		if(!LeafTree->Build(&TB, &Pool))	goto FreeAndExit;
 	}
 
-	// 3) Create an optimized tree according to user-settings
+	// 3) Create an optimized tree according to user-settings. Hybrid colliders don't support wide trees.
 	if(!CreateTree(create.mNoLeaf, create.mQuantized))	goto FreeAndExit;
 
 	// 3-2) Create optimized tree
-	if(!mTree->Build(LeafTree))	goto FreeAndExit;
+	if(!mTree->Build(LeafTree, &Pool))	goto FreeAndExit;
 
 	// Finally ok...
 	Status = true;
@@ -309,6 +318,66 @@ udword HybridModel::GetUsedBytes() const
 	return UsedBytes;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Saves the collision model to a file.
+ *	\param		filename	[in] the file
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool HybridModel::Save(const char* filename) const
+{
+	return SaveBase(filename, OPC_MODEL_FILE_HYBRID, mTriangles, mNbLeaves, mIndices, mNbPrimitives);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Loads a collision model saved by Save(), instead of building it.
+ *	\param		filename	[in] the file
+ *	\param		imesh		[in] mesh interface of the mesh the model was built for
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool HybridModel::Load(const char* filename, const MeshInterface* imesh)
+{
+	Release();
+	const ModelFileHeader* Header = LoadBase(filename, OPC_MODEL_FILE_HYBRID, imesh);
+	if(!Header)
+	{
+		Release();
+		return false;
+	}
+
+	// Leaf data is used in place, like the nodes
+	mNbLeaves		= Header->mNbLeaves;
+	mTriangles		= mNbLeaves ? (LeafTriangles*)(mFile->GetData() + Header->mLeavesOffset) : null;
+	mNbPrimitives	= Header->mNbIndices;
+	mIndices		= mNbPrimitives ? (udword*)(mFile->GetData() + Header->mIndicesOffset) : null;
+
+	// Check the leaf triangle groups against the indices, or against the mesh if it has been remapped
+	udword NbTris = imesh->GetNbTriangles();
+	udword NbLeafTris = mIndices ? mNbPrimitives : NbTris;
+	for(udword i=0;i<mNbLeaves;i++)
+	{
+		if(mTriangles[i].GetTriangleIndex() + mTriangles[i].GetNbTriangles() > NbLeafTris)
+		{
+			// Corrupted model file.
+			Release();
+			return false;
+		}
+	}
+	for(udword i=0;i<mNbPrimitives;i++)
+	{
+		if(mIndices[i]>=NbTris)
+		{
+			// Corrupted model file.
+			Release();
+			return false;
+		}
+	}
+	return true;
+}
+
 inline_ void ComputeMinMax(Point& min, Point& max, const VertexPointers& vp)
 {
 	// Compute triangle's AABB = a leaf box
@@ -352,6 +421,7 @@ bool HybridModel::Refit()
 
 	// Bottom-up update
 	VertexPointers VP;
+	ConversionArea VC;
 	Point Min,Max;
 	Point Min_,Max_;
 	udword Index = mTree->GetNbNodes();
@@ -378,7 +448,7 @@ bool HybridModel::Refit()
 				// Loop through triangles and test each of them
 				while(NbTris--)
 				{
-					mIMesh->GetTriangle(VP, *T++);
+					mIMesh->GetTriangle(VP, *T++, VC);
 					ComputeMinMax(TmpMin, TmpMax, VP);
 					Min.Min(TmpMin);
 					Max.Max(TmpMax);
@@ -391,7 +461,7 @@ bool HybridModel::Refit()
 				// Loop through triangles and test each of them
 				while(NbTris--)
 				{
-					mIMesh->GetTriangle(VP, BaseIndex++);
+					mIMesh->GetTriangle(VP, BaseIndex++, VC);
 					ComputeMinMax(TmpMin, TmpMax, VP);
 					Min.Min(TmpMin);
 					Max.Max(TmpMax);
@@ -423,7 +493,7 @@ bool HybridModel::Refit()
 				// Loop through triangles and test each of them
 				while(NbTris--)
 				{
-					mIMesh->GetTriangle(VP, *T++);
+					mIMesh->GetTriangle(VP, *T++, VC);
 					ComputeMinMax(TmpMin, TmpMax, VP);
 					Min_.Min(TmpMin);
 					Max_.Max(TmpMax);
@@ -436,7 +506,7 @@ bool HybridModel::Refit()
 				// Loop through triangles and test each of them
 				while(NbTris--)
 				{
-					mIMesh->GetTriangle(VP, BaseIndex++);
+					mIMesh->GetTriangle(VP, BaseIndex++, VC);
 					ComputeMinMax(TmpMin, TmpMax, VP);
 					Min_.Min(TmpMin);
 					Max_.Max(TmpMax);
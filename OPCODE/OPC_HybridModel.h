@@ -42,6 +42,7 @@
 		inline_	udword	GetTriangleIndex()				const	{ return Data>>4;												}
 		inline_	void	SetData(udword nb, udword index)		{ ASSERT(nb>0 && nb<=16);	nb--;	Data = (index<<4)|(nb&15);	}
 	};
+	ICE_COMPILE_TIME_ASSERT(sizeof(LeafTriangles)==sizeof(udword));	// Leaf descriptors are saved as is in model files
 
 	class OPCODE_API HybridModel : public BaseModel
 	{
@@ -67,6 +68,25 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		override(BaseModel)	udword					GetUsedBytes()		const;
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Saves the collision model to a file.
+		 *	\param		filename	[in] the file
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		override(BaseModel)	bool					Save(const char* filename)	const;
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Loads a collision model saved by Save(), instead of building it.
+		 *	\param		filename	[in] the file
+		 *	\param		imesh		[in] mesh interface of the mesh the model was built for
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		override(BaseModel)	bool					Load(const char* filename, const MeshInterface* imesh);
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
 		 *	Refits the collision model. This can be used to handle dynamic meshes. Usage is:
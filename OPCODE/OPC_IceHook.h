@@ -38,6 +38,11 @@
 	#include "Ice/IceFPU.h"
 	#include "Ice/IceMemoryMacros.h"
 
+	namespace Opcode
+	{
+		class TaskPool;
+	}
+
 	namespace IceCore
 	{
 		#include "Ice/IceUtils.h"
@@ -120,8 +120,6 @@
 
 using namespace Opcode;
 
-Point MeshInterface::VertexCache[3];
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Constructor.
@@ -188,12 +186,13 @@ udword MeshInterface::CheckTopology()	const
 	udword NbDegenerate = 0;
 
 	VertexPointers VP;
+	ConversionArea VC;
 
 	// Using callbacks, we don't have access to vertex indices. Nevertheless we still can check for
 	// redundant vertex pointers, which cover all possibilities (callbacks/pointers/strides).
 	for(udword i=0;i<mNbTris;i++)
 	{
-		GetTriangle(VP, i);
+		GetTriangle(VP, i, VC);
 
 		if(		(VP.Vertex[0]==VP.Vertex[1])
 			||	(VP.Vertex[1]==VP.Vertex[2])
@@ -38,6 +38,10 @@
 		}
 	};
 
+	//! Caller-provided storage for the vertices of a triangle converted from double precision. Keeping it on the
+	//! caller's stack makes GetTriangle() reentrant, and lets two triangles be fetched at once.
+	typedef Point ConversionArea[3];
+
 #ifdef OPC_USE_CALLBACKS
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	/**
@@ -113,9 +117,10 @@
 		 *	Fetches a triangle given a triangle index.
 		 *	\param		vp		[out] required triangle's vertex pointers
 		 *	\param		index	[in] triangle index
+		 *	\param		vc		[out] storage for converted vertices, when vertices are double precision
 		 */
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		inline_			void				GetTriangle(VertexPointers& vp, udword index)	const
+		inline_			void				GetTriangle(VertexPointers& vp, udword index, ConversionArea vc)	const
 											{
 #ifdef OPC_USE_CALLBACKS
 												(mObjCallback)(index, vp, mUserData);
@@ -132,10 +137,10 @@
 													for (int i = 0; i < 3; i++){
 														const double* v = (const double*)(((ubyte*)mVerts) + T->mVRef[i] * mVertexStride);
 
-														VertexCache[i].x = (float)v[0];
-														VertexCache[i].y = (float)v[1];
-														VertexCache[i].z = (float)v[2];
-														vp.Vertex[i] = &VertexCache[i];
+														vc[i].x = (float)v[0];
+														vc[i].y = (float)v[1];
+														vc[i].z = (float)v[2];
+														vp.Vertex[i] = &vc[i];
 													}
 												}
 	#else
@@ -191,8 +196,6 @@
 	#endif
 		public:
 						bool Single;							//!< Use single or double precision vertices
-		private:
-						static Point VertexCache[3];
 #endif
 	};
 
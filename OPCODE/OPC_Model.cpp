@@ -43,6 +43,16 @@
  *		bool Status = Sample.Build(OPCC);
  *	\endcode
  *
+ *	Models only queried by rays, spheres and boxes can use a 4-wide tree (OPCC.Wide = true), tested with SIMD code.
+ *
+ *	Static models can be saved once, then loaded instead of being built again:
+ *
+ *	\code
+ *		Sample.Save("Sample.opc");
+ *		...
+ *		if(!Sample.Load("Sample.opc", &IMesh))	Sample.Build(OPCC);
+ *	\endcode
+ *
  *	3) Create a tree collider and set it up:
  *
  *	\code
@@ -168,6 +178,9 @@ bool Model::Build(const OPCODECREATE& create)
 	mSource = new AABBTree;
 	CHECKALLOC(mSource);
 
+	// Threads for large models, started on demand. Trees are the same with any number of threads.
+	TaskPool Pool(create.mSettings.mNbThreads);
+
 	// 2-1) Setup a builder. Our primitives here are triangles from input mesh,
 	// so we use an AABBTreeOfTrianglesBuilder.....
 	{
@@ -175,14 +188,14 @@ bool Model::Build(const OPCODECREATE& create)
 		TB.mIMesh			= create.mIMesh;
 		TB.mSettings		= create.mSettings;
 		TB.mNbPrimitives	= NbTris;
-		if(!mSource->Build(&TB))	return false;
+		if(!mSource->Build(&TB, &Pool))	return false;
 	}
 
 	// 3) Create an optimized tree according to user-settings
-	if(!CreateTree(create.mNoLeaf, create.mQuantized))	return false;
+	if(!CreateTree(create.mNoLeaf, create.mQuantized, create.mWide))	return false;
 
 	// 3-2) Create optimized tree
-	if(!mTree->Build(mSource))	return false;
+	if(!mTree->Build(mSource, &Pool))	return false;
 
 	// 3-3) Delete generic tree if needed
 	if(!create.mKeepOriginal)	DELETESINGLE(mSource);
@@ -220,3 +233,34 @@ udword Model::GetUsedBytes() const
 	if(!mTree)	return 0;
 	return mTree->GetUsedBytes();
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Saves the collision model to a file.
+ *	\param		filename	[in] the file
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Model::Save(const char* filename) const
+{
+	return SaveBase(filename, OPC_MODEL_FILE_MODEL, null, 0, null, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Loads a collision model saved by Save(), instead of building it.
+ *	\param		filename	[in] the file
+ *	\param		imesh		[in] mesh interface of the mesh the model was built for
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Model::Load(const char* filename, const MeshInterface* imesh)
+{
+	Release();
+	if(!LoadBase(filename, OPC_MODEL_FILE_MODEL, imesh))
+	{
+		Release();
+		return false;
+	}
+	return true;
+}
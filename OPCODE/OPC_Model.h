@@ -54,6 +54,25 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		override(BaseModel)	udword				GetUsedBytes()	const;
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Saves the collision model to a file.
+		 *	\param		filename	[in] the file
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		override(BaseModel)	bool				Save(const char* filename)	const;
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Loads a collision model saved by Save(), instead of building it.
+		 *	\param		filename	[in] the file
+		 *	\param		imesh		[in] mesh interface of the mesh the model was built for
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		override(BaseModel)	bool				Load(const char* filename, const MeshInterface* imesh);
+
 		private:
 #ifdef __MESHMERIZER_H__
 							CollisionHull*		mHull;			//!< Possible convex hull
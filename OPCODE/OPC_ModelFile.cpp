@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains the file format of saved models, and memory-mapped files to load them.
+ *	\file		OPC_ModelFile.cpp
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	A read-only file mapped in memory, copy-on-write.
+ *
+ *	Saved models are used in place from the mapping: several processes loading the same model share its pages.
+ *
+ *	\class		MappedFile
+ *	\version	1.3
+ *	\date		October, 18, 2026
+*/
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// System headers first, since Ice defines macros like AND, OR, XOR...
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled Header
+#include "Stdafx.h"
+
+using namespace Opcode;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MappedFile::MappedFile() : mData(null), mSize(0), mFile(null), mMapping(null)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Maps a whole file in memory. Pages are shared with other processes mapping the same file, until written to:
+ *	writes go to private copies and never reach the file.
+ *	\param		filename	[in] the file
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+	if(!filename)	return false;
+
+#ifdef _WIN32
+	HANDLE File = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, null, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, null);
+	if(File==INVALID_HANDLE_VALUE)	return false;
+	mFile = File;
+
+	LARGE_INTEGER Size;
+	if(!GetFileSizeEx(File, &Size) || !Size.QuadPart || Size.HighPart)	{ Close();	return false;	}
+	mSize = Size.LowPart;
+
+	mMapping = CreateFileMappingA(File, null, PAGE_WRITECOPY, 0, 0, null);
+	if(!mMapping)	{ Close();	return false;	}
+
+	mData = (ubyte*)MapViewOfFile(mMapping, FILE_MAP_COPY, 0, 0, 0);
+	if(!mData)	{ Close();	return false;	}
+#else
+	int File = open(filename, O_RDONLY);
+	if(File<0)	return false;
+
+	struct stat Stats;
+	if(fstat(File, &Stats) || !Stats.st_size || Stats.st_size>MAX_UDWORD)	{ close(File);	return false;	}
+	mSize = udword(Stats.st_size);
+
+	// The mapping keeps the file open
+	void* Data = mmap(null, mSize, PROT_READ|PROT_WRITE, MAP_PRIVATE, File, 0);
+	close(File);
+	if(Data==MAP_FAILED)	{ mSize = 0;	return false;	}
+	mData = (ubyte*)Data;
+#endif
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Unmaps the file.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if(mData)		UnmapViewOfFile(mData);
+	if(mMapping)	CloseHandle(mMapping);
+	if(mFile)		CloseHandle(mFile);
+#else
+	if(mData)		munmap(mData, mSize);
+#endif
+	mData		= null;
+	mSize		= 0;
+	mFile		= null;
+	mMapping	= null;
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains the file format of saved models, and memory-mapped files to load them.
+ *	\file		OPC_ModelFile.h
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Include Guard
+#ifndef __OPC_MODELFILE_H__
+#define __OPC_MODELFILE_H__
+
+	//! Model file magic number, also tells the byte order
+	#define OPC_MODEL_FILE_MAGIC	0x4d43504f	// "OPCM"
+	//! Model file version. Change it whenever nodes or the header change: files of other versions are rejected.
+	#define OPC_MODEL_FILE_VERSION	1
+	//! Alignment of the file sections
+	#define OPC_MODEL_FILE_ALIGN	16
+
+	enum ModelFileType
+	{
+		OPC_MODEL_FILE_MODEL	= 0,	//!< Model
+		OPC_MODEL_FILE_HYBRID	= 1		//!< HybridModel
+	};
+
+	//! Model file header. Sections follow, each one aligned on OPC_MODEL_FILE_ALIGN bytes.
+	struct OPCODE_API ModelFileHeader
+	{
+		udword				mMagic;			//!< OPC_MODEL_FILE_MAGIC
+		udword				mVersion;		//!< OPC_MODEL_FILE_VERSION
+		udword				mHeaderSize;	//!< Size of this header
+		udword				mFileSize;		//!< Size of the whole file
+		udword				mModelType;		//!< ModelFileType
+		udword				mModelCode;		//!< Model code = combination of ModelFlag(s)
+		udword				mNbTriangles;	//!< Number of triangles of the mesh
+		udword				mNbVertices;	//!< Number of vertices of the mesh
+		udword				mNbNodes;		//!< Number of nodes of the optimized tree
+		udword				mNodeSize;		//!< Size of a node
+		udword				mNodesOffset;	//!< Offset of the nodes
+		udword				mNbLeaves;		//!< Number of leaf triangle groups [hybrid models]
+		udword				mLeavesOffset;	//!< Offset of the leaf triangle groups [hybrid models]
+		udword				mNbIndices;		//!< Number of triangle indices [hybrid models]
+		udword				mIndicesOffset;	//!< Offset of the triangle indices [hybrid models]
+		udword				mReserved;
+		Point				mCenterCoeff;	//!< Quantization coeffs for centers [quantized trees]
+		Point				mExtentsCoeff;	//!< Quantization coeffs for extents [quantized trees]
+	};
+
+	class OPCODE_API MappedFile
+	{
+		public:
+		// Constructor / Destructor
+											MappedFile();
+											~MappedFile();
+
+						bool				Open(const char* filename);
+						void				Close();
+
+		// Data access
+		inline_			ubyte*				GetData()	const	{ return mData;	}
+		inline_			udword				GetSize()	const	{ return mSize;	}
+
+		private:
+						ubyte*				mData;		//!< Mapped file
+						udword				mSize;		//!< File size
+						void*				mFile;		//!< File handle [Windows]
+						void*				mMapping;	//!< Mapping handle [Windows]
+	};
+
+#endif // __OPC_MODELFILE_H__
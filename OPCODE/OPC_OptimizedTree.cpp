@@ -75,6 +75,9 @@ using namespace Opcode;
 //! - false to see the effects of quantization errors (faster, but wrong results in some cases)
 static bool gFixQuantized = true;
 
+#define PARALLEL_CONVERT_LIMIT	4096	//!< Subtrees of at least this many primitives are converted by separate tasks [parallel build]
+#define PARALLEL_QUANTIZE_GRAIN	4096	//!< Number of nodes per thread chunk when quantizing [parallel build]
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Builds an implicit tree from a standard one. An implicit tree is a complete tree (2*N-1 nodes) whose negative
@@ -86,17 +89,25 @@ static bool gFixQuantized = true;
  *			- data (32-bits value)
  *
  *	if data's LSB = 1 =>	remaining bits are a primitive pointer
- *	else					remaining bits are a P-node pointer, and N = P + 1
+ *	else					data is the offset in bytes from the node to its P-node, and N = P + 1
+ *
+ *	Offsets instead of pointers make the nodes position-independent: they can be saved and mapped back anywhere.
+ *
+ *	Large subtrees are pushed as tasks when a pool is given. Since the input tree is complete, a subtree of N primitives
+ *	always takes the next 2*N-2 indices, so the result is the same as a serial build.
  *
  *	\relates	AABBCollisionNode
- *	\fn			_BuildCollisionTree(AABBCollisionNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node)
+ *	\fn			_BuildCollisionTree(AABBCollisionNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node, TaskPool* pool, udword worker)
  *	\param		linear			[in] base address of destination nodes
  *	\param		box_id			[in] index of destination node
  *	\param		current_id		[in] current running index
  *	\param		current_node	[in] current node from input tree
+ *	\param		pool			[in] pool of build threads, or null
+ *	\param		worker			[in] index of the calling thread
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-static void _BuildCollisionTree(AABBCollisionNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node)
+static void _BuildCollisionTreeTask(TaskPool& pool, udword worker, const Task& task);
+static void _BuildCollisionTree(AABBCollisionNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node, TaskPool* pool, udword worker)
 {
 	// Current node from input tree is "current_node". Must be flattened into "linear[boxid]".
 
@@ -118,13 +129,64 @@ static void _BuildCollisionTree(AABBCollisionNode* linear, const udword box_id,
 		// To make the negative one implicit, we must store P and N in successive order
 		udword PosID = current_id++;	// Get a new id for positive child
 		udword NegID = current_id++;	// Get a new id for negative child
-		// Setup box data as the forthcoming new P pointer
-		linear[box_id].mData = (udword)&linear[PosID];
+		// Setup box data as the offset to the forthcoming new P node
+		linear[box_id].mData = (PosID - box_id)*sizeof(AABBCollisionNode);
 		// Make sure it's not marked as leaf
 		ASSERT(!(linear[box_id].mData&1));
 		// Recurse with new IDs
-		_BuildCollisionTree(linear, PosID, current_id, current_node->GetPos());
-		_BuildCollisionTree(linear, NegID, current_id, current_node->GetNeg());
+		const AABBTreeNode* P = current_node->GetPos();
+		if(pool && P->GetNbPrimitives()>=PARALLEL_CONVERT_LIMIT)
+		{
+			Task Subtree;
+			Subtree.mFunction	= _BuildCollisionTreeTask;
+			Subtree.mObject		= (void*)P;
+			Subtree.mUserData	= linear;
+			Subtree.mParams[0]	= PosID;
+			Subtree.mParams[1]	= current_id;
+			pool->Push(worker, Subtree);
+			current_id += P->GetNbPrimitives()*2 - 2;
+		}
+		else _BuildCollisionTree(linear, PosID, current_id, P, pool, worker);
+		_BuildCollisionTree(linear, NegID, current_id, current_node->GetNeg(), pool, worker);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds part of an implicit tree in a task [parallel build].
+ *	\param		pool		[in] the pool of build threads
+ *	\param		worker		[in] index of the thread running the task
+ *	\param		task		[in] the task: input node, destination nodes, destination index and running index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _BuildCollisionTreeTask(TaskPool& pool, udword worker, const Task& task)
+{
+	udword CurID = task.mParams[1];
+	_BuildCollisionTree((AABBCollisionNode*)task.mUserData, task.mParams[0], CurID, (const AABBTreeNode*)task.mObject, &pool, worker);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds an implicit tree, on all threads for large trees.
+ *	\param		linear			[in] destination nodes
+ *	\param		tree			[in] input tree
+ *	\param		pool			[in] pool of build threads, or null
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _BuildCollisionTree(AABBCollisionNode* linear, const AABBTree* tree, TaskPool* pool)
+{
+	Task Root;
+	Root.mFunction	= _BuildCollisionTreeTask;
+	Root.mObject	= (void*)tree;
+	Root.mUserData	= linear;
+	Root.mParams[0]	= 0;
+	Root.mParams[1]	= 1;
+	if(pool && pool->GetNbThreads()>1 && tree->GetNbPrimitives()>=PARALLEL_CONVERT_LIMIT)	pool->Run(Root);
+	else
+	{
+		udword CurID = 1;
+		_BuildCollisionTree(linear, 0, CurID, tree, null, 0);
+		ASSERT(CurID==tree->GetNbNodes());
 	}
 }
 
@@ -136,18 +198,24 @@ static void _BuildCollisionTree(AABBCollisionNode* linear, const udword box_id,
  *
  *	Node:
  *			- box
- *			- P pointer => a node (LSB=0) or a primitive (LSB=1)
- *			- N pointer => a node (LSB=0) or a primitive (LSB=1)
+ *			- P pointer => a node offset in bytes (LSB=0) or a primitive (LSB=1)
+ *			- N pointer => a node offset in bytes (LSB=0) or a primitive (LSB=1)
+ *
+ *	Large subtrees are pushed as tasks when a pool is given. Since the input tree is complete, a subtree of N primitives
+ *	always takes the next N-1 indices, so the result is the same as a serial build.
  *
  *	\relates	AABBNoLeafNode
- *	\fn			_BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node)
+ *	\fn			_BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node, TaskPool* pool, udword worker)
  *	\param		linear			[in] base address of destination nodes
  *	\param		box_id			[in] index of destination node
  *	\param		current_id		[in] current running index
  *	\param		current_node	[in] current node from input tree
+ *	\param		pool			[in] pool of build threads, or null
+ *	\param		worker			[in] index of the calling thread
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-static void _BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node)
+static void _BuildNoLeafTreeTask(TaskPool& pool, udword worker, const Task& task);
+static void _BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node, TaskPool* pool, udword worker)
 {
 	const AABBTreeNode* P = current_node->GetPos();
 	const AABBTreeNode* N = current_node->GetNeg();
@@ -172,11 +240,22 @@ static void _BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword
 		// Get a new id for positive child
 		udword PosID = current_id++;
 		// Setup box data
-		linear[box_id].mPosData = (udword)&linear[PosID];
+		linear[box_id].mPosData = (PosID - box_id)*sizeof(AABBNoLeafNode);
 		// Make sure it's not marked as leaf
 		ASSERT(!(linear[box_id].mPosData&1));
 		// Recurse
-		_BuildNoLeafTree(linear, PosID, current_id, P);
+		if(pool && P->GetNbPrimitives()>=PARALLEL_CONVERT_LIMIT)
+		{
+			Task Subtree;
+			Subtree.mFunction	= _BuildNoLeafTreeTask;
+			Subtree.mObject		= (void*)P;
+			Subtree.mUserData	= linear;
+			Subtree.mParams[0]	= PosID;
+			Subtree.mParams[1]	= current_id;
+			pool->Push(worker, Subtree);
+			current_id += P->GetNbPrimitives() - 2;
+		}
+		else _BuildNoLeafTree(linear, PosID, current_id, P, pool, worker);
 	}
 
 	if(N->IsLeaf())
@@ -193,11 +272,61 @@ static void _BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword
 		// Get a new id for negative child
 		udword NegID = current_id++;
 		// Setup box data
-		linear[box_id].mNegData = (udword)&linear[NegID];
+		linear[box_id].mNegData = (NegID - box_id)*sizeof(AABBNoLeafNode);
 		// Make sure it's not marked as leaf
 		ASSERT(!(linear[box_id].mNegData&1));
 		// Recurse
-		_BuildNoLeafTree(linear, NegID, current_id, N);
+		if(pool && N->GetNbPrimitives()>=PARALLEL_CONVERT_LIMIT)
+		{
+			Task Subtree;
+			Subtree.mFunction	= _BuildNoLeafTreeTask;
+			Subtree.mObject		= (void*)N;
+			Subtree.mUserData	= linear;
+			Subtree.mParams[0]	= NegID;
+			Subtree.mParams[1]	= current_id;
+			pool->Push(worker, Subtree);
+			current_id += N->GetNbPrimitives() - 2;
+		}
+		else _BuildNoLeafTree(linear, NegID, current_id, N, pool, worker);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds part of a no-leaf tree in a task [parallel build].
+ *	\param		pool		[in] the pool of build threads
+ *	\param		worker		[in] index of the thread running the task
+ *	\param		task		[in] the task: input node, destination nodes, destination index and running index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _BuildNoLeafTreeTask(TaskPool& pool, udword worker, const Task& task)
+{
+	udword CurID = task.mParams[1];
+	_BuildNoLeafTree((AABBNoLeafNode*)task.mUserData, task.mParams[0], CurID, (const AABBTreeNode*)task.mObject, &pool, worker);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds a no-leaf tree, on all threads for large trees.
+ *	\param		linear			[in] destination nodes
+ *	\param		tree			[in] input tree
+ *	\param		pool			[in] pool of build threads, or null
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _BuildNoLeafTree(AABBNoLeafNode* linear, const AABBTree* tree, TaskPool* pool)
+{
+	Task Root;
+	Root.mFunction	= _BuildNoLeafTreeTask;
+	Root.mObject	= (void*)tree;
+	Root.mUserData	= linear;
+	Root.mParams[0]	= 0;
+	Root.mParams[1]	= 1;
+	if(pool && pool->GetNbThreads()>1 && tree->GetNbPrimitives()>=PARALLEL_CONVERT_LIMIT)	pool->Run(Root);
+	else
+	{
+		udword CurID = 1;
+		_BuildNoLeafTree(linear, 0, CurID, tree, null, 0);
+		ASSERT(CurID==tree->GetNbPrimitives()-1);
 	}
 }
 
@@ -217,17 +346,18 @@ AABBCollisionTree::AABBCollisionTree() : mNodes(null)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 AABBCollisionTree::~AABBCollisionTree()
 {
-	DELETEARRAY(mNodes);
+	ReleaseNodes();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Builds the collision tree from a generic AABB tree.
  *	\param		tree			[in] generic AABB tree
+ *	\param		pool			[in] pool of threads for large trees, or null
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool AABBCollisionTree::Build(AABBTree* tree)
+bool AABBCollisionTree::Build(AABBTree* tree, TaskPool* pool)
 {
 	// Checkings
 	if(!tree)	return false;
@@ -237,18 +367,16 @@ bool AABBCollisionTree::Build(AABBTree* tree)
 	if(NbNodes!=NbTriangles*2-1)	return false;
 
 	// Get nodes
-	if(mNbNodes!=NbNodes)	// Same number of nodes => keep moving
+	if(mNbNodes!=NbNodes || mExternalNodes)	// Same number of nodes => keep moving
 	{
 		mNbNodes = NbNodes;
-		DELETEARRAY(mNodes);
+		ReleaseNodes();
 		mNodes = new AABBCollisionNode[mNbNodes];
 		CHECKALLOC(mNodes);
 	}
 
 	// Build the tree
-	udword CurID = 1;
-	_BuildCollisionTree(mNodes, 0, CurID, tree);
-	ASSERT(CurID==mNbNodes);
+	_BuildCollisionTree(mNodes, tree, pool);
 
 	return true;
 }
@@ -295,6 +423,23 @@ bool AABBCollisionTree::Walk(GenericWalkingCallback callback, void* user_data) c
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Checks the child links of the nodes, e.g. after SetExternalNodes().
+ *	\param		nb_primitives	[in] number of primitives the leaves refer to
+ *	\return		true if the links are valid
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBCollisionTree::Check(udword nb_primitives) const
+{
+	for(udword i=0;i<mNbNodes;i++)
+	{
+		// Implicit nodes: the negative child follows the positive one
+		if(!CheckLink(mNodes[i].mData, i, sizeof(AABBCollisionNode), 1, nb_primitives))	return false;
+	}
+	return true;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
@@ -312,17 +457,18 @@ AABBNoLeafTree::AABBNoLeafTree() : mNodes(null)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 AABBNoLeafTree::~AABBNoLeafTree()
 {
-	DELETEARRAY(mNodes);
+	ReleaseNodes();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Builds the collision tree from a generic AABB tree.
  *	\param		tree			[in] generic AABB tree
+ *	\param		pool			[in] pool of threads for large trees, or null
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool AABBNoLeafTree::Build(AABBTree* tree)
+bool AABBNoLeafTree::Build(AABBTree* tree, TaskPool* pool)
 {
 	// Checkings
 	if(!tree)	return false;
@@ -332,18 +478,16 @@ bool AABBNoLeafTree::Build(AABBTree* tree)
 	if(NbNodes!=NbTriangles*2-1)	return false;
 
 	// Get nodes
-	if(mNbNodes!=NbTriangles-1)	// Same number of nodes => keep moving
+	if(mNbNodes!=NbTriangles-1 || mExternalNodes)	// Same number of nodes => keep moving
 	{
 		mNbNodes = NbTriangles-1;
-		DELETEARRAY(mNodes);
+		ReleaseNodes();
 		mNodes = new AABBNoLeafNode[mNbNodes];
 		CHECKALLOC(mNodes);
 	}
 
 	// Build the tree
-	udword CurID = 1;
-	_BuildNoLeafTree(mNodes, 0, CurID, tree);
-	ASSERT(CurID==mNbNodes);
+	_BuildNoLeafTree(mNodes, tree, pool);
 
 	return true;
 }
@@ -384,6 +528,7 @@ bool AABBNoLeafTree::Refit(const MeshInterface* mesh_interface)
 
 	// Bottom-up update
 	VertexPointers VP;
+	ConversionArea VC;
 	Point Min,Max;
 	Point Min_,Max_;
 	udword Index = mNbNodes;
@@ -393,7 +538,7 @@ bool AABBNoLeafTree::Refit(const MeshInterface* mesh_interface)
 
 		if(Current.HasPosLeaf())
 		{
-			mesh_interface->GetTriangle(VP, Current.GetPosPrimitive());
+			mesh_interface->GetTriangle(VP, Current.GetPosPrimitive(), VC);
 			ComputeMinMax(Min, Max, VP);
 		}
 		else
@@ -405,7 +550,7 @@ bool AABBNoLeafTree::Refit(const MeshInterface* mesh_interface)
 
 		if(Current.HasNegLeaf())
 		{
-			mesh_interface->GetTriangle(VP, Current.GetNegPrimitive());
+			mesh_interface->GetTriangle(VP, Current.GetNegPrimitive(), VC);
 			ComputeMinMax(Min_, Max_, VP);
 		}
 		else
@@ -456,6 +601,23 @@ bool AABBNoLeafTree::Walk(GenericWalkingCallback callback, void* user_data) cons
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Checks the child links of the nodes, e.g. after SetExternalNodes().
+ *	\param		nb_primitives	[in] number of primitives the leaves refer to
+ *	\return		true if the links are valid
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBNoLeafTree::Check(udword nb_primitives) const
+{
+	for(udword i=0;i<mNbNodes;i++)
+	{
+		if(!CheckLink(mNodes[i].mPosData, i, sizeof(AABBNoLeafNode), 0, nb_primitives))	return false;
+		if(!CheckLink(mNodes[i].mNegData, i, sizeof(AABBNoLeafNode), 0, nb_primitives))	return false;
+	}
+	return true;
+}
+
 // Quantization notes:
 // - We could use the highest bits of mData to store some more quantized bits. Dequantization code
 //   would be slightly more complex, but number of overlap tests would be reduced (and anyhow those
@@ -549,9 +711,9 @@ bool AABBNoLeafTree::Walk(GenericWalkingCallback callback, void* user_data) cons
 	Data = Nodes[i].member;											\
 	if(!(Data&1))													\
 	{																\
-		/* Compute box number */									\
-		udword Nb = (Data - udword(Nodes))/Nodes[i].GetNodeSize();	\
-		Data = udword(&mNodes[Nb]);									\
+		/* Compute box offset */									\
+		udword Nb = Data/Nodes[i].GetNodeSize();					\
+		Data = Nb*mNodes[i].GetNodeSize();							\
 	}																\
 	/* ...remapped */												\
 	mNodes[i].member = Data;
@@ -572,17 +734,18 @@ AABBQuantizedTree::AABBQuantizedTree() : mNodes(null)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 AABBQuantizedTree::~AABBQuantizedTree()
 {
-	DELETEARRAY(mNodes);
+	ReleaseNodes();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Builds the collision tree from a generic AABB tree.
  *	\param		tree			[in] generic AABB tree
+ *	\param		pool			[in] pool of threads for large trees, or null
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool AABBQuantizedTree::Build(AABBTree* tree)
+bool AABBQuantizedTree::Build(AABBTree* tree, TaskPool* pool)
 {
 	// Checkings
 	if(!tree)	return false;
@@ -593,13 +756,12 @@ bool AABBQuantizedTree::Build(AABBTree* tree)
 
 	// Get nodes
 	mNbNodes = NbNodes;
-	DELETEARRAY(mNodes);
+	ReleaseNodes();
 	AABBCollisionNode* Nodes = new AABBCollisionNode[mNbNodes];
 	CHECKALLOC(Nodes);
 
 	// Build the tree
-	udword CurID = 1;
-	_BuildCollisionTree(Nodes, 0, CurID, tree);
+	_BuildCollisionTree(Nodes, tree, pool);
 
 	// Quantize
 	{
@@ -612,13 +774,30 @@ bool AABBQuantizedTree::Build(AABBTree* tree)
 		// Quantization
 		INIT_QUANTIZATION
 
-		// Quantize
-		udword Data;
-		for(udword i=0;i<mNbNodes;i++)
+		// Quantize, on all threads for large trees
+		struct Local
 		{
-			PERFORM_QUANTIZATION
-			REMAP_DATA(mData)
+			AABBQuantizedTree*	mTree;
+			const AABBCollisionNode*	mNodes;
+			Point				mCQuantCoeff;
+			Point				mEQuantCoeff;
+
+			static void _Quantize(udword first, udword last, void* user_data)
+			{
+				Local* Quantization = (Local*)user_data;
+				Quantization->mTree->_Quantize(Quantization->mNodes, Quantization->mCQuantCoeff, Quantization->mEQuantCoeff, first, last);
+			}
+		};
+		if(pool && mNbNodes>=PARALLEL_CONVERT_LIMIT)
+		{
+			Local Quantization;
+			Quantization.mTree			= this;
+			Quantization.mNodes			= Nodes;
+			Quantization.mCQuantCoeff	= CQuantCoeff;
+			Quantization.mEQuantCoeff	= EQuantCoeff;
+			pool->ParallelFor(0, mNbNodes, PARALLEL_QUANTIZE_GRAIN, Local::_Quantize, &Quantization);
 		}
+		else _Quantize(Nodes, CQuantCoeff, EQuantCoeff, 0, mNbNodes);
 
 		DELETEARRAY(Nodes);
 	}
@@ -626,6 +805,26 @@ bool AABBQuantizedTree::Build(AABBTree* tree)
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Quantizes a range of nodes.
+ *	\param		Nodes			[in] nodes to quantize
+ *	\param		CQuantCoeff		[in] center quantization coeffs
+ *	\param		EQuantCoeff		[in] extents quantization coeffs
+ *	\param		first			[in] first node
+ *	\param		last			[in] last node + 1
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBQuantizedTree::_Quantize(const AABBCollisionNode* Nodes, const Point& CQuantCoeff, const Point& EQuantCoeff, udword first, udword last)
+{
+	udword Data;
+	for(udword i=first;i<last;i++)
+	{
+		PERFORM_QUANTIZATION
+		REMAP_DATA(mData)
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Refits the collision tree after vertices have been modified.
@@ -668,6 +867,23 @@ bool AABBQuantizedTree::Walk(GenericWalkingCallback callback, void* user_data) c
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Checks the child links of the nodes, e.g. after SetExternalNodes().
+ *	\param		nb_primitives	[in] number of primitives the leaves refer to
+ *	\return		true if the links are valid
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBQuantizedTree::Check(udword nb_primitives) const
+{
+	for(udword i=0;i<mNbNodes;i++)
+	{
+		// Implicit nodes: the negative child follows the positive one
+		if(!CheckLink(mNodes[i].mData, i, sizeof(AABBQuantizedNode), 1, nb_primitives))	return false;
+	}
+	return true;
+}
+
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -686,17 +902,18 @@ AABBQuantizedNoLeafTree::AABBQuantizedNoLeafTree() : mNodes(null)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 AABBQuantizedNoLeafTree::~AABBQuantizedNoLeafTree()
 {
-	DELETEARRAY(mNodes);
+	ReleaseNodes();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Builds the collision tree from a generic AABB tree.
  *	\param		tree			[in] generic AABB tree
+ *	\param		pool			[in] pool of threads for large trees, or null
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool AABBQuantizedNoLeafTree::Build(AABBTree* tree)
+bool AABBQuantizedNoLeafTree::Build(AABBTree* tree, TaskPool* pool)
 {
 	// Checkings
 	if(!tree)	return false;
@@ -707,14 +924,12 @@ bool AABBQuantizedNoLeafTree::Build(AABBTree* tree)
 
 	// Get nodes
 	mNbNodes = NbTriangles-1;
-	DELETEARRAY(mNodes);
+	ReleaseNodes();
 	AABBNoLeafNode* Nodes = new AABBNoLeafNode[mNbNodes];
 	CHECKALLOC(Nodes);
 
 	// Build the tree
-	udword CurID = 1;
-	_BuildNoLeafTree(Nodes, 0, CurID, tree);
-	ASSERT(CurID==mNbNodes);
+	_BuildNoLeafTree(Nodes, tree, pool);
 
 	// Quantize
 	{
@@ -727,14 +942,30 @@ bool AABBQuantizedNoLeafTree::Build(AABBTree* tree)
 		// Quantization
 		INIT_QUANTIZATION
 
-		// Quantize
-		udword Data;
-		for(udword i=0;i<mNbNodes;i++)
+		// Quantize, on all threads for large trees
+		struct Local
+		{
+			AABBQuantizedNoLeafTree*	mTree;
+			const AABBNoLeafNode*	mNodes;
+			Point				mCQuantCoeff;
+			Point				mEQuantCoeff;
+
+			static void _Quantize(udword first, udword last, void* user_data)
+			{
+				Local* Quantization = (Local*)user_data;
+				Quantization->mTree->_Quantize(Quantization->mNodes, Quantization->mCQuantCoeff, Quantization->mEQuantCoeff, first, last);
+			}
+		};
+		if(pool && mNbNodes>=PARALLEL_CONVERT_LIMIT)
 		{
-			PERFORM_QUANTIZATION
-			REMAP_DATA(mPosData)
-			REMAP_DATA(mNegData)
+			Local Quantization;
+			Quantization.mTree			= this;
+			Quantization.mNodes			= Nodes;
+			Quantization.mCQuantCoeff	= CQuantCoeff;
+			Quantization.mEQuantCoeff	= EQuantCoeff;
+			pool->ParallelFor(0, mNbNodes, PARALLEL_QUANTIZE_GRAIN, Local::_Quantize, &Quantization);
 		}
+		else _Quantize(Nodes, CQuantCoeff, EQuantCoeff, 0, mNbNodes);
 
 		DELETEARRAY(Nodes);
 	}
@@ -742,6 +973,27 @@ bool AABBQuantizedNoLeafTree::Build(AABBTree* tree)
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Quantizes a range of nodes.
+ *	\param		Nodes			[in] nodes to quantize
+ *	\param		CQuantCoeff		[in] center quantization coeffs
+ *	\param		EQuantCoeff		[in] extents quantization coeffs
+ *	\param		first			[in] first node
+ *	\param		last			[in] last node + 1
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBQuantizedNoLeafTree::_Quantize(const AABBNoLeafNode* Nodes, const Point& CQuantCoeff, const Point& EQuantCoeff, udword first, udword last)
+{
+	udword Data;
+	for(udword i=first;i<last;i++)
+	{
+		PERFORM_QUANTIZATION
+		REMAP_DATA(mPosData)
+		REMAP_DATA(mNegData)
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Refits the collision tree after vertices have been modified.
@@ -780,3 +1032,20 @@ bool AABBQuantizedNoLeafTree::Walk(GenericWalkingCallback callback, void* user_d
 	Local::_Walk(mNodes, callback, user_data);
 	return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Checks the child links of the nodes, e.g. after SetExternalNodes().
+ *	\param		nb_primitives	[in] number of primitives the leaves refer to
+ *	\return		true if the links are valid
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBQuantizedNoLeafTree::Check(udword nb_primitives) const
+{
+	for(udword i=0;i<mNbNodes;i++)
+	{
+		if(!CheckLink(mNodes[i].mPosData, i, sizeof(AABBQuantizedNoLeafNode), 0, nb_primitives))	return false;
+		if(!CheckLink(mNodes[i].mNegData, i, sizeof(AABBQuantizedNoLeafNode), 0, nb_primitives))	return false;
+	}
+	return true;
+}
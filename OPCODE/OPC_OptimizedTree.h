@@ -29,8 +29,8 @@
 		/* Leaf test */																						\
 		inline_			BOOL				IsLeaf()		const	{ return mData&1;					}	\
 		/* Data access */																					\
-		inline_			const base_class*	GetPos()		const	{ return (base_class*)mData;		}	\
-		inline_			const base_class*	GetNeg()		const	{ return ((base_class*)mData)+1;	}	\
+		inline_			const base_class*	GetPos()		const	{ return (base_class*)(((ubyte*)this)+mData);	}	\
+		inline_			const base_class*	GetNeg()		const	{ return GetPos()+1;				}	\
 		inline_			udword				GetPrimitive()	const	{ return (mData>>1);				}	\
 		/* Stats */																							\
 		inline_			udword				GetNodeSize()	const	{ return SIZEOFOBJECT;				}	\
@@ -48,8 +48,8 @@
 		inline_			BOOL				HasPosLeaf()		const	{ return mPosData&1;			}	\
 		inline_			BOOL				HasNegLeaf()		const	{ return mNegData&1;			}	\
 		/* Data access */																					\
-		inline_			const base_class*	GetPos()			const	{ return (base_class*)mPosData;	}	\
-		inline_			const base_class*	GetNeg()			const	{ return (base_class*)mNegData;	}	\
+		inline_			const base_class*	GetPos()			const	{ return (base_class*)(((ubyte*)this)+mPosData);	}	\
+		inline_			const base_class*	GetNeg()			const	{ return (base_class*)(((ubyte*)this)+mNegData);	}	\
 		inline_			udword				GetPosPrimitive()	const	{ return (mPosData>>1);			}	\
 		inline_			udword				GetNegPrimitive()	const	{ return (mNegData>>1);			}	\
 		/* Stats */																							\
@@ -116,17 +116,25 @@
 													base_class();													\
 		virtual										~base_class();													\
 		/* Builds from a standard tree */																			\
-		override(AABBOptimizedTree)	bool			Build(AABBTree* tree);											\
+		override(AABBOptimizedTree)	bool			Build(AABBTree* tree, TaskPool* pool=null);						\
 		/* Refits the tree */																						\
 		override(AABBOptimizedTree)	bool			Refit(const MeshInterface* mesh_interface);						\
 		/* Walks the tree */																						\
 		override(AABBOptimizedTree)	bool			Walk(GenericWalkingCallback callback, void* user_data) const;	\
+		/* Checks the child links */																				\
+		override(AABBOptimizedTree)	bool			Check(udword nb_primitives) const;								\
 		/* Data access */																							\
 		inline_						const node*		GetNodes()		const	{ return mNodes;					}	\
+		/* Serialization */																							\
+		override(AABBOptimizedTree)	const void*		GetNodeData()	const	{ return mNodes;					}	\
+		override(AABBOptimizedTree)	void			SetExternalNodes(udword nb_nodes, void* nodes)					\
+													{ ReleaseNodes(); mNbNodes = nb_nodes; mNodes = (node*)nodes; mExternalNodes = true;	}	\
 		/* Stats */																									\
 		override(AABBOptimizedTree)	udword			GetUsedBytes()	const	{ return mNbNodes*sizeof(node);		}	\
 		private:																									\
-									node*			mNodes;
+									node*			mNodes;															\
+		/* Frees the nodes, unless they are external */																\
+		inline_						void			ReleaseNodes()	{ if(mExternalNodes) mNodes = null; else DELETEARRAY(mNodes); mExternalNodes = false;	}
 
 	typedef		bool				(*GenericWalkingCallback)	(const void* current, void* user_data);
 
@@ -135,7 +143,8 @@
 		public:
 		// Constructor / Destructor
 											AABBOptimizedTree() :
-												mNbNodes	(0)
+												mNbNodes		(0),
+												mExternalNodes	(false)
 																							{}
 		virtual								~AABBOptimizedTree()							{}
 
@@ -143,10 +152,11 @@
 		/**
 		 *	Builds the collision tree from a generic AABB tree.
 		 *	\param		tree			[in] generic AABB tree
+		 *	\param		pool			[in] pool of threads for large trees, or null. The result is the same.
 		 *	\return		true if success
 		 */
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		virtual			bool				Build(AABBTree* tree)											= 0;
+		virtual			bool				Build(AABBTree* tree, TaskPool* pool=null)						= 0;
 
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
@@ -167,12 +177,51 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		virtual			bool				Walk(GenericWalkingCallback callback, void* user_data) const	= 0;
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Checks the child links of the nodes, e.g. after SetExternalNodes(). Each link must be a primitive index below
+		 *	nb_primitives, or an offset to a node further in the array, so that walking the nodes never leaves them.
+		 *	\param		nb_primitives	[in] number of primitives the leaves refer to
+		 *	\return		true if the links are valid
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		virtual			bool				Check(udword nb_primitives) const								= 0;
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Gets the nodes, as a block of GetUsedBytes() bytes. Child links are offsets from their parent node, so the block
+		 *	can be saved and used again at any address.
+		 *	\return		the nodes
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		virtual			const void*			GetNodeData()		const										= 0;
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Uses nodes stored elsewhere, e.g. in a memory-mapped file, instead of building them. The tree doesn't free them.
+		 *	\param		nb_nodes	[in] number of nodes
+		 *	\param		nodes		[in] the nodes, as given by GetNodeData()
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		virtual			void				SetExternalNodes(udword nb_nodes, void* nodes)					= 0;
+
 		// Data access
 		virtual			udword				GetUsedBytes()		const										= 0;
 		inline_			udword				GetNbNodes()		const						{ return mNbNodes;	}
+		inline_			bool				HasExternalNodes()	const						{ return mExternalNodes;	}
 
 		protected:
+		// Checks the child link of node "index": a primitive index if LSB = 1, else an offset in bytes to the child
+		// node, followed by nb_siblings more nodes.
+		inline_			bool				CheckLink(udword data, udword index, udword node_size, udword nb_siblings, udword nb_primitives) const
+											{
+												if(data&1)					return (data>>1)<nb_primitives;
+												if(!data || data%node_size)	return false;
+												return data/node_size + nb_siblings < mNbNodes - index;
+											}
+
 						udword				mNbNodes;
+						bool				mExternalNodes;	//!< Nodes not owned by the tree
 	};
 
 	class OPCODE_API AABBCollisionTree : public AABBOptimizedTree
@@ -192,6 +241,9 @@
 		public:
 						Point				mCenterCoeff;
 						Point				mExtentsCoeff;
+		private:
+		// Internal methods
+						void				_Quantize(const AABBCollisionNode* Nodes, const Point& CQuantCoeff, const Point& EQuantCoeff, udword first, udword last);
 	};
 
 	class OPCODE_API AABBQuantizedNoLeafTree : public AABBOptimizedTree
@@ -201,6 +253,9 @@
 		public:
 						Point				mCenterCoeff;
 						Point				mExtentsCoeff;
+		private:
+		// Internal methods
+						void				_Quantize(const AABBNoLeafNode* Nodes, const Point& CQuantCoeff, const Point& EQuantCoeff, udword first, udword last);
 	};
 
 #endif // __OPC_OPTIMIZEDTREE_H__
@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains reentrant query functions.
+ *	\file		OPC_Query.cpp
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	The colliders keep their traversal state in members, so a collider can't be shared between threads. The functions
+ *	below build one on the stack for each query: the collider is the scratch context, the caller's cache is the result
+ *	sink, and the model is only read. Any number of threads can then query the same model concurrently.
+ *
+ *	Queries return the collider's status: true if success. Use the cache's contact status or the sink to check for hits.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled Header
+#include "Stdafx.h"
+
+using namespace Opcode;
+
+static void SetupCollider(Collider& collider, const QuerySettings& settings)
+{
+	collider.SetFirstContact(settings.mFirstContact);
+	collider.SetTemporalCoherence(settings.mTemporalCoherence);
+}
+
+static void GetVolumeStats(const VolumeCollider& collider, QueryStats* stats)
+{
+	if(!stats)	return;
+	stats->mNbBVTests	= collider.GetNbVolumeBVTests();
+	stats->mNbPrimTests	= collider.GetNbVolumePrimTests();
+}
+
+static void SetupRayCollider(RayCollider& collider, const QuerySettings& settings)
+{
+	SetupCollider(collider, settings);
+	collider.SetClosestHit(settings.mClosestHit);
+	collider.SetCulling(settings.mCulling);
+	collider.SetMaxDist(settings.mMaxDist);
+}
+
+static void GetRayStats(const RayCollider& collider, QueryStats* stats)
+{
+	if(!stats)	return;
+	stats->mNbBVTests	= collider.GetNbRayBVTests();
+	stats->mNbPrimTests	= collider.GetNbRayPrimTests();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Sphere-vs-model query.
+ *	\param		model		[in] model to query
+ *	\param		sphere		[in] sphere in local space
+ *	\param		cache		[in/out] sphere cache, receives the touched primitives
+ *	\param		settings	[in] query settings
+ *	\param		worlds		[in] sphere's world matrix, or null
+ *	\param		worldm		[in] model's world matrix, or null
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QuerySphere(const Model& model, const Sphere& sphere, SphereCache& cache, const QuerySettings& settings, const Matrix4x4* worlds, const Matrix4x4* worldm, QueryStats* stats)
+{
+	SphereCollider SC;
+	SetupCollider(SC, settings);
+	bool Status = SC.Collide(cache, sphere, model, worlds, worldm);
+	GetVolumeStats(SC, stats);
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	AABB-vs-model query.
+ *	\param		model		[in] model to query
+ *	\param		box			[in] box in model space
+ *	\param		cache		[in/out] box cache, receives the touched primitives
+ *	\param		settings	[in] query settings
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QueryAABB(const Model& model, const CollisionAABB& box, AABBCache& cache, const QuerySettings& settings, QueryStats* stats)
+{
+	AABBCollider AC;
+	SetupCollider(AC, settings);
+	bool Status = AC.Collide(cache, box, model);
+	GetVolumeStats(AC, stats);
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	OBB-vs-model query.
+ *	\param		model		[in] model to query
+ *	\param		box			[in] box in local space
+ *	\param		cache		[in/out] box cache, receives the touched primitives
+ *	\param		settings	[in] query settings
+ *	\param		worldb		[in] box's world matrix, or null
+ *	\param		worldm		[in] model's world matrix, or null
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QueryOBB(const Model& model, const OBB& box, OBBCache& cache, const QuerySettings& settings, const Matrix4x4* worldb, const Matrix4x4* worldm, QueryStats* stats)
+{
+	OBBCollider OC;
+	SetupCollider(OC, settings);
+	bool Status = OC.Collide(cache, box, model, worldb, worldm);
+	GetVolumeStats(OC, stats);
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	LSS-vs-model query.
+ *	\param		model		[in] model to query
+ *	\param		lss			[in] LSS in local space
+ *	\param		cache		[in/out] LSS cache, receives the touched primitives
+ *	\param		settings	[in] query settings
+ *	\param		worldl		[in] LSS's world matrix, or null
+ *	\param		worldm		[in] model's world matrix, or null
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QueryLSS(const Model& model, const LSS& lss, LSSCache& cache, const QuerySettings& settings, const Matrix4x4* worldl, const Matrix4x4* worldm, QueryStats* stats)
+{
+	LSSCollider LC;
+	SetupCollider(LC, settings);
+	bool Status = LC.Collide(cache, lss, model, worldl, worldm);
+	GetVolumeStats(LC, stats);
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Planes-vs-model query.
+ *	\param		model		[in] model to query
+ *	\param		planes		[in] planes in world space
+ *	\param		nb_planes	[in] number of planes
+ *	\param		cache		[in/out] planes cache, receives the touched primitives
+ *	\param		settings	[in] query settings
+ *	\param		worldm		[in] model's world matrix, or null
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QueryPlanes(const Model& model, const Plane* planes, udword nb_planes, PlanesCache& cache, const QuerySettings& settings, const Matrix4x4* worldm, QueryStats* stats)
+{
+	PlanesCollider PC;
+	SetupCollider(PC, settings);
+	bool Status = PC.Collide(cache, planes, nb_planes, model, worldm);
+	GetVolumeStats(PC, stats);
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Ray-vs-model query.
+ *	\param		model		[in] model to query
+ *	\param		world_ray	[in] ray in world space
+ *	\param		faces		[out] receives the stabbed faces
+ *	\param		settings	[in] query settings
+ *	\param		world		[in] model's world matrix, or null
+ *	\param		cache		[in/out] temporal coherence cache, or null
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QueryRay(const Model& model, const Ray& world_ray, CollisionFaces& faces, const QuerySettings& settings, const Matrix4x4* world, udword* cache, QueryStats* stats)
+{
+	RayCollider RC;
+	SetupRayCollider(RC, settings);
+	RC.SetDestination(&faces);
+	bool Status = RC.Collide(world_ray, model, world, cache);
+	GetRayStats(RC, stats);
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Ray packet-vs-model query.
+ *	\param		model		[in] model to query
+ *	\param		nb_rays		[in] number of rays
+ *	\param		world_rays	[in] rays in world space
+ *	\param		closest_hits	[out] one closest hit per ray, with mFaceID = INVALID_ID when the ray doesn't hit
+ *	\param		settings	[in] query settings
+ *	\param		world		[in] model's world matrix, or null
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QueryRays(const Model& model, udword nb_rays, const Ray* world_rays, CollisionFace* closest_hits, const QuerySettings& settings, const Matrix4x4* world, QueryStats* stats)
+{
+	RayCollider RC;
+	SetupRayCollider(RC, settings);
+	bool Status = RC.Collide(nb_rays, world_rays, model, closest_hits, world);
+	GetRayStats(RC, stats);
+	return Status;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Tree-vs-tree query.
+ *	\param		cache		[in/out] models and temporal coherence cache
+ *	\param		pairs		[out] receives the colliding pairs, as (id0, id1) couples of entries
+ *	\param		settings	[in] query settings
+ *	\param		world0		[in] world matrix for first object, or null
+ *	\param		world1		[in] world matrix for second object, or null
+ *	\param		stats		[out] query stats, or null
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Opcode::QueryTrees(BVTCache& cache, Container& pairs, const QuerySettings& settings, const Matrix4x4* world0, const Matrix4x4* world1, QueryStats* stats)
+{
+	AABBTreeCollider TC;
+	SetupCollider(TC, settings);
+	bool Status = TC.Collide(cache, world0, world1);
+	pairs.Reset();
+	if(Status)	pairs.Add((const udword*)TC.GetPairs(), TC.GetNbPairs()*2);
+	if(stats)
+	{
+		stats->mNbBVTests	= TC.GetNbBVBVTests();
+		stats->mNbPrimTests	= TC.GetNbPrimPrimTests() + TC.GetNbBVPrimTests();
+	}
+	return Status;
+}
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains reentrant query functions.
+ *	\file		OPC_Query.h
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Include Guard
+#ifndef __OPC_QUERY_H__
+#define __OPC_QUERY_H__
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/**
+	 *	Query settings. They are only read by the queries, so a single instance can be shared by any number of threads.
+	 *
+	 *	\class		QuerySettings
+	 *	\version	1.3
+	 *	\date		October, 18, 2026
+	 */
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	struct OPCODE_API QuerySettings
+	{
+		//! Constructor
+		inline_			QuerySettings() : mFirstContact(false), mTemporalCoherence(false), mClosestHit(false), mCulling(true), mMaxDist(MAX_FLOAT)	{}
+
+				bool	mFirstContact;		//!< Stop at first contact
+				bool	mTemporalCoherence;	//!< Use the caller's cache to exploit temporal coherence
+				bool	mClosestHit;		//!< Rays only: keep the closest hit only
+				bool	mCulling;			//!< Rays only: backface culling
+				float	mMaxDist;			//!< Rays only: max distance for segment queries
+	};
+
+	//! Query statistics, filled by the query when the caller provides them
+	struct OPCODE_API QueryStats
+	{
+		//! Constructor
+		inline_			QueryStats() : mNbBVTests(0), mNbPrimTests(0)	{}
+
+				udword	mNbBVTests;			//!< Number of bounding volume tests
+				udword	mNbPrimTests;		//!< Number of primitive tests
+	};
+
+	// Each query runs on a collider built on the stack, and writes its results to the caller's cache or sink. Models
+	// are only read, so several threads can query the same model at once as long as they don't share caches or sinks.
+	OPCODE_API	bool QuerySphere	(const Model& model, const Sphere& sphere, SphereCache& cache, const QuerySettings& settings, const Matrix4x4* worlds=null, const Matrix4x4* worldm=null, QueryStats* stats=null);
+	OPCODE_API	bool QueryAABB		(const Model& model, const CollisionAABB& box, AABBCache& cache, const QuerySettings& settings, QueryStats* stats=null);
+	OPCODE_API	bool QueryOBB		(const Model& model, const OBB& box, OBBCache& cache, const QuerySettings& settings, const Matrix4x4* worldb=null, const Matrix4x4* worldm=null, QueryStats* stats=null);
+	OPCODE_API	bool QueryLSS		(const Model& model, const LSS& lss, LSSCache& cache, const QuerySettings& settings, const Matrix4x4* worldl=null, const Matrix4x4* worldm=null, QueryStats* stats=null);
+	OPCODE_API	bool QueryPlanes	(const Model& model, const Plane* planes, udword nb_planes, PlanesCache& cache, const QuerySettings& settings, const Matrix4x4* worldm=null, QueryStats* stats=null);
+	OPCODE_API	bool QueryRay		(const Model& model, const Ray& world_ray, CollisionFaces& faces, const QuerySettings& settings, const Matrix4x4* world=null, udword* cache=null, QueryStats* stats=null);
+	OPCODE_API	bool QueryRays		(const Model& model, udword nb_rays, const Ray* world_rays, CollisionFace* closest_hits, const QuerySettings& settings, const Matrix4x4* world=null, QueryStats* stats=null);
+	OPCODE_API	bool QueryTrees		(BVTCache& cache, Container& pairs, const QuerySettings& settings, const Matrix4x4* world0=null, const Matrix4x4* world1=null, QueryStats* stats=null);
+
+#endif // __OPC_QUERY_H__
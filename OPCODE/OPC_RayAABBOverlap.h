@@ -61,3 +61,125 @@ inline_ BOOL RayCollider::RayAABBOverlap(const Point& center, const Point& exten
 
 	return TRUE;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes segment-AABB overlap tests for the children of a wide node at once, with SSE. Same test as SegmentAABBOverlap.
+ *	\param		node	[in] wide node
+ *	\return		overlapping children, bit i for child i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ udword RayCollider::SegmentWideOverlap(const AABBWideNode* node)
+{
+	// Stats
+	udword NbChildren = node->GetNbChildren();
+	mNbRayBVTests += NbChildren;
+
+	const __m128 SignMask = _mm_set1_ps(-0.0f);
+	const __m128 Ex = _mm_loadu_ps(node->mExtentsX);
+	const __m128 Ey = _mm_loadu_ps(node->mExtentsY);
+	const __m128 Ez = _mm_loadu_ps(node->mExtentsZ);
+	const __m128 FDx = _mm_set1_ps(mFDir.x);
+	const __m128 FDy = _mm_set1_ps(mFDir.y);
+	const __m128 FDz = _mm_set1_ps(mFDir.z);
+
+	__m128 Dx = _mm_sub_ps(_mm_set1_ps(mData2.x), _mm_loadu_ps(node->mCenterX));
+	__m128 Dy = _mm_sub_ps(_mm_set1_ps(mData2.y), _mm_loadu_ps(node->mCenterY));
+	__m128 Dz = _mm_sub_ps(_mm_set1_ps(mData2.z), _mm_loadu_ps(node->mCenterZ));
+	__m128 Out =			_mm_cmpgt_ps(_mm_andnot_ps(SignMask, Dx), _mm_add_ps(Ex, FDx));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, Dy), _mm_add_ps(Ey, FDy)));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, Dz), _mm_add_ps(Ez, FDz)));
+
+	__m128 f;
+	f = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(mData.y), Dz), _mm_mul_ps(_mm_set1_ps(mData.z), Dy));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, f), _mm_add_ps(_mm_mul_ps(Ey, FDz), _mm_mul_ps(Ez, FDy))));
+	f = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(mData.z), Dx), _mm_mul_ps(_mm_set1_ps(mData.x), Dz));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, f), _mm_add_ps(_mm_mul_ps(Ex, FDz), _mm_mul_ps(Ez, FDx))));
+	f = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(mData.x), Dy), _mm_mul_ps(_mm_set1_ps(mData.y), Dx));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, f), _mm_add_ps(_mm_mul_ps(Ex, FDy), _mm_mul_ps(Ey, FDx))));
+
+	return ~_mm_movemask_ps(Out) & ((1<<NbChildren)-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes ray-AABB overlap tests for the children of a wide node at once, with SSE. Same test as RayAABBOverlap.
+ *	\param		node	[in] wide node
+ *	\return		overlapping children, bit i for child i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ udword RayCollider::RayWideOverlap(const AABBWideNode* node)
+{
+	// Stats
+	udword NbChildren = node->GetNbChildren();
+	mNbRayBVTests += NbChildren;
+
+	const __m128 SignMask = _mm_set1_ps(-0.0f);
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 Ex = _mm_loadu_ps(node->mExtentsX);
+	const __m128 Ey = _mm_loadu_ps(node->mExtentsY);
+	const __m128 Ez = _mm_loadu_ps(node->mExtentsZ);
+	const __m128 DirX = _mm_set1_ps(mDir.x);
+	const __m128 DirY = _mm_set1_ps(mDir.y);
+	const __m128 DirZ = _mm_set1_ps(mDir.z);
+	const __m128 FDx = _mm_set1_ps(mFDir.x);
+	const __m128 FDy = _mm_set1_ps(mFDir.y);
+	const __m128 FDz = _mm_set1_ps(mFDir.z);
+
+	__m128 Dx = _mm_sub_ps(_mm_set1_ps(mOrigin.x), _mm_loadu_ps(node->mCenterX));
+	__m128 Dy = _mm_sub_ps(_mm_set1_ps(mOrigin.y), _mm_loadu_ps(node->mCenterY));
+	__m128 Dz = _mm_sub_ps(_mm_set1_ps(mOrigin.z), _mm_loadu_ps(node->mCenterZ));
+	__m128 Out =			_mm_and_ps(_mm_cmpgt_ps(_mm_andnot_ps(SignMask, Dx), Ex), _mm_cmpge_ps(_mm_mul_ps(Dx, DirX), Zero));
+	Out = _mm_or_ps(Out,	_mm_and_ps(_mm_cmpgt_ps(_mm_andnot_ps(SignMask, Dy), Ey), _mm_cmpge_ps(_mm_mul_ps(Dy, DirY), Zero)));
+	Out = _mm_or_ps(Out,	_mm_and_ps(_mm_cmpgt_ps(_mm_andnot_ps(SignMask, Dz), Ez), _mm_cmpge_ps(_mm_mul_ps(Dz, DirZ), Zero)));
+
+	__m128 f;
+	f = _mm_sub_ps(_mm_mul_ps(DirY, Dz), _mm_mul_ps(DirZ, Dy));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, f), _mm_add_ps(_mm_mul_ps(Ey, FDz), _mm_mul_ps(Ez, FDy))));
+	f = _mm_sub_ps(_mm_mul_ps(DirZ, Dx), _mm_mul_ps(DirX, Dz));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, f), _mm_add_ps(_mm_mul_ps(Ex, FDz), _mm_mul_ps(Ez, FDx))));
+	f = _mm_sub_ps(_mm_mul_ps(DirX, Dy), _mm_mul_ps(DirY, Dx));
+	Out = _mm_or_ps(Out,	_mm_cmpgt_ps(_mm_andnot_ps(SignMask, f), _mm_add_ps(_mm_mul_ps(Ex, FDy), _mm_mul_ps(Ey, FDx))));
+
+	return ~_mm_movemask_ps(Out) & ((1<<NbChildren)-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes packet-AABB overlap tests for the rays of the current packet, 4 at a time with SSE. Slab test, clipped to the
+ *	closest hit of each ray so far.
+ *	\param		center	[in] AABB center
+ *	\param		extents	[in] AABB extents
+ *	\param		active	[in] rays to test, bit i for ray i
+ *	\return		overlapping rays, bit i for ray i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ udword RayCollider::PacketAABBOverlap(const Point& center, const Point& extents, udword active)
+{
+	// Stats
+	mNbRayBVTests++;
+
+	const __m128 Min[3] = { _mm_set1_ps(center.x - extents.x), _mm_set1_ps(center.y - extents.y), _mm_set1_ps(center.z - extents.z) };
+	const __m128 Max[3] = { _mm_set1_ps(center.x + extents.x), _mm_set1_ps(center.y + extents.y), _mm_set1_ps(center.z + extents.z) };
+
+	// 4 rays at a time
+	udword Overlaps = 0;
+	for(udword i=0;i<OPC_RAY_PACKET_SIZE;i+=4)
+	{
+		if(!((active>>i)&15))	continue;
+
+		__m128 Near = _mm_setzero_ps();
+		__m128 Far = _mm_loadu_ps(mPacketMaxDist+i);
+		for(udword j=0;j<3;j++)
+		{
+			const __m128 Origin = _mm_loadu_ps(mPacketOrigin[j]+i);
+			const __m128 InvDir = _mm_loadu_ps(mPacketInvDir[j]+i);
+			const __m128 T0 = _mm_mul_ps(_mm_sub_ps(Min[j], Origin), InvDir);
+			const __m128 T1 = _mm_mul_ps(_mm_sub_ps(Max[j], Origin), InvDir);
+			Near = _mm_max_ps(Near, _mm_min_ps(T0, T1));
+			Far = _mm_min_ps(Far, _mm_max_ps(T0, T1));
+		}
+		Overlaps |= _mm_movemask_ps(_mm_cmple_ps(Near, Far))<<i;
+	}
+	return Overlaps & active;
+}
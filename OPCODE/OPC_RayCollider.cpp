@@ -114,6 +114,8 @@
 // Precompiled Header
 #include "Stdafx.h"
 
+#include <xmmintrin.h>
+
 using namespace Opcode;
 
 #include "OPC_RayAABBOverlap.h"
@@ -173,14 +175,14 @@ using namespace Opcode;
 
 #define SEGMENT_PRIM(prim_index, flag)														\
 	/* Request vertices from the app */														\
-	VertexPointers VP;	mIMesh->GetTriangle(VP, prim_index);								\
+	VertexPointers VP;	ConversionArea VC;	mIMesh->GetTriangle(VP, prim_index, VC);			\
 																							\
 	/* Perform ray-tri overlap test and return */											\
 	if(RayTriOverlap(*VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]))							\
 	{																						\
 		/* Intersection point is valid if dist < segment's length */						\
-		/* We know dist>0 so we can use integers */											\
-		if(IR(mStabbedFace.mDistance)<IR(mMaxDist))											\
+		/* We know dist>0 */																\
+		if(mStabbedFace.mDistance<mMaxDist)													\
 		{																					\
 			HANDLE_CONTACT(prim_index, flag)												\
 		}																					\
@@ -188,7 +190,7 @@ using namespace Opcode;
 
 #define RAY_PRIM(prim_index, flag)															\
 	/* Request vertices from the app */														\
-	VertexPointers VP;	mIMesh->GetTriangle(VP, prim_index);								\
+	VertexPointers VP;	ConversionArea VC;	mIMesh->GetTriangle(VP, prim_index, VC);			\
 																							\
 	/* Perform ray-tri overlap test and return */											\
 	if(RayTriOverlap(*VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]))							\
@@ -196,6 +198,15 @@ using namespace Opcode;
 		HANDLE_CONTACT(prim_index, flag)													\
 	}
 
+#define PACKET_PRIM(prim_index, active)													\
+	{																						\
+		/* Request vertices from the app */													\
+		VertexPointers VP;	ConversionArea VC;	mIMesh->GetTriangle(VP, prim_index, VC);		\
+																							\
+		/* Perform packet-tri overlap test, which records closest hits */				\
+		PacketTriOverlap(*VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2], prim_index, active);	\
+	}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
@@ -203,18 +214,20 @@ using namespace Opcode;
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 RayCollider::RayCollider() :
-	mNbRayBVTests		(0),
-	mNbRayPrimTests		(0),
-	mNbIntersections	(0),
-	mCulling			(true),
 #ifdef OPC_RAYHIT_CALLBACK
 	mHitCallback		(null),
 	mUserData			(0),
 #else
-	mClosestHit			(false),
 	mStabbedFaces		(null),
 #endif
-	mMaxDist			(MAX_FLOAT)
+	mNbRayBVTests		(0),
+	mNbRayPrimTests		(0),
+	mNbIntersections	(0),
+	mMaxDist			(MAX_FLOAT),
+#ifndef OPC_RAYHIT_CALLBACK
+	mClosestHit			(false),
+#endif
+	mCulling			(true)
 {
 }
 
@@ -267,7 +280,15 @@ bool RayCollider::Collide(const Ray& world_ray, const Model& model, const Matrix
 	// Init collision query
 	if(InitQuery(world_ray, world, cache))	return true;
 
-	if(!model.HasLeafNodes())
+	if(model.IsWide())
+	{
+		const AABBWideTree* Tree = (const AABBWideTree*)model.GetTree();
+
+		// Perform stabbing query
+		if(mMaxDist!=MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
+		else								_RayStab(Tree->GetNodes());
+	}
+	else if(!model.HasLeafNodes())
 	{
 		if(model.IsQuantized())
 		{
@@ -278,7 +299,7 @@ bool RayCollider::Collide(const Ray& world_ray, const Model& model, const Matrix
 			mExtentsCoeff	= Tree->mExtentsCoeff;
 
 			// Perform stabbing query
-			if(IR(mMaxDist)!=IEEE_MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
+			if(mMaxDist!=MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
 			else								_RayStab(Tree->GetNodes());
 		}
 		else
@@ -286,7 +307,7 @@ bool RayCollider::Collide(const Ray& world_ray, const Model& model, const Matrix
 			const AABBNoLeafTree* Tree = (const AABBNoLeafTree*)model.GetTree();
 
 			// Perform stabbing query
-			if(IR(mMaxDist)!=IEEE_MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
+			if(mMaxDist!=MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
 			else								_RayStab(Tree->GetNodes());
 		}
 	}
@@ -301,7 +322,7 @@ bool RayCollider::Collide(const Ray& world_ray, const Model& model, const Matrix
 			mExtentsCoeff	= Tree->mExtentsCoeff;
 
 			// Perform stabbing query
-			if(IR(mMaxDist)!=IEEE_MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
+			if(mMaxDist!=MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
 			else								_RayStab(Tree->GetNodes());
 		}
 		else
@@ -309,7 +330,7 @@ bool RayCollider::Collide(const Ray& world_ray, const Model& model, const Matrix
 			const AABBCollisionTree* Tree = (const AABBCollisionTree*)model.GetTree();
 
 			// Perform stabbing query
-			if(IR(mMaxDist)!=IEEE_MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
+			if(mMaxDist!=MAX_FLOAT)	_SegmentStab(Tree->GetNodes());
 			else								_RayStab(Tree->GetNodes());
 		}
 	}
@@ -388,7 +409,8 @@ BOOL RayCollider::InitQuery(const Ray& world_ray, const Matrix4x4* world, udword
 		{
 			// Request vertices from the app
 			VertexPointers VP;
-			mIMesh->GetTriangle(VP, *face_id);
+			ConversionArea VC;
+			mIMesh->GetTriangle(VP, *face_id, VC);
 			// Perform ray-cached tri overlap test
 			if(RayTriOverlap(*VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]))
 			{
@@ -396,7 +418,7 @@ BOOL RayCollider::InitQuery(const Ray& world_ray, const Matrix4x4* world, udword
 				// - distance is positive (else it can just be a face behind the orig point)
 				// - distance is smaller than a given max distance (useful for shadow feelers)
 //				if(mStabbedFace.mDistance>0.0f && mStabbedFace.mDistance<mMaxDist)
-				if(IR(mStabbedFace.mDistance)<IR(mMaxDist))	// The other test is already performed in RayTriOverlap
+				if(mStabbedFace.mDistance<mMaxDist)	// The other test is already performed in RayTriOverlap
 				{
 					// Set contact status
 					mFlags |= OPC_TEMPORAL_CONTACT;
@@ -421,7 +443,7 @@ BOOL RayCollider::InitQuery(const Ray& world_ray, const Matrix4x4* world, udword
 	}
 
 	// Precompute data (moved after temporal coherence since only needed for ray-AABB)
-	if(IR(mMaxDist)!=IEEE_MAX_FLOAT)
+	if(mMaxDist!=MAX_FLOAT)
 	{
 		// For Segment-AABB overlap
 		mData = 0.5f * mDir * mMaxDist;
@@ -477,12 +499,134 @@ bool RayCollider::Collide(const Ray& world_ray, const AABBTree* tree, Container&
 	if(InitQuery(world_ray))	return true;
 
 	// Perform stabbing query
-	if(IR(mMaxDist)!=IEEE_MAX_FLOAT)	_SegmentStab(tree, box_indices);
+	if(mMaxDist!=MAX_FLOAT)	_SegmentStab(tree, box_indices);
 	else								_RayStab(tree, box_indices);
 
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Packet stabbing query for generic OPCODE models: closest hits of many rays, traced 4 at a time with SSE.
+ *
+ *	\param		nb_rays			[in] number of rays
+ *	\param		world_rays		[in] stabbing rays in world space
+ *	\param		model			[in] Opcode model to collide with
+ *	\param		closest_hits	[out] closest hit of each ray. mFaceID is INVALID_ID if the ray hits nothing.
+ *	\param		world			[in] model's world matrix, or null
+ *	\return		true if success
+ *	\warning	SCALE NOT SUPPORTED. The matrices must contain rotation & translation parts only.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool RayCollider::Collide(udword nb_rays, const Ray* world_rays, const Model& model, CollisionFace* closest_hits, const Matrix4x4* world)
+{
+	// Checkings
+	if(!Setup(&model))					return false;
+	if(!world_rays || !closest_hits)	return false;
+
+	// Reset stats & contact status
+	Collider::InitQuery();
+	mNbRayBVTests		= 0;
+	mNbRayPrimTests		= 0;
+	mNbIntersections	= 0;
+
+	// Rays go to local space like in InitQuery()
+	Matrix3x3 InvWorld;
+	Matrix4x4 World;
+	if(world)
+	{
+		InvWorld = *world;
+		InvertPRMatrix(World, *world);
+	}
+	else
+	{
+		InvWorld.Identity();
+		World.Identity();
+	}
+
+	// Setup dequantization coeffs
+	const AABBOptimizedTree* Tree = model.GetTree();
+	if(!model.IsWide() && model.IsQuantized())
+	{
+		if(!model.HasLeafNodes())
+		{
+			mCenterCoeff	= ((const AABBQuantizedNoLeafTree*)Tree)->mCenterCoeff;
+			mExtentsCoeff	= ((const AABBQuantizedNoLeafTree*)Tree)->mExtentsCoeff;
+		}
+		else
+		{
+			mCenterCoeff	= ((const AABBQuantizedTree*)Tree)->mCenterCoeff;
+			mExtentsCoeff	= ((const AABBQuantizedTree*)Tree)->mExtentsCoeff;
+		}
+	}
+
+	for(udword Base=0;Base<nb_rays;Base+=OPC_RAY_PACKET_SIZE)
+	{
+		// Setup the packet. Lanes past the last ray are done from the start.
+		udword Active = 0;
+		mPacketHits = closest_hits + Base;
+		mPacketDirSum.Zero();
+		for(udword i=0;i<OPC_RAY_PACKET_SIZE;i++)
+		{
+			Point Origin(0.0f, 0.0f, 0.0f), Dir(0.0f, 0.0f, 0.0f);
+			mPacketMaxDist[i] = -1.0f;
+			if(Base+i<nb_rays)
+			{
+				if(world)
+				{
+					Dir		= InvWorld * world_rays[Base+i].mDir;
+					Origin	= world_rays[Base+i].mOrig * World;
+				}
+				else
+				{
+					Dir		= world_rays[Base+i].mDir;
+					Origin	= world_rays[Base+i].mOrig;
+				}
+				mPacketMaxDist[i] = mMaxDist;
+				mPacketDirSum += Dir;
+				Active |= 1<<i;
+
+				mPacketHits[i].mFaceID		= INVALID_ID;
+				mPacketHits[i].mDistance	= MAX_FLOAT;
+				mPacketHits[i].mU			= 0.0f;
+				mPacketHits[i].mV			= 0.0f;
+			}
+			for(udword j=0;j<3;j++)
+			{
+				mPacketOrigin[j][i]	= Origin[j];
+				mPacketDir[j][i]	= Dir[j];
+				// Keep slab tests finite when the ray is parallel to a slab
+				float d = Dir[j];
+				if(fabsf(d)<1.0e-20f)	d = d<0.0f ? -1.0e-20f : 1.0e-20f;
+				mPacketInvDir[j][i]	= 1.0f / d;
+			}
+		}
+
+		// Perform stabbing query
+		if(model.HasSingleNode())
+		{
+			PACKET_PRIM(udword(0), Active)
+		}
+		else if(model.IsWide())		_PacketStab(((const AABBWideTree*)Tree)->GetNodes(), Active);
+		else if(!model.HasLeafNodes())
+		{
+			if(model.IsQuantized())	_PacketStab(((const AABBQuantizedNoLeafTree*)Tree)->GetNodes(), Active);
+			else					_PacketStab(((const AABBNoLeafTree*)Tree)->GetNodes(), Active);
+		}
+		else
+		{
+			if(model.IsQuantized())	_PacketStab(((const AABBQuantizedTree*)Tree)->GetNodes(), Active);
+			else					_PacketStab(((const AABBCollisionTree*)Tree)->GetNodes(), Active);
+		}
+
+		for(udword i=0;i<OPC_RAY_PACKET_SIZE && Base+i<nb_rays;i++)
+		{
+			if(mPacketHits[i].mFaceID!=INVALID_ID)	mNbIntersections++;
+		}
+	}
+	return true;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
@@ -596,6 +740,31 @@ void RayCollider::_SegmentStab(const AABBQuantizedNoLeafNode* node)
 	else _SegmentStab(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive stabbing query for wide AABB trees.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_SegmentStab(const AABBWideNode* node)
+{
+	// Perform Segment-AABB overlap tests on all children
+	udword Overlaps = SegmentWideOverlap(node);
+
+	for(udword i=0;i<OPC_WIDE_NODE_SIZE;i++)
+	{
+		if(!(Overlaps & (1<<i)))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			SEGMENT_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+		}
+		else _SegmentStab(node->GetChild(i));
+
+		if(ContactFound()) return;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive stabbing query for vanilla AABB trees.
@@ -734,6 +903,31 @@ void RayCollider::_RayStab(const AABBQuantizedNoLeafNode* node)
 	else _RayStab(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive stabbing query for wide AABB trees.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_RayStab(const AABBWideNode* node)
+{
+	// Perform Ray-AABB overlap tests on all children
+	udword Overlaps = RayWideOverlap(node);
+
+	for(udword i=0;i<OPC_WIDE_NODE_SIZE;i++)
+	{
+		if(!(Overlaps & (1<<i)))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			RAY_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+		}
+		else _RayStab(node->GetChild(i));
+
+		if(ContactFound()) return;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive stabbing query for vanilla AABB trees.
@@ -760,3 +954,188 @@ void RayCollider::_RayStab(const AABBTreeNode* node, Container& box_indices)
 		_RayStab(node->GetNeg(), box_indices);
 	}
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for normal AABB trees.
+ *	\param		node	[in] current collision node
+ *	\param		active	[in] rays still overlapping the parent node, bit i for ray i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_PacketStab(const AABBCollisionNode* node, udword active)
+{
+	// Perform packet-AABB overlap test
+	active = PacketAABBOverlap(node->mAABB.mCenter, node->mAABB.mExtents, active);
+	if(!active)	return;
+
+	if(node->IsLeaf())
+	{
+		PACKET_PRIM(node->GetPrimitive(), active)
+	}
+	else
+	{
+		// Closest child first, so that rays get shorter sooner
+		const AABBCollisionNode* First = node->GetPos();
+		const AABBCollisionNode* Second = node->GetNeg();
+		if(((Second->mAABB.mCenter - First->mAABB.mCenter)|mPacketDirSum)<0.0f)	TSwap(First, Second);
+
+		_PacketStab(First, active);
+		_PacketStab(Second, active);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for quantized AABB trees.
+ *	\param		node	[in] current collision node
+ *	\param		active	[in] rays still overlapping the parent node, bit i for ray i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_PacketStab(const AABBQuantizedNode* node, udword active)
+{
+	// Dequantize box
+	const QuantizedAABB& Box = node->mAABB;
+	const Point Center(float(Box.mCenter[0]) * mCenterCoeff.x, float(Box.mCenter[1]) * mCenterCoeff.y, float(Box.mCenter[2]) * mCenterCoeff.z);
+	const Point Extents(float(Box.mExtents[0]) * mExtentsCoeff.x, float(Box.mExtents[1]) * mExtentsCoeff.y, float(Box.mExtents[2]) * mExtentsCoeff.z);
+
+	// Perform packet-AABB overlap test
+	active = PacketAABBOverlap(Center, Extents, active);
+	if(!active)	return;
+
+	if(node->IsLeaf())
+	{
+		PACKET_PRIM(node->GetPrimitive(), active)
+	}
+	else
+	{
+		// Closest child first, so that rays get shorter sooner
+		const AABBQuantizedNode* First = node->GetPos();
+		const AABBQuantizedNode* Second = node->GetNeg();
+		const sword* C0 = First->mAABB.mCenter;
+		const sword* C1 = Second->mAABB.mCenter;
+		const Point Delta(float(C1[0] - C0[0]) * mCenterCoeff.x, float(C1[1] - C0[1]) * mCenterCoeff.y, float(C1[2] - C0[2]) * mCenterCoeff.z);
+		if((Delta|mPacketDirSum)<0.0f)	TSwap(First, Second);
+
+		_PacketStab(First, active);
+		_PacketStab(Second, active);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for no-leaf AABB trees.
+ *	\param		node	[in] current collision node
+ *	\param		active	[in] rays still overlapping the parent node, bit i for ray i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_PacketStab(const AABBNoLeafNode* node, udword active)
+{
+	// Perform packet-AABB overlap test
+	active = PacketAABBOverlap(node->mAABB.mCenter, node->mAABB.mExtents, active);
+	if(!active)	return;
+
+	// Leaves first, they may shorten the rays
+	if(node->HasPosLeaf())
+	{
+		PACKET_PRIM(node->GetPosPrimitive(), active)
+	}
+	if(node->HasNegLeaf())
+	{
+		PACKET_PRIM(node->GetNegPrimitive(), active)
+	}
+
+	// Then the closest child first
+	const AABBNoLeafNode* First = node->HasPosLeaf() ? null : node->GetPos();
+	const AABBNoLeafNode* Second = node->HasNegLeaf() ? null : node->GetNeg();
+	if(First && Second && ((Second->mAABB.mCenter - First->mAABB.mCenter)|mPacketDirSum)<0.0f)	TSwap(First, Second);
+
+	if(First)	_PacketStab(First, active);
+	if(Second)	_PacketStab(Second, active);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for quantized no-leaf AABB trees.
+ *	\param		node	[in] current collision node
+ *	\param		active	[in] rays still overlapping the parent node, bit i for ray i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_PacketStab(const AABBQuantizedNoLeafNode* node, udword active)
+{
+	// Dequantize box
+	const QuantizedAABB& Box = node->mAABB;
+	const Point Center(float(Box.mCenter[0]) * mCenterCoeff.x, float(Box.mCenter[1]) * mCenterCoeff.y, float(Box.mCenter[2]) * mCenterCoeff.z);
+	const Point Extents(float(Box.mExtents[0]) * mExtentsCoeff.x, float(Box.mExtents[1]) * mExtentsCoeff.y, float(Box.mExtents[2]) * mExtentsCoeff.z);
+
+	// Perform packet-AABB overlap test
+	active = PacketAABBOverlap(Center, Extents, active);
+	if(!active)	return;
+
+	// Leaves first, they may shorten the rays
+	if(node->HasPosLeaf())
+	{
+		PACKET_PRIM(node->GetPosPrimitive(), active)
+	}
+	if(node->HasNegLeaf())
+	{
+		PACKET_PRIM(node->GetNegPrimitive(), active)
+	}
+
+	// Then the closest child first
+	const AABBQuantizedNoLeafNode* First = node->HasPosLeaf() ? null : node->GetPos();
+	const AABBQuantizedNoLeafNode* Second = node->HasNegLeaf() ? null : node->GetNeg();
+	if(First && Second)
+	{
+		const sword* C0 = First->mAABB.mCenter;
+		const sword* C1 = Second->mAABB.mCenter;
+		const Point Delta(float(C1[0] - C0[0]) * mCenterCoeff.x, float(C1[1] - C0[1]) * mCenterCoeff.y, float(C1[2] - C0[2]) * mCenterCoeff.z);
+		if((Delta|mPacketDirSum)<0.0f)	TSwap(First, Second);
+	}
+
+	if(First)	_PacketStab(First, active);
+	if(Second)	_PacketStab(Second, active);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for wide AABB trees.
+ *	\param		node	[in] current collision node
+ *	\param		active	[in] rays still overlapping the parent node, bit i for ray i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_PacketStab(const AABBWideNode* node, udword active)
+{
+	// Perform packet-AABB overlap tests on all children
+	udword NbChildren = node->GetNbChildren();
+	udword Overlaps[OPC_WIDE_NODE_SIZE];
+	udword Order[OPC_WIDE_NODE_SIZE];
+	float Keys[OPC_WIDE_NODE_SIZE];
+	for(udword i=0;i<NbChildren;i++)
+	{
+		Point Center, Extents;
+		node->GetCenter(i, Center);
+		node->GetExtents(i, Extents);
+		Overlaps[i] = PacketAABBOverlap(Center, Extents, active);
+
+		// Sort children front to back
+		udword j = i;
+		Keys[i] = Center|mPacketDirSum;
+		while(j && Keys[Order[j-1]]>Keys[i])
+		{
+			Order[j] = Order[j-1];
+			j--;
+		}
+		Order[j] = i;
+	}
+
+	// Leaves first, they may shorten the rays
+	for(udword i=0;i<NbChildren;i++)
+	{
+		if(Overlaps[i] && node->IsLeaf(i))	PACKET_PRIM(node->GetPrimitive(i), Overlaps[i])
+	}
+	for(udword k=0;k<NbChildren;k++)
+	{
+		udword i = Order[k];
+		if(Overlaps[i] && !node->IsLeaf(i))	_PacketStab(node->GetChild(i), Overlaps[i]);
+	}
+}
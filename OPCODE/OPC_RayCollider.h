@@ -60,6 +60,9 @@
 	typedef void	(*HitCallback)	(const CollisionFace& hit, void* user_data);
 #endif
 
+	//! Number of rays traced together by packet queries
+	#define OPC_RAY_PACKET_SIZE	4
+
 	class OPCODE_API RayCollider : public Collider
 	{
 		public:
@@ -84,6 +87,27 @@
 							bool			Collide(const Ray& world_ray, const Model& model, const Matrix4x4* world=null, udword* cache=null);
 		//
 							bool			Collide(const Ray& world_ray, const AABBTree* tree, Container& box_indices);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Packet stabbing query for generic OPCODE models: closest hits of many rays, traced 4 at a time with SSE. The rays of
+		 *	a packet share the tree traversal, and each one stops visiting boxes beyond its closest hit so far. Packets work
+		 *	best with coherent rays, i.e. rays from nearby origins in similar directions, such as rays from an eye through
+		 *	neighboring pixels.
+		 *
+		 *	Closest hit mode is implied. In "first contact" mode each ray stops at its first hit instead. Temporal coherence
+		 *	is not used.
+		 *
+		 *	\param		nb_rays			[in] number of rays
+		 *	\param		world_rays		[in] stabbing rays in world space
+		 *	\param		model			[in] Opcode model to collide with
+		 *	\param		closest_hits	[out] closest hit of each ray. mFaceID is INVALID_ID if the ray hits nothing.
+		 *	\param		world			[in] model's world matrix, or null
+		 *	\return		true if success
+		 *	\warning	SCALE NOT SUPPORTED. The matrices must contain rotation & translation parts only.
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							bool			Collide(udword nb_rays, const Ray* world_rays, const Model& model, CollisionFace* closest_hits, const Matrix4x4* world=null);
 		// Settings
 
 #ifndef OPC_RAYHIT_CALLBACK
@@ -141,7 +165,7 @@
 		 *	Stats: gets the number of Ray-BV overlap tests after a collision query.
 		 *	\see		GetNbRayPrimTests()
 		 *	\see		GetNbIntersections()
-		 *	\return		the number of Ray-BV tests performed during last query
+		 *	\return		the number of Ray-BV tests performed during last query, or of packet-BV tests for a packet query
 		 */
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		inline_				udword			GetNbRayBVTests()				const	{ return mNbRayBVTests;		}
@@ -151,7 +175,7 @@
 		 *	Stats: gets the number of Ray-Triangle overlap tests after a collision query.
 		 *	\see		GetNbRayBVTests()
 		 *	\see		GetNbIntersections()
-		 *	\return		the number of Ray-Triangle tests performed during last query
+		 *	\return		the number of Ray-Triangle tests performed during last query, or of packet-Triangle tests for a packet query
 		 */
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		inline_				udword			GetNbRayPrimTests()				const	{ return mNbRayPrimTests;	}
@@ -162,7 +186,7 @@
 		 *	Stats: gets the number of intersection found after a collision query. Can be used for in/out tests.
 		 *	\see		GetNbRayBVTests()
 		 *	\see		GetNbRayPrimTests()
-		 *	\return		the number of valid intersections during last query
+		 *	\return		the number of valid intersections during last query, or of rays hitting the mesh for a packet query
 		 */
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		inline_				udword			GetNbIntersections()			const	{ return mNbIntersections;	}
@@ -189,6 +213,13 @@
 #else
 							CollisionFaces*	mStabbedFaces;		//!< List of stabbed faces
 #endif
+		// Ray packet in local space, one array per coordinate
+							float			mPacketOrigin[3][OPC_RAY_PACKET_SIZE];	//!< Ray origins
+							float			mPacketDir[3][OPC_RAY_PACKET_SIZE];		//!< Ray directions
+							float			mPacketInvDir[3][OPC_RAY_PACKET_SIZE];	//!< Inverse ray directions, for slab tests
+							float			mPacketMaxDist[OPC_RAY_PACKET_SIZE];	//!< Closest hit so far, or higher distance bound. Negative when done.
+							Point			mPacketDirSum;		//!< Sum of ray directions, to visit children front to back
+							CollisionFace*	mPacketHits;		//!< Closest hits of the current packet
 		// Stats
 							udword			mNbRayBVTests;		//!< Number of Ray-BV tests
 							udword			mNbRayPrimTests;	//!< Number of Ray-Primitive tests
@@ -209,15 +240,26 @@
 							void			_SegmentStab(const AABBQuantizedNode* node);
 							void			_SegmentStab(const AABBQuantizedNoLeafNode* node);
 							void			_SegmentStab(const AABBTreeNode* node, Container& box_indices);
+							void			_SegmentStab(const AABBWideNode* node);
 							void			_RayStab(const AABBCollisionNode* node);
 							void			_RayStab(const AABBNoLeafNode* node);
 							void			_RayStab(const AABBQuantizedNode* node);
 							void			_RayStab(const AABBQuantizedNoLeafNode* node);
 							void			_RayStab(const AABBTreeNode* node, Container& box_indices);
+							void			_RayStab(const AABBWideNode* node);
+							void			_PacketStab(const AABBCollisionNode* node, udword active);
+							void			_PacketStab(const AABBNoLeafNode* node, udword active);
+							void			_PacketStab(const AABBQuantizedNode* node, udword active);
+							void			_PacketStab(const AABBQuantizedNoLeafNode* node, udword active);
+							void			_PacketStab(const AABBWideNode* node, udword active);
 			// Overlap tests
 		inline_				BOOL			RayAABBOverlap(const Point& center, const Point& extents);
 		inline_				BOOL			SegmentAABBOverlap(const Point& center, const Point& extents);
+		inline_				udword			RayWideOverlap(const AABBWideNode* node);
+		inline_				udword			SegmentWideOverlap(const AABBWideNode* node);
+		inline_				udword			PacketAABBOverlap(const Point& center, const Point& extents, udword active);
 		inline_				BOOL			RayTriOverlap(const Point& vert0, const Point& vert1, const Point& vert2);
+		inline_				void			PacketTriOverlap(const Point& vert0, const Point& vert1, const Point& vert2, udword prim_index, udword active);
 			// Init methods
 							BOOL			InitQuery(const Ray& world_ray, const Matrix4x4* world=null, udword* face_id=null);
 	};
@@ -87,3 +87,95 @@ inline_ BOOL RayCollider::RayTriOverlap(const Point& vert0, const Point& vert1,
 	}
 	return TRUE;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes ray-triangle intersection tests for the rays of the current packet, 4 at a time with SSE. Same test as
+ *	RayTriOverlap. Rays hitting the triangle closer than their closest hit so far record it in mPacketHits.
+ *
+ *	\param		vert0		[in] triangle vertex
+ *	\param		vert1		[in] triangle vertex
+ *	\param		vert2		[in] triangle vertex
+ *	\param		prim_index	[in] triangle index
+ *	\param		active		[in] rays to test, bit i for ray i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ void RayCollider::PacketTriOverlap(const Point& vert0, const Point& vert1, const Point& vert2, udword prim_index, udword active)
+{
+	// Stats
+	mNbRayPrimTests++;
+
+	// Find vectors for two edges sharing vert0
+	const Point edge1 = vert1 - vert0;
+	const Point edge2 = vert2 - vert0;
+	const __m128 E1x = _mm_set1_ps(edge1.x);	const __m128 E1y = _mm_set1_ps(edge1.y);	const __m128 E1z = _mm_set1_ps(edge1.z);
+	const __m128 E2x = _mm_set1_ps(edge2.x);	const __m128 E2y = _mm_set1_ps(edge2.y);	const __m128 E2z = _mm_set1_ps(edge2.z);
+	const __m128 V0x = _mm_set1_ps(vert0.x);	const __m128 V0y = _mm_set1_ps(vert0.y);	const __m128 V0z = _mm_set1_ps(vert0.z);
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 Epsilon = _mm_set1_ps(LOCAL_EPSILON);
+
+	// 4 rays at a time
+	for(udword i=0;i<OPC_RAY_PACKET_SIZE;i+=4)
+	{
+		if(!((active>>i)&15))	continue;
+
+		const __m128 Dx = _mm_loadu_ps(mPacketDir[0]+i);
+		const __m128 Dy = _mm_loadu_ps(mPacketDir[1]+i);
+		const __m128 Dz = _mm_loadu_ps(mPacketDir[2]+i);
+
+		// Begin calculating determinant - also used to calculate U parameter
+		const __m128 Px = _mm_sub_ps(_mm_mul_ps(Dy, E2z), _mm_mul_ps(Dz, E2y));
+		const __m128 Py = _mm_sub_ps(_mm_mul_ps(Dz, E2x), _mm_mul_ps(Dx, E2z));
+		const __m128 Pz = _mm_sub_ps(_mm_mul_ps(Dx, E2y), _mm_mul_ps(Dy, E2x));
+		const __m128 Det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(E1x, Px), _mm_mul_ps(E1y, Py)), _mm_mul_ps(E1z, Pz));
+
+		// If determinant is near zero, ray lies in plane of triangle
+		__m128 Valid;
+		if(mCulling)	Valid = _mm_cmpgt_ps(Det, Epsilon);
+		else			Valid = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), Det), Epsilon);
+		if(!((_mm_movemask_ps(Valid)<<i) & active))	continue;
+		const __m128 OneOverDet = _mm_div_ps(One, Det);
+
+		// Calculate distance from vert0 to ray origin
+		const __m128 Tx = _mm_sub_ps(_mm_loadu_ps(mPacketOrigin[0]+i), V0x);
+		const __m128 Ty = _mm_sub_ps(_mm_loadu_ps(mPacketOrigin[1]+i), V0y);
+		const __m128 Tz = _mm_sub_ps(_mm_loadu_ps(mPacketOrigin[2]+i), V0z);
+
+		// Calculate U parameter and test bounds
+		const __m128 U = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Tx, Px), _mm_mul_ps(Ty, Py)), _mm_mul_ps(Tz, Pz)), OneOverDet);
+		Valid = _mm_and_ps(Valid, _mm_and_ps(_mm_cmpge_ps(U, Zero), _mm_cmple_ps(U, One)));
+
+		// Calculate V parameter and test bounds
+		const __m128 Qx = _mm_sub_ps(_mm_mul_ps(Ty, E1z), _mm_mul_ps(Tz, E1y));
+		const __m128 Qy = _mm_sub_ps(_mm_mul_ps(Tz, E1x), _mm_mul_ps(Tx, E1z));
+		const __m128 Qz = _mm_sub_ps(_mm_mul_ps(Tx, E1y), _mm_mul_ps(Ty, E1x));
+		const __m128 V = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Dx, Qx), _mm_mul_ps(Dy, Qy)), _mm_mul_ps(Dz, Qz)), OneOverDet);
+		Valid = _mm_and_ps(Valid, _mm_and_ps(_mm_cmpge_ps(V, Zero), _mm_cmple_ps(_mm_add_ps(U, V), One)));
+
+		// Calculate t. Intersection point is valid if distance is positive, and closer than the closest hit so far.
+		const __m128 Dist = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(E2x, Qx), _mm_mul_ps(E2y, Qy)), _mm_mul_ps(E2z, Qz)), OneOverDet);
+		Valid = _mm_and_ps(Valid, _mm_and_ps(_mm_cmpge_ps(Dist, Zero), _mm_cmplt_ps(Dist, _mm_loadu_ps(mPacketMaxDist+i))));
+
+		const udword Hits = (_mm_movemask_ps(Valid)<<i) & active;
+		if(!Hits)	continue;
+
+		// Record the hits
+		float HitDist[4], HitU[4], HitV[4];
+		_mm_storeu_ps(HitDist, Dist);
+		_mm_storeu_ps(HitU, U);
+		_mm_storeu_ps(HitV, V);
+		for(udword k=0;k<4;k++)
+		{
+			if(!(Hits & (1<<(i+k))))	continue;
+			CollisionFace& Hit = mPacketHits[i+k];
+			Hit.mFaceID		= prim_index;
+			Hit.mDistance	= HitDist[k];
+			Hit.mU			= HitU[k];
+			Hit.mV			= HitV[k];
+			// In "first contact" mode the ray is done
+			mPacketMaxDist[i+k] = FirstContactEnabled() ? -1.0f : HitDist[k];
+		}
+		mFlags |= OPC_CONTACT;
+	}
+}
@@ -28,6 +28,8 @@
 
 	//! Use epsilon value in tri-tri overlap test
 	#define OPC_TRITRI_EPSILON_TEST
+	//! Batch leaf-leaf triangle tests in the tree collider, and reject them with SSE (comment that line to test pairs one at a time)
+	#define OPC_BATCH_PRIM_TESTS
 
 	//! Use tree-coherence or not [not implemented yet]
 //	#define OPC_USE_TREE_COHERENCE
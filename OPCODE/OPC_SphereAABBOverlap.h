@@ -126,3 +126,32 @@ float Max = center[i] + extents[i];
 #endif
 	return d <= mRadius2;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Sphere-AABB overlap tests for the children of a wide node at once, with SSE. Computes the square distance from
+ *	the sphere center to each box in one pass, instead of the early exits of SphereAABBOverlap.
+ *	\param		node	[in] wide node
+ *	\return		overlapping children, bit i for child i
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ udword SphereCollider::SphereWideOverlap(const AABBWideNode* node)
+{
+	// Stats
+	udword NbChildren = node->GetNbChildren();
+	mNbVolumeBVTests += NbChildren;
+
+	const __m128 SignMask = _mm_set1_ps(-0.0f);
+	const __m128 Zero = _mm_setzero_ps();
+
+	// Distance from the center to each box along each axis, 0 inside the box
+	__m128 sx = _mm_sub_ps(_mm_andnot_ps(SignMask, _mm_sub_ps(_mm_set1_ps(mCenter.x), _mm_loadu_ps(node->mCenterX))), _mm_loadu_ps(node->mExtentsX));
+	__m128 sy = _mm_sub_ps(_mm_andnot_ps(SignMask, _mm_sub_ps(_mm_set1_ps(mCenter.y), _mm_loadu_ps(node->mCenterY))), _mm_loadu_ps(node->mExtentsY));
+	__m128 sz = _mm_sub_ps(_mm_andnot_ps(SignMask, _mm_sub_ps(_mm_set1_ps(mCenter.z), _mm_loadu_ps(node->mCenterZ))), _mm_loadu_ps(node->mExtentsZ));
+	sx = _mm_max_ps(sx, Zero);
+	sy = _mm_max_ps(sy, Zero);
+	sz = _mm_max_ps(sz, Zero);
+
+	__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, sx), _mm_mul_ps(sy, sy)), _mm_mul_ps(sz, sz));
+	return _mm_movemask_ps(_mm_cmple_ps(d, _mm_set1_ps(mRadius2))) & ((1<<NbChildren)-1);
+}
@@ -34,6 +34,8 @@
 // Precompiled Header
 #include "Stdafx.h"
 
+#include <xmmintrin.h>
+
 using namespace Opcode;
 
 #include "OPC_SphereAABBOverlap.h"
@@ -47,7 +49,7 @@ using namespace Opcode;
 //! Sphere-triangle overlap test
 #define SPHERE_PRIM(prim_index, flag)									\
 	/* Request vertices from the app */									\
-	VertexPointers VP;	mIMesh->GetTriangle(VP, prim_index);			\
+	VertexPointers VP;	ConversionArea VC;	mIMesh->GetTriangle(VP, prim_index, VC);	\
 																		\
 	/* Perform sphere-tri overlap test */								\
 	if(SphereTriOverlap(*VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]))	\
@@ -99,7 +101,15 @@ bool SphereCollider::Collide(SphereCache& cache, const Sphere& sphere, const Mod
 	// Init collision query
 	if(InitQuery(cache, sphere, worlds, worldm))	return true;
 
-	if(!model.HasLeafNodes())
+	if(model.IsWide())
+	{
+		const AABBWideTree* Tree = (const AABBWideTree*)model.GetTree();
+
+		// Perform collision query
+		if(SkipPrimitiveTests())	_CollideNoPrimitiveTest(Tree->GetNodes());
+		else						_Collide(Tree->GetNodes());
+	}
+	else if(!model.HasLeafNodes())
 	{
 		if(model.IsQuantized())
 		{
@@ -550,6 +560,80 @@ void SphereCollider::_CollideNoPrimitiveTest(const AABBQuantizedNoLeafNode* node
 	else					_CollideNoPrimitiveTest(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for wide AABB trees.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SphereCollider::_Collide(const AABBWideNode* node)
+{
+	// Perform overlap tests on all children
+	udword Overlaps = SphereWideOverlap(node);
+
+	for(udword i=0;i<OPC_WIDE_NODE_SIZE;i++)
+	{
+		if(!(Overlaps & (1<<i)))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			SPHERE_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+		}
+		else
+		{
+			Point Center, Extents;
+			node->GetCenter(i, Center);
+			node->GetExtents(i, Extents);
+			if(SphereContainsBox(Center, Extents))
+			{
+				// Set contact status
+				mFlags |= OPC_CONTACT;
+				_Dump(node->GetChild(i));
+			}
+			else _Collide(node->GetChild(i));
+		}
+
+		if(ContactFound()) return;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for wide AABB trees, without primitive tests.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SphereCollider::_CollideNoPrimitiveTest(const AABBWideNode* node)
+{
+	// Perform overlap tests on all children
+	udword Overlaps = SphereWideOverlap(node);
+
+	for(udword i=0;i<OPC_WIDE_NODE_SIZE;i++)
+	{
+		if(!(Overlaps & (1<<i)))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			SET_CONTACT(node->GetPrimitive(i), OPC_CONTACT)
+		}
+		else
+		{
+			Point Center, Extents;
+			node->GetCenter(i, Center);
+			node->GetExtents(i, Extents);
+			if(SphereContainsBox(Center, Extents))
+			{
+				// Set contact status
+				mFlags |= OPC_CONTACT;
+				_Dump(node->GetChild(i));
+			}
+			else _CollideNoPrimitiveTest(node->GetChild(i));
+		}
+
+		if(ContactFound()) return;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive collision query for vanilla AABB trees.
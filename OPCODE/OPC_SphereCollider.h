@@ -73,9 +73,12 @@
 							void			_CollideNoPrimitiveTest(const AABBNoLeafNode* node);
 							void			_CollideNoPrimitiveTest(const AABBQuantizedNode* node);
 							void			_CollideNoPrimitiveTest(const AABBQuantizedNoLeafNode* node);
+							void			_Collide(const AABBWideNode* node);
+							void			_CollideNoPrimitiveTest(const AABBWideNode* node);
 			// Overlap tests
 		inline_				BOOL			SphereContainsBox(const Point& bc, const Point& be);
 		inline_				BOOL			SphereAABBOverlap(const Point& center, const Point& extents);
+		inline_				udword			SphereWideOverlap(const AABBWideNode* node);
 							BOOL			SphereTriOverlap(const Point& vert0, const Point& vert1, const Point& vert2);
 			// Init methods
 							BOOL			InitQuery(SphereCache& cache, const Sphere& sphere, const Matrix4x4* worlds=null, const Matrix4x4* worldm=null);
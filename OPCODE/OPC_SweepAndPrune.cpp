@@ -44,6 +44,16 @@ inline_ void Sort(udword& id0, udword& id1)
 				SAP_EndPoint*	Max[3];
 	};
 
+	//! An open box of the sweep, with the bounds needed to test it
+	class Opcode::SAP_ActiveBox
+	{
+		public:
+				udword			ID;			// Box ID
+				float			Max0;		// Max value on the sweep axis
+				float			Min1, Max1;	// Bounds on the other axes
+				float			Min2, Max2;
+	};
+
 	class Opcode::SAP_EndPoint
 	{
 		public:
@@ -354,6 +364,168 @@ void SAP_PairData::DumpPairs(PairCallback callback, void* user_data) const
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collects the pairs involving at least one flagged object.
+ *	\param		flags	[in] one flag per object, non-zero for flagged objects
+ *	\param		pairs	[out] set of pairs
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SAP_PairData::DumpPairs(const ubyte* flags, SAP_PairSet& pairs) const
+{
+	for(udword i=0;i<mNbObjects;i++)
+	{
+		SAP_Element* Current = mArray[i];
+		while(Current)
+		{
+			ASSERT(Current->mID<mNbObjects);
+
+			if(flags[i] || flags[Current->mID])	pairs.AddPair(i, Current->mID);
+			Current = Current->mNext;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+SAP_PairSet::SAP_PairSet() :
+	mNbPairs	(0),
+	mMaxNbPairs	(0),
+	mPairs		(null),
+	mHashTable	(null),
+	mHashSize	(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+SAP_PairSet::~SAP_PairSet()
+{
+	DELETEARRAY(mHashTable);
+	DELETEARRAY(mPairs);
+}
+
+//! Hashes a pair of ids
+static inline_ udword HashPair(udword id0, udword id1)
+{
+	const udword h = id0 * 0x9e3779b1 + id1 * 0x85ebca6b;
+	return h ^ (h>>15);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Empties the set. Memory is kept for the next pairs.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SAP_PairSet::Reset()
+{
+	if(mNbPairs)	FillMemory(mHashTable, mHashSize*sizeof(udword), 0xff);
+	mNbPairs = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Looks for a pair.
+ *	\param		id0		[in] smallest id
+ *	\param		id1		[in] largest id
+ *	\return		index of the pair in mPairs, or INVALID_ID if not found
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword SAP_PairSet::FindIndex(udword id0, udword id1) const
+{
+	if(!mHashSize)	return INVALID_ID;
+
+	udword Slot = HashPair(id0, id1) & (mHashSize-1);
+	while(mHashTable[Slot]!=INVALID_ID)
+	{
+		const Pair& Current = mPairs[mHashTable[Slot]];
+		if(Current.id0==id0 && Current.id1==id1)	return mHashTable[Slot];
+		Slot = (Slot+1) & (mHashSize-1);
+	}
+	return INVALID_ID;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Rebuilds the hash table from the list of pairs.
+ *	\param		size		[in] new hash table size, a power of 2
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SAP_PairSet::RebuildHashTable(udword size)
+{
+	DELETEARRAY(mHashTable);
+	mHashTable = new udword[size];
+	mHashSize = size;
+	FillMemory(mHashTable, size*sizeof(udword), 0xff);
+
+	for(udword i=0;i<mNbPairs;i++)
+	{
+		udword Slot = HashPair(mPairs[i].id0, mPairs[i].id1) & (mHashSize-1);
+		while(mHashTable[Slot]!=INVALID_ID)	Slot = (Slot+1) & (mHashSize-1);
+		mHashTable[Slot] = i;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Adds a pair to the set.
+ *	\param		id0		[in] first id
+ *	\param		id1		[in] second id
+ *	\return		true if the pair has been added, false if it was already there
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool SAP_PairSet::AddPair(udword id0, udword id1)
+{
+	// Order the ids
+	Sort(id0, id1);
+
+	if(FindIndex(id0, id1)!=INVALID_ID)	return false;
+
+	if(mNbPairs==mMaxNbPairs)
+	{
+		// Resize
+		mMaxNbPairs = mMaxNbPairs ? (mMaxNbPairs<<1) : 64;
+
+		Pair* NewPairs = new Pair[mMaxNbPairs];
+		if(mNbPairs)	CopyMemory(NewPairs, mPairs, mNbPairs*sizeof(Pair));
+		DELETEARRAY(mPairs);
+		mPairs = NewPairs;
+
+		// Keep the hash table at most half full
+		RebuildHashTable(mMaxNbPairs*2);
+	}
+
+	mPairs[mNbPairs] = Pair(id0, id1);
+
+	udword Slot = HashPair(id0, id1) & (mHashSize-1);
+	while(mHashTable[Slot]!=INVALID_ID)	Slot = (Slot+1) & (mHashSize-1);
+	mHashTable[Slot] = mNbPairs++;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Checks whether the set contains a pair.
+ *	\param		id0		[in] first id
+ *	\param		id1		[in] second id
+ *	\return		true if the pair is in the set
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool SAP_PairSet::HasPair(udword id0, udword id1) const
+{
+	// Order the ids
+	Sort(id0, id1);
+
+	return FindIndex(id0, id1)!=INVALID_ID;
+}
+
 
 
 
@@ -386,8 +558,15 @@ void SAP_PairData::DumpPairs(PairCallback callback, void* user_data) const
  *	Constructor.
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-SweepAndPrune::SweepAndPrune()
+SweepAndPrune::SweepAndPrune() :
+	mNbObjects		(0),
+	mBoxes			(null),
+	mMoved			(null),
+	mActiveMoved	(null),
+	mActiveStatic	(null),
+	mActiveIndex	(null)
 {
+	mList[0] = mList[1] = mList[2] = null;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -397,6 +576,18 @@ SweepAndPrune::SweepAndPrune()
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 SweepAndPrune::~SweepAndPrune()
 {
+	Release();
+}
+
+void SweepAndPrune::Release()
+{
+	DELETEARRAY(mActiveIndex);
+	DELETEARRAY(mActiveStatic);
+	DELETEARRAY(mActiveMoved);
+	DELETEARRAY(mMoved);
+	for(udword Axis=0;Axis<3;Axis++)	DELETEARRAY(mList[Axis]);
+	DELETEARRAY(mBoxes);
+	mNbObjects = 0;
 }
 
 void SweepAndPrune::GetPairs(Pairs& pairs) const
@@ -411,6 +602,9 @@ void SweepAndPrune::GetPairs(PairCallback callback, void* user_data) const
 
 bool SweepAndPrune::Init(udword nb_objects, const AABB** boxes)
 {
+	// Make sure everything has been released
+	Release();
+
 	// 1) Create sorted lists
 	mNbObjects = nb_objects;
 
@@ -461,6 +655,14 @@ bool SweepAndPrune::Init(udword nb_objects, const AABB** boxes)
 
 	CheckListsIntegrity();
 
+	// Scratch data for batch updates
+	mMoved			= new ubyte[nb_objects];
+	mActiveMoved	= new SAP_ActiveBox[nb_objects];
+	mActiveStatic	= new SAP_ActiveBox[nb_objects];
+	mActiveIndex	= new udword[nb_objects];
+	ZeroMemory(mMoved, nb_objects*sizeof(ubyte));
+	FillMemory(mActiveIndex, nb_objects*sizeof(udword), 0xff);
+
 	// 2) Quickly find starting pairs
 
 	mPairs.Init(nb_objects);
@@ -662,3 +864,229 @@ bool SweepAndPrune::UpdateObject(udword i, const AABB& box)
 
 	return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Updates a batch of objects at once.
+ *	Moved endpoints are taken out of the sorted lists, sorted on their own, and merged back in a single pass per axis. A sweep
+ *	then finds the pairs involving moved objects, which are compared to the previous ones through hashed sets. The cost is
+ *	linear in the number of objects and pairs, instead of growing with the number of endpoint swaps when many objects move
+ *	together. When only a few objects move, UpdateObject() is still cheaper, as it doesn't walk the whole lists.
+ *	Created and deleted pairs are available afterwards through GetCreatedPairs() and GetDeletedPairs().
+ *	\param		nb		[in] number of moved objects
+ *	\param		ids		[in] ids of moved objects, each id at most once
+ *	\param		boxes	[in] new boxes of moved objects
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool SweepAndPrune::UpdateObjects(udword nb, const udword* ids, const AABB** boxes)
+{
+	mCreatedPairs.ResetPairs();
+	mDeletedPairs.ResetPairs();
+
+	// Checkings
+	if(!nb)	return true;
+	if(!ids || !boxes || !mMoved)	return false;
+
+	// Flag moved objects
+	for(udword i=0;i<nb;i++)
+	{
+		const udword id = ids[i];
+		ASSERT(id<mNbObjects && !mMoved[id]);
+		if(id>=mNbObjects || mMoved[id])
+		{
+			for(udword j=0;j<i;j++)	mMoved[ids[j]] = 0;
+			return false;
+		}
+		mMoved[id] = 1;
+	}
+
+	// 1) Catch the current pairs of moved objects
+	mOldPairs.Reset();
+	mPairs.DumpPairs(mMoved, mOldPairs);
+
+	// 2) Move endpoints
+	for(udword Axis=0;Axis<3;Axis++)	MergeEndPoints(Axis, nb, ids, boxes);
+
+	// 3) Find the new pairs of moved objects
+	FindMovedPairs();
+
+	// 4) Apply differences
+	const Pair* NewPairs = mNewPairs.GetPairs();
+	for(udword i=0;i<mNewPairs.GetNbPairs();i++)
+	{
+		if(!mOldPairs.HasPair(NewPairs[i].id0, NewPairs[i].id1))
+		{
+			mPairs.AddPair(NewPairs[i].id0, NewPairs[i].id1);
+			mCreatedPairs.AddPair(NewPairs[i]);
+		}
+	}
+	const Pair* OldPairs = mOldPairs.GetPairs();
+	for(udword i=0;i<mOldPairs.GetNbPairs();i++)
+	{
+		if(!mNewPairs.HasPair(OldPairs[i].id0, OldPairs[i].id1))
+		{
+			mPairs.RemovePair(OldPairs[i].id0, OldPairs[i].id1);
+			mDeletedPairs.AddPair(OldPairs[i]);
+		}
+	}
+
+	for(udword i=0;i<nb;i++)	mMoved[ids[i]] = 0;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Moves the endpoints of moved objects on one axis: they are removed from the sorted list, sorted, and merged back.
+ *	On equal values, moved mins go before and moved maxs go after the other endpoints, so that touching boxes overlap.
+ *	\param		axis	[in] axis index
+ *	\param		nb		[in] number of moved objects
+ *	\param		ids		[in] ids of moved objects
+ *	\param		boxes	[in] new boxes of moved objects
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SweepAndPrune::MergeEndPoints(udword axis, udword nb, const udword* ids, const AABB** boxes)
+{
+	// Remove moved endpoints from the list
+	for(udword i=0;i<nb;i++)
+	{
+		const SAP_Box& Box = mBoxes[ids[i]];
+		for(udword j=0;j<2;j++)
+		{
+			SAP_EndPoint* Current = j ? Box.Max[axis] : Box.Min[axis];
+			if(Current->Previous)	Current->Previous->Next = Current->Next;
+			if(Current->Next)		Current->Next->Previous = Current->Previous;
+		}
+	}
+
+	// Find the head of the remaining list
+	SAP_EndPoint* Current = null;
+	for(udword i=0;i<mNbObjects && !Current;i++)
+	{
+		if(!mMoved[i])	Current = mBoxes[i].Min[axis];
+	}
+	if(Current)
+	{
+		while(Current->Previous)	Current = Current->Previous;
+	}
+
+	// Sort new values. Mins are [0, nb[ and maxs are [nb, 2*nb[.
+	float* Data = new float[nb*2];
+	for(udword i=0;i<nb;i++)
+	{
+		Data[i]		= boxes[i]->GetMin(axis);
+		Data[nb+i]	= boxes[i]->GetMax(axis);
+	}
+	const udword* Sorted = mSorter.Sort(Data, nb*2).GetRanks();
+
+	// Merge
+	SAP_EndPoint* Previous = null;
+	for(udword i=0;i<nb*2;)
+	{
+		// The sorter keeps the previous order of equal values, which is arbitrary here: insert the mins of a run of
+		// equal values first, then its maxs.
+		const float Value = Data[Sorted[i]];
+		udword End = i+1;
+		while(End<nb*2 && Data[Sorted[End]]==Value)	End++;
+
+		for(udword Pass=0;Pass<2;Pass++)
+		{
+			const bool IsMax = Pass!=0;
+			if(IsMax)	{ while(Current && Current->Value <= Value)	{ Previous = Current; Current = Current->Next; } }
+			else		{ while(Current && Current->Value < Value)	{ Previous = Current; Current = Current->Next; } }
+
+			for(udword j=i;j<End;j++)
+			{
+				const udword SortedIndex = Sorted[j];
+				if((SortedIndex>=nb)!=IsMax)	continue;
+
+				const SAP_Box& Box = mBoxes[ids[IsMax ? SortedIndex-nb : SortedIndex]];
+				SAP_EndPoint* EndPoint = IsMax ? Box.Max[axis] : Box.Min[axis];
+
+				EndPoint->Value		= Data[SortedIndex];
+				EndPoint->Previous	= Previous;
+				EndPoint->Next		= Current;
+				if(Previous)	Previous->Next = EndPoint;
+				if(Current)		Current->Previous = EndPoint;
+				Previous = EndPoint;
+			}
+		}
+		i = End;
+	}
+
+	DELETEARRAY(Data);
+}
+
+inline_ BOOL Intersect(const SAP_ActiveBox& a, const SAP_ActiveBox& b, float min0)
+{
+	// Most tests fail on a random axis: combine all comparisons instead of branching on each one
+	return !((a.Max0 < min0)
+		| (b.Max1 < a.Min1) | (a.Max1 < b.Min1)
+		| (b.Max2 < a.Min2) | (a.Max2 < b.Min2));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Finds the pairs involving moved objects, with a sweep along the first axis.
+ *	Open boxes are kept in two lists. A new box is tested against open moved boxes, and a moved one against open static
+ *	boxes as well: pairs of static objects can't have changed.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SweepAndPrune::FindMovedPairs()
+{
+	mNewPairs.Reset();
+
+	// Find list head
+	SAP_EndPoint* Current = mList[0];
+	while(Current->Previous)	Current = Current->Previous;
+
+	udword NbActiveMoved = 0;
+	udword NbActiveStatic = 0;
+	while(Current)
+	{
+		const udword id = Current->GetBoxID();
+		const bool Moved = mMoved[id]!=0;
+		SAP_ActiveBox* Active = Moved ? mActiveMoved : mActiveStatic;
+		udword& NbActive = Moved ? NbActiveMoved : NbActiveStatic;
+
+		if(!Current->IsMax())
+		{
+			// Box starts: catch its bounds once, and test it against open boxes
+			const SAP_Box& Box = mBoxes[id];
+			SAP_ActiveBox& NewBox = Active[NbActive];
+			NewBox.ID	= id;
+			NewBox.Max0	= Box.Max[0]->Value;
+			NewBox.Min1	= Box.Min[1]->Value;	NewBox.Max1	= Box.Max[1]->Value;
+			NewBox.Min2	= Box.Min[2]->Value;	NewBox.Max2	= Box.Max[2]->Value;
+			const float Min0 = Current->Value;
+
+			for(udword i=0;i<NbActiveMoved;i++)
+			{
+				if(Intersect(mActiveMoved[i], NewBox, Min0))	mNewPairs.AddPair(id, mActiveMoved[i].ID);
+			}
+			if(Moved)
+			{
+				for(udword i=0;i<NbActiveStatic;i++)
+				{
+					if(Intersect(mActiveStatic[i], NewBox, Min0))	mNewPairs.AddPair(id, mActiveStatic[i].ID);
+				}
+			}
+
+			mActiveIndex[id] = NbActive++;
+		}
+		else if(mActiveIndex[id]!=INVALID_ID)
+		{
+			// Box ends: close it. Static lists may have a max before its min for empty boxes, then there's nothing to close.
+			const SAP_ActiveBox& Last = Active[--NbActive];
+			Active[mActiveIndex[id]] = Last;
+			mActiveIndex[Last.ID] = mActiveIndex[id];
+			mActiveIndex[id] = INVALID_ID;
+		}
+		Current = Current->Next;
+	}
+
+	// Boxes left open by misordered endpoints
+	for(udword i=0;i<NbActiveMoved;i++)		mActiveIndex[mActiveMoved[i].ID] = INVALID_ID;
+	for(udword i=0;i<NbActiveStatic;i++)	mActiveIndex[mActiveStatic[i].ID] = INVALID_ID;
+}
@@ -34,6 +34,8 @@
 	class SAP_Element;
 	class SAP_EndPoint;
 	class SAP_Box;
+	class SAP_PairSet;
+	class SAP_ActiveBox;
 
 	class OPCODE_API SAP_PairData
 	{
@@ -48,6 +50,7 @@
 
 				void			DumpPairs(Pairs& pairs)								const;
 				void			DumpPairs(PairCallback callback, void* user_data)	const;
+				void			DumpPairs(const ubyte* flags, SAP_PairSet& pairs)	const;
 		private:
 				udword			mNbElements;		//!< Total number of elements in the pool
 				udword			mNbUsedElements;	//!< Number of used elements
@@ -62,6 +65,30 @@
 				void			Release();
 	};
 
+	//! A hashed set of pairs, with ids sorted in each pair
+	class OPCODE_API SAP_PairSet
+	{
+		public:
+								SAP_PairSet();
+								~SAP_PairSet();
+
+				void			Reset();
+				bool			AddPair(udword id0, udword id1);
+				bool			HasPair(udword id0, udword id1)						const;
+
+		inline_	udword			GetNbPairs()										const	{ return mNbPairs;	}
+		inline_	const Pair*		GetPairs()											const	{ return mPairs;	}
+		private:
+				udword			mNbPairs;			//!< Number of pairs in the set
+				udword			mMaxNbPairs;		//!< Number of pairs mPairs has room for
+				Pair*			mPairs;				//!< Pairs, in insertion order
+				udword*			mHashTable;			//!< Open-addressing hash table of indices in mPairs
+				udword			mHashSize;			//!< Hash table size, a power of 2
+		// Internal methods
+				udword			FindIndex(udword id0, udword id1)					const;
+				void			RebuildHashTable(udword size);
+	};
+
 	class OPCODE_API SweepAndPrune
 	{
 		public:
@@ -70,17 +97,36 @@
 
 				bool			Init(udword nb_objects, const AABB** boxes);
 				bool			UpdateObject(udword i, const AABB& box);
+				bool			UpdateObjects(udword nb, const udword* ids, const AABB** boxes);
 
 				void			GetPairs(Pairs& pairs)								const;
 				void			GetPairs(PairCallback callback, void* user_data)	const;
+
+		//! Pairs created by the last UpdateObjects() call
+		inline_	const Pairs&	GetCreatedPairs()									const	{ return mCreatedPairs;	}
+		//! Pairs deleted by the last UpdateObjects() call
+		inline_	const Pairs&	GetDeletedPairs()									const	{ return mDeletedPairs;	}
 		private:
 				SAP_PairData	mPairs;
 
 				udword			mNbObjects;
 				SAP_Box*		mBoxes;
 				SAP_EndPoint*	mList[3];
+		// Batch updates
+				RadixSort		mSorter;			//!< Sorts the new endpoints of moved objects
+				ubyte*			mMoved;				//!< Per object, 1 if moved by the current batch
+				SAP_ActiveBox*	mActiveMoved;		//!< Sweep's list of open moved boxes
+				SAP_ActiveBox*	mActiveStatic;		//!< Sweep's list of open static boxes
+				udword*			mActiveIndex;		//!< Per object, index in its active list or INVALID_ID
+				SAP_PairSet		mOldPairs;			//!< Pairs of moved objects before the batch
+				SAP_PairSet		mNewPairs;			//!< Pairs of moved objects after the batch
+				Pairs			mCreatedPairs;		//!< Pairs created by the last batch
+				Pairs			mDeletedPairs;		//!< Pairs deleted by the last batch
 		// Internal methods
 				bool			CheckListsIntegrity();
+				void			Release();
+				void			MergeEndPoints(udword axis, udword nb, const udword* ids, const AABB** boxes);
+				void			FindMovedPairs();
 	};
 
 #endif //__OPC_SWEEPANDPRUNE_H__
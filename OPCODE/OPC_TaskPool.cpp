@@ -0,0 +1,303 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains a work-stealing pool of threads for parallel tree builds.
+ *	\file		OPC_TaskPool.cpp
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	A work-stealing pool of threads.
+ *
+ *	Each thread owns a queue of tasks. A task may push more tasks: they go at the back of the queue of the thread
+ *	running it, and that thread takes its next task from the back again (depth-first, the most recent data is still
+ *	in cache). An idle thread steals the task at the front of another thread's queue, i.e. the oldest one, which for
+ *	recursive builds is the largest piece of work left. Run() returns when all the tasks are done.
+ *
+ *	Threads are created by the first Run() and live as long as the pool. Between runs they sleep.
+ *
+ *	\class		TaskPool
+ *	\version	1.3
+ *	\date		October, 18, 2026
+*/
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled Header
+#include "Stdafx.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+using namespace Opcode;
+
+//! Task queue of a thread
+struct TaskQueue
+{
+	std::mutex					mMutex;
+	std::deque<Task>			mTasks;
+};
+
+//! Threads and task queues
+struct Opcode::TaskPoolData
+{
+	TaskPoolData(udword nb_threads) : mNbPending(0), mRunning(false), mQuit(false)
+	{
+		mQueues = new TaskQueue[nb_threads];
+	}
+	~TaskPoolData()
+	{
+		DELETEARRAY(mQueues);
+	}
+
+	std::vector<std::thread>	mThreads;		//!< Worker threads, the caller of Run() being worker 0
+	TaskQueue*					mQueues;		//!< One queue per thread
+	std::atomic<udword>			mNbPending;		//!< Number of tasks pushed and not done yet
+	std::atomic<bool>			mRunning;		//!< Run() in progress
+	bool						mQuit;			//!< Threads must exit
+	std::mutex					mMutex;			//!< Guards mRunning changes and mQuit
+	std::condition_variable		mWake;			//!< Wakes sleeping threads
+};
+
+//! A range split into chunks for ParallelFor
+struct RangeJob
+{
+	RangeFunction				mFunction;
+	void*						mUserData;
+	udword						mNb;
+	udword						mGrain;
+	std::atomic<udword>			mNbLeft;		//!< Number of chunks not done yet
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ *	\param		nb_threads	[in] number of threads, including the caller of Run(). 0 for one thread per hardware thread.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TaskPool::TaskPool(udword nb_threads) : mNbThreads(nb_threads), mData(null)
+{
+	if(!mNbThreads)	mNbThreads = std::thread::hardware_concurrency();
+	if(!mNbThreads)	mNbThreads = 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TaskPool::~TaskPool()
+{
+	if(!mData)	return;
+	{
+		std::lock_guard<std::mutex> Lock(mData->mMutex);
+		mData->mQuit = true;
+	}
+	mData->mWake.notify_all();
+	for(udword i=0;i<mData->mThreads.size();i++)	mData->mThreads[i].join();
+	DELETESINGLE(mData);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Runs a task, and the tasks it pushes, on all the threads. The caller is worker 0.
+ *	Tasks must not call Run() themselves.
+ *	\param		task		[in] the task
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void TaskPool::Run(const Task& task)
+{
+	// Create the threads on first use
+	if(!mData)
+	{
+		mData = new TaskPoolData(mNbThreads);
+		for(udword i=1;i<mNbThreads;i++)	mData->mThreads.push_back(std::thread(&TaskPool::_WorkerLoop, this, i));
+	}
+
+	Push(0, task);
+	{
+		std::lock_guard<std::mutex> Lock(mData->mMutex);
+		mData->mRunning = true;
+	}
+	mData->mWake.notify_all();
+
+	// Work until all tasks are done. A task is only done after the tasks it pushed have been counted.
+	while(mData->mNbPending)
+	{
+		if(!Execute(0))	std::this_thread::yield();
+	}
+
+	std::lock_guard<std::mutex> Lock(mData->mMutex);
+	mData->mRunning = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Pushes a task. Called from a running task.
+ *	\param		worker		[in] index of the calling thread, as given to the task
+ *	\param		task		[in] the task
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void TaskPool::Push(udword worker, const Task& task)
+{
+	mData->mNbPending++;
+	TaskQueue& Queue = mData->mQueues[worker];
+	std::lock_guard<std::mutex> Lock(Queue.mMutex);
+	Queue.mTasks.push_back(task);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Executes one task: the last one pushed by the thread, else the oldest one of another thread.
+ *	\param		worker		[in] index of the calling thread
+ *	\return		true if a task has been executed
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool TaskPool::Execute(udword worker)
+{
+	Task Current;
+	bool Found = false;
+	{
+		TaskQueue& Queue = mData->mQueues[worker];
+		std::lock_guard<std::mutex> Lock(Queue.mMutex);
+		if(!Queue.mTasks.empty())
+		{
+			Current = Queue.mTasks.back();
+			Queue.mTasks.pop_back();
+			Found = true;
+		}
+	}
+	for(udword i=1;!Found && i<mNbThreads;i++)
+	{
+		TaskQueue& Queue = mData->mQueues[(worker+i)%mNbThreads];
+		std::lock_guard<std::mutex> Lock(Queue.mMutex);
+		if(!Queue.mTasks.empty())
+		{
+			Current = Queue.mTasks.front();
+			Queue.mTasks.pop_front();
+			Found = true;
+		}
+	}
+	if(!Found)	return false;
+
+	(Current.mFunction)(*this, worker, Current);
+	mData->mNbPending--;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Worker thread: executes tasks while Run() is in progress, sleeps otherwise.
+ *	\param		worker		[in] index of the thread
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void TaskPool::_WorkerLoop(udword worker)
+{
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(mData->mMutex);
+			while(!mData->mRunning && !mData->mQuit)	mData->mWake.wait(Lock);
+			if(mData->mQuit)	return;
+		}
+		while(mData->mRunning)
+		{
+			if(!Execute(worker))	std::this_thread::yield();
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Runs a chunk of a range.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _RangeTask(TaskPool& /*pool*/, udword /*worker*/, const Task& task)
+{
+	RangeJob* Job = (RangeJob*)task.mObject;
+	udword First = task.mParams[0]*Job->mGrain;
+	udword Last = First + Job->mGrain;
+	if(Last>Job->mNb)	Last = Job->mNb;
+	(Job->mFunction)(First, Last, Job->mUserData);
+	Job->mNbLeft--;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Runs a ParallelFor called outside of Run().
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _ParallelForTask(TaskPool& pool, udword worker, const Task& task)
+{
+	RangeJob* Job = (RangeJob*)task.mObject;
+	pool.ParallelFor(worker, Job->mNb, Job->mGrain, Job->mFunction, Job->mUserData);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Calls a function over a range of indices split into chunks, on all threads, and waits for completion.
+ *	The calling thread executes other tasks while waiting. May be called from a task or, with worker 0, outside of Run().
+ *	\param		worker		[in] index of the calling thread
+ *	\param		nb			[in] number of indices
+ *	\param		grain		[in] number of indices per chunk
+ *	\param		function	[in] function called for each chunk
+ *	\param		user_data	[in] user-defined data
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void TaskPool::ParallelFor(udword worker, udword nb, udword grain, RangeFunction function, void* user_data)
+{
+	if(!grain)	grain = 1;
+	udword NbChunks = (nb + grain - 1)/grain;
+	if(NbChunks<=1 || mNbThreads==1)
+	{
+		if(nb)	(function)(0, nb, user_data);
+		return;
+	}
+
+	RangeJob Job;
+	Job.mFunction	= function;
+	Job.mUserData	= user_data;
+	Job.mNb			= nb;
+	Job.mGrain		= grain;
+	Job.mNbLeft		= NbChunks;
+
+	Task Chunk;
+	Chunk.mObject	= &Job;
+	Chunk.mUserData	= null;
+
+	// Outside of Run(), start the threads first
+	if(!mData || !mData->mRunning)
+	{
+		Chunk.mFunction	= _ParallelForTask;
+		Chunk.mParams[0]	= 0;
+		Run(Chunk);
+		return;
+	}
+
+	// Push the chunks in reverse order so that the caller takes them in order, then help until they're all done
+	Chunk.mFunction = _RangeTask;
+	for(udword i=NbChunks-1;i>0;i--)
+	{
+		Chunk.mParams[0] = i;
+		Push(worker, Chunk);
+	}
+	Chunk.mParams[0] = 0;
+	_RangeTask(*this, worker, Chunk);
+	while(Job.mNbLeft)
+	{
+		if(!Execute(worker))	std::this_thread::yield();
+	}
+}
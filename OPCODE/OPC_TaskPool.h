@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains a work-stealing pool of threads for parallel tree builds.
+ *	\file		OPC_TaskPool.h
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Include Guard
+#ifndef __OPC_TASKPOOL_H__
+#define __OPC_TASKPOOL_H__
+
+	class TaskPool;
+	struct Task;
+	struct TaskPoolData;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/**
+	 *	Task function, called by one of the pool's threads.
+	 *	\param		pool		[in] the task pool, to push more tasks from the task
+	 *	\param		worker		[in] index of the calling thread (0 is the thread which called TaskPool::Run)
+	 *	\param		task		[in] the task
+	 */
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	typedef		void				(*TaskFunction)		(TaskPool& pool, udword worker, const Task& task);
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/**
+	 *	Range function, called by TaskPool::ParallelFor for a part of the range.
+	 *	\param		first		[in] first index
+	 *	\param		last		[in] last index + 1
+	 *	\param		user_data	[in] user-defined data
+	 */
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	typedef		void				(*RangeFunction)	(udword first, udword last, void* user_data);
+
+	struct OPCODE_API Task
+	{
+		TaskFunction	mFunction;		//!< Function running the task
+		void*			mObject;		//!< Object the task works on
+		void*			mUserData;		//!< Data shared with other tasks
+		udword			mParams[2];		//!< Task parameters
+	};
+
+	class OPCODE_API TaskPool
+	{
+		public:
+		// Constructor / Destructor
+									TaskPool(udword nb_threads);
+									~TaskPool();
+
+		// Number of threads, including the caller of Run()
+		inline_	udword				GetNbThreads()	const	{ return mNbThreads;	}
+
+				void				Run(const Task& task);
+				void				Push(udword worker, const Task& task);
+				void				ParallelFor(udword worker, udword nb, udword grain, RangeFunction function, void* user_data);
+		private:
+				udword				mNbThreads;		//!< Number of threads, including the caller
+				TaskPoolData*		mData;			//!< Threads and task queues, created by the first Run()
+		// Internal methods
+				bool				Execute(udword worker);
+				void				_WorkerLoop(udword worker);
+	};
+
+#endif // __OPC_TASKPOOL_H__
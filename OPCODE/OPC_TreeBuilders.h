@@ -29,6 +29,7 @@
 		SPLIT_BEST_AXIS			= (1<<2),		//!< Try largest axis, then second, then last
 		SPLIT_BALANCED			= (1<<3),		//!< Try to keep a well-balanced tree
 		SPLIT_FIFTY				= (1<<4),		//!< Arbitrary 50-50 split
+		SPLIT_SAH				= (1<<6),		//!< Binned surface area heuristic: split where (area * number of primitives) of the children is least
 		// Node split
 		SPLIT_GEOM_CENTER		= (1<<5),		//!< Split at geometric center (else split in the middle)
 		//
@@ -38,10 +39,11 @@
 	//! Simple wrapper around build-related settings [Opcode 1.3]
 	struct OPCODE_API BuildSettings
 	{
-		inline_	BuildSettings() : mLimit(1), mRules(SPLIT_FORCE_DWORD)	{}
+		inline_	BuildSettings() : mLimit(1), mRules(SPLIT_FORCE_DWORD), mNbThreads(1)	{}
 
 		udword	mLimit;		//!< Limit number of primitives / node. If limit is 1, build a complete tree (2*N-1 nodes)
 		udword	mRules;		//!< Building/Splitting rules (a combination of SplittingRules flags)
+		udword	mNbThreads;	//!< Number of threads building models, 0 for one per hardware thread. The trees are the same as with 1 thread.
 	};
 
 	class OPCODE_API AABBTreeBuilder
@@ -110,6 +112,14 @@
 														return TRUE;
 													}
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Checks the builder can be used by several threads at once, for parallel builds.
+		 *	\return		TRUE if the builder is thread-safe
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		virtual						BOOL			IsThreadSafe()	const	{ return FALSE;	}
+
 									BuildSettings	mSettings;			//!< Splitting rules & split limit [Opcode 1.3]
 									udword			mNbPrimitives;		//!< Total number of primitives.
 									void*			mNodeBase;			//!< Address of node pool [Opcode 1.3]
@@ -137,6 +147,7 @@
 		override(AABBTreeBuilder)	bool			ComputeGlobalBox(const udword* primitives, udword nb_prims, AABB& global_box)	const;
 		override(AABBTreeBuilder)	float			GetSplittingValue(udword index, udword axis)									const;
 		override(AABBTreeBuilder)	float			GetSplittingValue(const udword* primitives, udword nb_prims, const AABB& global_box, udword axis)	const;
+		override(AABBTreeBuilder)	BOOL			IsThreadSafe()																	const	{ return TRUE;	}
 
 		const						Point*			mVertexArray;		//!< Shortcut to an app-controlled array of vertices.
 	};
@@ -151,6 +162,7 @@
 
 		override(AABBTreeBuilder)	bool			ComputeGlobalBox(const udword* primitives, udword nb_prims, AABB& global_box)	const;
 		override(AABBTreeBuilder)	float			GetSplittingValue(udword index, udword axis)									const;
+		override(AABBTreeBuilder)	BOOL			IsThreadSafe()																	const	{ return TRUE;	}
 
 		const						AABB*			mAABBArray;			//!< Shortcut to an app-controlled array of AABBs.
 	};
@@ -166,6 +178,7 @@
 		override(AABBTreeBuilder)	bool			ComputeGlobalBox(const udword* primitives, udword nb_prims, AABB& global_box)	const;
 		override(AABBTreeBuilder)	float			GetSplittingValue(udword index, udword axis)									const;
 		override(AABBTreeBuilder)	float			GetSplittingValue(const udword* primitives, udword nb_prims, const AABB& global_box, udword axis)	const;
+		override(AABBTreeBuilder)	BOOL			IsThreadSafe()																	const;
 
 		const				MeshInterface*			mIMesh;			//!< Shortcut to an app-controlled mesh interface
 	};
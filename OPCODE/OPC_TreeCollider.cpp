@@ -31,6 +31,8 @@
 // Precompiled Header
 #include "Stdafx.h"
 
+#include <xmmintrin.h>
+
 using namespace Opcode;
 
 #include "OPC_BoxBoxOverlap.h"
@@ -43,13 +45,19 @@ using namespace Opcode;
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 AABBTreeCollider::AABBTreeCollider() :
+	mIMesh0				(null),
+	mIMesh1				(null),
 	mNbBVBVTests		(0),
 	mNbPrimPrimTests	(0),
 	mNbBVPrimTests		(0),
+	mBatchSize			(0),
 	mFullBoxBoxTest		(true),
 	mFullPrimBoxTest	(true),
-	mIMesh0				(null),
-	mIMesh1				(null)
+	mFrontManager		(null),
+	mFront				(null),
+	mNewFront			(null),
+	mFrontBase0			(null),
+	mFrontBase1			(null)
 {
 }
 
@@ -94,6 +102,7 @@ bool AABBTreeCollider::Collide(BVTCache& cache, const Matrix4x4* world0, const M
 	if(!cache.Model0 || !cache.Model1)								return false;
 	if(cache.Model0->HasLeafNodes()!=cache.Model1->HasLeafNodes())	return false;
 	if(cache.Model0->IsQuantized()!=cache.Model1->IsQuantized())	return false;
+	if(cache.Model0->IsWide() || cache.Model1->IsWide())			return false;
 
 	/*
 	
@@ -170,6 +179,9 @@ bool AABBTreeCollider::Collide(BVTCache& cache, const Matrix4x4* world0, const M
 	// Checkings
 	if(!Setup(cache.Model0->GetMeshInterface(), cache.Model1->GetMeshInterface()))	return false;
 
+	// Restart from the last front of these models. A first contact query stops early and leaves an incomplete front.
+	mFront = (mFrontManager && !FirstContactEnabled()) ? mFrontManager->GetFront(cache.Model0, cache.Model1) : null;
+
 	// Simple double-dispatch
 	bool Status;
 	if(!cache.Model0->HasLeafNodes())
@@ -202,6 +214,7 @@ bool AABBTreeCollider::Collide(BVTCache& cache, const Matrix4x4* world0, const M
 			Status = Collide(T0, T1, world0, world1, &cache);
 		}
 	}
+	mFront = null;
 
 #ifdef __MESHMERIZER_H__
 	if(Status)
@@ -239,6 +252,8 @@ void AABBTreeCollider::InitQuery(const Matrix4x4* world0, const Matrix4x4* world
 	mNbBVBVTests		= 0;
 	mNbPrimPrimTests	= 0;
 	mNbBVPrimTests		= 0;
+	mBatchSize			= 0;
+	mNewFront			= null;
 	mPairs.Reset();
 
 	// Setup matrices
@@ -315,8 +330,16 @@ bool AABBTreeCollider::Collide(const AABBCollisionTree* tree0, const AABBCollisi
 	// Check previous state
 	if(CheckTemporalCoherence(cache))		return true;
 
-	// Perform collision query
-	_Collide(tree0->GetNodes(), tree1->GetNodes());
+	// Perform collision query, from the last front if possible
+	const BOOL Restart = BeginFront(tree0->GetNodes(), tree1->GetNodes(), tree0->GetNodes()->mAABB.mExtents, tree1->GetNodes()->mAABB.mExtents);
+	if(Restart)	_CollideFront(tree0, tree1);
+	else		_Collide(tree0->GetNodes(), tree1->GetNodes());
+
+	// Test remaining batched pairs
+#ifdef OPC_BATCH_PRIM_TESTS
+	FlushPrimBatch();
+#endif
+	EndFront(Restart);
 
 	UPDATE_CACHE
 
@@ -343,8 +366,16 @@ bool AABBTreeCollider::Collide(const AABBNoLeafTree* tree0, const AABBNoLeafTree
 	// Check previous state
 	if(CheckTemporalCoherence(cache))		return true;
 
-	// Perform collision query
-	_Collide(tree0->GetNodes(), tree1->GetNodes());
+	// Perform collision query, from the last front if possible
+	const BOOL Restart = BeginFront(tree0->GetNodes(), tree1->GetNodes(), tree0->GetNodes()->mAABB.mExtents, tree1->GetNodes()->mAABB.mExtents);
+	if(Restart)	_CollideFront(tree0, tree1);
+	else		_Collide(tree0->GetNodes(), tree1->GetNodes());
+
+	// Test remaining batched pairs
+#ifdef OPC_BATCH_PRIM_TESTS
+	FlushPrimBatch();
+#endif
+	EndFront(Restart);
 
 	UPDATE_CACHE
 
@@ -386,8 +417,16 @@ bool AABBTreeCollider::Collide(const AABBQuantizedTree* tree0, const AABBQuantiz
 	const Point b(float(N1->mAABB.mExtents[0]) * mExtentsCoeff1.x, float(N1->mAABB.mExtents[1]) * mExtentsCoeff1.y, float(N1->mAABB.mExtents[2]) * mExtentsCoeff1.z);
 	const Point Pb(float(N1->mAABB.mCenter[0]) * mCenterCoeff1.x, float(N1->mAABB.mCenter[1]) * mCenterCoeff1.y, float(N1->mAABB.mCenter[2]) * mCenterCoeff1.z);
 
-	// Perform collision query
-	_Collide(N0, N1, a, Pa, b, Pb);
+	// Perform collision query, from the last front if possible
+	const BOOL Restart = BeginFront(N0, N1, a, b);
+	if(Restart)	_CollideFront(tree0, tree1);
+	else		_Collide(N0, N1, a, Pa, b, Pb);
+
+	// Test remaining batched pairs
+#ifdef OPC_BATCH_PRIM_TESTS
+	FlushPrimBatch();
+#endif
+	EndFront(Restart);
 
 	UPDATE_CACHE
 
@@ -420,8 +459,22 @@ bool AABBTreeCollider::Collide(const AABBQuantizedNoLeafTree* tree0, const AABBQ
 	mCenterCoeff1	= tree1->mCenterCoeff;
 	mExtentsCoeff1	= tree1->mExtentsCoeff;
 
-	// Perform collision query
-	_Collide(tree0->GetNodes(), tree1->GetNodes());
+	// Dequantize root extents
+	const AABBQuantizedNoLeafNode* N0 = tree0->GetNodes();
+	const AABBQuantizedNoLeafNode* N1 = tree1->GetNodes();
+	const Point a(float(N0->mAABB.mExtents[0]) * mExtentsCoeff0.x, float(N0->mAABB.mExtents[1]) * mExtentsCoeff0.y, float(N0->mAABB.mExtents[2]) * mExtentsCoeff0.z);
+	const Point b(float(N1->mAABB.mExtents[0]) * mExtentsCoeff1.x, float(N1->mAABB.mExtents[1]) * mExtentsCoeff1.y, float(N1->mAABB.mExtents[2]) * mExtentsCoeff1.z);
+
+	// Perform collision query, from the last front if possible
+	const BOOL Restart = BeginFront(N0, N1, a, b);
+	if(Restart)	_CollideFront(tree0, tree1);
+	else		_Collide(N0, N1);
+
+	// Test remaining batched pairs
+#ifdef OPC_BATCH_PRIM_TESTS
+	FlushPrimBatch();
+#endif
+	EndFront(Restart);
 
 	UPDATE_CACHE
 
@@ -447,9 +500,9 @@ bool AABBTreeCollider::Collide(const AABBQuantizedNoLeafTree* tree0, const AABBQ
 void AABBTreeCollider::_Collide(const AABBCollisionNode* b0, const AABBCollisionNode* b1)
 {
 	// Perform BV-BV overlap test
-	if(!BoxBoxOverlap(b0->mAABB.mExtents, b0->mAABB.mCenter, b1->mAABB.mExtents, b1->mAABB.mCenter))	return;
+	if(!BoxBoxOverlap(b0->mAABB.mExtents, b0->mAABB.mCenter, b1->mAABB.mExtents, b1->mAABB.mCenter))	{ AddFront(FrontID0(b0), FrontID1(b1)); return; }
 
-	if(b0->IsLeaf() && b1->IsLeaf()) { PrimTest(b0->GetPrimitive(), b1->GetPrimitive()); return; }
+	if(b0->IsLeaf() && b1->IsLeaf()) { AddFront(FrontID0(b0), FrontID1(b1)); PrimTest(b0->GetPrimitive(), b1->GetPrimitive()); return; }
 
 	if(b1->IsLeaf() || (!b0->IsLeaf() && (b0->GetSize() > b1->GetSize())))
 	{
@@ -479,6 +532,7 @@ void AABBTreeCollider::_Collide(const AABBCollisionNode* b0, const AABBCollision
 	// Perform BV-BV overlap test
 	if(!BoxBoxOverlap(b0->mAABB.mExtents, b0->mAABB.mCenter, b1->mAABB.mExtents, b1->mAABB.mCenter))
 	{
+		AddFront(FrontID0(b0), FrontID1(b1));
 		return;
 	}
 
@@ -486,6 +540,7 @@ void AABBTreeCollider::_Collide(const AABBCollisionNode* b0, const AABBCollision
 	{
 		if(b1->IsLeaf())
 		{
+			AddFront(FrontID0(b0), FrontID1(b1));
 			PrimTest(b0->GetPrimitive(), b1->GetPrimitive());
 		}
 		else
@@ -518,6 +573,48 @@ void AABBTreeCollider::_Collide(const AABBCollisionNode* b0, const AABBCollision
 // No-leaf trees
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Triangle-triangle test for a pair of leaves, whose vertices are in a common space. Unless a first contact is wanted,
+ *	the pair is batched and tested later by FlushPrimBatch().
+ *	\param		V0		[in] triangle 0, vertex 0
+ *	\param		V1		[in] triangle 0, vertex 1
+ *	\param		V2		[in] triangle 0, vertex 2
+ *	\param		U0		[in] triangle 1, vertex 0
+ *	\param		U1		[in] triangle 1, vertex 1
+ *	\param		U2		[in] triangle 1, vertex 2
+ *	\param		id0		[in] index from first leaf-triangle
+ *	\param		id1		[in] index from second leaf-triangle
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ void AABBTreeCollider::TriTriTest(const Point& V0, const Point& V1, const Point& V2, const Point& U0, const Point& U1, const Point& U2, udword id0, udword id1)
+{
+#ifdef OPC_BATCH_PRIM_TESTS
+	// A first contact query must stop at the first overlap, so it can't wait for the batch to be full
+	if(!FirstContactEnabled())
+	{
+		const udword j = mBatchSize;
+		mBatchV[0][j] = V0.x;	mBatchV[1][j] = V0.y;	mBatchV[2][j] = V0.z;
+		mBatchV[3][j] = V1.x;	mBatchV[4][j] = V1.y;	mBatchV[5][j] = V1.z;
+		mBatchV[6][j] = V2.x;	mBatchV[7][j] = V2.y;	mBatchV[8][j] = V2.z;
+		mBatchU[0][j] = U0.x;	mBatchU[1][j] = U0.y;	mBatchU[2][j] = U0.z;
+		mBatchU[3][j] = U1.x;	mBatchU[4][j] = U1.y;	mBatchU[5][j] = U1.z;
+		mBatchU[6][j] = U2.x;	mBatchU[7][j] = U2.y;	mBatchU[8][j] = U2.z;
+		mBatchIDs[0][j] = id0;
+		mBatchIDs[1][j] = id1;
+		if(++mBatchSize==OPC_PRIM_BATCH_SIZE)	FlushPrimBatch();
+		return;
+	}
+#endif
+	if(TriTriOverlap(V0, V1, V2, U0, U1, U2))
+	{
+		// Keep track of colliding pairs
+		mPairs.Add(id0).Add(id1);
+		// Set contact status
+		mFlags |= OPC_CONTACT;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Leaf-leaf test for two primitive indices.
@@ -529,9 +626,11 @@ void AABBTreeCollider::PrimTest(udword id0, udword id1)
 {
 	// Request vertices from the app
 	VertexPointers VP0;
+	ConversionArea VC0;
 	VertexPointers VP1;
-	mIMesh0->GetTriangle(VP0, id0);
-	mIMesh1->GetTriangle(VP1, id1);
+	ConversionArea VC1;
+	mIMesh0->GetTriangle(VP0, id0, VC0);
+	mIMesh1->GetTriangle(VP1, id1, VC1);
 
 	// Transform from space 1 to space 0
 	Point u0,u1,u2;
@@ -540,13 +639,7 @@ void AABBTreeCollider::PrimTest(udword id0, udword id1)
 	TransformPoint(u2, *VP1.Vertex[2], mR1to0, mT1to0);
 
 	// Perform triangle-triangle overlap test
-	if(TriTriOverlap(*VP0.Vertex[0], *VP0.Vertex[1], *VP0.Vertex[2], u0, u1, u2))
-	{
-		// Keep track of colliding pairs
-		mPairs.Add(id0).Add(id1);
-		// Set contact status
-		mFlags |= OPC_CONTACT;
-	}
+	TriTriTest(*VP0.Vertex[0], *VP0.Vertex[1], *VP0.Vertex[2], u0, u1, u2, id0, id1);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -559,16 +652,13 @@ inline_ void AABBTreeCollider::PrimTestTriIndex(udword id1)
 {
 	// Request vertices from the app
 	VertexPointers VP;
-	mIMesh1->GetTriangle(VP, id1);
+	ConversionArea VC;
+	mIMesh1->GetTriangle(VP, id1, VC);
+
+	AddFront(OPC_FRONT_TRI|OPC_FRONT_LEAF|mLeafIndex, OPC_FRONT_TRI|id1);
 
 	// Perform triangle-triangle overlap test
-	if(TriTriOverlap(mLeafVerts[0], mLeafVerts[1], mLeafVerts[2], *VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]))
-	{
-		// Keep track of colliding pairs
-		mPairs.Add(mLeafIndex).Add(id1);
-		// Set contact status
-		mFlags |= OPC_CONTACT;
-	}
+	TriTriTest(mLeafVerts[0], mLeafVerts[1], mLeafVerts[2], *VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2], mLeafIndex, id1);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -581,16 +671,13 @@ inline_ void AABBTreeCollider::PrimTestIndexTri(udword id0)
 {
 	// Request vertices from the app
 	VertexPointers VP;
-	mIMesh0->GetTriangle(VP, id0);
+	ConversionArea VC;
+	mIMesh0->GetTriangle(VP, id0, VC);
+
+	AddFront(OPC_FRONT_TRI|id0, OPC_FRONT_TRI|OPC_FRONT_LEAF|mLeafIndex);
 
 	// Perform triangle-triangle overlap test
-	if(TriTriOverlap(mLeafVerts[0], mLeafVerts[1], mLeafVerts[2], *VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]))
-	{
-		// Keep track of colliding pairs
-		mPairs.Add(id0).Add(mLeafIndex);
-		// Set contact status
-		mFlags |= OPC_CONTACT;
-	}
+	TriTriTest(mLeafVerts[0], mLeafVerts[1], mLeafVerts[2], *VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2], id0, mLeafIndex);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -602,7 +689,7 @@ inline_ void AABBTreeCollider::PrimTestIndexTri(udword id0)
 void AABBTreeCollider::_CollideTriBox(const AABBNoLeafNode* b)
 {
 	// Perform triangle-box overlap test
-	if(!TriBoxOverlap(b->mAABB.mCenter, b->mAABB.mExtents))	return;
+	if(!TriBoxOverlap(b->mAABB.mCenter, b->mAABB.mExtents))	{ AddFront(OPC_FRONT_TRI|OPC_FRONT_LEAF|mLeafIndex, FrontID1(b)); return; }
 
 	// Keep same triangle, deal with first child
 	if(b->HasPosLeaf())	PrimTestTriIndex(b->GetPosPrimitive());
@@ -624,7 +711,7 @@ void AABBTreeCollider::_CollideTriBox(const AABBNoLeafNode* b)
 void AABBTreeCollider::_CollideBoxTri(const AABBNoLeafNode* b)
 {
 	// Perform triangle-box overlap test
-	if(!TriBoxOverlap(b->mAABB.mCenter, b->mAABB.mExtents))	return;
+	if(!TriBoxOverlap(b->mAABB.mCenter, b->mAABB.mExtents))	{ AddFront(FrontID0(b), OPC_FRONT_TRI|OPC_FRONT_LEAF|mLeafIndex); return; }
 
 	// Keep same triangle, deal with first child
 	if(b->HasPosLeaf())	PrimTestIndexTri(b->GetPosPrimitive());
@@ -641,7 +728,7 @@ void AABBTreeCollider::_CollideBoxTri(const AABBNoLeafNode* b)
 #define FETCH_LEAF(prim_index, imesh, rot, trans)				\
 	mLeafIndex = prim_index;									\
 	/* Request vertices from the app */							\
-	VertexPointers VP;	imesh->GetTriangle(VP, prim_index);		\
+	VertexPointers VP;	ConversionArea VC;	imesh->GetTriangle(VP, prim_index, VC);	\
 	/* Transform them in a common space */						\
 	TransformPoint(mLeafVerts[0], *VP.Vertex[0], rot, trans);	\
 	TransformPoint(mLeafVerts[1], *VP.Vertex[1], rot, trans);	\
@@ -657,7 +744,7 @@ void AABBTreeCollider::_CollideBoxTri(const AABBNoLeafNode* b)
 void AABBTreeCollider::_Collide(const AABBNoLeafNode* a, const AABBNoLeafNode* b)
 {
 	// Perform BV-BV overlap test
-	if(!BoxBoxOverlap(a->mAABB.mExtents, a->mAABB.mCenter, b->mAABB.mExtents, b->mAABB.mCenter))	return;
+	if(!BoxBoxOverlap(a->mAABB.mExtents, a->mAABB.mCenter, b->mAABB.mExtents, b->mAABB.mCenter))	{ AddFront(FrontID0(a), FrontID1(b)); return; }
 
 	// Catch leaf status
 	BOOL BHasPosLeaf = b->HasPosLeaf();
@@ -752,9 +839,9 @@ void AABBTreeCollider::_Collide(const AABBNoLeafNode* a, const AABBNoLeafNode* b
 void AABBTreeCollider::_Collide(const AABBQuantizedNode* b0, const AABBQuantizedNode* b1, const Point& a, const Point& Pa, const Point& b, const Point& Pb)
 {
 	// Perform BV-BV overlap test
-	if(!BoxBoxOverlap(a, Pa, b, Pb))	return;
+	if(!BoxBoxOverlap(a, Pa, b, Pb))	{ AddFront(FrontID0(b0), FrontID1(b1)); return; }
 
-	if(b0->IsLeaf() && b1->IsLeaf()) { PrimTest(b0->GetPrimitive(), b1->GetPrimitive()); return; }
+	if(b0->IsLeaf() && b1->IsLeaf()) { AddFront(FrontID0(b0), FrontID1(b1)); PrimTest(b0->GetPrimitive(), b1->GetPrimitive()); return; }
 
 	if(b1->IsLeaf() || (!b0->IsLeaf() && (b0->GetSize() > b1->GetSize())))
 	{
@@ -809,7 +896,7 @@ void AABBTreeCollider::_CollideTriBox(const AABBQuantizedNoLeafNode* b)
 	const Point eb(float(bb->mExtents[0]) * mExtentsCoeff1.x, float(bb->mExtents[1]) * mExtentsCoeff1.y, float(bb->mExtents[2]) * mExtentsCoeff1.z);
 
 	// Perform triangle-box overlap test
-	if(!TriBoxOverlap(Pb, eb))	return;
+	if(!TriBoxOverlap(Pb, eb))	{ AddFront(OPC_FRONT_TRI|OPC_FRONT_LEAF|mLeafIndex, FrontID1(b)); return; }
 
 	if(b->HasPosLeaf())	PrimTestTriIndex(b->GetPosPrimitive());
 	else				_CollideTriBox(b->GetPos());
@@ -835,7 +922,7 @@ void AABBTreeCollider::_CollideBoxTri(const AABBQuantizedNoLeafNode* b)
 	const Point ea(float(bb->mExtents[0]) * mExtentsCoeff0.x, float(bb->mExtents[1]) * mExtentsCoeff0.y, float(bb->mExtents[2]) * mExtentsCoeff0.z);
 
 	// Perform triangle-box overlap test
-	if(!TriBoxOverlap(Pa, ea))	return;
+	if(!TriBoxOverlap(Pa, ea))	{ AddFront(FrontID0(b), OPC_FRONT_TRI|OPC_FRONT_LEAF|mLeafIndex); return; }
 
 	if(b->HasPosLeaf())	PrimTestIndexTri(b->GetPosPrimitive());
 	else				_CollideBoxTri(b->GetPos());
@@ -865,7 +952,7 @@ void AABBTreeCollider::_Collide(const AABBQuantizedNoLeafNode* a, const AABBQuan
 	const Point eb(float(bb->mExtents[0]) * mExtentsCoeff1.x, float(bb->mExtents[1]) * mExtentsCoeff1.y, float(bb->mExtents[2]) * mExtentsCoeff1.z);
 
 	// Perform BV-BV overlap test
-	if(!BoxBoxOverlap(ea, Pa, eb, Pb))	return;
+	if(!BoxBoxOverlap(ea, Pa, eb, Pb))	{ AddFront(FrontID0(a), FrontID1(b)); return; }
 
 	// Catch leaf status
 	BOOL BHasPosLeaf = b->HasPosLeaf();
@@ -941,3 +1028,181 @@ void AABBTreeCollider::_Collide(const AABBQuantizedNoLeafNode* a, const AABBQuan
 		else _Collide(a->GetNeg(), b->GetNeg());
 	}
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Traversal fronts
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Sets up the front of current query. The new front is recorded anyway, but the query restarts from the last one only
+ *	if it still matches the trees and the relative motion since it was built from the roots is small enough.
+ *	\param		nodes0		[in] nodes of first tree
+ *	\param		nodes1		[in] nodes of second tree
+ *	\param		extents0	[in] root box extents of first tree
+ *	\param		extents1	[in] root box extents of second tree
+ *	\return		true to restart from the last front, false to start from the roots
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL AABBTreeCollider::BeginFront(const void* nodes0, const void* nodes1, const Point& extents0, const Point& extents1)
+{
+	mNewFront = null;
+	if(!mFront)	return FALSE;
+
+	mFrontBase0	= (const ubyte*)nodes0;
+	mFrontBase1	= (const ubyte*)nodes1;
+	mNewFront	= &mFront->mEntries[mFront->mCurrent^1];
+	mNewFront->Reset();
+
+	// Trees may have been rebuilt since last time
+	if(!mFront->mValid || mFront->mNodes0!=nodes0 || mFront->mNodes1!=nodes1)	return FALSE;
+
+	// The front only goes down, so rebuild it when it grew too much
+	if(mFront->GetNbEntries() > udword(mFront->mMaxGrowth * float(mFront->mRootSize)) + 64)	return FALSE;
+
+	// Check relative motion since last rebuild
+	const float MaxTranslation = mFront->mMaxTranslation * MIN(extents0.Magnitude(), extents1.Magnitude());
+	if((mT1to0 - mFront->mT1to0).SquareMagnitude() > MaxTranslation*MaxTranslation)	return FALSE;
+
+	for(udword i=0;i<3;i++)
+	{
+		for(udword j=0;j<3;j++)
+		{
+			if(fabsf(mR1to0.m[i][j] - mFront->mR1to0.m[i][j]) > mFront->mMaxRotation)	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Keeps the front recorded by current query, and the colliding pairs, for next query.
+ *	\param		restart		[in] true if current query restarted from the last front
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBTreeCollider::EndFront(BOOL restart)
+{
+	if(!mNewFront)	return;
+
+	if(!restart)
+	{
+		// Front built from the roots
+		mFront->mR1to0		= mR1to0;
+		mFront->mT1to0		= mT1to0;
+		mFront->mNodes0		= mFrontBase0;
+		mFront->mNodes1		= mFrontBase1;
+		mFront->mRootSize	= mNewFront->GetNbEntries()>>1;
+		mFront->mValid		= true;
+	}
+	mFront->mCurrent ^= 1;
+
+	mFront->mPairs.Reset();
+	mFront->mPairs.Add(mPairs.GetEntries(), mPairs.GetNbEntries());
+
+	mNewFront = null;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collision query for normal AABB trees, from the last front.
+ *	\param		tree0			[in] AABB tree from first object
+ *	\param		tree1			[in] AABB tree from second object
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBTreeCollider::_CollideFront(const AABBCollisionTree* /*tree0*/, const AABBCollisionTree* /*tree1*/)
+{
+	const Container& Front = mFront->mEntries[mFront->mCurrent];
+	const udword* Entries = Front.GetEntries();
+	const udword Nb = Front.GetNbEntries();
+
+	for(udword i=0;i<Nb;i+=2)
+	{
+		_Collide((const AABBCollisionNode*)(mFrontBase0 + Entries[i]), (const AABBCollisionNode*)(mFrontBase1 + Entries[i+1]));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collision query for quantized AABB trees, from the last front.
+ *	\param		tree0			[in] AABB tree from first object
+ *	\param		tree1			[in] AABB tree from second object
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBTreeCollider::_CollideFront(const AABBQuantizedTree* /*tree0*/, const AABBQuantizedTree* /*tree1*/)
+{
+	const Container& Front = mFront->mEntries[mFront->mCurrent];
+	const udword* Entries = Front.GetEntries();
+	const udword Nb = Front.GetNbEntries();
+
+	for(udword i=0;i<Nb;i+=2)
+	{
+		const AABBQuantizedNode* N0 = (const AABBQuantizedNode*)(mFrontBase0 + Entries[i]);
+		const AABBQuantizedNode* N1 = (const AABBQuantizedNode*)(mFrontBase1 + Entries[i+1]);
+
+		// Dequantize boxes
+		const Point a(float(N0->mAABB.mExtents[0]) * mExtentsCoeff0.x, float(N0->mAABB.mExtents[1]) * mExtentsCoeff0.y, float(N0->mAABB.mExtents[2]) * mExtentsCoeff0.z);
+		const Point Pa(float(N0->mAABB.mCenter[0]) * mCenterCoeff0.x, float(N0->mAABB.mCenter[1]) * mCenterCoeff0.y, float(N0->mAABB.mCenter[2]) * mCenterCoeff0.z);
+		const Point b(float(N1->mAABB.mExtents[0]) * mExtentsCoeff1.x, float(N1->mAABB.mExtents[1]) * mExtentsCoeff1.y, float(N1->mAABB.mExtents[2]) * mExtentsCoeff1.z);
+		const Point Pb(float(N1->mAABB.mCenter[0]) * mCenterCoeff1.x, float(N1->mAABB.mCenter[1]) * mCenterCoeff1.y, float(N1->mAABB.mCenter[2]) * mCenterCoeff1.z);
+
+		_Collide(N0, N1, a, Pa, b, Pb);
+	}
+}
+
+//! Restarts a no-leaf traversal from a front entry: a pair of nodes, a fetched leaf and a node, or two leaves
+#define COLLIDE_NOLEAF_FRONT_ENTRY(node_type, id0, id1)											\
+	if(id0 & OPC_FRONT_LEAF)																	\
+	{																							\
+		FETCH_LEAF(id0 & OPC_FRONT_ID_MASK, mIMesh0, mR0to1, mT0to1)							\
+		if(id1 & OPC_FRONT_TRI)	PrimTestTriIndex(id1 & OPC_FRONT_ID_MASK);						\
+		else					_CollideTriBox((const node_type*)(mFrontBase1 + id1));			\
+	}																							\
+	else if(id1 & OPC_FRONT_LEAF)																\
+	{																							\
+		FETCH_LEAF(id1 & OPC_FRONT_ID_MASK, mIMesh1, mR1to0, mT1to0)							\
+		if(id0 & OPC_FRONT_TRI)	PrimTestIndexTri(id0 & OPC_FRONT_ID_MASK);						\
+		else					_CollideBoxTri((const node_type*)(mFrontBase0 + id0));			\
+	}																							\
+	else _Collide((const node_type*)(mFrontBase0 + id0), (const node_type*)(mFrontBase1 + id1));
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collision query for no-leaf AABB trees, from the last front.
+ *	\param		tree0			[in] AABB tree from first object
+ *	\param		tree1			[in] AABB tree from second object
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBTreeCollider::_CollideFront(const AABBNoLeafTree* /*tree0*/, const AABBNoLeafTree* /*tree1*/)
+{
+	const Container& Front = mFront->mEntries[mFront->mCurrent];
+	const udword* Entries = Front.GetEntries();
+	const udword Nb = Front.GetNbEntries();
+
+	for(udword i=0;i<Nb;i+=2)
+	{
+		const udword ID0 = Entries[i];
+		const udword ID1 = Entries[i+1];
+		COLLIDE_NOLEAF_FRONT_ENTRY(AABBNoLeafNode, ID0, ID1)
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collision query for quantized no-leaf AABB trees, from the last front.
+ *	\param		tree0			[in] AABB tree from first object
+ *	\param		tree1			[in] AABB tree from second object
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBTreeCollider::_CollideFront(const AABBQuantizedNoLeafTree* /*tree0*/, const AABBQuantizedNoLeafTree* /*tree1*/)
+{
+	const Container& Front = mFront->mEntries[mFront->mCurrent];
+	const udword* Entries = Front.GetEntries();
+	const udword Nb = Front.GetNbEntries();
+
+	for(udword i=0;i<Nb;i+=2)
+	{
+		const udword ID0 = Entries[i];
+		const udword ID1 = Entries[i+1];
+		COLLIDE_NOLEAF_FRONT_ENTRY(AABBQuantizedNoLeafNode, ID0, ID1)
+	}
+}
@@ -20,6 +20,9 @@
 #ifndef __OPC_TREECOLLIDER_H__
 #define __OPC_TREECOLLIDER_H__
 
+	//! Number of leaf-leaf triangle pairs tested at once when OPC_BATCH_PRIM_TESTS is defined
+	#define OPC_PRIM_BATCH_SIZE	4
+
 	//! This structure holds cached information used by the algorithm.
 	//! Two model pointers and two colliding primitives are cached. Model pointers are assigned
 	//! to their respective meshes, and the pair of colliding primitives is used for temporal
@@ -115,6 +118,16 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		inline_				void			SetFullPrimBoxTest(bool flag)			{ mFullPrimBoxTest		= flag;					}
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Settings: keeps a traversal front per pair of models, so that queries through a BVTCache restart where the last
+		 *	query of the same models stopped, instead of the roots. Fronts aren't used in "First Contact" mode.
+		 *	\param		fm		[in] front manager, or null to always start from the roots
+		 *	\see		BVTFront
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline_				void			SetFrontManager(BVTFrontManager* fm)	{ mFrontManager			= fm;					}
+
 		// Stats
 
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -201,9 +214,20 @@
 		// Leaf description
 							Point			mLeafVerts[3];		//!< Triangle vertices
 							udword			mLeafIndex;			//!< Triangle index
+		// Batched leaf-leaf tests
+							float			mBatchV[9][OPC_PRIM_BATCH_SIZE];	//!< Triangles from first object, one array per vertex coordinate
+							float			mBatchU[9][OPC_PRIM_BATCH_SIZE];	//!< Triangles from second object, in the same space
+							udword			mBatchIDs[2][OPC_PRIM_BATCH_SIZE];	//!< Primitive indices of the batched pairs
+							udword			mBatchSize;			//!< Number of batched pairs
 		// Settings
 							bool			mFullBoxBoxTest;	//!< Perform full BV-BV tests (true) or SAT-lite tests (false)
 							bool			mFullPrimBoxTest;	//!< Perform full Primitive-BV tests (true) or SAT-lite tests (false)
+		// Traversal front
+					BVTFrontManager*		mFrontManager;		//!< Fronts of model pairs, or null
+							BVTFront*		mFront;				//!< Front of current query, or null
+							Container*		mNewFront;			//!< Receives the front of current query, or null
+					const	ubyte*			mFrontBase0;		//!< Nodes of first tree, front entries are offsets from there
+					const	ubyte*			mFrontBase1;		//!< Nodes of second tree, front entries are offsets from there
 		// Internal methods
 
 			// Standard AABB trees
@@ -222,6 +246,18 @@
 							void			PrimTest(udword id0, udword id1);
 			inline_			void			PrimTestTriIndex(udword id1);
 			inline_			void			PrimTestIndexTri(udword id0);
+			inline_			void			TriTriTest(const Point& V0, const Point& V1, const Point& V2, const Point& U0, const Point& U1, const Point& U2, udword id0, udword id1);
+							void			FlushPrimBatch();
+			// Traversal front
+							BOOL			BeginFront(const void* nodes0, const void* nodes1, const Point& extents0, const Point& extents1);
+							void			EndFront(BOOL restart);
+			inline_			void			AddFront(udword id0, udword id1)	{ if(mNewFront)	mNewFront->Add(id0).Add(id1);			}
+			inline_			udword			FrontID0(const void* node)	const	{ return udword((const ubyte*)node - mFrontBase0);	}
+			inline_			udword			FrontID1(const void* node)	const	{ return udword((const ubyte*)node - mFrontBase1);	}
+							void			_CollideFront(const AABBCollisionTree* tree0, const AABBCollisionTree* tree1);
+							void			_CollideFront(const AABBNoLeafTree* tree0, const AABBNoLeafTree* tree1);
+							void			_CollideFront(const AABBQuantizedTree* tree0, const AABBQuantizedTree* tree1);
+							void			_CollideFront(const AABBQuantizedNoLeafTree* tree0, const AABBQuantizedNoLeafTree* tree1);
 
 			inline_			BOOL			BoxBoxOverlap(const Point& ea, const Point& ca, const Point& eb, const Point& cb);
 			inline_			BOOL			TriBoxOverlap(const Point& center, const Point& extents);
@@ -0,0 +1,258 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for persistent tree-collision fronts.
+ *	\file		OPC_TreeFront.cpp
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled Header
+#include "Stdafx.h"
+
+using namespace Opcode;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BVTFront::BVTFront() :
+	mMaxTranslation	(0.1f),
+	mMaxRotation	(0.05f),
+	mMaxGrowth		(2.0f),
+	mCurrent		(0),
+	mNodes0			(null),
+	mNodes1			(null),
+	mRootSize		(0),
+	mValid			(false)
+{
+	mT1to0.Zero();
+	mR1to0.Identity();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BVTFront::~BVTFront()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BVTFrontManager::BVTFrontManager() :
+	mMaxAge			(60),
+	mFronts			(null),
+	mNbFronts		(0),
+	mMaxNbFronts	(0),
+	mHashTable		(null),
+	mHashSize		(0),
+	mFrame			(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BVTFrontManager::~BVTFrontManager()
+{
+	Release();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Releases all fronts.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void BVTFrontManager::Release()
+{
+	for(udword i=0;i<mNbFronts;i++)	DELETESINGLE(mFronts[i].mFront);
+	DELETEARRAY(mFronts);
+	DELETEARRAY(mHashTable);
+	mNbFronts		= 0;
+	mMaxNbFronts	= 0;
+	mHashSize		= 0;
+}
+
+//! Hashes a pair of model pointers
+static inline_ udword HashModels(const Model* model0, const Model* model1)
+{
+	const udword h = udword(size_t(model0)>>4) * 0x9e3779b1 + udword(size_t(model1)>>4) * 0x85ebca6b;
+	return h ^ (h>>15);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Looks for the front of a pair of models.
+ *	\param		model0		[in] first model
+ *	\param		model1		[in] second model
+ *	\return		index of the front, or INVALID_ID if not found
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword BVTFrontManager::FindIndex(const Model* model0, const Model* model1) const
+{
+	if(!mHashSize)	return INVALID_ID;
+
+	udword Slot = HashModels(model0, model1) & (mHashSize-1);
+	while(mHashTable[Slot]!=INVALID_ID)
+	{
+		const FrontEntry& Entry = mFronts[mHashTable[Slot]];
+		if(Entry.mModel0==model0 && Entry.mModel1==model1)	return mHashTable[Slot];
+		Slot = (Slot+1) & (mHashSize-1);
+	}
+	return INVALID_ID;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Puts a front in the first free slot after its hash. The hash table must have one.
+ *	\param		index		[in] index of the front in mFronts
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void BVTFrontManager::InsertIndex(udword index)
+{
+	udword Slot = HashModels(mFronts[index].mModel0, mFronts[index].mModel1) & (mHashSize-1);
+	while(mHashTable[Slot]!=INVALID_ID)	Slot = (Slot+1) & (mHashSize-1);
+	mHashTable[Slot] = index;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Rebuilds the hash table from the list of fronts.
+ *	\param		size		[in] new hash table size, a power of 2
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void BVTFrontManager::RebuildHashTable(udword size)
+{
+	DELETEARRAY(mHashTable);
+	mHashTable = new udword[size];
+	mHashSize = size;
+	FillMemory(mHashTable, size*sizeof(udword), 0xff);
+
+	for(udword i=0;i<mNbFronts;i++)	InsertIndex(i);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Deletes a front and moves the last one in its place. The hash table must be rebuilt afterwards.
+ *	\param		index		[in] index of the front in mFronts
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void BVTFrontManager::DeleteFront(udword index)
+{
+	DELETESINGLE(mFronts[index].mFront);
+	mFronts[index] = mFronts[--mNbFronts];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Finds the front of a pair of models.
+ *	\param		model0		[in] first model
+ *	\param		model1		[in] second model
+ *	\return		the front, or null if that pair has none yet
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BVTFront* BVTFrontManager::FindFront(const Model* model0, const Model* model1) const
+{
+	const udword Index = FindIndex(model0, model1);
+	return Index!=INVALID_ID ? mFronts[Index].mFront : null;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Gets the front of a pair of models, and creates it on first use.
+ *	\param		model0		[in] first model
+ *	\param		model1		[in] second model
+ *	\return		the front
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BVTFront* BVTFrontManager::GetFront(const Model* model0, const Model* model1)
+{
+	const udword Index = FindIndex(model0, model1);
+	if(Index!=INVALID_ID)
+	{
+		mFronts[Index].mLastFrame = mFrame;
+		return mFronts[Index].mFront;
+	}
+
+	// Resize the list of fronts
+	if(mNbFronts==mMaxNbFronts)
+	{
+		mMaxNbFronts = mMaxNbFronts ? mMaxNbFronts*2 : 16;
+		FrontEntry* NewFronts = new FrontEntry[mMaxNbFronts];
+		if(mNbFronts)	CopyMemory(NewFronts, mFronts, mNbFronts*sizeof(FrontEntry));
+		DELETEARRAY(mFronts);
+		mFronts = NewFronts;
+	}
+
+	FrontEntry& Entry = mFronts[mNbFronts++];
+	Entry.mModel0		= model0;
+	Entry.mModel1		= model1;
+	Entry.mFront		= new BVTFront;
+	Entry.mLastFrame	= mFrame;
+
+	// Keep the hash table at most half full
+	if(mNbFronts*2>mHashSize)	RebuildHashTable(mHashSize ? mHashSize*2 : 32);
+	else						InsertIndex(mNbFronts-1);
+	return Entry.mFront;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Starts a new frame, and frees the fronts that haven't been used for more than mMaxAge frames.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void BVTFrontManager::NewFrame()
+{
+	mFrame++;
+
+	udword NbRemoved = 0;
+	udword i=0;
+	while(i<mNbFronts)
+	{
+		if(mFrame - mFronts[i].mLastFrame > mMaxAge)
+		{
+			DeleteFront(i);
+			NbRemoved++;
+		}
+		else i++;
+	}
+	if(NbRemoved)	RebuildHashTable(mHashSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Removes the fronts of a model. Must be called when the model is released, since fronts are keyed by model addresses.
+ *	\param		model		[in] the model
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void BVTFrontManager::RemoveModel(const Model* model)
+{
+	udword NbRemoved = 0;
+	udword i=0;
+	while(i<mNbFronts)
+	{
+		if(mFronts[i].mModel0==model || mFronts[i].mModel1==model)
+		{
+			DeleteFront(i);
+			NbRemoved++;
+		}
+		else i++;
+	}
+	if(NbRemoved)	RebuildHashTable(mHashSize);
+}
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for persistent tree-collision fronts.
+ *	\file		OPC_TreeFront.h
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Include Guard
+#ifndef __OPC_TREEFRONT_H__
+#define __OPC_TREEFRONT_H__
+
+	//! Front entry flag: the ID is a triangle index instead of a node offset
+	#define OPC_FRONT_TRI		0x80000000
+	//! Front entry flag: the triangle is the fetched leaf, transformed into the other model's space
+	#define OPC_FRONT_LEAF		0x40000000
+	//! Mask to get the triangle index or the node offset of a front entry
+	#define OPC_FRONT_ID_MASK	0x3fffffff
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/**
+	 *	A tree-collision front. That's the list of node pairs where the last tree-vs-tree query stopped recursing: the
+	 *	pairs whose bounding volumes didn't overlap, and the leaf pairs. The next query for the same two models restarts
+	 *	from that list instead of the roots, which skips the upper part of the traversal when objects move slowly.
+	 *
+	 *	Restarting from the front finds the same colliding pairs as a query from the roots, possibly in another order:
+	 *	colliding triangles always lie in overlapping boxes, whatever the front. (Triangles that barely touch can differ,
+	 *	when round-off made a box test above the front fail.) The front only goes down the trees though, so it's rebuilt
+	 *	from the roots when the relative motion since the last rebuild gets large, or when it grew too much.
+	 *
+	 *	\class		BVTFront
+	 *	\version	1.3
+	 *	\date		October, 18, 2026
+	 */
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	class OPCODE_API BVTFront
+	{
+		public:
+		// Constructor / Destructor
+											BVTFront();
+											~BVTFront();
+
+		//! Forces a rebuild from the roots at next query, e.g. after a model has been refit
+		inline_				void			Invalidate()					{ mValid = false;									}
+		//! Checks the front can be used by next query
+		inline_				bool			IsValid()				const	{ return mValid;									}
+		//! Gets the number of node pairs in the front
+		inline_				udword			GetNbEntries()			const	{ return mEntries[mCurrent].GetNbEntries()>>1;		}
+		//! Gets the number of colliding pairs found by the last query
+		inline_				udword			GetNbPairs()			const	{ return mPairs.GetNbEntries()>>1;					}
+		//! Gets the colliding pairs found by the last query
+		inline_				const Pair*		GetPairs()				const	{ return (const Pair*)mPairs.GetEntries();			}
+
+		// Settings
+							float			mMaxTranslation;	//!< Max relative translation since last rebuild, as a fraction of the smaller root box size
+							float			mMaxRotation;		//!< Max change of a relative rotation matrix element since last rebuild
+							float			mMaxGrowth;			//!< Max front size, as a multiple of its size after last rebuild
+		// Internal data, maintained by the tree collider
+							Container		mEntries[2];		//!< Current front and next one, as (id0, id1) couples
+							udword			mCurrent;			//!< Index of current front
+							Container		mPairs;				//!< Colliding pairs found by the last query
+							Matrix3x3		mR1to0;				//!< Relative rotation at last rebuild
+							Point			mT1to0;				//!< Relative translation at last rebuild
+					const	void*			mNodes0;			//!< Nodes of first tree at last rebuild
+					const	void*			mNodes1;			//!< Nodes of second tree at last rebuild
+							udword			mRootSize;			//!< Front size after last rebuild
+							bool			mValid;				//!< Front can be used by next query
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/**
+	 *	Keeps one front per pair of models, across queries. Give it to the tree collider with SetFrontManager().
+	 *
+	 *	Call NewFrame() once per frame: it frees the fronts no query used for mMaxAge frames, so pairs that stopped
+	 *	being tested don't pile up. Fronts are keyed by model addresses though, so a model's fronts must still be
+	 *	removed with RemoveModel() when it's released, before another model gets the same address.
+	 *
+	 *	\class		BVTFrontManager
+	 *	\version	1.3
+	 *	\date		October, 18, 2026
+	 */
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	class OPCODE_API BVTFrontManager
+	{
+		public:
+		// Constructor / Destructor
+											BVTFrontManager();
+											~BVTFrontManager();
+
+							BVTFront*		GetFront(const Model* model0, const Model* model1);
+							BVTFront*		FindFront(const Model* model0, const Model* model1)	const;
+							void			NewFrame();
+							void			RemoveModel(const Model* model);
+							void			Release();
+
+		inline_				udword			GetNbFronts()			const	{ return mNbFronts;		}
+
+		// Settings
+							udword			mMaxAge;			//!< Number of frames NewFrame() keeps an unused front
+
+		private:
+		struct FrontEntry
+		{
+			const	Model*		mModel0;
+			const	Model*		mModel1;
+					BVTFront*	mFront;
+					udword		mLastFrame;		//!< Last frame the front was used
+		};
+							FrontEntry*		mFronts;			//!< Fronts and their keys
+							udword			mNbFronts;			//!< Number of fronts
+							udword			mMaxNbFronts;		//!< Capacity of mFronts
+							udword*			mHashTable;			//!< Open-addressing hash table of indices in mFronts
+							udword			mHashSize;			//!< Hash table size, a power of 2
+							udword			mFrame;				//!< Frame counter, increased by NewFrame()
+		// Internal methods
+							udword			FindIndex(const Model* model0, const Model* model1)	const;
+							void			InsertIndex(udword index);
+							void			RebuildHashTable(udword size);
+							void			DeleteFront(udword index);
+	};
+
+#endif // __OPC_TREEFRONT_H__
@@ -154,6 +154,77 @@ BOOL CoplanarTriTri(const Point& n, const Point& v0, const Point& v1, const Poin
 	}																					\
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Second part of the triangle/triangle test, once the triangles straddle each other's plane: compares the intervals
+ *	where the triangles cross the intersection line.
+ *
+ *	\param		V0, V1, V2		[in] triangle 0
+ *	\param		U0, U1, U2		[in] triangle 1
+ *	\param		N1				[in] normal of triangle 0
+ *	\param		N2				[in] normal of triangle 1
+ *	\param		du0, du1, du2	[in] signed distances of triangle 1's vertices to triangle 0's plane
+ *	\param		dv0, dv1, dv2	[in] signed distances of triangle 0's vertices to triangle 1's plane
+ *	\return		true if triangles overlap
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ BOOL TriTriIntervalsOverlap(const Point& V0, const Point& V1, const Point& V2, const Point& U0, const Point& U1, const Point& U2, const Point& N1, const Point& N2,
+									float du0, float du1, float du2, float dv0, float dv1, float dv2)
+{
+	const float du0du1 = du0 * du1;
+	const float du0du2 = du0 * du2;
+	const float dv0dv1 = dv0 * dv1;
+	const float dv0dv2 = dv0 * dv2;
+
+	// Compute direction of intersection line
+	const Point D = N1^N2;
+
+	// Compute and index to the largest component of D
+	float max=fabsf(D[0]);
+	short index=0;
+	float bb=fabsf(D[1]);
+	float cc=fabsf(D[2]);
+	if(bb>max) max=bb,index=1;
+	if(cc>max) max=cc,index=2;
+
+	// This is the simplified projection onto L
+	const float vp0 = V0[index];
+	const float vp1 = V1[index];
+	const float vp2 = V2[index];
+
+	const float up0 = U0[index];
+	const float up1 = U1[index];
+	const float up2 = U2[index];
+
+	// Compute interval for triangle 1
+	float a,b,c,x0,x1;
+	NEWCOMPUTE_INTERVALS(vp0,vp1,vp2,dv0,dv1,dv2,dv0dv1,dv0dv2,a,b,c,x0,x1);
+
+	// Compute interval for triangle 2
+	float d,e,f,y0,y1;
+	NEWCOMPUTE_INTERVALS(up0,up1,up2,du0,du1,du2,du0du1,du0du2,d,e,f,y0,y1);
+
+	const float xx=x0*x1;
+	const float yy=y0*y1;
+	const float xxyy=xx*yy;
+
+	float isect1[2], isect2[2];
+
+	float tmp=a*xxyy;
+	isect1[0]=tmp+b*x1*yy;
+	isect1[1]=tmp+c*x0*yy;
+
+	tmp=d*xxyy;
+	isect2[0]=tmp+e*xx*y1;
+	isect2[1]=tmp+f*xx*y0;
+
+	SORT(isect1[0],isect1[1]);
+	SORT(isect2[0],isect2[1]);
+
+	if(isect1[1]<isect2[0] || isect2[1]<isect1[0]) return FALSE;
+	return TRUE;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Triangle/triangle intersection test routine,
@@ -229,51 +300,112 @@ inline_ BOOL AABBTreeCollider::TriTriOverlap(const Point& V0, const Point& V1, c
 	if(dv0dv1>0.0f && dv0dv2>0.0f)	// same sign on all of them + not equal 0 ?
 		return FALSE;				// no intersection occurs
 
-	// Compute direction of intersection line
-	const Point D = N1^N2;
-
-	// Compute and index to the largest component of D
-	float max=fabsf(D[0]);
-	short index=0;
-	float bb=fabsf(D[1]);
-	float cc=fabsf(D[2]);
-	if(bb>max) max=bb,index=1;
-	if(cc>max) max=cc,index=2;
-
-	// This is the simplified projection onto L
-	const float vp0 = V0[index];
-	const float vp1 = V1[index];
-	const float vp2 = V2[index];
-
-	const float up0 = U0[index];
-	const float up1 = U1[index];
-	const float up2 = U2[index];
+	return TriTriIntervalsOverlap(V0, V1, V2, U0, U1, U2, N1, N2, du0, du1, du2, dv0, dv1, dv2);
+}
 
-	// Compute interval for triangle 1
-	float a,b,c,x0,x1;
-	NEWCOMPUTE_INTERVALS(vp0,vp1,vp2,dv0,dv1,dv2,dv0dv1,dv0dv2,a,b,c,x0,x1);
+#ifdef OPC_BATCH_PRIM_TESTS
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Plane rejection test for a batch of triangle pairs: tests the triangles Q against the planes of the triangles P. The
+ *	operations are the scalar ones, in the same order, so a lane is rejected exactly when TriTriOverlap() would return
+ *	FALSE at the matching plane test.
+ *
+ *	\param		P		[in] OPC_PRIM_BATCH_SIZE triangles defining the planes, one array per vertex coordinate
+ *	\param		Q		[in] OPC_PRIM_BATCH_SIZE triangles to test, one array per vertex coordinate
+ *	\param		N		[out] normals of the triangles P
+ *	\param		D		[out] signed distances of Q's vertices to P's planes
+ *	\return		bit mask of the lanes where Q is not strictly on one side of P's plane
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ udword TriPlaneTest4(const float P[9][OPC_PRIM_BATCH_SIZE], const float Q[9][OPC_PRIM_BATCH_SIZE], float N[3][OPC_PRIM_BATCH_SIZE], float D[3][OPC_PRIM_BATCH_SIZE])
+{
+	// Compute plane equation of P: N.X+d=0
+	const __m128 P0x = _mm_loadu_ps(P[0]);
+	const __m128 P0y = _mm_loadu_ps(P[1]);
+	const __m128 P0z = _mm_loadu_ps(P[2]);
+	const __m128 E1x = _mm_sub_ps(_mm_loadu_ps(P[3]), P0x);
+	const __m128 E1y = _mm_sub_ps(_mm_loadu_ps(P[4]), P0y);
+	const __m128 E1z = _mm_sub_ps(_mm_loadu_ps(P[5]), P0z);
+	const __m128 E2x = _mm_sub_ps(_mm_loadu_ps(P[6]), P0x);
+	const __m128 E2y = _mm_sub_ps(_mm_loadu_ps(P[7]), P0y);
+	const __m128 E2z = _mm_sub_ps(_mm_loadu_ps(P[8]), P0z);
+	const __m128 Nx = _mm_sub_ps(_mm_mul_ps(E1y, E2z), _mm_mul_ps(E1z, E2y));
+	const __m128 Ny = _mm_sub_ps(_mm_mul_ps(E1z, E2x), _mm_mul_ps(E1x, E2z));
+	const __m128 Nz = _mm_sub_ps(_mm_mul_ps(E1x, E2y), _mm_mul_ps(E1y, E2x));
+	_mm_storeu_ps(N[0], Nx);
+	_mm_storeu_ps(N[1], Ny);
+	_mm_storeu_ps(N[2], Nz);
+	const __m128 SignMask = _mm_set1_ps(-0.0f);
+	const __m128 d = _mm_add_ps(_mm_add_ps(	_mm_mul_ps(_mm_xor_ps(Nx, SignMask), P0x),
+											_mm_mul_ps(_mm_xor_ps(Ny, SignMask), P0y)),
+											_mm_mul_ps(_mm_xor_ps(Nz, SignMask), P0z));
+
+	// Signed distances of Q's vertices to the plane
+	__m128 dq[3];
+	for(udword i=0;i<3;i++)
+	{
+		dq[i] = _mm_add_ps(_mm_add_ps(_mm_add_ps(	_mm_mul_ps(Nx, _mm_loadu_ps(Q[i*3+0])),
+													_mm_mul_ps(Ny, _mm_loadu_ps(Q[i*3+1]))),
+													_mm_mul_ps(Nz, _mm_loadu_ps(Q[i*3+2]))), d);
+#ifdef OPC_TRITRI_EPSILON_TEST
+		// Coplanarity robustness check
+		dq[i] = _mm_andnot_ps(_mm_cmplt_ps(_mm_andnot_ps(SignMask, dq[i]), _mm_set1_ps(LOCAL_EPSILON)), dq[i]);
+#endif
+		_mm_storeu_ps(D[i], dq[i]);
+	}
 
-	// Compute interval for triangle 2
-	float d,e,f,y0,y1;
-	NEWCOMPUTE_INTERVALS(up0,up1,up2,du0,du1,du2,du0du1,du0du2,d,e,f,y0,y1);
+	// Same sign on all of them + not equal 0 => no intersection occurs
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 Rejected = _mm_and_ps(	_mm_cmpgt_ps(_mm_mul_ps(dq[0], dq[1]), Zero),
+										_mm_cmpgt_ps(_mm_mul_ps(dq[0], dq[2]), Zero));
+	return ~udword(_mm_movemask_ps(Rejected)) & ((1<<OPC_PRIM_BATCH_SIZE)-1);
+}
 
-	const float xx=x0*x1;
-	const float yy=y0*y1;
-	const float xxyy=xx*yy;
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Leaf-leaf test for the batched triangle pairs. The two plane rejection tests of TriTriOverlap() run on the whole batch
+ *	at once, and the pairs they don't reject finish with the scalar interval test, so the results are the same as testing
+ *	pairs one at a time. Colliding pairs are reported in batch order.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBTreeCollider::FlushPrimBatch()
+{
+	if(!mBatchSize)	return;
 
-	float isect1[2], isect2[2];
+	// Fill unused lanes with the first pair, their results are ignored
+	for(udword j=mBatchSize;j<OPC_PRIM_BATCH_SIZE;j++)
+	{
+		for(udword i=0;i<9;i++)
+		{
+			mBatchV[i][j] = mBatchV[i][0];
+			mBatchU[i][j] = mBatchU[i][0];
+		}
+	}
 
-	float tmp=a*xxyy;
-	isect1[0]=tmp+b*x1*yy;
-	isect1[1]=tmp+c*x0*yy;
+	// Stats
+	mNbPrimPrimTests += mBatchSize;
 
-	tmp=d*xxyy;
-	isect2[0]=tmp+e*xx*y1;
-	isect2[1]=tmp+f*xx*y0;
+	float N1[3][OPC_PRIM_BATCH_SIZE], DU[3][OPC_PRIM_BATCH_SIZE];
+	float N2[3][OPC_PRIM_BATCH_SIZE], DV[3][OPC_PRIM_BATCH_SIZE];
+	udword Mask = TriPlaneTest4(mBatchV, mBatchU, N1, DU);
+	if(Mask)	Mask &= TriPlaneTest4(mBatchU, mBatchV, N2, DV);
 
-	SORT(isect1[0],isect1[1]);
-	SORT(isect2[0],isect2[1]);
+	for(udword j=0;j<mBatchSize;j++)
+	{
+		// Rejected pairs are done
+		if(!(Mask & (1<<j)))	continue;
 
-	if(isect1[1]<isect2[0] || isect2[1]<isect1[0]) return FALSE;
-	return TRUE;
+		if(TriTriIntervalsOverlap(	Point(mBatchV[0][j], mBatchV[1][j], mBatchV[2][j]), Point(mBatchV[3][j], mBatchV[4][j], mBatchV[5][j]), Point(mBatchV[6][j], mBatchV[7][j], mBatchV[8][j]),
+									Point(mBatchU[0][j], mBatchU[1][j], mBatchU[2][j]), Point(mBatchU[3][j], mBatchU[4][j], mBatchU[5][j]), Point(mBatchU[6][j], mBatchU[7][j], mBatchU[8][j]),
+									Point(N1[0][j], N1[1][j], N1[2][j]), Point(N2[0][j], N2[1][j], N2[2][j]),
+									DU[0][j], DU[1][j], DU[2][j], DV[0][j], DV[1][j], DV[2][j]))
+		{
+			// Keep track of colliding pairs
+			mPairs.Add(mBatchIDs[0][j]).Add(mBatchIDs[1][j]);
+			// Set contact status
+			mFlags |= OPC_CONTACT;
+		}
+	}
+	mBatchSize = 0;
 }
+#endif
@@ -101,3 +101,15 @@ IMPLEMENT_NOLEAFDUMP(AABBQuantizedNoLeafNode)
 
 IMPLEMENT_LEAFDUMP(AABBCollisionNode)
 IMPLEMENT_LEAFDUMP(AABBQuantizedNode)
+
+void VolumeCollider::_Dump(const AABBWideNode* node)
+{
+	udword NbChildren = node->GetNbChildren();
+	for(udword i=0;i<NbChildren;i++)
+	{
+		if(node->IsLeaf(i))	mTouchedPrimitives->Add(node->GetPrimitive(i));
+		else				_Dump(node->GetChild(i));
+
+		if(ContactFound()) return;
+	}
+}
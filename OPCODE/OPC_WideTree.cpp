@@ -0,0 +1,398 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for wide (4-ary) optimized trees.
+ *	\file		OPC_WideTree.cpp
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	A wide AABB tree: the binary tree is collapsed into nodes of 4 children, whose boxes are stored coordinate by
+ *	coordinate (SoA layout). Colliders test the 4 boxes of a node at once with SSE, and the tree has about half the
+ *	nodes of a no-leaf tree, i.e. half the traversal steps.
+ *
+ *	Supported by the ray, sphere and AABB colliders.
+ *
+ *	\class		AABBWideTree
+ *	\version	1.3
+ *	\date		October, 18, 2026
+*/
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled Header
+#include "Stdafx.h"
+
+using namespace Opcode;
+
+//! Costs of a subtree of the input tree, when split into 1 to 4 children of a wide node [wide build]
+struct WideCost
+{
+	float	mCost[OPC_WIDE_NODE_SIZE+1];	//!< mCost[k] = cost of the wide nodes below k children covering the subtree. mCost[0] is unused.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Half surface area of a box.
+ *	\param		box		[in] the box
+ *	\return		half surface area
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static float HalfArea(const AABB& box)
+{
+	Point Extents;
+	box.GetExtents(Extents);
+	return Extents.x*Extents.y + Extents.y*Extents.z + Extents.z*Extents.x;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes the costs of a subtree of the input tree [wide build]. A wide node costs the area of its box, i.e. how likely
+ *	a query is to visit it: the total is the expected number of wide nodes visited. Leaves cost nothing, their triangles
+ *	are tested anyway. Collapsing greedily instead leaves many wide nodes with 2 children near the leaves.
+ *
+ *	Nodes of the input tree are indexed in depth-first order: the positive child comes next, and the negative child after
+ *	the 2*N-1 nodes of the positive subtree since the input tree is complete.
+ *
+ *	\param		costs			[out] costs of all nodes
+ *	\param		index			[in] index of the current node
+ *	\param		current_node	[in] current node from input tree
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _ComputeWideCosts(WideCost* costs, const udword index, const AABBTreeNode* current_node)
+{
+	WideCost& Current = costs[index];
+	if(current_node->IsLeaf())
+	{
+		// A leaf is a single child
+		Current.mCost[1] = 0.0f;
+		for(udword k=2;k<=OPC_WIDE_NODE_SIZE;k++)	Current.mCost[k] = MAX_FLOAT;
+		return;
+	}
+
+	const AABBTreeNode* P = current_node->GetPos();
+	const AABBTreeNode* N = current_node->GetNeg();
+	const udword PosIndex = index + 1;
+	const udword NegIndex = PosIndex + P->GetNbPrimitives()*2 - 1;
+	_ComputeWideCosts(costs, PosIndex, P);
+	_ComputeWideCosts(costs, NegIndex, N);
+
+	// k children: k1 from the positive subtree, k-k1 from the negative one
+	float Best = MAX_FLOAT;
+	for(udword k=2;k<=OPC_WIDE_NODE_SIZE;k++)
+	{
+		Current.mCost[k] = MAX_FLOAT;
+		for(udword k1=1;k1<k;k1++)
+		{
+			float Cost = costs[PosIndex].mCost[k1] + costs[NegIndex].mCost[k-k1];
+			if(Cost<Current.mCost[k])	Current.mCost[k] = Cost;
+		}
+		if(Current.mCost[k]<Best)	Best = Current.mCost[k];
+	}
+
+	// A single child: a wide node of its own
+	Current.mCost[1] = HalfArea(*current_node->GetAABB()) + Best;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collects the children of a wide node covering a subtree, following the costs [wide build].
+ *	\param		costs			[in] costs of all nodes
+ *	\param		index			[in] index of the current node
+ *	\param		current_node	[in] current node from input tree
+ *	\param		nb_children		[in] number of children covering the current node
+ *	\param		children		[out] children
+ *	\param		indices			[out] indices of the children
+ *	\param		nb				[in/out] number of children collected so far
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _CollectWideChildren(const WideCost* costs, const udword index, const AABBTreeNode* current_node, udword nb_children, const AABBTreeNode** children, udword* indices, udword& nb)
+{
+	if(nb_children==1)
+	{
+		children[nb] = current_node;
+		indices[nb] = index;
+		nb++;
+		return;
+	}
+
+	const AABBTreeNode* P = current_node->GetPos();
+	const AABBTreeNode* N = current_node->GetNeg();
+	const udword PosIndex = index + 1;
+	const udword NegIndex = PosIndex + P->GetNbPrimitives()*2 - 1;
+
+	udword NbPos = 1;
+	float Best = MAX_FLOAT;
+	for(udword k1=1;k1<nb_children;k1++)
+	{
+		float Cost = costs[PosIndex].mCost[k1] + costs[NegIndex].mCost[nb_children-k1];
+		if(Cost<Best)
+		{
+			Best = Cost;
+			NbPos = k1;
+		}
+	}
+	_CollectWideChildren(costs, PosIndex, P, NbPos, children, indices, nb);
+	_CollectWideChildren(costs, NegIndex, N, nb_children-NbPos, children, indices, nb);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds a wide tree from a complete binary one. Each wide node covers a subtree of the input tree with the 2 to 4
+ *	children of least cost, the most children on ties. Children nodes take consecutive indices.
+ *
+ *	Layout for wide trees:
+ *	Node:
+ *			- 4 boxes, stored as X centers, Y centers, ..., Z extents
+ *			- 4 data (32-bits values)
+ *
+ *	if data's LSB = 1 =>	remaining bits are a primitive pointer
+ *	else if data != 0 =>	data is the offset in bytes from the node to the child node
+ *	else					the slot is empty, and so are the next ones. Its box is inverted so that it never overlaps.
+ *
+ *	\relates	AABBWideNode
+ *	\fn			_BuildWideTree(AABBWideNode* linear, const udword box_id, udword& current_id, const WideCost* costs, const udword index, const AABBTreeNode* current_node)
+ *	\param		linear			[in] base address of destination nodes
+ *	\param		box_id			[in] index of destination node
+ *	\param		current_id		[in] current running index
+ *	\param		costs			[in] costs of all input nodes
+ *	\param		index			[in] index of the current input node
+ *	\param		current_node	[in] current node from input tree
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _BuildWideTree(AABBWideNode* linear, const udword box_id, udword& current_id, const WideCost* costs, const udword index, const AABBTreeNode* current_node)
+{
+	// Leaf nodes here?!
+	ASSERT(!current_node->IsLeaf());
+
+	// Collect the children
+	udword NbChildren = 2;
+	for(udword k=3;k<=OPC_WIDE_NODE_SIZE;k++)
+	{
+		if(costs[index].mCost[k]<=costs[index].mCost[NbChildren])	NbChildren = k;
+	}
+	const AABBTreeNode* Children[OPC_WIDE_NODE_SIZE];
+	udword Indices[OPC_WIDE_NODE_SIZE];
+	udword Nb = 0;
+	_CollectWideChildren(costs, index, current_node, NbChildren, Children, Indices, Nb);
+	ASSERT(Nb==NbChildren);
+
+	// Setup the slots, and get new ids for children nodes
+	AABBWideNode& Current = linear[box_id];
+	udword ChildID[OPC_WIDE_NODE_SIZE];
+	for(udword i=0;i<OPC_WIDE_NODE_SIZE;i++)
+	{
+		if(i>=NbChildren)
+		{
+			// Empty slot
+			Current.mCenterX[i] = Current.mCenterY[i] = Current.mCenterZ[i] = 0.0f;
+			Current.mExtentsX[i] = Current.mExtentsY[i] = Current.mExtentsZ[i] = -MAX_FLOAT;
+			Current.mData[i] = 0;
+			continue;
+		}
+
+		Point Center, Extents;
+		Children[i]->GetAABB()->GetCenter(Center);
+		Children[i]->GetAABB()->GetExtents(Extents);
+		Current.mCenterX[i] = Center.x;		Current.mExtentsX[i] = Extents.x;
+		Current.mCenterY[i] = Center.y;		Current.mExtentsY[i] = Extents.y;
+		Current.mCenterZ[i] = Center.z;		Current.mExtentsZ[i] = Extents.z;
+
+		if(Children[i]->IsLeaf())
+		{
+			// The input tree must be complete => i.e. one primitive/leaf
+			ASSERT(Children[i]->GetNbPrimitives()==1);
+			Current.mData[i] = (Children[i]->GetPrimitives()[0]<<1)|1;
+		}
+		else
+		{
+			ChildID[i] = current_id++;
+			Current.mData[i] = (ChildID[i] - box_id)*sizeof(AABBWideNode);
+			// Make sure it's not marked as leaf
+			ASSERT(!(Current.mData[i]&1));
+		}
+	}
+
+	// Recurse
+	for(udword i=0;i<NbChildren;i++)
+	{
+		if(!Children[i]->IsLeaf())	_BuildWideTree(linear, ChildID[i], current_id, costs, Indices[i], Children[i]);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+AABBWideTree::AABBWideTree() : mNodes(null)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+AABBWideTree::~AABBWideTree()
+{
+	ReleaseNodes();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds the collision tree from a generic AABB tree. The conversion is serial: the number of wide nodes in a subtree
+ *	isn't known in advance, and the conversion is cheap next to the build of the generic tree.
+ *	\param		tree			[in] generic AABB tree
+ *	\param		pool			[in] pool of build threads, unused
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBWideTree::Build(AABBTree* tree, TaskPool* /*pool*/)
+{
+	// Checkings
+	if(!tree)	return false;
+	// Check the input tree is complete
+	udword NbTriangles	= tree->GetNbPrimitives();
+	udword NbNodes		= tree->GetNbNodes();
+	if(NbNodes!=NbTriangles*2-1 || NbTriangles<2)	return false;
+
+	// Compute the costs of the input nodes
+	WideCost* Costs = new WideCost[NbNodes];
+	CHECKALLOC(Costs);
+	_ComputeWideCosts(Costs, 0, tree);
+
+	// Build the tree in a temporary array, large enough for a no-leaf tree
+	AABBWideNode* Nodes = new AABBWideNode[NbTriangles-1];
+	CHECKALLOC(Nodes);
+	udword CurID = 1;
+	_BuildWideTree(Nodes, 0, CurID, Costs, 0, tree);
+	DELETEARRAY(Costs);
+
+	// Get nodes
+	if(mNbNodes!=CurID || mExternalNodes)	// Same number of nodes => keep moving
+	{
+		mNbNodes = CurID;
+		ReleaseNodes();
+		mNodes = new AABBWideNode[mNbNodes];
+		CHECKALLOC(mNodes);
+	}
+	CopyMemory(mNodes, Nodes, mNbNodes*sizeof(AABBWideNode));
+	DELETEARRAY(Nodes);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Refits the collision tree after vertices have been modified.
+ *	\param		mesh_interface	[in] mesh interface for current model
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBWideTree::Refit(const MeshInterface* mesh_interface)
+{
+	// Checkings
+	if(!mesh_interface)	return false;
+
+	// Bottom-up update: children nodes always come after their parent
+	VertexPointers VP;
+	ConversionArea VC;
+	Point Min,Max;
+	Point Min_,Max_;
+	udword Index = mNbNodes;
+	while(Index--)
+	{
+		AABBWideNode& Current = mNodes[Index];
+
+		udword NbChildren = Current.GetNbChildren();
+		for(udword i=0;i<NbChildren;i++)
+		{
+			if(Current.IsLeaf(i))
+			{
+				// Triangle's box
+				mesh_interface->GetTriangle(VP, Current.GetPrimitive(i), VC);
+				Min = Max = *VP.Vertex[0];
+				Min.Min(*VP.Vertex[1]);	Max.Max(*VP.Vertex[1]);
+				Min.Min(*VP.Vertex[2]);	Max.Max(*VP.Vertex[2]);
+			}
+			else
+			{
+				// Union of the child node's boxes
+				const AABBWideNode* Child = Current.GetChild(i);
+				udword NbGrandChildren = Child->GetNbChildren();
+				Min.Set(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+				Max.Set(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+				for(udword j=0;j<NbGrandChildren;j++)
+				{
+					Min_.Set(Child->mCenterX[j] - Child->mExtentsX[j], Child->mCenterY[j] - Child->mExtentsY[j], Child->mCenterZ[j] - Child->mExtentsZ[j]);
+					Max_.Set(Child->mCenterX[j] + Child->mExtentsX[j], Child->mCenterY[j] + Child->mExtentsY[j], Child->mCenterZ[j] + Child->mExtentsZ[j]);
+					Min.Min(Min_);
+					Max.Max(Max_);
+				}
+			}
+			Current.mCenterX[i] = (Max.x + Min.x)*0.5f;		Current.mExtentsX[i] = (Max.x - Min.x)*0.5f;
+			Current.mCenterY[i] = (Max.y + Min.y)*0.5f;		Current.mExtentsY[i] = (Max.y - Min.y)*0.5f;
+			Current.mCenterZ[i] = (Max.z + Min.z)*0.5f;		Current.mExtentsZ[i] = (Max.z - Min.z)*0.5f;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Walks the tree and call the user back for each node.
+ *	\param		callback	[in] walking callback
+ *	\param		user_data	[in] callback's user data
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBWideTree::Walk(GenericWalkingCallback callback, void* user_data) const
+{
+	if(!callback)	return false;
+
+	struct Local
+	{
+		static void _Walk(const AABBWideNode* current_node, GenericWalkingCallback callback, void* user_data)
+		{
+			if(!current_node || !(callback)(current_node, user_data))	return;
+
+			udword NbChildren = current_node->GetNbChildren();
+			for(udword i=0;i<NbChildren;i++)
+			{
+				if(!current_node->IsLeaf(i))	_Walk(current_node->GetChild(i), callback, user_data);
+			}
+		}
+	};
+	Local::_Walk(mNodes, callback, user_data);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Checks the child links of the nodes, e.g. after SetExternalNodes().
+ *	\param		nb_primitives	[in] number of primitives the leaves refer to
+ *	\return		true if the links are valid
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBWideTree::Check(udword nb_primitives) const
+{
+	for(udword i=0;i<mNbNodes;i++)
+	{
+		udword NbChildren = mNodes[i].GetNbChildren();
+		for(udword j=0;j<NbChildren;j++)
+		{
+			if(!CheckLink(mNodes[i].mData[j], i, sizeof(AABBWideNode), 0, nb_primitives))	return false;
+		}
+	}
+	return true;
+}
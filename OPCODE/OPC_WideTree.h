@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for wide (4-ary) optimized trees.
+ *	\file		OPC_WideTree.h
+ *	\date		October, 18, 2026
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Include Guard
+#ifndef __OPC_WIDETREE_H__
+#define __OPC_WIDETREE_H__
+
+	//! Number of children of a wide node
+	#define OPC_WIDE_NODE_SIZE	4
+
+	class OPCODE_API AABBWideNode
+	{
+		public:
+		// Constructor / Destructor
+		inline_								AABBWideNode()		{}
+		inline_								~AABBWideNode()		{}
+		// Child tests
+		inline_			BOOL				IsEmpty(udword i)		const	{ return !mData[i];					}
+		inline_			BOOL				IsLeaf(udword i)		const	{ return mData[i]&1;				}
+		// Data access
+		inline_			const AABBWideNode*	GetChild(udword i)		const	{ return (AABBWideNode*)(((ubyte*)this)+mData[i]);	}
+		inline_			udword				GetPrimitive(udword i)	const	{ return (mData[i]>>1);				}
+		inline_			void				GetCenter(udword i, Point& center)		const	{ center.Set(mCenterX[i], mCenterY[i], mCenterZ[i]);		}
+		inline_			void				GetExtents(udword i, Point& extents)	const	{ extents.Set(mExtentsX[i], mExtentsY[i], mExtentsZ[i]);	}
+		// Children are packed at the front, empty slots at the back
+		inline_			udword				GetNbChildren()			const
+											{
+												udword Nb = 0;
+												while(Nb<OPC_WIDE_NODE_SIZE && mData[Nb])	Nb++;
+												return Nb;
+											}
+		// Stats
+		inline_			udword				GetNodeSize()			const	{ return SIZEOFOBJECT;				}
+
+		// Children boxes, one array per coordinate so that SIMD code tests all the boxes at once
+						float				mCenterX[OPC_WIDE_NODE_SIZE];
+						float				mCenterY[OPC_WIDE_NODE_SIZE];
+						float				mCenterZ[OPC_WIDE_NODE_SIZE];
+						float				mExtentsX[OPC_WIDE_NODE_SIZE];
+						float				mExtentsY[OPC_WIDE_NODE_SIZE];
+						float				mExtentsZ[OPC_WIDE_NODE_SIZE];
+		// Children data, as in no-leaf nodes: primitive index if LSB = 1, else offset in bytes to the child node. 0 for empty slots.
+						udword				mData[OPC_WIDE_NODE_SIZE];
+	};
+
+	class OPCODE_API AABBWideTree : public AABBOptimizedTree
+	{
+		IMPLEMENT_COLLISION_TREE(AABBWideTree, AABBWideNode)
+	};
+
+#endif // __OPC_WIDETREE_H__
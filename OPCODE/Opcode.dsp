@@ -336,6 +336,14 @@ SOURCE=.\OPC_Model.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\OPC_ModelFile.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\OPC_ModelFile.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\OPC_OBBCollider.cpp
 # End Source File
 # Begin Source File
@@ -376,6 +384,14 @@ SOURCE=.\OPC_PlanesTriOverlap.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\OPC_Query.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\OPC_Query.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\OPC_RayAABBOverlap.h
 # End Source File
 # Begin Source File
@@ -420,6 +436,14 @@ SOURCE=.\OPC_SweepAndPrune.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\OPC_TaskPool.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\OPC_TaskPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\OPC_TreeBuilders.cpp
 # End Source File
 # Begin Source File
@@ -436,6 +460,14 @@ SOURCE=.\OPC_TreeCollider.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\OPC_TreeFront.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\OPC_TreeFront.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\OPC_TriBoxOverlap.h
 # End Source File
 # Begin Source File
@@ -452,6 +484,14 @@ SOURCE=.\OPC_VolumeCollider.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\OPC_WideTree.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\OPC_WideTree.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\Opcode.cpp
 # End Source File
 # Begin Source File
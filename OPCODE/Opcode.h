@@ -80,17 +80,21 @@
 		#include "OPC_Common.h"
 		#include "OPC_MeshInterface.h"
 		// Builders
+		#include "OPC_TaskPool.h"
 		#include "OPC_TreeBuilders.h"
 		// Trees
 		#include "OPC_AABBTree.h"
 		#include "OPC_OptimizedTree.h"
+		#include "OPC_WideTree.h"
 		// Models
+		#include "OPC_ModelFile.h"
 		#include "OPC_BaseModel.h"
 		#include "OPC_Model.h"
 		#include "OPC_HybridModel.h"
 		// Colliders
 		#include "OPC_Collider.h"
 		#include "OPC_VolumeCollider.h"
+		#include "OPC_TreeFront.h"
 		#include "OPC_TreeCollider.h"
 		#include "OPC_RayCollider.h"
 		#include "OPC_SphereCollider.h"
@@ -100,6 +104,7 @@
 		#include "OPC_PlanesCollider.h"
 		// Usages
 		#include "OPC_Picking.h"
+		#include "OPC_Query.h"
 		// Sweep-and-prune
 		#include "OPC_BoxPruning.h"
 		#include "OPC_SweepAndPrune.h"
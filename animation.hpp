@@ -4,8 +4,11 @@
 //* Date Made: 11/19/04                                                     *//
 //* File Desc: Class declaration and implementation details                 *//
 //*            representing an object animation.                            *//
-//* Rev. Date:                                                              *//
-//* Rev. Desc:                                                              *//
+//* Rev. Date: 10/18/26                                                     *//
+//* Rev. Desc: Compiled clips: keyframes held in flat arrays shared by all  *//
+//*            animated bodies, with binary clip file loading.              *//
+//*            Layered mixer blending clips with per-part masks.            *//
+//*            Layer channels of all bodies stepped in one batch.           *//
 //*                                                                         *//
 //***************************************************************************//
 
@@ -13,243 +16,662 @@
 #define __ANIMATION_HPP__
 
 #include <GL/gl.h>
-#include <list>
+#include <stdio.h>
+#include <vector>
+#include <deque>
 #include "body.hpp"
 
-// Body part animation.
-class AnimPart
+// Animation channels of a keyframe.
+#define ANIM_NUM_CHANNELS 6
+enum { ANIM_TX=0, ANIM_TY=1, ANIM_TZ=2, ANIM_RX=3, ANIM_RY=4, ANIM_RZ=5 };
+
+// Clip file identification.
+#define ANIM_FILE_MAGIC 0x4d494e41
+#define ANIM_FILE_VERSION 1
+
+// Step channel values toward their targets at the given speeds,
+// scaled by per-channel speed factors. A channel with a zero speed
+// is not animated. Channels are independent, so a batch may hold
+// keys of any number of clusters and bodies. Returns number of
+// channels not at their targets.
+inline int animStep(int count, const GLfloat *target, const GLfloat *speed,
+	const GLfloat *factor, const GLfloat *current, GLfloat *delta)
+{
+	int i,pending;
+	GLfloat s,d;
+
+	pending = 0;
+	for (i = 0; i < count; i++)
+	{
+		s = speed[i] * factor[i];
+		s = s < 0.0f ? 0.0f : s;
+		d = target[i] - current[i];
+		d = d > s ? s : d;
+		d = d < -s ? -s : d;
+		delta[i] = speed[i] > 0.0f ? d : 0.0f;
+		pending += (speed[i] > 0.0f && target[i] != current[i]);
+	}
+	return pending;
+}
+
+// Compiled animation clip: a sequence of clusters of concurrent
+// body part keyframes. Immutable once built, so one clip is shared
+// by the animations of all bodies with the same skeleton.
+class AnimClip
 {
 public:
 
-	// Body part to animate.
-	BodyPart *part;
+	// Cluster boundaries: cluster i holds keys clusters[i] to
+	// clusters[i+1]-1; the last entry is the number of keys.
+	std::vector<int> clusters;
 
-	// Target translation and speeds.
-	GLfloat tx,ty,tz;
-	GLfloat txs, tys, tzs;
+	// Body part index of each key.
+	std::vector<int> parts;
 
-	// Target rotation and speeds.
-	GLfloat rx,ry,rz;
-	GLfloat rxs, rys, rzs;
+	// Target values and speeds: ANIM_NUM_CHANNELS per key.
+	std::vector<GLfloat> targets;
+	std::vector<GLfloat> speeds;
 
-	AnimPart()
+	AnimClip()
 	{
-		tx = ty = tz = 0.0;
-		txs = tys = tzs = 0.0;
-		rx = ry = rz = 0.0;
-		rxs = rys = rzs = 0.0;
+		clusters.push_back(0);
 	}
 
-	// Transform part: return true if transforms done.
-	bool run(float speedFactor)
+	int numClusters() { return (int)clusters.size() - 1; }
+	int numKeys() { return (int)parts.size(); }
+
+	// Parts animated by clip: bit per part index.
+	unsigned int partMask()
 	{
-		GLfloat delta;
-		GLfloat forward[3];
-		GLfloat speed;
-		bool done = true;
+		unsigned int mask = 0;
+
+		for (int i = 0; i < numKeys(); i++) mask |= (1 << parts[i]);
+		return mask;
+	}
+
+	// Start a new cluster.
+	void addCluster()
+	{
+		clusters.push_back(clusters.back());
+	}
 
-		// Translations.
-		part->transform.spacial->getForward(forward);
-		delta = tx - part->transform.tx;
-		speed = speedFactor * txs;
-		if (speed < 0.0) speed = 0.0;
-		if (txs > 0.0 && fabs(delta) > 0.0)
+	// Add a key to the current cluster.
+	void addKey(int part, const GLfloat *target, const GLfloat *speed)
+	{
+		parts.push_back(part);
+		for (int i = 0; i < ANIM_NUM_CHANNELS; i++)
 		{
-			done = false;
-			if (delta > 0.0 && delta > speed)
-			{
-				delta = speed;
-			} else if (delta < 0.0 && -delta > speed)
-			{
-					delta = -speed;
-			}
-			part->transform.tx += forward[0] + delta;
+			targets.push_back(target[i]);
+			speeds.push_back(speed[i]);
 		}
-		delta = ty - part->transform.ty;
-		speed = speedFactor * tys;
-		if (speed < 0.0) speed = 0.0;
-		if (tys > 0.0 && fabs(delta) > 0.0)
+		clusters.back()++;
+	}
+
+	// Add a pitch-only key to the current cluster.
+	void addPitch(int part, GLfloat rx, GLfloat rxs)
+	{
+		GLfloat target[ANIM_NUM_CHANNELS],speed[ANIM_NUM_CHANNELS];
+
+		for (int i = 0; i < ANIM_NUM_CHANNELS; i++)
 		{
-			done = false;
-			if (delta > 0.0 && delta > speed)
-			{
-				delta = speed;
-			} else if (delta < 0.0 && -delta > speed)
-			{
-					delta = -speed;
-			}
-			part->transform.ty += forward[1] + delta;
+			target[i] = speed[i] = 0.0;
 		}
-		delta = tz - part->transform.tz;
-		speed = speedFactor * tzs;
-		if (speed < 0.0) speed = 0.0;
-		if (tzs > 0.0 && fabs(delta) > 0.0)
+		target[ANIM_RX] = rx;
+		speed[ANIM_RX] = rxs;
+		addKey(part, target, speed);
+	}
+
+	// Save clip.
+	bool save(FILE *fp)
+	{
+		int n[2];
+
+		n[0] = numClusters();
+		n[1] = numKeys();
+		if (fwrite(n, sizeof(int), 2, fp) != 2) return false;
+		if (fwrite(&clusters[0], sizeof(int), n[0] + 1, fp) != n[0] + 1) return false;
+		if (n[1] == 0) return true;
+		if (fwrite(&parts[0], sizeof(int), n[1], fp) != n[1]) return false;
+		if (fwrite(&targets[0], sizeof(GLfloat), n[1] * ANIM_NUM_CHANNELS, fp) !=
+			n[1] * ANIM_NUM_CHANNELS) return false;
+		if (fwrite(&speeds[0], sizeof(GLfloat), n[1] * ANIM_NUM_CHANNELS, fp) !=
+			n[1] * ANIM_NUM_CHANNELS) return false;
+		return true;
+	}
+
+	// Load clip: body part indexes must be less than numParts.
+	bool load(FILE *fp, int numParts)
+	{
+		int i,n[2];
+		long here,left;
+
+		if (fread(n, sizeof(int), 2, fp) != 2) return false;
+		if (n[0] < 0 || n[1] < 0) return false;
+
+		// Counts must fit in the rest of the file: the cluster
+		// offsets, then a part and the channel targets and speeds
+		// per key, all 4 bytes.
+		if ((here = ftell(fp)) < 0 || fseek(fp, 0, SEEK_END) != 0) return false;
+		left = ftell(fp) - here;
+		if (fseek(fp, here, SEEK_SET) != 0 || left < 0) return false;
+		left /= sizeof(int);
+		if (n[0] >= left) return false;
+		left -= n[0] + 1;
+		if (n[1] > left / (1 + (2 * ANIM_NUM_CHANNELS))) return false;
+		clusters.resize(n[0] + 1);
+		parts.resize(n[1]);
+		targets.resize(n[1] * ANIM_NUM_CHANNELS);
+		speeds.resize(n[1] * ANIM_NUM_CHANNELS);
+		if (fread(&clusters[0], sizeof(int), n[0] + 1, fp) != n[0] + 1) return false;
+		if (clusters[0] != 0 || clusters[n[0]] != n[1]) return false;
+		for (i = 0; i < n[0]; i++)
 		{
-			done = false;
-			if (delta > 0.0 && delta > speed)
-			{
-				delta = speed;
-			} else if (delta < 0.0 && -delta > speed)
-			{
-					delta = -speed;
-			}
-			part->transform.tz += forward[2] + delta;
+			if (clusters[i + 1] < clusters[i]) return false;
 		}
+		if (n[1] == 0) return true;
+		if (fread(&parts[0], sizeof(int), n[1], fp) != n[1]) return false;
+		for (i = 0; i < n[1]; i++)
+		{
+			if (parts[i] < 0 || parts[i] >= numParts) return false;
+		}
+		if (fread(&targets[0], sizeof(GLfloat), n[1] * ANIM_NUM_CHANNELS, fp) !=
+			n[1] * ANIM_NUM_CHANNELS) return false;
+		if (fread(&speeds[0], sizeof(GLfloat), n[1] * ANIM_NUM_CHANNELS, fp) !=
+			n[1] * ANIM_NUM_CHANNELS) return false;
+		return true;
+	}
+};
+
+// Save clips to binary file.
+inline bool saveAnimClips(char *filename, std::vector<AnimClip *> &clips)
+{
+	FILE *fp;
+	int h[3];
+	bool ok;
+
+	if ((fp = fopen(filename, "wb")) == NULL) return false;
+	h[0] = ANIM_FILE_MAGIC;
+	h[1] = ANIM_FILE_VERSION;
+	h[2] = (int)clips.size();
+	ok = (fwrite(h, sizeof(int), 3, fp) == 3);
+	for (int i = 0; ok && i < h[2]; i++)
+	{
+		ok = clips[i]->save(fp);
+	}
+	fclose(fp);
+	return ok;
+}
 
-		// Pitch.
-		delta = rx - part->transform.rx;
-		speed = speedFactor * rxs;
-		if (speed < 0.0) speed = 0.0;
-		if (rxs > 0.0 && fabs(delta) > 0.0)
+// Load clips from binary file: on failure, clips is unchanged.
+inline bool loadAnimClips(char *filename, int numParts, std::vector<AnimClip *> &clips)
+{
+	FILE *fp;
+	int i,h[3];
+	bool ok;
+	std::vector<AnimClip *> loaded;
+
+	if ((fp = fopen(filename, "rb")) == NULL) return false;
+	ok = (fread(h, sizeof(int), 3, fp) == 3 &&
+		h[0] == ANIM_FILE_MAGIC && h[1] == ANIM_FILE_VERSION && h[2] >= 0);
+	for (i = 0; ok && i < h[2]; i++)
+	{
+		loaded.push_back(new AnimClip());
+		ok = loaded.back()->load(fp, numParts);
+	}
+	fclose(fp);
+	if (!ok)
+	{
+		for (i = 0; i < (int)loaded.size(); i++) delete loaded[i];
+		return false;
+	}
+	clips = loaded;
+	return true;
+}
+
+// Layer channel arrays of all animated bodies: pose, current cluster
+// targets and speeds, speed factors and steps. Layers of every body
+// are stepped together in one batch per frame.
+class AnimChannels
+{
+public:
+
+	std::vector<GLfloat> pose;
+	std::vector<GLfloat> target;
+	std::vector<GLfloat> speed;
+	std::vector<GLfloat> factor;
+	std::vector<GLfloat> delta;
+
+	// Add channels: return index of the first.
+	int add(int count)
+	{
+		int first = (int)pose.size();
+
+		pose.resize(first + count, 0.0);
+		target.resize(first + count, 0.0);
+		speed.resize(first + count, 0.0);
+		factor.resize(first + count, 0.0);
+		delta.resize(first + count, 0.0);
+		return first;
+	}
+
+	// Step all channels: layers set their factors beforehand.
+	void step()
+	{
+		int n = (int)pose.size();
+
+		if (n > 0) animStep(n, &target[0], &speed[0], &factor[0], &pose[0], &delta[0]);
+	}
+};
+
+// Weight change per unit of speed factor when a layer fades in or out.
+#define ANIM_FADE_RATE 0.1
+
+// Animation layer: plays one clip at a time on the body parts in its
+// mask. The layer keeps its own pose, so switching clips blends from
+// the current pose rather than restarting from the body state.
+class AnimLayer
+{
+public:
+
+	// Body parts driven by layer: bit per part index.
+	unsigned int mask;
+
+	// Playing clip and current cluster.
+	AnimClip *clip;
+	int cluster;
+
+	// Clip is advancing? A finished clip holds its last pose.
+	bool active;
+
+	// Clip is looped? Paced clips also scale with the pace factor.
+	bool looped;
+	bool paced;
+
+	// Blend weight, fading toward target weight.
+	GLfloat weight;
+	GLfloat targetWeight;
+
+	// Clips to play after the current one: only the current clip
+	// is evaluated, so queue length does not affect frame cost.
+	struct Queued
+	{
+		AnimClip *clip;
+		bool looped;
+		bool paced;
+	};
+	std::deque<Queued> queue;
+
+	// Channels over all body parts, from first in the shared
+	// channel arrays, and their 1/0 mask.
+	AnimChannels *channels;
+	int first;
+	int count;
+	std::vector<GLfloat> channelMask;
+
+	// Stepped in the current frame?
+	bool stepping;
+
+	AnimLayer(AnimChannels *channels, int numParts, unsigned int mask)
+	{
+		int n = numParts * ANIM_NUM_CHANNELS;
+
+		this->mask = mask;
+		this->channels = channels;
+		first = channels->add(n);
+		count = n;
+		clip = NULL;
+		cluster = 0;
+		active = looped = paced = stepping = false;
+		weight = targetWeight = 0.0;
+		channelMask.resize(n, 0.0);
+		for (int i = 0; i < n; i++)
 		{
-			done = false;
-			if (delta > 0.0 && delta > speed)
-			{
-				delta = speed;
-			} else if (delta < 0.0 && -delta > speed)
-			{
-					delta = -speed;
-			}
-			part->transform.addPitch(delta);
+			if (mask & (1 << (i / ANIM_NUM_CHANNELS))) channelMask[i] = 1.0;
 		}
+	}
+
+	// Play clip now, blending from the current pose.
+	void play(AnimClip *clip, bool looped, bool paced)
+	{
+		queue.clear();
+		begin(clip, looped, paced);
+	}
 
-		// Yaw.
-		delta = ry - part->transform.ry;
-		speed = speedFactor * rys;
-		if (speed < 0.0) speed = 0.0;
-		if (rys > 0.0 && fabs(delta) > 0.0)
+	// Play clip when the current clip finishes.
+	void enqueue(AnimClip *clip, bool looped, bool paced)
+	{
+		Queued q;
+
+		if (!active || targetWeight == 0.0)
 		{
-			done = false;
-			if (delta > 0.0 && delta > speed)
-			{
-				delta = speed;
-			} else if (delta < 0.0 && -delta > speed)
-			{
-					delta = -speed;
-			}
-			part->transform.addYaw(delta);
+			begin(clip, looped, paced);
+			return;
 		}
+		q.clip = clip;
+		q.looped = looped;
+		q.paced = paced;
+		queue.push_back(q);
+	}
+
+	// Fade out layer to the rest pose.
+	void stop()
+	{
+		queue.clear();
+		looped = false;
+		targetWeight = 0.0;
+	}
+
+	void unloop()
+	{
+		looped = false;
+	}
 
-		// Roll.
-		delta = rz - part->transform.rz;
-		speed = speedFactor * rzs;
-		if (speed < 0.0) speed = 0.0;
-		if (rzs > 0.0 && fabs(delta) > 0.0)
+	// Playing clip?
+	bool isPlaying(AnimClip *clip)
+	{
+		return active && this->clip == clip && targetWeight > 0.0;
+	}
+
+	// Layer pose over all body parts.
+	GLfloat *pose()
+	{
+		return &channels->pose[first];
+	}
+
+	// Fade layer and set its speed factors for the channel step.
+	void prepare(GLfloat speedFactor, GLfloat paceFactor)
+	{
+		int i;
+		GLfloat fade,s,*p,*f;
+
+		// Fade weight.
+		fade = ANIM_FADE_RATE * speedFactor;
+		if (fade < 0.0) fade = 0.0;
+		if (weight < targetWeight)
 		{
-			done = false;
-			if (delta > 0.0 && delta > speed)
+			weight += fade;
+			if (weight > targetWeight) weight = targetWeight;
+		} else if (weight > targetWeight)
+		{
+			weight -= fade;
+			if (weight < targetWeight) weight = targetWeight;
+		}
+		if (clip != NULL && weight == 0.0 && targetWeight == 0.0)
+		{
+			clip = NULL;
+			active = false;
+			p = pose();
+			for (i = 0; i < count; i++) p[i] = 0.0;
+		}
+
+		// Inactive layers hold their pose.
+		stepping = active;
+		s = stepping ? (paced ? speedFactor * paceFactor : speedFactor) : 0.0;
+		f = &channels->factor[first];
+		for (i = 0; i < count; i++) f[i] = s;
+	}
+
+	// Apply channel step and advance clusters: after the step.
+	void finish()
+	{
+		int i,pending;
+		GLfloat *p,*t,*v,*d;
+
+		if (!stepping) return;
+		p = pose();
+		t = &channels->target[first];
+		v = &channels->speed[first];
+		d = &channels->delta[first];
+		pending = 0;
+		for (i = 0; i < count; i++)
+		{
+			pending += (v[i] > 0.0f && t[i] != p[i]);
+			p[i] += d[i];
+		}
+		if (pending > 0) return;
+
+		// Next cluster.
+		cluster++;
+		if (cluster >= clip->numClusters())
+		{
+			if (looped)
 			{
-				delta = speed;
-			} else if (delta < 0.0 && -delta > speed)
+				cluster = 0;
+			} else if (queue.size() > 0)
 			{
-					delta = -speed;
+				Queued q = queue.front();
+				queue.pop_front();
+				begin(q.clip, q.looped, q.paced);
+				return;
+			} else {
+				active = false;
+				return;
 			}
-			part->transform.addRoll(delta);
 		}
-
-		return done;
+		loadCluster();
 	}
-};
 
-// Cluster of concurrent body part animations.
-class AnimCluster
-{
-public:
+private:
 
-	std::list<AnimPart *> cluster;
+	// Begin playing clip.
+	void begin(AnimClip *clip, bool looped, bool paced)
+	{
+		this->clip = clip;
+		this->looped = looped;
+		this->paced = paced;
+		cluster = 0;
+		active = (clip->numClusters() > 0);
+		targetWeight = 1.0;
+		if (active) loadCluster();
+	}
 
-	// Run parts: return true if all done.
-	bool run(float speedFactor)
+	// Load current cluster keys of masked parts.
+	void loadCluster()
 	{
-		bool done;
-		AnimPart *part;
-		std::list<AnimPart *>::iterator partItr;
+		int i,k,p;
+		GLfloat *target,*speed;
 
-		done = true;
-		for (partItr = cluster.begin();
-			partItr != cluster.end(); partItr++)
+		target = &channels->target[first];
+		speed = &channels->speed[first];
+		for (i = 0; i < count; i++) speed[i] = 0.0;
+		for (k = clip->clusters[cluster]; k < clip->clusters[cluster + 1]; k++)
 		{
-			part = *partItr;
-			if (!part->run(speedFactor)) done = false;
+			p = clip->parts[k];
+			if (!(mask & (1 << p))) continue;
+			for (i = 0; i < ANIM_NUM_CHANNELS; i++)
+			{
+				target[(p * ANIM_NUM_CHANNELS) + i] = clip->targets[(k * ANIM_NUM_CHANNELS) + i];
+				speed[(p * ANIM_NUM_CHANNELS) + i] = clip->speeds[(k * ANIM_NUM_CHANNELS) + i];
+			}
 		}
-		return done;
 	}
 };
 
-// Animation sequence.
-class Animation
+// Animation mixer: prepares layers for the shared channel step, then
+// applies their weighted blend to a body in a single pass. The mixer
+// only applies the change of its output, so transforms set directly
+// on parts are kept as offsets. Poses that clips must blend with,
+// such as a carrying posture, are set as mixer offsets instead.
+class AnimMixer
 {
 public:
 
-	// Sequence of clusters.
-	std::list<AnimCluster *> sequence;
-	std::list<AnimCluster *>::iterator seqItr;
+	// Animated body parts.
+	BodyPart **parts;
+	int numParts;
 
-	// Animation is active?
-	bool active;
+	// Shared layer channels.
+	AnimChannels *channels;
 
-	// Animation is looped?
-	bool looped;
+	// Layers.
+	std::vector<AnimLayer> layers;
+
+	AnimMixer()
+	{
+		parts = NULL;
+		numParts = 0;
+		channels = NULL;
+	}
 
-	Animation()
+	void init(BodyPart **parts, int numParts, AnimChannels *channels)
 	{
-		active = looped = false;
+		this->parts = parts;
+		this->numParts = numParts;
+		this->channels = channels;
+		layers.clear();
+		blend.resize(numParts * ANIM_NUM_CHANNELS, 0.0);
+		output.resize(numParts * ANIM_NUM_CHANNELS, 0.0);
+		offset.assign(numParts * ANIM_NUM_CHANNELS, 0.0);
+		offsetFrom.assign(numParts * ANIM_NUM_CHANNELS, 0.0);
+		offsetTo.assign(numParts * ANIM_NUM_CHANNELS, 0.0);
+		offsetWeight.assign(numParts * ANIM_NUM_CHANNELS, 1.0);
 	}
 
-	void reset()
+	// Set offset added to the blend of a part channel: the offset
+	// fades from its current value at the layer fade rate.
+	void setOffset(int part, int channel, GLfloat value)
 	{
-		seqItr = sequence.begin();
+		int i = (part * ANIM_NUM_CHANNELS) + channel;
 
+		if (offsetTo[i] == value) return;
+		offsetFrom[i] = offset[i];
+		offsetTo[i] = value;
+		offsetWeight[i] = 0.0;
 	}
 
-	void start()
+	// Add layer for parts in mask: return layer index.
+	int addLayer(unsigned int mask)
 	{
-		reset();
-		active = true;
+		layers.push_back(AnimLayer(channels, numParts, mask));
+		return (int)layers.size() - 1;
 	}
 
-	void stop()
+	// Play clip on the layers driving its parts.
+	void play(AnimClip *clip, bool looped, bool paced)
+	{
+		unsigned int mask = clip->partMask();
+
+		for (int i = 0; i < (int)layers.size(); i++)
+		{
+			if (layers[i].mask & mask) layers[i].play(clip, looped, paced);
+		}
+	}
+
+	// Queue clip on the layers driving its parts.
+	void enqueue(AnimClip *clip, bool looped, bool paced)
 	{
-		reset();
-		active = false;
+		unsigned int mask = clip->partMask();
+
+		for (int i = 0; i < (int)layers.size(); i++)
+		{
+			if (layers[i].mask & mask) layers[i].enqueue(clip, looped, paced);
+		}
 	}
 
-	void loop()
+	// Fade out layers playing clip.
+	void stop(AnimClip *clip)
 	{
-		looped = true;
+		for (int i = 0; i < (int)layers.size(); i++)
+		{
+			if (layers[i].isPlaying(clip)) layers[i].stop();
+		}
 	}
 
-	void unloop()
+	// Finish clip at end of its current cycle.
+	void unloop(AnimClip *clip)
 	{
-		looped = false;
+		for (int i = 0; i < (int)layers.size(); i++)
+		{
+			if (layers[i].isPlaying(clip)) layers[i].unloop();
+		}
 	}
 
-	// Run cluster sequence: return true if done.
-	bool run(float speedFactor)
+	bool isPlaying(AnimClip *clip)
 	{
-		AnimCluster *cluster;
+		for (int i = 0; i < (int)layers.size(); i++)
+		{
+			if (layers[i].isPlaying(clip)) return true;
+		}
+		return false;
+	}
 
-		if (!active) return true;
+	// Fade layers and offsets before the channels are stepped.
+	void prepare(GLfloat speedFactor, GLfloat paceFactor)
+	{
+		int i,n;
+		GLfloat fade;
 
-		cluster = *seqItr;
-		if (cluster->run(speedFactor))
+		n = numParts * ANIM_NUM_CHANNELS;
+		fade = ANIM_FADE_RATE * speedFactor;
+		if (fade < 0.0) fade = 0.0;
+		for (i = 0; i < n; i++)
 		{
-			seqItr++;
+			if (offsetWeight[i] < 1.0)
+			{
+				offsetWeight[i] += fade;
+				if (offsetWeight[i] > 1.0) offsetWeight[i] = 1.0;
+				offset[i] = offsetFrom[i] + ((offsetTo[i] - offsetFrom[i]) * offsetWeight[i]);
+			}
 		}
+		for (i = 0; i < (int)layers.size(); i++)
+		{
+			layers[i].prepare(speedFactor, paceFactor);
+		}
+	}
 
-		if (seqItr == sequence.end())
+	// Finish layers and apply blend to body parts: after the
+	// channels are stepped.
+	void apply()
+	{
+		int i,l,n;
+		GLfloat w,*p,*d;
+		BodyTransform *transform;
+		AnimLayer *layer;
+
+		n = numParts * ANIM_NUM_CHANNELS;
+		for (i = 0; i < n; i++) blend[i] = offset[i];
+		for (l = 0; l < (int)layers.size(); l++)
 		{
-			if (looped)
+			layer = &layers[l];
+			layer->finish();
+			w = layer->weight;
+			if (w == 0.0) continue;
+			p = layer->pose();
+			for (i = 0; i < n; i++)
 			{
-				reset();
-				return false;
-			} else {
-				stop();
-				return true;
+				blend[i] += layer->channelMask[i] * w * p[i];
 			}
-		} else {
-			return false;
+		}
+
+		// Apply change: rotations only touch the quaternion when moving.
+		for (i = 0; i < n; i++)
+		{
+			w = blend[i];
+			blend[i] -= output[i];
+			output[i] = w;
+		}
+		for (i = 0; i < numParts; i++)
+		{
+			transform = &parts[i]->transform;
+			d = &blend[i * ANIM_NUM_CHANNELS];
+			transform->tx += d[ANIM_TX];
+			transform->ty += d[ANIM_TY];
+			transform->tz += d[ANIM_TZ];
+			if (d[ANIM_RX] != 0.0) transform->addPitch(d[ANIM_RX]);
+			if (d[ANIM_RY] != 0.0) transform->addYaw(d[ANIM_RY]);
+			if (d[ANIM_RZ] != 0.0) transform->addRoll(d[ANIM_RZ]);
 		}
 	}
+
+private:
+
+	// Blended channels, last applied output, and offsets fading
+	// from/to with weight.
+	std::vector<GLfloat> blend;
+	std::vector<GLfloat> output;
+	std::vector<GLfloat> offset;
+	std::vector<GLfloat> offsetFrom;
+	std::vector<GLfloat> offsetTo;
+	std::vector<GLfloat> offsetWeight;
 };
 #endif
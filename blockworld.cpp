@@ -5,10 +5,15 @@
 #include <ode/ode.h>
 #include <drawstuff/drawstuff.h>
 #include "glut.h"
-#include "cyd.hpp"
+#include "workers.hpp"
 #include "frameRate.hpp"
+#include "profiler.hpp"
+#include "frustum.hpp"
+#include "contacts.hpp"
+#include "cyd.hpp"
 #include <list>
 #include <vector>
+#include <set>
 
 extern "C" { FILE _iob[3] = { __acrt_iob_func(0), __acrt_iob_func(1), __acrt_iob_func(2) }; }
 
@@ -16,8 +21,50 @@ extern "C" { FILE _iob[3] = { __acrt_iob_func(0), __acrt_iob_func(1), __acrt_iob
 #pragma warning(disable:4244 4305)  // for VC++, no precision loss complaints
 #endif
 
-// Cyd.
-Cyd cyd;
+// Cyd agents.
+// The Cyd model (display lists and bounds) is shared by all agents;
+// each agent has its own skeleton, animations, collision space
+// and interaction state.
+enum InteractionModeType { COLLISION, SELECTION };
+struct CydAgent {
+  Cyd *cyd;
+  InteractionModeType interactionMode;
+  dGeomID heldObject;
+};
+std::vector<CydAgent> Agents;
+int CurrentAgent = 0;		// agent controlled by keyboard
+#define AGENT_SPACING 1.5	// distance between agents at creation
+#define AGENTS_PER_ROW 10
+
+// Agent update threads.
+WorkerPool AgentWorkers;
+
+// Frame-rate independent movement.
+#define TARGET_FRAME_RATE 70.0
+class FrameRate frameRate(TARGET_FRAME_RATE);
+
+// Frame phase profiling.
+enum ProfilePhase {
+  PROFILE_COLLIDE, PROFILE_STEP, PROFILE_JOINTS, PROFILE_OBJECTS,
+  PROFILE_ANIMATE, PROFILE_CYD_UPDATE, PROFILE_CYD_DRAW, PROFILE_CARRY,
+  NUM_PROFILE_PHASES
+};
+static const char *ProfilePhaseNames[NUM_PROFILE_PHASES] = {
+  "dSpaceCollide", "dWorldQuickStep", "dJointGroupEmpty", "object draw",
+  "animation", "cyd update", "cyd draw", "carryObject"
+};
+Profiler FrameProfiler(ProfilePhaseNames, NUM_PROFILE_PHASES);
+
+// Print frame profile.
+void printProfile()
+{
+  printf ("Frame rate: %.1f FPS, frame time: %.3f ms\n",
+	  frameRate.FPS, (double)frameRate.frameTime / 1.0e6);
+  FrameProfiler.print(stdout);
+  int drawCalls,stateChanges;
+  dsGetDrawStats (&drawCalls,&stateChanges);
+  printf ("Draw calls: %d, state changes: %d\n", drawCalls, stateChanges);
+}
 
 // Cyd movement.
 #define ANGULAR_DELTA_SCALE 1.0   // Scales body rotation rate.
@@ -46,6 +93,7 @@ GLfloat MovementRate = 3.0;
 #define dsDrawSphere dsDrawSphereD
 #define dsDrawCylinder dsDrawCylinderD
 #define dsDrawCappedCylinder dsDrawCappedCylinderD
+#define dsDrawLine dsDrawLineD
 #endif
 
 
@@ -77,13 +125,26 @@ static MyObject obj[NUM];
 static GLfloat objColors[NUM][3];
 static dJointGroupID contactgroup;
 static int show_aabb = 0;	// show geom AABBs?
-static int show_contacts = 0;	// show contact points?
 static int random_pos = 1;	// drop objects from random position?
 static int write_world = 0;
 
-// Cyd/object interaction variables.
-enum { COLLISION, SELECTION } InteractionMode = COLLISION;
-dGeomID HeldObject = 0;
+// Contact points captured by collision: enabled to show them.
+ContactBuffer Contacts;
+#define CONTACT_NORMAL_LENGTH 0.1
+
+// Objects held by agents.
+std::set<dGeomID> HeldObjects;
+
+static bool isHeld(dGeomID g)
+{
+  return HeldObjects.find(g) != HeldObjects.end();
+}
+
+// Get agent owning a Cyd bounding box.
+static CydAgent *getAgent(dGeomID g)
+{
+  return &Agents[((Cyd *)dGeomGetData(g))->id];
+}
 
 // this is called by dSpaceCollide when two objects in space are
 // potentially colliding.
@@ -92,6 +153,14 @@ static void nearCallback (void *data, dGeomID o1, dGeomID o2)
 {
   int i,j;
 
+  // collide agent spaces with other geoms, but not with each other.
+  if (dGeomIsSpace(o1) || dGeomIsSpace(o2)) {
+    if (dGeomIsSpace(o1) && dGeomIsSpace(o2)) return;
+    TraceScope trace("narrowphase batch","collide");
+    dSpaceCollide2 (o1,o2,data,&nearCallback);
+    return;
+  }
+
   // get the categories for the geoms.
   unsigned long c1 = dGeomGetCategoryBits(o1);
   unsigned long c2 = dGeomGetCategoryBits(o2);
@@ -104,6 +173,9 @@ static void nearCallback (void *data, dGeomID o1, dGeomID o2)
 
   // Cyd bounding blocks do not collide.
   if (cyd1 && cyd2) return;
+  CydAgent *agent = 0;
+  if (cyd1) agent = getAgent(o1);
+  if (cyd2) agent = getAgent(o2);
 
   // exit without doing anything if the two bodies are connected by a joint
   dBodyID b1 = dGeomGetBody(o1);
@@ -119,17 +191,19 @@ static void nearCallback (void *data, dGeomID o1, dGeomID o2)
     contact[i].surface.bounce_vel = 0.1;
     contact[i].surface.soft_cfm = 0.01;
   }
-  if (int numc = dCollide (o1,o2,MAX_CONTACTS,&contact[0].geom,
-			   sizeof(dContact))) {
-    dMatrix3 RI;
-    dRSetIdentity (RI);
-    const dReal ss[3] = {0.02,0.02,0.02};
+  int numc;
+  {
+    TraceScope trace("dCollide","collide");
+    numc = dCollide (o1,o2,MAX_CONTACTS,&contact[0].geom,sizeof(dContact));
+  }
+  if (numc) {
+    TraceScope trace("contact joints","collide",numc);
     for (i=0; i<numc; i++) {
 
 	  // Selection mode.
-	  if (InteractionMode == SELECTION && (cyd1 || cyd2))
+	  if (agent != 0 && agent->interactionMode == SELECTION)
 	  {
-		  if (HeldObject != 0) continue;
+		  if (agent->heldObject != 0) continue;
 		  if (b2 != 0 && (c1 == CYD_LEFT_HAND || c1 == CYD_RIGHT_HAND))
 		  {
 			for (j = 0; j < num; j++)
@@ -146,11 +220,11 @@ static void nearCallback (void *data, dGeomID o1, dGeomID o2)
 		  }
 		  continue;
 	  }
-	  if (o1 != HeldObject && o2 != HeldObject)
+	  if (!isHeld(o1) && !isHeld(o2))
 	  {
 		dJointID c = dJointCreateContact (world,contactgroup,contact+i);
 		dJointAttach (c,b1,b2);
-		if (show_contacts) dsDrawBox (contact[i].geom.pos,RI,ss);
+		Contacts.add (contact[i].geom);
 	  }
     }
   }
@@ -182,6 +256,9 @@ void showHelp()
   printf ("To select next body part, press n.\n");
   printf ("To rotate body part, press h, l, and arrow keys.\n");
   printf ("To show bounding boxes, press v.\n");
+  printf ("To add another Cyd, press y.\n");
+  printf ("To control the next Cyd, press g.\n");
+  printf ("To print the frame profile, press p.\n");
   printf ("Block world commands:\n");
   printf ("To drop another object, press:\n");
   printf ("   b for box.\n");
@@ -221,7 +298,7 @@ char locase (char c)
 }
 
 // pick up object.
-void pickupObject()
+void pickupObject(CydAgent &agent)
 {
 	int i,j,k;
 	dGeomID bestGeom = 0;
@@ -233,9 +310,10 @@ void pickupObject()
 	const dReal *p;
 	dReal pos[3];
 	bool multObj;
+	Cyd &cyd = *agent.cyd;
 
-	if (HeldObject != 0) return;
-	if (InteractionMode != SELECTION) return;
+	if (agent.heldObject != 0) return;
+	if (agent.interactionMode != SELECTION) return;
 
 	// Get target (optimal) object position.
 	for (i = 0; i < 3; i++)
@@ -261,6 +339,7 @@ void pickupObject()
 			if (j > 1) multObj = true;
 			for (j = 0; j < GPB && obj[i].geom[j] != 0; j++)
 			{
+				if (isHeld(obj[i].geom[j])) continue;
 				p = dGeomGetPosition(obj[i].geom[j]);
 				for (k = 0; k < 3; k++) pos[k] = p[k];
 				if (multObj) {
@@ -295,14 +374,15 @@ void pickupObject()
 	}
 	if (bestGeom != 0)
 	{
-		HeldObject = bestGeom;
+		agent.heldObject = bestGeom;
+		HeldObjects.insert(bestGeom);
 		dBodyDisable(obj[bestIndex].body);
-		cyd.bodyParts[Cyd::TORSO].transform.setPitch(0.0);
+		cyd.setCarrying(true);
 	}
 }
 
 // Carry object.
-void carryObject(dGeomID heldObject)
+void carryObject(CydAgent &agent)
 {
 	int i,j,part,index;
 	dMatrix3 rotation;
@@ -311,17 +391,20 @@ void carryObject(dGeomID heldObject)
 	double cosa,sina;
 	GLfloat objectPosition[3];
 	dBodyID heldBody;
+	Cyd &cyd = *agent.cyd;
 
 	// Validate object.
-	if (HeldObject == 0) return;
-	heldBody = dGeomGetBody(HeldObject);
+	if (agent.heldObject == 0) return;
+	heldBody = dGeomGetBody(agent.heldObject);
 	for (index = 0; index < num; index++)
 	{
 		if (obj[index].body == heldBody) break;
 	}
 	if (index == num)
 	{
-		HeldObject = 0;
+		HeldObjects.erase(agent.heldObject);
+		agent.heldObject = 0;
+		cyd.setCarrying(false);
 		return;
 	}
 
@@ -359,14 +442,41 @@ void carryObject(dGeomID heldObject)
 }
 
 // drop held object.
-void dropObject()
+void dropObject(CydAgent &agent)
 {
-	if (HeldObject != 0)
+	if (agent.heldObject != 0)
 	{
-		dBodyEnable(dGeomGetBody(HeldObject));
-		cyd.bodyParts[Cyd::TORSO].transform.setPitch(45.0);
+		dBodyEnable(dGeomGetBody(agent.heldObject));
+		agent.cyd->setCarrying(false);
+		HeldObjects.erase(agent.heldObject);
 	}
-	HeldObject = 0;
+	agent.heldObject = 0;
+}
+
+// Stop walking.
+void stopWalking(CydAgent &agent)
+{
+	Cyd &cyd = *agent.cyd;
+
+	// Walking layers fade back to the rest pose.
+	cyd.speed = 0.0;
+	cyd.stopAnimation(CYD_LEGS_WALKING);
+	cyd.stopAnimation(CYD_ARMS_WALKING);
+}
+
+// Add a Cyd agent.
+void addAgent()
+{
+	CydAgent agent;
+	int id = (int)Agents.size();
+
+	agent.cyd = new Cyd();
+	agent.cyd->init(world, space, id);
+	agent.cyd->transform.tx = -AGENT_SPACING * (GLfloat)(id % AGENTS_PER_ROW);
+	agent.cyd->transform.ty = -AGENT_SPACING * (GLfloat)(id / AGENTS_PER_ROW);
+	agent.interactionMode = COLLISION;
+	agent.heldObject = 0;
+	Agents.push_back(agent);
 }
 
 // Current body part.
@@ -377,39 +487,33 @@ void
 keyInput(unsigned char key, int x, int y)
 {
   int i;
+  CydAgent &agent = Agents[CurrentAgent];
+  Cyd &cyd = *agent.cyd;
 
   switch(key)
     {
 	case ' ':
-		if (HeldObject != 0) break;
-		if (InteractionMode == COLLISION)
+		if (agent.heldObject != 0) break;
+		if (agent.interactionMode == COLLISION)
 		{
-			InteractionMode = SELECTION;
+			agent.interactionMode = SELECTION;
 			cyd.showHands = true;
-			cyd.animations[CYD_ARMS_WALKING]->unloop();
-			cyd.animations[CYD_ARMS_WALKING]->stop();
-			cyd.animations[CYD_ARMS_DOWN]->unloop();
-			cyd.animations[CYD_ARMS_DOWN]->stop();
-			cyd.animations[CYD_ARMS_PICKUP]->start();
+			cyd.playAnimation(CYD_ARMS_PICKUP, false, false);
 		} else {
-			InteractionMode = COLLISION;
+			agent.interactionMode = COLLISION;
 			for (i = 0; i < num; i++)
 			{
 				obj[i].selected = false;
 			}
 			cyd.showHands = false;
-			cyd.animations[CYD_ARMS_WALKING]->unloop();
-			cyd.animations[CYD_ARMS_WALKING]->stop();
-			cyd.animations[CYD_ARMS_PICKUP]->unloop();
-			cyd.animations[CYD_ARMS_PICKUP]->stop();
-			cyd.animations[CYD_ARMS_DOWN]->start();
+			cyd.playAnimation(CYD_ARMS_DOWN, false, false);
 		}
 		break;
     case '[':
-		pickupObject();
+		pickupObject(agent);
 		break;
 	case ']':
-		dropObject();
+		dropObject(agent);
 		break;
     case 'n':
 		CurrentPart = (CurrentPart + 1) % (CYD_NUM_BODY_PARTS + 1);
@@ -451,14 +555,14 @@ keyInput(unsigned char key, int x, int y)
 	case '8':
 	case '9':
 		int i = key - '0';
-		if (cyd.animations.size() > i)
+		if (i < CYD_NUM_ANIMATIONS)
 		{
-			if (!cyd.animations[i]->active)
+			if (!cyd.isAnimating(i))
 			{
-				cyd.animations[i]->loop();
-				cyd.animations[i]->start();
+				cyd.playAnimation(i, true,
+					i == CYD_LEGS_WALKING || i == CYD_ARMS_WALKING);
 			} else {
-				cyd.animations[i]->unloop();
+				cyd.unloopAnimation(i);
 			}
 		}
 		break;
@@ -470,6 +574,8 @@ void
 specialKeyInput(int key, int x, int y)
 {
   GLfloat direction[3];
+  CydAgent &agent = Agents[CurrentAgent];
+  Cyd &cyd = *agent.cyd;
 
   switch(CurrentPart)
     {
@@ -541,17 +647,15 @@ specialKeyInput(int key, int x, int y)
 			cyd.transform.ty -= direction[1] * LINEAR_DELTA_SCALE * MovementRate;
 			cyd.transform.tz -= direction[2] * LINEAR_DELTA_SCALE * MovementRate;
 			cyd.speed = MovementRate * LINEAR_SPEED_SCALE;
-			if (!cyd.animations[CYD_LEGS_WALKING]->active)
+			if (!cyd.isAnimating(CYD_LEGS_WALKING))
 			{
-				cyd.animations[CYD_LEGS_WALKING]->loop();
-				cyd.animations[CYD_LEGS_WALKING]->start();
+				cyd.playAnimation(CYD_LEGS_WALKING, true, true);
 			}
-			if (InteractionMode == COLLISION && 
-				!cyd.animations[CYD_ARMS_DOWN]->active &&
-				!cyd.animations[CYD_ARMS_WALKING]->active)
+			if (agent.interactionMode == COLLISION && 
+				!cyd.isAnimating(CYD_ARMS_DOWN) &&
+				!cyd.isAnimating(CYD_ARMS_WALKING))
 			{
-				cyd.animations[CYD_ARMS_WALKING]->loop();
-				cyd.animations[CYD_ARMS_WALKING]->start();
+				cyd.playAnimation(CYD_ARMS_WALKING, true, true);
 			}
 			break;
 		case 'k':
@@ -560,17 +664,15 @@ specialKeyInput(int key, int x, int y)
 			cyd.transform.ty += direction[1] * LINEAR_DELTA_SCALE * MovementRate;
 			cyd.transform.tz += direction[2] * LINEAR_DELTA_SCALE * MovementRate;
 			cyd.speed = -MovementRate * LINEAR_SPEED_SCALE;
-			if (!cyd.animations[CYD_LEGS_WALKING]->active)
+			if (!cyd.isAnimating(CYD_LEGS_WALKING))
 			{
-				cyd.animations[CYD_LEGS_WALKING]->loop();
-				cyd.animations[CYD_LEGS_WALKING]->start();
+				cyd.playAnimation(CYD_LEGS_WALKING, true, true);
 			}
-			if (InteractionMode == COLLISION && 
-				!cyd.animations[CYD_ARMS_DOWN]->active &&
-				!cyd.animations[CYD_ARMS_WALKING]->active)
+			if (agent.interactionMode == COLLISION && 
+				!cyd.isAnimating(CYD_ARMS_DOWN) &&
+				!cyd.isAnimating(CYD_ARMS_WALKING))
 			{
-				cyd.animations[CYD_ARMS_WALKING]->loop();
-				cyd.animations[CYD_ARMS_WALKING]->start();
+				cyd.playAnimation(CYD_ARMS_WALKING, true, true);
 			}
 			break;
 		case 'l': cyd.transform.addYaw(ANGULAR_DELTA_SCALE * MovementRate); break;
@@ -803,14 +905,14 @@ static void command (int cmd)
   }
 
   if (cmd == 'd') {
-	  if (HeldObject == 0) {
+	  if (Agents[CurrentAgent].heldObject == 0) {
 		  for (k = 0; k < num; k++) {
 			if (obj[k].selected) dBodyDisable (obj[k].body);
 		  }
 	  }
   }
   else if (cmd == 'e') {
-	  if (HeldObject == 0) {
+	  if (Agents[CurrentAgent].heldObject == 0) {
 		  for (k = 0; k < num; k++) {
 			if (obj[k].selected) dBodyEnable (obj[k].body);
 		  }
@@ -820,7 +922,7 @@ static void command (int cmd)
     show_aabb ^= 1;
   }
   else if (cmd == 't') {
-    show_contacts ^= 1;
+    Contacts.enabled = !Contacts.enabled;
   }
   else if (cmd == 'r') {
     random_pos ^= 1;
@@ -828,6 +930,9 @@ static void command (int cmd)
   else if (cmd == '1') {
     write_world = 1;
   }
+  else if (cmd == 'p') {
+    printProfile();
+  }
   else if (cmd == 'f') {
     // fuse the selected bodies and geoms.
 	int numg;
@@ -843,7 +948,7 @@ static void command (int cmd)
 	dReal ctr[3];
 
 	// drop held object.
-	dropObject();
+	dropObject(Agents[CurrentAgent]);
 
 	// can fuse be done?
 	for (i = j = p = 0; i < num; i++) {
@@ -958,17 +1063,24 @@ static void command (int cmd)
 	dBodySetPosition(obj[i].body,ctr[0],ctr[1],ctr[2]);
   }
   else if (cmd == 'z') {
-	dropObject();
+	dropObject(Agents[CurrentAgent]);
 	destroySelected();
   }
+  else if (cmd == 'y') {
+	addAgent();
+	printf("Agents: %d\n", (int)Agents.size());
+  }
+  else if (cmd == 'g') {
+	stopWalking(Agents[CurrentAgent]);
+	CurrentAgent = (CurrentAgent + 1) % (int)Agents.size();
+	printf("Agent: %d\n", CurrentAgent);
+  }
 }
 
 // draw a geom
 
-void drawGeom (dGeomID g, const dReal *pos, const dReal *R, int show_aabb)
+void drawGeom (dGeomID g, const dReal *pos, const dReal *R)
 {
-  int i;
-
   if (!g) return;
   if (!pos) pos = dGeomGetPosition (g);
   if (!R) R = dGeomGetRotation (g);
@@ -1006,35 +1118,124 @@ void drawGeom (dGeomID g, const dReal *pos, const dReal *R, int show_aabb)
     actual_pos[1] += pos[1];
     actual_pos[2] += pos[2];
     dMULTIPLY0_333 (actual_R,R,R2);
-    drawGeom (g2,actual_pos,actual_R,0);
+    drawGeom (g2,actual_pos,actual_R);
   }
+}
+
+// View frustum: updated each frame.
+Frustum ViewFrustum;
+
+// Is geom or its shadow in the view frustum?
+static bool isVisible (dGeomID g)
+{
+  int i;
+  dReal aabb[6];
+  GLfloat box[6];
 
-  if (show_aabb) {
-    // draw the bounding box for this geom
-    dReal aabb[6];
-    dGeomGetAABB (g,aabb);
-    dVector3 bbpos;
-    for (i=0; i<3; i++) bbpos[i] = 0.5*(aabb[i*2] + aabb[i*2+1]);
-    dVector3 bbsides;
-    for (i=0; i<3; i++) bbsides[i] = aabb[i*2+1] - aabb[i*2];
-    dMatrix3 RI;
-    dRSetIdentity (RI);
-    dsSetColorAlpha (1,0,0,0.5);
-    dsDrawBox (bbpos,RI,bbsides);
+  dGeomGetAABB (g,aabb);
+  for (i=0; i<6; i++) box[i] = (GLfloat)aabb[i];
+
+  // Extend box to its shadow on the ground.
+  if (box[5] > 0.0) {
+    box[0] -= LIGHTX*box[5];
+    box[2] -= LIGHTY*box[5];
   }
+  if (box[4] > 0.0) box[4] = 0.0;
+  return ViewFrustum.overlapAABB (box);
 }
 
-// Frame-rate independent movement.
-#define TARGET_FRAME_RATE 70.0
-class FrameRate frameRate(TARGET_FRAME_RATE);
+// Draw the bounding box of a geom.
+void drawGeomAABB (dGeomID g)
+{
+  int i;
+
+  if (!g) return;
+  dReal aabb[6];
+  dGeomGetAABB (g,aabb);
+  dVector3 bbpos;
+  for (i=0; i<3; i++) bbpos[i] = 0.5*(aabb[i*2] + aabb[i*2+1]);
+  dVector3 bbsides;
+  for (i=0; i<3; i++) bbsides[i] = aabb[i*2+1] - aabb[i*2];
+  dMatrix3 RI;
+  dRSetIdentity (RI);
+  dsSetColorAlpha (1,0,0,0.5);
+  dsDrawBox (bbpos,RI,bbsides);
+}
+
+// Update agent animations and transforms: run by agent workers.
+static void updateAgent(int index, void *data)
+{
+  Cyd &cyd = *Agents[index].cyd;
+
+  // Apply animations stepped for all agents.
+  {
+    ProfileScope scope(FrameProfiler, PROFILE_ANIMATE);
+    cyd.applyAnimation();
+  }
+
+  // Update and get world transforms.
+  ProfileScope scope(FrameProfiler, PROFILE_CYD_UPDATE);
+  cyd.updateTransforms();
+}
+
+// Draw agent.
+static void drawAgent(CydAgent &agent)
+{
+  Cyd &cyd = *agent.cyd;
+
+  // Cull Cyd outside the view.
+  if (!isVisible ((dGeomID)cyd.agentSpace)) return;
+
+  GLfloat position[3];
+  position[0] = 0.0;
+  position[1] = 0.0;
+  position[2] = 0.0;
+  bodyMatrixTransformPoint(cyd.xmatrix, position);
+  if (position[2] >= 0.5)
+  {
+	cyd.draw(LIGHTX, LIGHTY);
+  } else if (position[2] >= -0.5)
+  {
+    cyd.draw();
+  }
+}
+
+// draw the captured contact points and their normals.
+void drawContacts()
+{
+  int i,j;
+  dMatrix3 RI;
+  dVector3 end;
+  const dReal ss[3] = {0.02,0.02,0.02};
+
+  dRSetIdentity (RI);
+  dsSetColor (0,0,2);
+  for (i=0; i<Contacts.size(); i++) {
+    const ContactPoint &point = Contacts.get(i);
+    dsDrawBox (point.pos,RI,ss);
+    for (j=0; j<3; j++) {
+      end[j] = point.pos[j] + (point.normal[j] * CONTACT_NORMAL_LENGTH);
+    }
+    dsDrawLine (point.pos,end);
+  }
+}
 
 // simulation loop
 
 static void simLoop (int pause)
 {
-  dsSetColor (0,0,2);
-  dSpaceCollide (space,0,&nearCallback);
-  if (!pause) dWorldQuickStep (world,0.05);
+  TraceScope trace("simLoop","frame");
+
+  Contacts.clear();
+  {
+    ProfileScope scope(FrameProfiler, PROFILE_COLLIDE);
+    dSpaceCollide (space,0,&nearCallback);
+  }
+  if (Contacts.enabled) drawContacts();
+  if (!pause) {
+    ProfileScope scope(FrameProfiler, PROFILE_STEP);
+    dWorldQuickStep (world,0.05);
+  }
 
   if (write_world) {
     FILE *f = fopen ("state.dif","wt");
@@ -1046,68 +1247,93 @@ static void simLoop (int pause)
   }
 
   // remove all contact joints
-  dJointGroupEmpty (contactgroup);
+  {
+    ProfileScope scope(FrameProfiler, PROFILE_JOINTS);
+    dJointGroupEmpty (contactgroup);
+  }
 
   dsSetColor (1,1,0);
   dsSetTexture (DS_WOOD);
-  for (int i=0; i<num; i++) {
-    for (int j=0; j < GPB; j++) {
-      if (obj[i].selected) {
-		dsSetColor (objColors[i][0],objColors[i][1],objColors[i][2]);
-      }
-      else if (! dBodyIsEnabled (obj[i].body)) {
-		dsSetColor (1,0.8,0);
+  ViewFrustum.update();
+  {
+    ProfileScope scope(FrameProfiler, PROFILE_OBJECTS);
+    for (int i=0; i<num; i++) {
+      TraceScope trace("drawGeom","draw",i);
+      for (int j=0; j < GPB; j++) {
+        if (!obj[i].geom[j] || !isVisible (obj[i].geom[j])) continue;
+        if (obj[i].selected) {
+		  dsSetColor (objColors[i][0],objColors[i][1],objColors[i][2]);
+        }
+        else if (! dBodyIsEnabled (obj[i].body)) {
+		  dsSetColor (1,0.8,0);
+        }
+        else {
+		  dsSetColor (1,1,0);
+        }
+        drawGeom (obj[i].geom[j],0,0);
       }
-      else {
-		dsSetColor (1,1,0);
+    }
+
+    // Draw bounding boxes after the objects they contain.
+    if (show_aabb) {
+      for (int i=0; i<num; i++) {
+        for (int j=0; j < GPB; j++) {
+          drawGeomAABB (obj[i].geom[j]);
+        }
       }
-      drawGeom (obj[i].geom[j],0,0,show_aabb);
+    }
+
+    // Draw the objects before the Cyds, which set their own drawing state.
+    {
+      TraceScope trace("dsDrawBatch","draw");
+      dsDrawBatch();
     }
   }
 
-  // Update animations.
-  for (int i = 0; i < cyd.animations.size(); i++)
+  // Step agent animations together: walking is paced by the movement rate.
   {
-	switch(i)
-	{
-	case CYD_LEGS_WALKING:
-		cyd.animations[i]->run(frameRate.speedFactor * MovementRate);
-		break;
-	case CYD_ARMS_WALKING:
-		cyd.animations[i]->run(frameRate.speedFactor * MovementRate);
-		break;
-	default:
-		cyd.animations[i]->run(frameRate.speedFactor);
-		break;
-	}
+    ProfileScope scope(FrameProfiler, PROFILE_ANIMATE);
+    for (size_t i = 0; i < Agents.size(); i++) {
+      Agents[i].cyd->prepareAnimation(frameRate.speedFactor, MovementRate);
+    }
+    Cyd::stepAnimations();
   }
 
-  // Update and get world transforms.
-  glMatrixMode(GL_MODELVIEW);
-  glPushMatrix();
-  glLoadIdentity();
-  cyd.update();
-  glPopMatrix();
+  // Update agent animations and transforms.
+  AgentWorkers.run((int)Agents.size(), updateAgent, 0);
 
-  // Draw Cyd.
-  GLfloat position[3];
-  position[0] = 0.0;
-  position[1] = 0.0;
-  position[2] = 0.0;
-  cyd.transform.spacial->transformPoint(position, cyd.xmatrix);
-  if (position[2] >= 0.5)
+  // Move agent bounding boxes: ODE calls are done serially.
   {
-	cyd.draw(LIGHTX, LIGHTY);
-  } else if (position[2] >= -0.5)
+    ProfileScope scope(FrameProfiler, PROFILE_CYD_UPDATE);
+    for (size_t i = 0; i < Agents.size(); i++) {
+      Agents[i].cyd->updateBodies();
+    }
+  }
+
+  // Draw Cyds.
   {
-    cyd.draw();
+    ProfileScope scope(FrameProfiler, PROFILE_CYD_DRAW);
+    Cyd::updateView();
+    for (size_t i = 0; i < Agents.size(); i++) {
+      drawAgent(Agents[i]);
+    }
   }
 
   // Update object carrying variables.
-  if (HeldObject != 0) carryObject(HeldObject);
+  {
+    ProfileScope scope(FrameProfiler, PROFILE_CARRY);
+    for (size_t i = 0; i < Agents.size(); i++) {
+      if (Agents[i].heldObject != 0) carryObject(Agents[i]);
+    }
+  }
 
-  // Set frame-rate independence speed factor.
+  // Close the frame span before the frame ends.
+  trace.end();
+
+  // Set frame-rate independence speed factor and record frame profile.
   frameRate.update();
+  FrameProfiler.endFrame();
+  Tracer::get().endFrame();
 
   // Catch Cyd movement commands.
 	if(GetAsyncKeyState(VK_UP)) specialKeyInput(GLUT_KEY_UP, 0, 0);
@@ -1119,25 +1345,7 @@ static void simLoop (int pause)
 	if(GetAsyncKeyState('K')) specialKeyInput('k', 0, 0);
 	if (!GetAsyncKeyState('J') && !GetAsyncKeyState('K'))
 	{
-		cyd.speed = 0.0;
-		if (cyd.animations[CYD_LEGS_WALKING]->active)
-		{
-			cyd.animations[CYD_LEGS_WALKING]->unloop();
-			cyd.animations[CYD_LEGS_WALKING]->stop();
-			cyd.bodyParts[Cyd::UPPER_RIGHT_LEG].transform.setPitch(0.0);
-			cyd.bodyParts[Cyd::LOWER_RIGHT_LEG].transform.setPitch(0.0);
-			cyd.bodyParts[Cyd::UPPER_LEFT_LEG].transform.setPitch(0.0);
-			cyd.bodyParts[Cyd::LOWER_LEFT_LEG].transform.setPitch(0.0);
-		}
-		if (InteractionMode == COLLISION && cyd.animations[CYD_ARMS_WALKING]->active)
-		{
-			cyd.animations[CYD_ARMS_WALKING]->unloop();
-			cyd.animations[CYD_ARMS_WALKING]->stop();
-			cyd.bodyParts[Cyd::UPPER_RIGHT_ARM].transform.setPitch(0.0);
-			cyd.bodyParts[Cyd::LOWER_RIGHT_ARM].transform.setPitch(0.0);
-			cyd.bodyParts[Cyd::UPPER_LEFT_ARM].transform.setPitch(0.0);
-			cyd.bodyParts[Cyd::LOWER_LEFT_ARM].transform.setPitch(0.0);
-		}
+		stopWalking(Agents[CurrentAgent]);
 	}
 	if(GetAsyncKeyState('L')) specialKeyInput('l', 0, 0);
 	if(GetAsyncKeyState('U')) specialKeyInput('u', 0, 0);
@@ -1168,11 +1376,41 @@ int main (int argc, char **argv)
   dCreatePlane (space,0,0,1,0);
   memset (obj,0,sizeof(obj));
 
-  // Initialize Cyd.
-  cyd.init(world, space);
+  // Create Cyd agents.
+  int numAgents = 1;
+  for (int i = 1; i < argc - 1; i++) {
+    if (strcmp(argv[i],"-agents")==0) numAgents = atoi(argv[i+1]);
+    if (strcmp(argv[i],"-threads")==0) AgentWorkers.setNumThreads(atoi(argv[i+1]));
+    if (strcmp(argv[i],"-lodError")==0) CydLodPixelError = atof(argv[i+1]);
+    if (strcmp(argv[i],"-trace")==0 && !Tracer::get().open(argv[i+1]))
+      fprintf(stderr,"Cannot open trace file %s\n",argv[i+1]);
+  }
+  if (numAgents < 1) numAgents = 1;
+
+  // Load Cyd model.
+  for (int i = 1; i < argc - 1; i++) {
+    if (strcmp(argv[i],"-model")==0 && !loadCydModel(argv[i+1]))
+      fprintf(stderr,"Cannot load Cyd model from %s\n",argv[i+1]);
+  }
+
+  // Load or save Cyd animation clips.
+  for (int i = 1; i < argc - 1; i++) {
+    if (strcmp(argv[i],"-animations")==0 && !Cyd::loadClips(argv[i+1]))
+      fprintf(stderr,"Cannot load animations from %s\n",argv[i+1]);
+    if (strcmp(argv[i],"-saveAnimations")==0 && !Cyd::saveClips(argv[i+1]))
+      fprintf(stderr,"Cannot save animations to %s\n",argv[i+1]);
+  }
+  for (int i = 0; i < numAgents; i++) addAgent();
+
+  // Save Cyd model, e.g. converted from the built-in model.
+  for (int i = 1; i < argc - 1; i++) {
+    if (strcmp(argv[i],"-saveModel")==0 && !saveCydModel(argv[i+1]))
+      fprintf(stderr,"Cannot save Cyd model to %s\n",argv[i+1]);
+  }
 
   // run simulation
   dsSimulationLoop (argc,argv,352,288,&fn);
+  Tracer::get().close();
 
   dJointGroupDestroy (contactgroup);
   dSpaceDestroy (space);
@@ -14,8 +14,69 @@
 
 #include <GL/gl.h>
 #include <list>
+#include <string.h>
 #include "spacial.hpp"
 
+// Column-major 4x4 matrix operations following the OpenGL conventions.
+// These let transforms be computed without the GL matrix stack, so
+// they can be evaluated off the rendering thread.
+inline void bodyMatrixIdentity(GLfloat *m)
+{
+	for (int i = 0; i < 16; i++) m[i] = 0.0;
+	m[0] = m[5] = m[10] = m[15] = 1.0;
+}
+
+// m = m * n (same as glMultMatrixf).
+inline void bodyMatrixMultiply(GLfloat *m, const GLfloat *n)
+{
+	GLfloat r[16];
+
+	for (int c = 0; c < 4; c++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			r[(c*4)+i] = (m[i] * n[c*4]) + (m[4+i] * n[(c*4)+1]) +
+				(m[8+i] * n[(c*4)+2]) + (m[12+i] * n[(c*4)+3]);
+		}
+	}
+	memcpy(m, r, sizeof(r));
+}
+
+// m = m * translate(x,y,z) (same as glTranslatef).
+inline void bodyMatrixTranslate(GLfloat *m, GLfloat x, GLfloat y, GLfloat z)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		m[12+i] += (m[i] * x) + (m[4+i] * y) + (m[8+i] * z);
+	}
+}
+
+// m = m * scale(x,y,z) (same as glScalef).
+inline void bodyMatrixScale(GLfloat *m, GLfloat x, GLfloat y, GLfloat z)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		m[i] *= x;
+		m[4+i] *= y;
+		m[8+i] *= z;
+	}
+}
+
+// Transform point by matrix.
+inline void bodyMatrixTransformPoint(const GLfloat *m, GLfloat *point)
+{
+	GLfloat p[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		p[i] = (m[i] * point[0]) + (m[4+i] * point[1]) +
+			(m[8+i] * point[2]) + m[12+i];
+	}
+	point[0] = p[0];
+	point[1] = p[1];
+	point[2] = p[2];
+}
+
 // Transforms.
 class BodyTransform
 {
@@ -0,0 +1,70 @@
+//***************************************************************************//
+//* File Name: contacts.hpp                                                 *//
+//* Date Made: 10/18/26                                                     *//
+//* File Desc: Per-frame buffer of collision contact points, captured      *//
+//*            during collision for debug drawing and tools.                *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __CONTACTS_HPP__
+#define __CONTACTS_HPP__
+
+#include <vector>
+#include <ode/ode.h>
+
+// Contact point.
+struct ContactPoint
+{
+	dReal pos[3];
+	dReal normal[3];
+	dReal depth;
+};
+
+// Contact buffer: points are only captured when enabled, so a
+// disabled buffer costs a flag test per contact.
+class ContactBuffer
+{
+public:
+
+	// Capture contacts?
+	bool enabled;
+
+	// Constructor.
+	ContactBuffer()
+	{
+		enabled = false;
+	}
+
+	// Clear for a new frame.
+	void clear()
+	{
+		points.clear();
+	}
+
+	// Capture contact.
+	void add(const dContactGeom &contact)
+	{
+		ContactPoint point;
+
+		if (!enabled) return;
+		for (int i = 0; i < 3; i++)
+		{
+			point.pos[i] = contact.pos[i];
+			point.normal[i] = contact.normal[i];
+		}
+		point.depth = contact.depth;
+		points.push_back(point);
+	}
+
+	// Get captured contacts.
+	int size() { return (int)points.size(); }
+	const ContactPoint &get(int i) { return points[i]; }
+	const std::vector<ContactPoint> &getPoints() { return points; }
+
+private:
+
+	std::vector<ContactPoint> points;
+};
+#endif
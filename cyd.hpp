@@ -13,6 +13,8 @@
 #include <ode/ode.h>
 #include <list>
 #include <vector>
+#include "profiler.hpp"
+#include "frustum.hpp"
 #include "body.hpp"
 #include "animation.hpp"
 #include "cyd_model.h"
@@ -52,14 +54,19 @@ public:
 		// Body part transform matrix.
 		GLfloat xmatrix[16];
 
-		// Get transform.
-		void getTransform()
+		// Torso translation without rotation: parent transform of legs.
+		GLfloat basematrix[16];
+
+		// Component levels of detail: negative if culled.
+		int *lods;
+
+		// Get transform relative to parent transform.
+		void getTransform(const GLfloat *parent)
 		{
 			CydBodyPart *subpart;
 			std::list<BodyPart *>::iterator listItr;
 
-			glMatrixMode(GL_MODELVIEW);
-			glPushMatrix();
+			memcpy(xmatrix, parent, sizeof(xmatrix));
 
 			// Transform this part.
 			switch(part)
@@ -83,15 +90,14 @@ public:
 				subpart = (CydBodyPart *)*listItr;
 
 				// Remove torso rotation from leg transform.
-				if (subpart->part == UPPER_RIGHT_LEG)
+				if (part == TORSO &&
+					(subpart->part == UPPER_RIGHT_LEG || subpart->part == UPPER_LEFT_LEG))
 				{
-					glPopMatrix();
+					subpart->getTransform(basematrix);
+				} else {
+					subpart->getTransform(xmatrix);
 				}
-				glPushMatrix();
-				subpart->getTransform();
-				glPopMatrix();
 			}
-			glPopMatrix();
 		}
 
 		// Draw.
@@ -129,6 +135,18 @@ public:
 			}
 		}
 
+		// Draw model component.
+		void drawComponent(int component)
+		{
+			if (lods[component] < 0) return;
+			TraceScope trace("cyd component", "draw", component);
+#ifdef CYD_DRAW_USING_DISPLAY
+			glCallList(CydDisplays[component][lods[component]]);
+#else
+			drawCydComponent(component, lods[component]);
+#endif
+		}
+
 		// Specialized transform and drawing functions.
 		void getTorsoTransform()
 		{
@@ -138,28 +156,23 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 
-			// Separate torso rotation to pop before legs drawn.
-			glPushMatrix();
+			// Separate torso rotation from legs.
+			memcpy(basematrix, xmatrix, sizeof(basematrix));
 
-			glTranslatef(0.0, 0.0,
+			bodyMatrixTranslate(xmatrix, 0.0, 0.0,
 				CydBounds[CYD_TORSO].min[2]);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(0.0, 0.0,
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, 0.0, 0.0,
 				-CydBounds[CYD_TORSO].min[2]);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawTorso()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_TORSO]);
-#else
-			drawCydComponent(CYD_TORSO);
-#endif
+			drawComponent(CYD_TORSO);
 		}
 
 		void getHeadTransform()
@@ -170,31 +183,24 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 			for (int i = 0; i < 3; i++)
 			{
 				a[i] = (CydBounds[CYD_UPPER_RIGHT_ARM].max[i] +
 					CydBounds[CYD_UPPER_RIGHT_ARM].min[i]) / 2.0;
 			}
-			glTranslatef(0.0, a[1], 0.0);
+			bodyMatrixTranslate(xmatrix, 0.0, a[1], 0.0);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(0.0, -a[1], 0.0);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, 0.0, -a[1], 0.0);
 		}
 
 		void drawHead()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_HEAD]);
-			glCallList(CydDisplays[CYD_LEFT_EYE]);
-			glCallList(CydDisplays[CYD_RIGHT_EYE]);
-#else
-			drawCydComponent(CYD_HEAD);
-			drawCydComponent(CYD_LEFT_EYE);
-			drawCydComponent(CYD_RIGHT_EYE);
-#endif
+			drawComponent(CYD_HEAD);
+			drawComponent(CYD_LEFT_EYE);
+			drawComponent(CYD_RIGHT_EYE);
 		}
 
 		void getUpperRightArmTransform()
@@ -205,29 +211,24 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 			for (int i = 0; i < 3; i++)
 			{
 				a[i] = (CydBounds[CYD_UPPER_RIGHT_ARM].max[i] +
 					CydBounds[CYD_UPPER_RIGHT_ARM].min[i]) / 2.0;
 			}
-			glTranslatef(a[0] * 0.9, a[1],
+			bodyMatrixTranslate(xmatrix, a[0] * 0.9, a[1],
 				CydBounds[CYD_UPPER_RIGHT_ARM].max[2] * 0.9);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(-a[0] * 0.9, -a[1],
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, -a[0] * 0.9, -a[1],
 				-CydBounds[CYD_UPPER_RIGHT_ARM].max[2] * 0.9);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawUpperRightArm()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_UPPER_RIGHT_ARM]);
-#else
-			drawCydComponent(CYD_UPPER_RIGHT_ARM);
-#endif
+			drawComponent(CYD_UPPER_RIGHT_ARM);
 		}
 
 		void getLowerRightArmTransform()
@@ -238,31 +239,25 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 			for (int i = 0; i < 3; i++)
 			{
 				a[i] = (CydBounds[CYD_LOWER_RIGHT_ARM].max[i] +
 					CydBounds[CYD_LOWER_RIGHT_ARM].min[i]) / 2.0;
 			}
-			glTranslatef(a[0] * 0.9, a[1],
+			bodyMatrixTranslate(xmatrix, a[0] * 0.9, a[1],
 				CydBounds[CYD_LOWER_RIGHT_ARM].max[2] * 0.85);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(-a[0] * 0.9, -a[1],
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, -a[0] * 0.9, -a[1],
 				-CydBounds[CYD_LOWER_RIGHT_ARM].max[2] * 0.85);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawLowerRightArm()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_LOWER_RIGHT_ARM]);
-			glCallList(CydDisplays[CYD_RIGHT_HAND]);
-#else
-			drawCydComponent(CYD_LOWER_RIGHT_ARM);
-			drawCydComponent(CYD_RIGHT_HAND);
-#endif
+			drawComponent(CYD_LOWER_RIGHT_ARM);
+			drawComponent(CYD_RIGHT_HAND);
 		}
 
 		void getUpperRightLegTransform()
@@ -273,31 +268,25 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 			for (int i = 0; i < 3; i++)
 			{
 				a[i] = (CydBounds[CYD_UPPER_RIGHT_LEG].max[i] +
 					CydBounds[CYD_UPPER_RIGHT_LEG].min[i]) / 2.0;
 			}
-			glTranslatef(a[0] * 0.9, a[1],
+			bodyMatrixTranslate(xmatrix, a[0] * 0.9, a[1],
 				CydBounds[CYD_UPPER_RIGHT_LEG].max[2] * 0.8);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(-a[0] * 0.9, -a[1],
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, -a[0] * 0.9, -a[1],
 				-CydBounds[CYD_UPPER_RIGHT_LEG].max[2] * 0.8);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawUpperRightLeg()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_UPPER_RIGHT_LEG]);
-			glCallList(CydDisplays[CYD_RIGHT_KNEE]);
-#else
-			drawCydComponent(CYD_UPPER_RIGHT_LEG);
-			drawCydComponent(CYD_RIGHT_KNEE);
-#endif
+			drawComponent(CYD_UPPER_RIGHT_LEG);
+			drawComponent(CYD_RIGHT_KNEE);
 		}
 
 		void getLowerRightLegTransform()
@@ -308,26 +297,20 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
-			glTranslatef(0.0, CydBounds[CYD_LOWER_RIGHT_LEG].max[1] * 0.5,
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, 0.0, CydBounds[CYD_LOWER_RIGHT_LEG].max[1] * 0.5,
 				CydBounds[CYD_LOWER_RIGHT_LEG].max[2] * 1.1);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(0.0, -CydBounds[CYD_LOWER_RIGHT_LEG].max[1] * 0.5,
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, 0.0, -CydBounds[CYD_LOWER_RIGHT_LEG].max[1] * 0.5,
 				-CydBounds[CYD_LOWER_RIGHT_LEG].max[2] * 1.1);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawLowerRightLeg()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_LOWER_RIGHT_LEG]);
-			glCallList(CydDisplays[CYD_RIGHT_FOOT]);
-#else
-			drawCydComponent(CYD_LOWER_RIGHT_LEG);
-			drawCydComponent(CYD_RIGHT_FOOT);
-#endif
+			drawComponent(CYD_LOWER_RIGHT_LEG);
+			drawComponent(CYD_RIGHT_FOOT);
 		}
 
 		void getUpperLeftArmTransform()
@@ -338,29 +321,24 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 			for (int i = 0; i < 3; i++)
 			{
 				a[i] = (CydBounds[CYD_UPPER_LEFT_ARM].max[i] +
 					CydBounds[CYD_UPPER_LEFT_ARM].min[i]) / 2.0;
 			}
-			glTranslatef(a[0] * 0.9, a[1],
+			bodyMatrixTranslate(xmatrix, a[0] * 0.9, a[1],
 				CydBounds[CYD_UPPER_LEFT_ARM].max[2] * 0.9);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(-a[0] * 0.9, -a[1],
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, -a[0] * 0.9, -a[1],
 				-CydBounds[CYD_UPPER_LEFT_ARM].max[2] * 0.9);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawUpperLeftArm()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_UPPER_LEFT_ARM]);
-#else
-			drawCydComponent(CYD_UPPER_LEFT_ARM);
-#endif
+			drawComponent(CYD_UPPER_LEFT_ARM);
 		}
 
 		void getLowerLeftArmTransform()
@@ -371,31 +349,25 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 			for (int i = 0; i < 3; i++)
 			{
 				a[i] = (CydBounds[CYD_LOWER_LEFT_ARM].max[i] +
 					CydBounds[CYD_LOWER_LEFT_ARM].min[i]) / 2.0;
 			}
-			glTranslatef(a[0] * 0.9, a[1],
+			bodyMatrixTranslate(xmatrix, a[0] * 0.9, a[1],
 				CydBounds[CYD_LOWER_LEFT_ARM].max[2] * 0.85);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(-a[0] * 0.9, -a[1],
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, -a[0] * 0.9, -a[1],
 				-CydBounds[CYD_LOWER_LEFT_ARM].max[2] * 0.85);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawLowerLeftArm()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_LOWER_LEFT_ARM]);
-			glCallList(CydDisplays[CYD_LEFT_HAND]);
-#else
-			drawCydComponent(CYD_LOWER_LEFT_ARM);
-			drawCydComponent(CYD_LEFT_HAND);
-#endif
+			drawComponent(CYD_LOWER_LEFT_ARM);
+			drawComponent(CYD_LEFT_HAND);
 		}
 
 		void getUpperLeftLegTransform()
@@ -406,31 +378,25 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
 			for (int i = 0; i < 3; i++)
 			{
 				a[i] = (CydBounds[CYD_UPPER_LEFT_LEG].max[i] +
 					CydBounds[CYD_UPPER_LEFT_LEG].min[i]) / 2.0;
 			}
-			glTranslatef(a[0] * 0.9, a[1],
+			bodyMatrixTranslate(xmatrix, a[0] * 0.9, a[1],
 				CydBounds[CYD_UPPER_LEFT_LEG].max[2] * 0.8);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(-a[0] * 0.9, -a[1],
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, -a[0] * 0.9, -a[1],
 				-CydBounds[CYD_UPPER_LEFT_LEG].max[2] * 0.8);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawUpperLeftLeg()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_UPPER_LEFT_LEG]);
-			glCallList(CydDisplays[CYD_LEFT_KNEE]);
-#else
-			drawCydComponent(CYD_UPPER_LEFT_LEG);
-			drawCydComponent(CYD_LEFT_KNEE);
-#endif
+			drawComponent(CYD_UPPER_LEFT_LEG);
+			drawComponent(CYD_LEFT_KNEE);
 		}
 
 		void getLowerLeftLegTransform()
@@ -441,55 +407,71 @@ public:
 			t[0] = transform.ox + transform.tx;
 			t[1] = transform.oy + transform.ty;
 			t[2] = transform.oz + transform.tz;
-			glTranslatef(t[0], t[1], t[2]);
-			glTranslatef(0.0, CydBounds[CYD_LOWER_LEFT_LEG].max[1] * 0.5,
+			bodyMatrixTranslate(xmatrix, t[0], t[1], t[2]);
+			bodyMatrixTranslate(xmatrix, 0.0, CydBounds[CYD_LOWER_LEFT_LEG].max[1] * 0.5,
 				CydBounds[CYD_LOWER_LEFT_LEG].max[2] * 1.1);
 			spacial = transform.spacial;
-			glMultMatrixf(&spacial->rotmatrix[0][0]);
-			glTranslatef(0.0, -CydBounds[CYD_LOWER_LEFT_LEG].max[1] * 0.5,
+			bodyMatrixMultiply(xmatrix, &spacial->rotmatrix[0][0]);
+			bodyMatrixTranslate(xmatrix, 0.0, -CydBounds[CYD_LOWER_LEFT_LEG].max[1] * 0.5,
 				-CydBounds[CYD_LOWER_LEFT_LEG].max[2] * 1.1);
-			glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
 		}
 
 		void drawLowerLeftLeg()
 		{
 			glMultMatrixf(xmatrix);
-#ifdef CYD_DRAW_USING_DISPLAY
-			glCallList(CydDisplays[CYD_LOWER_LEFT_LEG]);
-			glCallList(CydDisplays[CYD_LEFT_FOOT]);
-#else
-			drawCydComponent(CYD_LOWER_LEFT_LEG);
-			drawCydComponent(CYD_LEFT_FOOT);
-#endif
+			drawComponent(CYD_LOWER_LEFT_LEG);
+			drawComponent(CYD_LEFT_FOOT);
 		}
 	};
 	CydBodyPart bodyParts[CYD_NUM_BODY_PARTS];
 
+	// Component levels of detail, selected when drawn:
+	// negative for components outside the view frustum.
+	int lods[CYD_NUM_COMPONENTS];
+
 	// Bounding boxes for ODE collision detection/response.
 	struct BoundingBox {
 	  dBodyID body;
 	  dGeomID geom;
+	  dReal position[3];
+	  dMatrix3 rotation;
 	};
 	struct BoundingBox boundingBoxes[CYD_NUM_COMPONENTS];
 
+	// Agent identifier.
+	int id;
+
 	// ODE world and space.
+	// The bounding boxes are kept in a per-agent space, so boxes
+	// of the same agent are never tested against each other.
 	dWorldID world;
 	dSpaceID space;
+	dSpaceID agentSpace;
 
 	// Show bounding boxes?
 	bool showBoxes;
 	bool showHands;
 
-	// Animations.
-	std::vector<Animation *> animations;
+	// Animations: clips are blended by a mixer with legs,
+	// arms and torso layers.
+	#define CYD_NUM_ANIMATIONS 4
+
+	// Torso pitch offset while carrying: cancels the pickup lean.
+	#define CYD_CARRY_PITCH -45.0
+	typedef enum
+	{
+		LEGS_LAYER=0, ARMS_LAYER=1, TORSO_LAYER=2
+	} CYD_ANIMATION_LAYER;
+	AnimMixer mixer;
+	BodyPart *animParts[CYD_NUM_BODY_PARTS];
 
 	// Initialize.
-	void init(dWorldID world, dSpaceID space)
+	void init(dWorldID world, dSpaceID space, int id = 0)
 	{
 		// Raise Cyd to "ground" level.
 		transform.oz = 0.5;
 
-		// Build Cyd model.
+		// Build Cyd model: shared by all agents.
 		buildCydModel();
 
 		// Build body parts.
@@ -518,12 +500,16 @@ public:
 		dReal sides[3],position[3];
 		dMass m;
 
+		this->id = id;
 		this->world = world;
 		this->space = space;
+		agentSpace = dSimpleSpaceCreate(space);
 
 		showBoxes = showHands = false;
+		speed = 0.0;
 		for (i = 0; i < CYD_NUM_COMPONENTS; i++)
 		{
+			lods[i] = 0;
 			boundingBoxes[i].body = dBodyCreate(world);
 			for (j = 0; j < 3; j++)
 			{
@@ -532,259 +518,215 @@ public:
 			}
 			dMassSetBox(&m,CYD_DENSITY,sides[0],sides[1],sides[2]);
 			dBodySetMass(boundingBoxes[i].body,&m);
-			boundingBoxes[i].geom = dCreateBox(space,sides[0],sides[1],sides[2]);
+			boundingBoxes[i].geom = dCreateBox(agentSpace,sides[0],sides[1],sides[2]);
 			dGeomSetCategoryBits(boundingBoxes[i].geom, (unsigned long)i);
+			dGeomSetData(boundingBoxes[i].geom, this);
 			dGeomSetBody(boundingBoxes[i].geom,boundingBoxes[i].body);
 			dGeomSetPosition(boundingBoxes[i].geom,position[0],position[1],position[2]);
 		}
 
-		// Create animations:
-		animations.resize(4);
+		// Create animation mixer: clips are shared by all agents.
+		for (i = 0; i < CYD_NUM_BODY_PARTS; i++)
+		{
+			animParts[i] = &bodyParts[i];
+			bodyParts[i].lods = lods;
+		}
+		getClips();
+		mixer.init(animParts, CYD_NUM_BODY_PARTS, &getAnimChannels());
+		mixer.addLayer((1 << UPPER_RIGHT_LEG) | (1 << LOWER_RIGHT_LEG) |
+			(1 << UPPER_LEFT_LEG) | (1 << LOWER_LEFT_LEG));
+		mixer.addLayer((1 << UPPER_RIGHT_ARM) | (1 << LOWER_RIGHT_ARM) |
+			(1 << UPPER_LEFT_ARM) | (1 << LOWER_LEFT_ARM));
+		mixer.addLayer((1 << TORSO) | (1 << HEAD));
+	}
+
+	// Play animation on the layers driving its parts.
+	// Paced animations also scale with the movement rate.
+	void playAnimation(int animation, bool looped, bool paced)
+	{
+		mixer.play(getClips()[animation], looped, paced);
+	}
+
+	// Fade out animation.
+	void stopAnimation(int animation)
+	{
+		mixer.stop(getClips()[animation]);
+	}
+
+	// Finish animation at end of its current cycle.
+	void unloopAnimation(int animation)
+	{
+		mixer.unloop(getClips()[animation]);
+	}
+
+	bool isAnimating(int animation)
+	{
+		return mixer.isPlaying(getClips()[animation]);
+	}
+
+	// Straighten up from the pickup lean to carry an object, or lean
+	// over again when it is dropped.
+	void setCarrying(bool carrying)
+	{
+		mixer.setOffset(TORSO, ANIM_RX, carrying ? CYD_CARRY_PITCH : 0.0);
+	}
+
+	// Run animations: prepare every agent, step the channels of all
+	// agents together, then apply each agent's animations.
+	void prepareAnimation(GLfloat speedFactor, GLfloat paceFactor)
+	{
+		mixer.prepare(speedFactor, paceFactor);
+	}
+	static void stepAnimations()
+	{
+		getAnimChannels().step();
+	}
+	void applyAnimation()
+	{
+		mixer.apply();
+	}
+
+	// Animation channels of all agents.
+	static AnimChannels &getAnimChannels()
+	{
+		static AnimChannels channels;
+
+		return channels;
+	}
+
+	// Animation clips, built on first use.
+	static std::vector<AnimClip *> &clipStore()
+	{
+		static std::vector<AnimClip *> clips;
+
+		return clips;
+	}
+	static std::vector<AnimClip *> &getClips()
+	{
+		std::vector<AnimClip *> &clips = clipStore();
+
+		if (clips.size() == 0) buildClips(clips);
+		return clips;
+	}
+
+	// Load animation clips from file: call before agents are initialized.
+	static bool loadClips(char *filename)
+	{
+		std::vector<AnimClip *> clips;
+
+		if (!loadAnimClips(filename, CYD_NUM_BODY_PARTS, clips)) return false;
+		if (clips.size() != CYD_NUM_ANIMATIONS)
+		{
+			for (int i = 0; i < (int)clips.size(); i++) delete clips[i];
+			return false;
+		}
+		for (int i = 0; i < (int)clipStore().size(); i++) delete clipStore()[i];
+		clipStore() = clips;
+		return true;
+	}
+
+	// Save animation clips to file.
+	static bool saveClips(char *filename)
+	{
+		return saveAnimClips(filename, getClips());
+	}
+
+	// Build built-in animation clips.
+	static void buildClips(std::vector<AnimClip *> &clips)
+	{
+		AnimClip *clip;
+
+		clips.resize(CYD_NUM_ANIMATIONS);
 
 		// Lower body walking.
-		Animation *animation = new Animation();
-		animations[0] = animation;
-		AnimCluster *cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		AnimPart *part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_LEG];
-		part->rx = -20.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_LEG];
-		part->rx = 20.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_LEFT_LEG];
-		part->rx = 40.0;
-		part->rxs = 2.0;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_LEG];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_LEG];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_LEFT_LEG];
-		part->rx = 0.0;
-		part->rxs = 2.0;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_LEG];
-		part->rx = 20.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_RIGHT_LEG];
-		part->rx = 40.0;
-		part->rxs = 2.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_LEG];
-		part->rx = -20.0;
-		part->rxs = 1.0;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_LEG];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_RIGHT_LEG];
-		part->rx = 0.0;
-		part->rxs = 2.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_LEG];
-		part->rx = 0.0;
-		part->rxs = 1.0;
+		clips[0] = clip = new AnimClip();
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_LEG, -20.0, 1.0);
+		clip->addPitch(UPPER_LEFT_LEG, 20.0, 1.0);
+		clip->addPitch(LOWER_LEFT_LEG, 40.0, 2.0);
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_LEG, 0.0, 1.0);
+		clip->addPitch(UPPER_LEFT_LEG, 0.0, 1.0);
+		clip->addPitch(LOWER_LEFT_LEG, 0.0, 2.0);
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_LEG, 20.0, 1.0);
+		clip->addPitch(LOWER_RIGHT_LEG, 40.0, 2.0);
+		clip->addPitch(UPPER_LEFT_LEG, -20.0, 1.0);
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_LEG, 0.0, 1.0);
+		clip->addPitch(LOWER_RIGHT_LEG, 0.0, 2.0);
+		clip->addPitch(UPPER_LEFT_LEG, 0.0, 1.0);
 
 		// Upper body walking.
-		animation = new Animation();
-		animations[1] = animation;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_ARM];
-		part->rx = 20.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_ARM];
-		part->rx = -20.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_LEFT_ARM];
-		part->rx = -40.0;
-		part->rxs = 2.0;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_LEFT_ARM];
-		part->rx = 0.0;
-		part->rxs = 2.0;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_ARM];
-		part->rx = -20.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_RIGHT_ARM];
-		part->rx = -40.0;
-		part->rxs = 2.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_ARM];
-		part->rx = 20.0;
-		part->rxs = 1.0;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_RIGHT_ARM];
-		part->rx = 0.0;
-		part->rxs = 2.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
+		clips[1] = clip = new AnimClip();
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_ARM, 20.0, 1.0);
+		clip->addPitch(UPPER_LEFT_ARM, -20.0, 1.0);
+		clip->addPitch(LOWER_LEFT_ARM, -40.0, 2.0);
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_ARM, 0.0, 1.0);
+		clip->addPitch(UPPER_LEFT_ARM, 0.0, 1.0);
+		clip->addPitch(LOWER_LEFT_ARM, 0.0, 2.0);
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_ARM, -20.0, 1.0);
+		clip->addPitch(LOWER_RIGHT_ARM, -40.0, 2.0);
+		clip->addPitch(UPPER_LEFT_ARM, 20.0, 1.0);
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_ARM, 0.0, 1.0);
+		clip->addPitch(LOWER_RIGHT_ARM, 0.0, 2.0);
+		clip->addPitch(UPPER_LEFT_ARM, 0.0, 1.0);
 
 		// Arms to pickup position.
-		animation = new Animation();
-		animations[2] = animation;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_ARM];
-		part->rx = -90.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_RIGHT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_ARM];
-		part->rx = -90.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_LEFT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[TORSO];
-		part->rx = 45.0;
-		part->rxs = 1.0;
+		clips[2] = clip = new AnimClip();
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_ARM, -90.0, 1.0);
+		clip->addPitch(LOWER_RIGHT_ARM, 0.0, 1.0);
+		clip->addPitch(UPPER_LEFT_ARM, -90.0, 1.0);
+		clip->addPitch(LOWER_LEFT_ARM, 0.0, 1.0);
+		clip->addPitch(TORSO, 45.0, 1.0);
 
 		// Arms to sides position.
-		animation = new Animation();
-		animations[3] = animation;
-		cluster = new AnimCluster();
-		animation->sequence.push_back(cluster);
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_RIGHT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_RIGHT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[UPPER_LEFT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[LOWER_LEFT_ARM];
-		part->rx = 0.0;
-		part->rxs = 1.0;
-		part = new AnimPart();
-		cluster->cluster.push_back(part);
-		part->part = &bodyParts[TORSO];
-		part->rx = 0.0;
-		part->rxs = 1.0;
+		clips[3] = clip = new AnimClip();
+		clip->addCluster();
+		clip->addPitch(UPPER_RIGHT_ARM, 0.0, 1.0);
+		clip->addPitch(LOWER_RIGHT_ARM, 0.0, 1.0);
+		clip->addPitch(UPPER_LEFT_ARM, 0.0, 1.0);
+		clip->addPitch(LOWER_LEFT_ARM, 0.0, 1.0);
+		clip->addPitch(TORSO, 0.0, 1.0);
 	}
 
 	// Update.
 	void update()
+	{
+		updateTransforms();
+		updateBodies();
+	}
+
+	// Update body part transforms and bounding box poses.
+	// This does not call OpenGL or ODE, so agents can be
+	// updated concurrently.
+	void updateTransforms()
 	{
 		int i,j,p,q;
-		dMatrix3 rotation;
 		GLfloat angle,ax,ay,az;
 		GLfloat matrix[4][4],quat[4];
 		double cosa,sina;
-		GLfloat position[3],forward[3];
-		dReal velocity[3],angularVelocity[3];
-
-		glMatrixMode(GL_MODELVIEW);
-		glPushMatrix();
+		GLfloat position[3];
 
 		// Get Cyd transform.
-		glTranslatef(transform.ox + transform.tx,
+		bodyMatrixIdentity(xmatrix);
+		bodyMatrixTranslate(xmatrix, transform.ox + transform.tx,
 			transform.oy + transform.ty,
 			transform.oz + transform.tz);
-		glMultMatrixf(&transform.spacial->rotmatrix[0][0]);
-		glScalef(transform.sx,transform.sy, transform.sz);
-		glGetFloatv(GL_MODELVIEW_MATRIX, xmatrix);
+		bodyMatrixMultiply(xmatrix, &transform.spacial->rotmatrix[0][0]);
+		bodyMatrixScale(xmatrix, transform.sx,transform.sy, transform.sz);
 
 		// Recursive body part transforms.
-		bodyParts[TORSO].getTransform();
-
-		glPopMatrix();
+		bodyParts[TORSO].getTransform(xmatrix);
 
 		// Transform bounding boxes.
-		transform.spacial->getUp(forward);
-		for (i = 0; i < 3; i++) velocity[i] = -forward[i] * speed;
-		for (i = 0; i < 3; i++) angularVelocity[i] = 0.0;
 		for (i = 0; i < CYD_NUM_COMPONENTS; i++)
 		{
-			dBodySetLinearVel (boundingBoxes[i].body,
-				velocity[0], velocity[1], velocity[2]);
-			dBodySetAngularVel(boundingBoxes[i].body,
-				angularVelocity[0], angularVelocity[1], angularVelocity[2]);
 			for (j = 0; j < 3; j++)
 			{
 				position[j] = (CydBounds[i].max[j] + CydBounds[i].min[j]) / 2.0;
@@ -806,10 +748,34 @@ public:
 			ax = quat[0] / sina;
 			ay = quat[1] / sina;
 			az = quat[2] / sina;
-			dRFromAxisAndAngle(rotation, ax, ay, az, -angle);
-			transform.spacial->transformPoint(position, bodyParts[j].xmatrix);
-			dBodySetRotation(boundingBoxes[i].body, rotation);
-			dBodySetPosition(boundingBoxes[i].body,position[0],position[1],position[2]);
+			dRFromAxisAndAngle(boundingBoxes[i].rotation, ax, ay, az, -angle);
+			bodyMatrixTransformPoint(bodyParts[j].xmatrix, position);
+			for (j = 0; j < 3; j++)
+			{
+				boundingBoxes[i].position[j] = position[j];
+			}
+		}
+	}
+
+	// Move bounding box bodies to the poses found by updateTransforms.
+	void updateBodies()
+	{
+		int i;
+		GLfloat forward[3];
+		dReal velocity[3],angularVelocity[3];
+
+		transform.spacial->getUp(forward);
+		for (i = 0; i < 3; i++) velocity[i] = -forward[i] * speed;
+		for (i = 0; i < 3; i++) angularVelocity[i] = 0.0;
+		for (i = 0; i < CYD_NUM_COMPONENTS; i++)
+		{
+			dBodySetLinearVel (boundingBoxes[i].body,
+				velocity[0], velocity[1], velocity[2]);
+			dBodySetAngularVel(boundingBoxes[i].body,
+				angularVelocity[0], angularVelocity[1], angularVelocity[2]);
+			dBodySetRotation(boundingBoxes[i].body, boundingBoxes[i].rotation);
+			dBodySetPosition(boundingBoxes[i].body, boundingBoxes[i].position[0],
+				boundingBoxes[i].position[1], boundingBoxes[i].position[2]);
 		}
 	}
 
@@ -889,22 +855,25 @@ public:
 		glEnable (GL_BLEND);
 		glBlendFunc (GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
 		glColor4f(0.0, 0.0, 0.0, 0.3);
-		for (int i = 0; i < CYD_NUM_COMPONENTS; i++)
+		glPushMatrix();
+		glDepthRange (0,0.9999);
+		setShadowTransform(lightx, lighty);
 		{
-			glPushMatrix();
-			glDepthRange (0,0.9999);
-			setShadowTransform(lightx, lighty);
-
-			// Draw precise shadow - too slow!
-//			bodyParts[TORSO].draw();
-
-			// Draw bounding box shadow.
-			glPushMatrix();
-			glMultMatrixf(bodyParts[getPartFromComponent(i)].xmatrix);
-			drawBoundingBox(i, true);
-			glPopMatrix();
-			glPopMatrix();
+			// Draw precise shadow from simplified meshes.
+			TraceScope trace("cyd shadow", "draw");
+			for (int i = 0; i < CYD_NUM_COMPONENTS; i++)
+			{
+				glPushMatrix();
+				glMultMatrixf(bodyParts[getPartFromComponent(i)].xmatrix);
+#ifdef CYD_DRAW_USING_DISPLAY
+				glCallList(CydShadowDisplays[i]);
+#else
+				drawCydShadow(i);
+#endif
+				glPopMatrix();
+			}
 		}
+		glPopMatrix();
 
 		// Draw Cyd.
 		draw();
@@ -925,6 +894,7 @@ public:
 		glLightModeli(GL_LIGHT_MODEL_TWO_SIDE ,1);
 
 		// Recursive draw.
+		cullComponents();
 		bodyParts[TORSO].draw();
 
 		// Draw bounding boxes.
@@ -948,6 +918,78 @@ public:
 		}
 	}
 
+	// Camera view of the frame, shared by all Cyds: modelview,
+	// projection, viewport and frustum.
+	struct View
+	{
+		GLfloat modelview[16],projection[16];
+		GLint viewport[4];
+		Frustum frustum;
+	};
+	static View &getView()
+	{
+		static View view;
+
+		return view;
+	}
+
+	// Get the view from the current GL transforms: call once per
+	// frame, before drawing Cyds.
+	static void updateView()
+	{
+		View &view = getView();
+
+		glGetFloatv(GL_MODELVIEW_MATRIX, view.modelview);
+		glGetFloatv(GL_PROJECTION_MATRIX, view.projection);
+		glGetIntegerv(GL_VIEWPORT, view.viewport);
+		view.frustum.update(view.projection, view.modelview);
+	}
+
+	// Cull components outside the view frustum, and select the
+	// levels of detail of the others: the coarsest whose error,
+	// projected to the nearest point of the component, is within
+	// the pixel error limit.
+	void cullComponents()
+	{
+		int i,j;
+		GLfloat matrix[16];
+		GLfloat center[3],extents[3],radius,scale,depth,pixels;
+		unsigned int clipMask;
+		View &view = getView();
+
+		for (i = 0; i < CYD_NUM_COMPONENTS; i++)
+		{
+			lods[i] = 0;
+			radius = 0.0;
+			for (j = 0; j < 3; j++)
+			{
+				center[j] = (CydBounds[i].max[j] + CydBounds[i].min[j]) / 2.0;
+				extents[j] = (CydBounds[i].max[j] - CydBounds[i].min[j]) / 2.0;
+				radius += extents[j] * extents[j];
+			}
+			clipMask = FRUSTUM_ALL_PLANES;
+			if (!view.frustum.overlap(bodyParts[getPartFromComponent(i)].xmatrix,
+				center, extents, clipMask))
+			{
+				lods[i] = -1;
+				continue;
+			}
+			if (CydLodPixelError <= 0.0) continue;
+			memcpy(matrix, view.modelview, sizeof(matrix));
+			bodyMatrixMultiply(matrix, bodyParts[getPartFromComponent(i)].xmatrix);
+			bodyMatrixTransformPoint(matrix, center);
+			scale = sqrt((matrix[0] * matrix[0]) + (matrix[1] * matrix[1]) +
+				(matrix[2] * matrix[2]));
+			radius = sqrt(radius) * scale;
+
+			// Pixels per model unit at the nearest depth.
+			depth = -center[2] - radius;
+			if (depth <= 0.0) continue;
+			pixels = scale * view.projection[5] * (GLfloat)view.viewport[3] * 0.5 / depth;
+			lods[i] = getCydLod(i, CydLodPixelError / pixels);
+		}
+	}
+
 	// Draw bounding box.
 	void drawBoundingBox(int component, bool solid)
 	{
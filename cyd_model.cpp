@@ -12,10 +12,28 @@ eMail       info@xdsoft.com
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#include <vector>
+#include <map>
+#ifdef CYD_BUILTIN_MODEL
+#include "simplifier.hpp"
+#endif
 #include "cyd_model.h"
 
 // Display lists.
-int CydDisplays[CYD_NUM_COMPONENTS];
+int CydDisplays[CYD_NUM_COMPONENTS][CYD_NUM_LODS];
+int CydShadowDisplays[CYD_NUM_COMPONENTS];
+
+// Level of detail error limit in pixels.
+GLfloat CydLodPixelError = CYD_LOD_PIXEL_ERROR;
 
 // Component bounds.
 struct CydBound CydBounds[CYD_NUM_COMPONENTS];
@@ -34,6 +52,11 @@ struct sample_TEXTURE{
  GLint  id;
 };
 
+static sample_TEXTURE texture_maps [1] = {
+{"cyd.d.bmp_0.bmp",0}
+};
+
+#ifdef CYD_BUILTIN_MODEL
 static sample_MATERIAL materials [8] = {
  {{0.1098f,0.0667f,0.502f},	{0.1765f,0.4627f,0.7882f},	{0.755973f,0.762372f,0.73062f},	{0.0f,0.0f,0.0f},	1.0f,147.033f,-1}, //Purple Alien Skin
  {{0.0f,0.3608f,0.3647f},	{0.0f,1.0f,1.0f},	{0.94259f,0.95f,0.95f},	{0.0f,0.0f,0.0f},	1.0f,512.0f,-1}, //Cyan Plastic
@@ -45,10 +68,6 @@ static sample_MATERIAL materials [8] = {
  {{1.0f,1.0f,1.0f},	{1.0f,1.0f,1.0f},	{1.0f,1.0f,1.0f},	{1.0f,1.0f,1.0f},	1.0f,14.9285f,0} //Material #2
 };
 
-static sample_TEXTURE texture_maps [1] = {
-{"cyd.d.bmp_0.bmp",0}
-};
-
 // 13669 Verticies
 // 5525 Texture Coordinates
 // 15424 Normals
@@ -24982,6 +25001,8 @@ static int material_ref [78][2] = {
 {6,160},
 {0,300}
 };
+#endif
+
 struct DIB2D{
  BITMAPINFOHEADER *Info;
  RGBQUAD *palette;
@@ -25172,10 +25193,7 @@ static void LoadTexture(char*filename)
   //DeleteObject(hbitmap);
  };
 
-// Current component.
-static int Component;
-
-static void MyMaterial(GLenum mode,GLfloat *f,GLfloat alpha)
+static void MyMaterial(GLenum mode,const GLfloat *f,GLfloat alpha)
 {
  GLfloat d[4];
  d[0]=f[0];
@@ -25184,26 +25202,15 @@ static void MyMaterial(GLenum mode,GLfloat *f,GLfloat alpha)
  d[3]=alpha;
  glMaterialfv (GL_FRONT_AND_BACK,mode,d);
 }
-/*
- *  SelectMaterial uses OpenGL commands to define facet colors.
- *
- *  Returns:
- *    Nothing
- */
 
-static void SelectMaterial(int i)
+static void ApplyMaterial(const sample_MATERIAL *material)
 {
-  //
-  // Define the reflective properties of the 3D Object faces.
-  //
-  glEnd();
-  if (Component == CYD_RIGHT_FOOT || Component == CYD_LEFT_FOOT) i = 0;
-  GLfloat alpha=materials[i].alpha;
-  MyMaterial (GL_AMBIENT, materials[i].ambient,alpha);
-  MyMaterial (GL_DIFFUSE, materials[i].diffuse,alpha);
-  MyMaterial (GL_SPECULAR, materials[i].specular,alpha);
-  MyMaterial (GL_EMISSION, materials[i].emission,alpha);
-  glMaterialf (GL_FRONT_AND_BACK,GL_SHININESS,materials[i].phExp);
+  GLfloat alpha=material->alpha;
+  MyMaterial (GL_AMBIENT, material->ambient,alpha);
+  MyMaterial (GL_DIFFUSE, material->diffuse,alpha);
+  MyMaterial (GL_SPECULAR, material->specular,alpha);
+  MyMaterial (GL_EMISSION, material->emission,alpha);
+  glMaterialf (GL_FRONT_AND_BACK,GL_SHININESS,material->phExp);
   if(alpha<1.0)
         {
          glEnable(GL_BLEND);
@@ -25213,84 +25220,209 @@ static void SelectMaterial(int i)
         {
          glDisable(GL_BLEND);
         }
-	glEnd();
-	if(materials[i].texture>-1)
+	if(material->texture>-1)
 	{
 	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D,texture_maps[materials[i].texture].id);
+	glBindTexture(GL_TEXTURE_2D,texture_maps[material->texture].id);
 	}
 	else
 	glDisable(GL_TEXTURE_2D);
+}
 
-  glBegin(GL_TRIANGLES);
+// Binary model file.
+// The file is mapped and drawn from in place: a header, a component
+// table and a material table, followed by the vertex, index and batch
+// blobs of each component. Offsets are in bytes from the start of the
+// file and are 4-byte aligned.
+#define CYD_MODEL_MAGIC "CYDM"
+#define CYD_MODEL_VERSION 2
+struct CydModelHeader
+{
+	char magic[4];
+	int version;
+	int size;
+	int numComponents;
+	int componentOffset;
+	int numMaterials;
+	int materialOffset;
+};
 
+// Component mesh: interleaved texture coordinate, normal and vertex
+// (GL_T2F_N3F_V3F) with triangles grouped by material, so a component
+// draws with one glDrawElements per material.
+// Each level of detail indexes a subset of the component vertices and
+// has an error bound: how far, in model units, its surface can be from
+// the full resolution one.
+#define CYD_MESH_STRIDE 8
+struct CydBatch
+{
+	int material;
+	int first,count;
+};
+struct CydLod
+{
+	int indexOffset,numIndices;
+	int batchOffset,numBatches;
+	GLfloat error;
 };
+struct CydComponentEntry
+{
+	int vertexOffset,numVertices;
+	struct CydLod lods[CYD_NUM_LODS];
+	struct CydBound bounds;
+};
+
+// Model image and its views.
+static const char *CydModelImage = NULL;
+static int CydModelSize = 0;
+static const CydComponentEntry *CydComponents;
+static const sample_MATERIAL *CydMaterials;
+static int CydNumMaterials;
+
+static const GLfloat *getVertices(int component)
+{
+	return (const GLfloat *)(CydModelImage + CydComponents[component].vertexOffset);
+}
+
+static const GLuint *getIndices(int component, int lod)
+{
+	return (const GLuint *)(CydModelImage + CydComponents[component].lods[lod].indexOffset);
+}
 
-// Bounds.
-static struct CydBound Bounds;
+static const CydBatch *getBatches(int component, int lod)
+{
+	return (const CydBatch *)(CydModelImage + CydComponents[component].lods[lod].batchOffset);
+}
 
-static void Gen3DObjectList(int lid, int numgroups,
-	int *begin, int *end)
+// Check that a section of count items of itemSize bytes at offset is
+// aligned and within an image of size bytes, without overflowing.
+static bool checkCydSection(int offset, int count, size_t itemSize, int size)
 {
-  int i,j,k,g;
-  bool firstBounds = true;
-  static bool first = false;
-  static GLuint texture_name;
-  if (first)
-  {
-	  first = false;
-	  glGenTextures(1,&texture_name);
-	  texture_maps[0].id=texture_name;
-	  glBindTexture(GL_TEXTURE_2D,texture_name);
-	  LoadTexture(texture_maps[0].name);
-  }
-  static int mcount=0;
-  static int mindex=0;
-   glNewList(lid, GL_COMPILE);
+	if (offset < 0 || offset % 4 != 0 || offset > size || count < 0) return false;
+	return (size_t)count <= (size_t)(size - offset) / itemSize;
+}
 
-    glBegin (GL_TRIANGLES);
-	for (g = 0; g < numgroups; g++)
+// Validate model image and set views: return false if invalid.
+static bool setCydModelImage(const char *image, int size)
+{
+	int i,j,k;
+	const CydModelHeader *header = (const CydModelHeader *)image;
+	const CydComponentEntry *entry;
+	const CydLod *lod;
+	const sample_MATERIAL *materials;
+	const CydBatch *batch;
+	const GLuint *indices;
+
+	if (size < (int)sizeof(CydModelHeader)) return false;
+	if (memcmp(header->magic, CYD_MODEL_MAGIC, 4) != 0 ||
+		header->version != CYD_MODEL_VERSION || header->size != size ||
+		header->numComponents != CYD_NUM_COMPONENTS ||
+		header->numMaterials < 1) return false;
+	if (!checkCydSection(header->componentOffset, CYD_NUM_COMPONENTS,
+		sizeof(CydComponentEntry), size)) return false;
+	if (!checkCydSection(header->materialOffset, header->numMaterials,
+		sizeof(sample_MATERIAL), size)) return false;
+	materials = (const sample_MATERIAL *)(image + header->materialOffset);
+	for (i = 0; i < header->numMaterials; i++)
 	{
-      for(i=*begin;i<*end;i++)
-       {
-      if(!mcount)
-       {
-        SelectMaterial(material_ref[mindex][0]);
-        mcount=material_ref[mindex][1];
-        mindex++;
-       }
-       mcount--;
-       for(j=0;j<3;j++)
-        {
-          int vi=face_indicies[i][j];
-          int ni=face_indicies[i][j+3];//Normal index
-          int ti=face_indicies[i][j+6];//Texture index
-           glNormal3f (normals[ni][0],normals[ni][1],normals[ni][2]);
-           glTexCoord2f(textures[ti][0],textures[ti][1]);
-           glVertex3f (vertices[vi][0],vertices[vi][1],vertices[vi][2]);
-		   for (k = 0; k < 3; k++)
-		   {
-			   if (firstBounds || vertices[vi][k] < Bounds.min[k])
-				{
-					Bounds.min[k] = vertices[vi][k];
-				}
+		if (materials[i].texture >= 1) return false;
+	}
+	for (i = 0; i < CYD_NUM_COMPONENTS; i++)
+	{
+		entry = (const CydComponentEntry *)(image + header->componentOffset) + i;
+		if (!checkCydSection(entry->vertexOffset, entry->numVertices,
+			CYD_MESH_STRIDE * sizeof(GLfloat), size)) return false;
+		for (k = 0; k < CYD_NUM_LODS; k++)
+		{
+			lod = &entry->lods[k];
+			if (!(lod->error >= 0.0)) return false;
+			if (!checkCydSection(lod->indexOffset, lod->numIndices,
+				sizeof(GLuint), size)) return false;
+			if (!checkCydSection(lod->batchOffset, lod->numBatches,
+				sizeof(CydBatch), size)) return false;
+			indices = (const GLuint *)(image + lod->indexOffset);
+			for (j = 0; j < lod->numIndices; j++)
+			{
+				if (indices[j] >= (GLuint)entry->numVertices) return false;
+			}
+			batch = (const CydBatch *)(image + lod->batchOffset);
+			for (j = 0; j < lod->numBatches; j++, batch++)
+			{
+				if (batch->material < 0 || batch->material >= header->numMaterials ||
+					batch->first < 0 || batch->first > lod->numIndices ||
+					batch->count < 0 || batch->count > lod->numIndices - batch->first) return false;
+			}
+		}
+	}
+	CydModelImage = image;
+	CydModelSize = size;
+	CydComponents = (const CydComponentEntry *)(image + header->componentOffset);
+	CydMaterials = (const sample_MATERIAL *)(image + header->materialOffset);
+	CydNumMaterials = header->numMaterials;
+	return true;
+}
 
-				if (firstBounds || vertices[vi][k] > Bounds.max[k])
-				{
-					Bounds.max[k] = vertices[vi][k];
-				}
-		   }
-		   firstBounds = false;
-	   }
-       }
-	  begin++;
-	  end++;
+// Load (map) Cyd model file.
+bool loadCydModel(char *filename)
+{
+	char *image;
+	int size;
+
+#ifdef WIN32
+	HANDLE file,mapping;
+
+	file = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	size = (int)GetFileSize(file, NULL);
+	mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) return false;
+	image = (char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (image == NULL) return false;
+	if (!setCydModelImage(image, size))
+	{
+		UnmapViewOfFile(image);
+		return false;
 	}
-    glEnd ();
+#else
+	int fd;
+	struct stat st;
 
-   glEndList();
-};
+	if ((fd = open(filename, O_RDONLY)) < 0) return false;
+	if (fstat(fd, &st) < 0)
+	{
+		close(fd);
+		return false;
+	}
+	size = (int)st.st_size;
+	image = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED) return false;
+	if (!setCydModelImage(image, size))
+	{
+		munmap(image, size);
+		return false;
+	}
+#endif
+	return true;
+}
+
+// Save Cyd model file.
+bool saveCydModel(char *filename)
+{
+	FILE *fp;
+	bool ok;
+
+	if (CydModelImage == NULL) return false;
+	if ((fp = fopen(filename, "wb")) == NULL) return false;
+	ok = (fwrite(CydModelImage, 1, CydModelSize, fp) == (size_t)CydModelSize);
+	fclose(fp);
+	return ok;
+}
 
+#ifdef CYD_BUILTIN_MODEL
 // Component face groups.
 #define CYD_NUM_GROUPS 59
 static int component_face_delimiters[] =
@@ -25357,168 +25489,315 @@ static int component_face_delimiters[] =
 26483
 };
 
-// Build Cyd model.
-void buildCydModel()
+// Get face range of component: torso groups are contiguous.
+static void getComponentFaces(int component, int &begin, int &end)
 {
-	int i,j,k;
-	int begin[CYD_NUM_GROUPS + 1],end[CYD_NUM_GROUPS + 1];
-	int *bp,*ep;
-	bp = begin;
-	ep = end;
-	GLint lid=glGenLists(CYD_NUM_COMPONENTS);
-	for (i = 0; i < CYD_NUM_COMPONENTS; i++)
+	begin = component_face_delimiters[component];
+	if (component < CYD_TORSO)
 	{
-		Component = i;
-		if (i < CYD_TORSO)
+		end = component_face_delimiters[component+1];
+	} else {
+		end = component_face_delimiters[CYD_NUM_GROUPS];
+	}
+}
+
+// Append data to image at a 4-byte aligned offset: return the offset.
+static int appendImage(std::vector<char> &image, const void *data, int size)
+{
+	int offset = (int)image.size();
+
+	image.resize(offset + size);
+	if (size > 0) memcpy(&image[offset], data, size);
+	return offset;
+}
+
+// Level of detail triangle fractions.
+static const float lod_fractions[CYD_NUM_LODS] = { 1.0f, 0.5f, 0.25f, 0.125f };
+
+// Append level of detail meshes to image: indices with material groups.
+static void appendLod(std::vector<char> &image, CydLod &lod,
+	std::vector<GLuint> &indices, std::vector<int> &groups, float error)
+{
+	int i;
+	CydBatch batch;
+	std::vector<CydBatch> batches;
+
+	for (i = 0; i < (int)groups.size(); i++)
+	{
+		if (i == 0 || groups[i] != groups[i-1])
 		{
-			begin[0] = component_face_delimiters[i];
-			end[0] = component_face_delimiters[i+1];
-			Gen3DObjectList(lid + i, 1, bp, ep);
-		} else {
-			for (j = i, k = 0; j < CYD_NUM_GROUPS; j++, k++)
-			{
-				begin[k] = component_face_delimiters[j];
-				end[k] = component_face_delimiters[j+1];
-			}
-			Gen3DObjectList(lid + i, k, bp, ep);
+			batch.material = groups[i];
+			batch.first = i * 3;
+			batch.count = 0;
+			batches.push_back(batch);
 		}
-		CydDisplays[i] = lid + i;
-		CydBounds[i] = Bounds;
+		batches.back().count += 3;
 	}
+	lod.numIndices = (int)indices.size();
+	lod.indexOffset = appendImage(image, indices.size() ? &indices[0] : NULL,
+		(int)indices.size() * sizeof(GLuint));
+	lod.numBatches = (int)batches.size();
+	lod.batchOffset = appendImage(image, batches.size() ? &batches[0] : NULL,
+		(int)batches.size() * sizeof(CydBatch));
+	lod.error = error;
 }
 
-static void Gen3DObject(int component, int numgroups,
-	int *begin, int *end)
+// Convert built-in model arrays to a model image.
+// Coarser levels of detail are simplified from the full mesh.
+static void convertCydModel()
 {
-  int i,j,k,g;
-  int mcount=0;
-  int mindex=0;
-
-  // Index appropriate material.
-  switch(component)
-  {
-  case CYD_UPPER_RIGHT_LEG:
-	  mcount=0;
-	  mindex=0;
-	  break;
-  case CYD_HEAD:
-	  mcount=6471;
-	  mindex=1;
-	  break;
-  case CYD_UPPER_RIGHT_ARM:
-	  mcount=3376;
-	  mindex=1;
-	  break;
-  case CYD_UPPER_LEFT_ARM:
-	  mcount=3124;
-	  mindex=1;
-	  break;
-  case CYD_LOWER_LEFT_ARM:
-	  mcount=2872;
-	  mindex=1;
-	  break;
-  case CYD_LOWER_RIGHT_ARM:
-	  mcount=2664;
-	  mindex=1;
-	  break;
-  case CYD_RIGHT_KNEE:
-	  mcount=2456;
-	  mindex=1;
-	  break;
-  case CYD_UPPER_LEFT_LEG:
-	  mcount=2278;
-	  mindex=1;
-	  break;
-  case CYD_LOWER_LEFT_LEG:
-	  mcount=1930;
-	  mindex=1;
-	  break;
-  case CYD_LEFT_KNEE:
-	  mcount=1054;
-	  mindex=1;
-	  break;
-  case CYD_LOWER_RIGHT_LEG:
-	  mcount=876;
-	  mindex=1;
-	  break;
-  case CYD_LEFT_EYE:
-	  mcount=0;
-	  mindex=1;
-	  break;
-  case CYD_RIGHT_EYE:
-	  mcount=150;
-	  mindex=2;
-	  break;
-  case CYD_RIGHT_HAND:
-	  mcount=0;
-	  mindex=2;
-	  break;
-  case CYD_LEFT_HAND:
-	  mcount=3656;
-	  mindex=3;
-	  break;
-  case CYD_RIGHT_FOOT:
-	  mcount=0;
-	  mindex=3;
-	  break;
-  case CYD_LEFT_FOOT:
-	  mcount=4346;
-	  mindex=4;
-	  break;
-  case CYD_TORSO:
-	  mcount=0;
-	  mindex=4;
-	  break;
-  }
+	int i,j,k,n,c,m,v,begin,end,mcount,mindex;
+	std::vector<int> faceMaterials(26483);
+	long long key;
+	std::map<long long,GLuint> corners;
+	std::map<long long,GLuint>::iterator cornerItr;
+	std::vector<int> faces[8];
+	std::vector<GLfloat> meshVertices;
+	std::vector<GLuint> meshIndices;
+	std::vector<int> meshGroups;
+	float error;
+	CydModelHeader header;
+	CydComponentEntry entries[CYD_NUM_COMPONENTS];
+	static std::vector<char> image;
 
-    glBegin (GL_TRIANGLES);
-	for (g = 0; g < numgroups; g++)
+	// Material of each face, from the material runs.
+	mcount = mindex = m = 0;
+	for (i = 0; i < 26483; i++)
 	{
-      for(i=*begin;i<*end;i++)
-       {
-		  if(!mcount)
-		   {
-			SelectMaterial(material_ref[mindex][0]);
-			mcount=material_ref[mindex][1];
+		if (!mcount)
+		{
+			m = material_ref[mindex][0];
+			mcount = material_ref[mindex][1];
 			mindex++;
-		   }
-		   mcount--;
-		   for(j=0;j<3;j++)
+		}
+		mcount--;
+		faceMaterials[i] = m;
+	}
+
+	// Reserve header and tables.
+	image.clear();
+	memset(&header, 0, sizeof(header));
+	memset(entries, 0, sizeof(entries));
+	appendImage(image, &header, sizeof(header));
+	header.componentOffset = appendImage(image, entries, sizeof(entries));
+	header.numMaterials = 8;
+	header.materialOffset = appendImage(image, materials, sizeof(materials));
+
+	for (c = 0; c < CYD_NUM_COMPONENTS; c++)
+	{
+		getComponentFaces(c, begin, end);
+
+		// Group faces by material.
+		for (m = 0; m < 8; m++) faces[m].clear();
+		for (i = begin; i < end; i++)
+		{
+			m = faceMaterials[i];
+			if (c == CYD_RIGHT_FOOT || c == CYD_LEFT_FOOT) m = 0;
+			faces[m].push_back(i);
+		}
+
+		// Add unique corners and indices.
+		corners.clear();
+		meshVertices.clear();
+		meshIndices.clear();
+		meshGroups.clear();
+		for (m = 0; m < 8; m++)
+		{
+			for (k = 0; k < (int)faces[m].size(); k++)
+			{
+				i = faces[m][k];
+				meshGroups.push_back(m);
+				for (j = 0; j < 3; j++)
+				{
+					int vi=face_indicies[i][j];
+					int ni=face_indicies[i][j+3];//Normal index
+					int ti=face_indicies[i][j+6];//Texture index
+					key = ((long long)vi << 32) | ((long long)ni << 16) | (long long)ti;
+					cornerItr = corners.find(key);
+					if (cornerItr != corners.end())
+					{
+						meshIndices.push_back(cornerItr->second);
+						continue;
+					}
+					v = (int)meshVertices.size() / CYD_MESH_STRIDE;
+					corners[key] = (GLuint)v;
+					meshIndices.push_back((GLuint)v);
+					meshVertices.push_back(textures[ti][0]);
+					meshVertices.push_back(textures[ti][1]);
+					meshVertices.push_back(normals[ni][0]);
+					meshVertices.push_back(normals[ni][1]);
+					meshVertices.push_back(normals[ni][2]);
+					meshVertices.push_back(vertices[vi][0]);
+					meshVertices.push_back(vertices[vi][1]);
+					meshVertices.push_back(vertices[vi][2]);
+
+					// Bounds.
+					for (n = 0; n < 3; n++)
+					{
+						if (v == 0 || vertices[vi][n] < entries[c].bounds.min[n])
+						{
+							entries[c].bounds.min[n] = vertices[vi][n];
+						}
+						if (v == 0 || vertices[vi][n] > entries[c].bounds.max[n])
+						{
+							entries[c].bounds.max[n] = vertices[vi][n];
+						}
+					}
+				}
+			}
+		}
+
+		// Add vertices and levels of detail.
+		entries[c].numVertices = (int)meshVertices.size() / CYD_MESH_STRIDE;
+		entries[c].vertexOffset = appendImage(image, &meshVertices[0],
+			(int)meshVertices.size() * sizeof(GLfloat));
+		MeshSimplifier simplifier(&meshVertices[5], CYD_MESH_STRIDE,
+			entries[c].numVertices, &meshIndices[0], &meshGroups[0],
+			(int)meshGroups.size());
+		n = (int)meshGroups.size();
+		appendLod(image, entries[c].lods[0], meshIndices, meshGroups, 0.0);
+		for (i = 1; i < CYD_NUM_LODS; i++)
+		{
+			error = simplifier.simplify((int)(n * lod_fractions[i]));
+
+			// A level that could not be simplified further shares
+			// the mesh of the level above.
+			if (simplifier.getNumTriangles() * 3 == entries[c].lods[i-1].numIndices)
 			{
-			  int vi=face_indicies[i][j];
-			  int ni=face_indicies[i][j+3];//Normal index
-			  int ti=face_indicies[i][j+6];//Texture index
-			   glNormal3f (normals[ni][0],normals[ni][1],normals[ni][2]);
-			   glTexCoord2f(textures[ti][0],textures[ti][1]);
-			   glVertex3f (vertices[vi][0],vertices[vi][1],vertices[vi][2]);
+				entries[c].lods[i] = entries[c].lods[i-1];
+				continue;
 			}
-       }
-	  begin++;
-	  end++;
+			simplifier.getTriangles(meshIndices, meshGroups);
+			appendLod(image, entries[c].lods[i], meshIndices, meshGroups, error);
+		}
 	}
-    glEnd ();
-};
 
-// Draw Cyd model component.
-void drawCydComponent(int component)
+	// Fill in header and component table.
+	memcpy(header.magic, CYD_MODEL_MAGIC, 4);
+	header.version = CYD_MODEL_VERSION;
+	header.size = (int)image.size();
+	header.numComponents = CYD_NUM_COMPONENTS;
+	memcpy(&image[0], &header, sizeof(header));
+	memcpy(&image[header.componentOffset], entries, sizeof(entries));
+	setCydModelImage(&image[0], (int)image.size());
+}
+#endif
+
+// Build Cyd model.
+// The model is shared by all Cyd agents, so it is built only once.
+void buildCydModel()
 {
 	int i,j;
-	int begin[CYD_NUM_GROUPS + 1],end[CYD_NUM_GROUPS + 1];
-	int *bp,*ep;
-	bp = begin;
-	ep = end;
-	Component = component;
-	if (component < CYD_TORSO)
+	static bool built = false;
+	static bool first = false;
+	static GLuint texture_name;
+
+	if (built) return;
+	built = true;
+
+	// Get model: loaded, built-in, or mapped from default file.
+	if (CydModelImage == NULL)
 	{
-		begin[0] = component_face_delimiters[component];
-		end[0] = component_face_delimiters[component+1];
-		Gen3DObject(component, 1, bp, ep);
-	} else {
-		for (i = component, j = 0; i < CYD_NUM_GROUPS; i++, j++)
+#ifdef CYD_BUILTIN_MODEL
+		convertCydModel();
+#else
+		if (!loadCydModel(CYD_MODEL_FILE))
+		{
+			fprintf(stderr, "Cannot load Cyd model %s\n", CYD_MODEL_FILE);
+			exit(1);
+		}
+#endif
+	}
+
+	if (first)
+	{
+		first = false;
+		glGenTextures(1,&texture_name);
+		texture_maps[0].id=texture_name;
+		glBindTexture(GL_TEXTURE_2D,texture_name);
+		LoadTexture(texture_maps[0].name);
+	}
+	GLint lid=glGenLists(CYD_NUM_COMPONENTS * (CYD_NUM_LODS + 1));
+	for (i = 0; i < CYD_NUM_COMPONENTS; i++)
+	{
+		CydBounds[i] = CydComponents[i].bounds;
+		for (j = 0; j < CYD_NUM_LODS; j++)
 		{
-			begin[j] = component_face_delimiters[i];
-			end[j] = component_face_delimiters[i+1];
+			if (j > 0 && CydComponents[i].lods[j].indexOffset ==
+				CydComponents[i].lods[j-1].indexOffset &&
+				CydComponents[i].lods[j].numIndices ==
+				CydComponents[i].lods[j-1].numIndices)
+			{
+				CydDisplays[i][j] = CydDisplays[i][j-1];
+				continue;
+			}
+			glNewList(lid, GL_COMPILE);
+			drawCydComponent(i, j);
+			glEndList();
+			CydDisplays[i][j] = lid++;
 		}
-		Gen3DObject(component, j, bp, ep);
+		glNewList(lid, GL_COMPILE);
+		drawCydShadow(i);
+		glEndList();
+		CydShadowDisplays[i] = lid++;
 	}
 }
+
+// Get coarsest level of detail of component within error limit.
+int getCydLod(int component, GLfloat error)
+{
+	int lod;
+
+	for (lod = CYD_NUM_LODS - 1; lod > 0; lod--)
+	{
+		if (CydComponents[component].lods[lod].error <= error) break;
+	}
+	return lod;
+}
+
+// Draw Cyd model component.
+void drawCydComponent(int component, int lod)
+{
+	int i;
+	const CydBatch *batch = getBatches(component, lod);
+	const GLuint *indices = getIndices(component, lod);
+
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glInterleavedArrays(GL_T2F_N3F_V3F, 0, getVertices(component));
+	for (i = 0; i < CydComponents[component].lods[lod].numBatches; i++, batch++)
+	{
+		ApplyMaterial(&CydMaterials[batch->material]);
+		glDrawElements(GL_TRIANGLES, batch->count, GL_UNSIGNED_INT,
+			indices + batch->first);
+	}
+	glPopClientAttrib();
+}
+
+// Draw Cyd model component shadow.
+// The batches of a level of detail cover all of its indices,
+// so the shadow is a single draw of the vertex positions.
+void drawCydShadow(int component)
+{
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, CYD_MESH_STRIDE * sizeof(GLfloat),
+		getVertices(component) + 5);
+	glDrawElements(GL_TRIANGLES, CydComponents[component].lods[CYD_SHADOW_LOD].numIndices,
+		GL_UNSIGNED_INT, getIndices(component, CYD_SHADOW_LOD));
+	glPopClientAttrib();
+}
+
+// Get Cyd model component mesh.
+bool getCydMesh(int component, int lod, const GLfloat *&positions, int &stride,
+	int &numVertices, const GLuint *&indices, int &numIndices)
+{
+	if (CydModelImage == NULL) return false;
+	positions = getVertices(component) + 5;
+	stride = CYD_MESH_STRIDE;
+	numVertices = CydComponents[component].numVertices;
+	indices = getIndices(component, lod);
+	numIndices = CydComponents[component].lods[lod].numIndices;
+	return true;
+}
@@ -24,8 +24,15 @@
 #define CYD_LEFT_FOOT 16
 #define CYD_TORSO 17
 
+// Levels of detail: 0 is full resolution.
+#define CYD_NUM_LODS 4
+
 // Display lists.
-extern int CydDisplays[CYD_NUM_COMPONENTS];
+extern int CydDisplays[CYD_NUM_COMPONENTS][CYD_NUM_LODS];
+
+// Shadow display lists: positions of the coarsest level of detail.
+#define CYD_SHADOW_LOD (CYD_NUM_LODS - 1)
+extern int CydShadowDisplays[CYD_NUM_COMPONENTS];
 
 // Component bounds.
 struct CydBound
@@ -35,10 +42,38 @@ struct CydBound
 
 extern struct CydBound CydBounds[CYD_NUM_COMPONENTS];
 
+// Default Cyd model file.
+#define CYD_MODEL_FILE "cyd.mesh"
+
+// Load Cyd model file: call before building model.
+// Building with CYD_BUILTIN_MODEL converts the built-in model arrays
+// instead, which can then be saved as a model file.
+bool loadCydModel(char *filename);
+
+// Save Cyd model file.
+bool saveCydModel(char *filename);
+
 // Build Cyd model.
 void buildCydModel();
 
+// Level of detail error limit in pixels: zero draws full resolution.
+#define CYD_LOD_PIXEL_ERROR 1.0
+extern GLfloat CydLodPixelError;
+
+// Get coarsest level of detail of component within error limit,
+// in model units.
+int getCydLod(int component, GLfloat error);
+
 // Draw Cyd model component.
-void drawCydComponent(int component);
+void drawCydComponent(int component, int lod = 0);
+
+// Draw Cyd model component shadow: positions only, with no material.
+void drawCydShadow(int component);
+
+// Get Cyd model component mesh at level of detail, e.g. for collision:
+// vertex positions are stride floats apart. Returns false if no model
+// is loaded.
+bool getCydMesh(int component, int lod, const GLfloat *&positions, int &stride,
+	int &numVertices, const GLuint *&indices, int &numIndices);
 
 #endif
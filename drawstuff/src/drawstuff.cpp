@@ -43,6 +43,8 @@ manage openGL state changes better
 #include <ode/config.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
+#include <vector>
+#include <algorithm>
 
 #include "drawstuff/drawstuff.h"
 #include "internal.h"
@@ -322,30 +324,6 @@ static void setColor (float r, float g, float b, float alpha)
 }
 
 
-static void setTransform (const float pos[3], const float R[12])
-{
-  GLfloat matrix[16];
-  matrix[0]=R[0];
-  matrix[1]=R[4];
-  matrix[2]=R[8];
-  matrix[3]=0;
-  matrix[4]=R[1];
-  matrix[5]=R[5];
-  matrix[6]=R[9];
-  matrix[7]=0;
-  matrix[8]=R[2];
-  matrix[9]=R[6];
-  matrix[10]=R[10];
-  matrix[11]=0;
-  matrix[12]=pos[0];
-  matrix[13]=pos[1];
-  matrix[14]=pos[2];
-  matrix[15]=1;
-  glPushMatrix();
-  glMultMatrixf (matrix);
-}
-
-
 // set shadow projection transform
 
 static void setShadowTransform()
@@ -446,6 +424,20 @@ static void drawPatch (float p1[3], float p2[3], float p3[3], int level)
 }
 
 
+// sphere and capped cylinder meshes are compiled into display lists once
+// per quality level, and drawn with a transform. quality levels beyond the
+// cache are clamped.
+
+#define MESH_QUALITY_LEVELS 16
+
+static int getMeshQuality (int n)
+{
+  if (n < 0) return 0;
+  if (n >= MESH_QUALITY_LEVELS) return MESH_QUALITY_LEVELS-1;
+  return n;
+}
+
+
 // draw a sphere of radius 1
 
 static int sphere_quality = 1;
@@ -483,19 +475,20 @@ static void drawSphere()
     {9, 2, 5},	  {7, 2, 11},
   };
 
-  static GLuint listnum = 0;
-  if (listnum==0) {
-    listnum = glGenLists (1);
-    glNewList (listnum,GL_COMPILE);
+  static GLuint listnums[MESH_QUALITY_LEVELS];
+  int quality = getMeshQuality (sphere_quality);
+  if (listnums[quality]==0) {
+    listnums[quality] = glGenLists (1);
+    glNewList (listnums[quality],GL_COMPILE);
     glBegin (GL_TRIANGLES);
     for (int i=0; i<20; i++) {
       drawPatch (&idata[index[i][2]][0],&idata[index[i][1]][0],
-		 &idata[index[i][0]][0],sphere_quality);
+		 &idata[index[i][0]][0],quality);
     }
     glEnd();
     glEndList();
   }
-  glCallList (listnum);
+  glCallList (listnums[quality]);
 }
 
 
@@ -556,59 +549,42 @@ static void drawTriangle (const float *v0, const float *v1, const float *v2, int
   glEnd();
 }
 
-static void drawTriangleD (const double *v0, const double *v1, const double *v2, int solid)
-{
-  float u[3],v[3],normal[3];
-  u[0] = float( v1[0] - v0[0] );
-  u[1] = float( v1[1] - v0[1] );
-  u[2] = float( v1[2] - v0[2] );
-  v[0] = float( v2[0] - v0[0] );
-  v[1] = float( v2[1] - v0[1] );
-  v[2] = float( v2[2] - v0[2] );
-  dCROSS (normal,=,u,v);
-  normalizeVector3 (normal);
-
-  glBegin(solid ? GL_TRIANGLES : GL_LINE_STRIP);
-  glNormal3fv (normal);
-  glVertex3dv (v0);
-  glVertex3dv (v1);
-  glVertex3dv (v2);
-  glEnd();
-}
-
-
-// draw a capped cylinder of length l and radius r, aligned along the x axis
+// draw a capped cylinder of length l and radius r, aligned along the x axis.
+// the body is a unit cylinder scaled to the length and radius, and the caps
+// are unit hemispheres scaled to the radius. GL_NORMALIZE must be enabled.
 
 static int capped_cylinder_quality = 3;
 
-static void drawCappedCylinder (float l, float r)
+static void compileCappedCylinder (GLuint listnum, int quality)
 {
   int i,j;
   float tmp,nx,ny,nz,start_nx,start_ny,a,ca,sa;
   // number of sides to the cylinder (divisible by 4):
-  const int n = capped_cylinder_quality*4;
+  const int n = quality*4;
 
-  l *= 0.5;
   a = float(M_PI*2.0)/float(n);
   sa = (float) sin(a);
   ca = (float) cos(a);
 
-  // draw cylinder body
+  // cylinder body, from z=-1 to z=1
+  glNewList (listnum,GL_COMPILE);
   ny=1; nz=0;		  // normal vector = (0,ny,nz)
   glBegin (GL_TRIANGLE_STRIP);
   for (i=0; i<=n; i++) {
     glNormal3d (ny,nz,0);
-    glVertex3d (ny*r,nz*r,l);
+    glVertex3d (ny,nz,1);
     glNormal3d (ny,nz,0);
-    glVertex3d (ny*r,nz*r,-l);
+    glVertex3d (ny,nz,-1);
     // rotate ny,nz
     tmp = ca*ny - sa*nz;
     nz = sa*ny + ca*nz;
     ny = tmp;
   }
   glEnd();
+  glEndList();
 
-  // draw first cylinder cap
+  // first cylinder cap
+  glNewList (listnum+1,GL_COMPILE);
   start_nx = 0;
   start_ny = 1;
   for (j=0; j<(n/4); j++) {
@@ -621,9 +597,9 @@ static void drawCappedCylinder (float l, float r)
     glBegin (GL_TRIANGLE_STRIP);
     for (i=0; i<=n; i++) {
       glNormal3d (ny2,nz2,nx2);
-      glVertex3d (ny2*r,nz2*r,l+nx2*r);
+      glVertex3d (ny2,nz2,nx2);
       glNormal3d (ny,nz,nx);
-      glVertex3d (ny*r,nz*r,l+nx*r);
+      glVertex3d (ny,nz,nx);
       // rotate n,n2
       tmp = ca*ny - sa*nz;
       nz = sa*ny + ca*nz;
@@ -636,8 +612,10 @@ static void drawCappedCylinder (float l, float r)
     start_nx = start_nx2;
     start_ny = start_ny2;
   }
+  glEndList();
 
-  // draw second cylinder cap
+  // second cylinder cap
+  glNewList (listnum+2,GL_COMPILE);
   start_nx = 0;
   start_ny = 1;
   for (j=0; j<(n/4); j++) {
@@ -650,9 +628,9 @@ static void drawCappedCylinder (float l, float r)
     glBegin (GL_TRIANGLE_STRIP);
     for (i=0; i<=n; i++) {
       glNormal3d (ny,nz,nx);
-      glVertex3d (ny*r,nz*r,-l+nx*r);
+      glVertex3d (ny,nz,nx);
       glNormal3d (ny2,nz2,nx2);
-      glVertex3d (ny2*r,nz2*r,-l+nx2*r);
+      glVertex3d (ny2,nz2,nx2);
       // rotate n,n2
       tmp = ca*ny - sa*nz;
       nz = sa*ny + ca*nz;
@@ -665,7 +643,33 @@ static void drawCappedCylinder (float l, float r)
     start_nx = start_nx2;
     start_ny = start_ny2;
   }
+  glEndList();
+}
+
+
+static void drawCappedCylinder (float l, float r)
+{
+  static GLuint listnums[MESH_QUALITY_LEVELS];
+  int quality = getMeshQuality (capped_cylinder_quality);
+  if (listnums[quality]==0) {
+    listnums[quality] = glGenLists (3);
+    compileCappedCylinder (listnums[quality],quality);
+  }
 
+  l *= 0.5;
+  glPushMatrix();
+  glScalef (r,r,l);
+  glCallList (listnums[quality]);
+  glPopMatrix();
+  glPushMatrix();
+  glTranslatef (0,0,l);
+  glScalef (r,r,r);
+  glCallList (listnums[quality]+1);
+  glPopMatrix();
+  glPushMatrix();
+  glTranslatef (0,0,-l);
+  glScalef (r,r,r);
+  glCallList (listnums[quality]+2);
   glPopMatrix();
 }
 
@@ -809,6 +813,17 @@ static Texture *sky_texture = 0;
 static Texture *ground_texture = 0;
 static Texture *wood_texture = 0;
 
+// background display lists, and the use_textures they were compiled for
+static GLuint background_lists = 0;
+static int background_textures = -1;
+
+// the viewport size the projection was set up for, and whether the
+// lights and other fixed state have been set up. these only need
+// setting again when they change.
+static int frame_width = -1;
+static int frame_height = -1;
+static int frame_setup = 0;
+
 
 #ifndef macintosh
 
@@ -863,10 +878,18 @@ void dsStopGraphics()
   sky_texture = 0;
   ground_texture = 0;
   wood_texture = 0;
+
+  // the background lists and fixed state belong to the old context
+  background_lists = 0;
+  background_textures = -1;
+  frame_width = frame_height = -1;
+  frame_setup = 0;
 }
 
 
-static void drawSky (float view_xyz[3])
+// draw the sky centered on the origin, with the texture unscrolled.
+
+static void drawSkyQuad()
 {
   glDisable (GL_LIGHTING);
   if (use_textures) {
@@ -885,26 +908,20 @@ static void drawSky (float view_xyz[3])
   glDepthRange (1,1);
 
   const float ssize = 1000.0f;
-  static float offset = 0.0f;
-
   float x = ssize*sky_scale;
-  float z = view_xyz[2] + sky_height;
 
   glBegin (GL_QUADS);
   glNormal3f (0,0,-1);
-  glTexCoord2f (-x+offset,-x+offset);
-  glVertex3f (-ssize+view_xyz[0],-ssize+view_xyz[1],z);
-  glTexCoord2f (-x+offset,x+offset);
-  glVertex3f (-ssize+view_xyz[0],ssize+view_xyz[1],z);
-  glTexCoord2f (x+offset,x+offset);
-  glVertex3f (ssize+view_xyz[0],ssize+view_xyz[1],z);
-  glTexCoord2f (x+offset,-x+offset);
-  glVertex3f (ssize+view_xyz[0],-ssize+view_xyz[1],z);
+  glTexCoord2f (-x,-x);
+  glVertex3f (-ssize,-ssize,0);
+  glTexCoord2f (-x,x);
+  glVertex3f (-ssize,ssize,0);
+  glTexCoord2f (x,x);
+  glVertex3f (ssize,ssize,0);
+  glTexCoord2f (x,-x);
+  glVertex3f (ssize,-ssize,0);
   glEnd();
 
-  offset = offset + 0.002f;
-  if (offset > 1) offset -= 1;
-
   glDepthFunc (GL_LESS);
   glDepthRange (0,1);
 }
@@ -998,6 +1015,63 @@ static void drawPyramidGrid()
 }
 
 
+// the background is static, so it is compiled into display lists: the
+// sky, drawn over the viewpoint, and the ground with the pyramid grid.
+// the lists are recompiled if the texture mode changes.
+
+static void compileBackground()
+{
+  if (background_lists && background_textures == use_textures) return;
+  if (background_lists) glDeleteLists (background_lists,2);
+  background_lists = glGenLists (2);
+  background_textures = use_textures;
+
+  glNewList (background_lists,GL_COMPILE);
+  drawSkyQuad();
+  glEndList();
+
+  glNewList (background_lists+1,GL_COMPILE);
+  drawGround();
+  drawPyramidGrid();
+  glEndList();
+}
+
+
+static void drawSky (float view_xyz[3])
+{
+  static float offset = 0.0f;
+
+  // scroll the sky texture
+  glMatrixMode (GL_TEXTURE);
+  glLoadIdentity();
+  glTranslatef (offset,offset,0);
+  glMatrixMode (GL_MODELVIEW);
+
+  glPushMatrix();
+  glTranslatef (view_xyz[0],view_xyz[1],view_xyz[2] + sky_height);
+  glCallList (background_lists);
+  glPopMatrix();
+
+  glMatrixMode (GL_TEXTURE);
+  glLoadIdentity();
+  glMatrixMode (GL_MODELVIEW);
+
+  offset = offset + 0.002f;
+  if (offset > 1) offset -= 1;
+}
+
+
+// draw calls and drawing state changes of this and the last frame,
+// counted when the commands recorded by the dsDrawXXX() functions are
+// submitted.
+static int draw_calls = 0;
+static int state_changes = 0;
+static int last_draw_calls = 0;
+static int last_state_changes = 0;
+
+static void submitCommands();
+
+
 void dsDrawFrame (int width, int height, dsFunctions *fn, int pause)
 {
   if (current_state < 1) dsDebug ("internal error");
@@ -1005,7 +1079,6 @@ void dsDrawFrame (int width, int height, dsFunctions *fn, int pause)
 
   // setup stuff
   glEnable (GL_LIGHTING);
-  glEnable (GL_LIGHT0);
   glDisable (GL_TEXTURE_2D);
   glDisable (GL_TEXTURE_GEN_S);
   glDisable (GL_TEXTURE_GEN_T);
@@ -1013,38 +1086,48 @@ void dsDrawFrame (int width, int height, dsFunctions *fn, int pause)
   glEnable (GL_DEPTH_TEST);
   glDepthFunc (GL_LESS);
   glEnable (GL_CULL_FACE);
-  glCullFace (GL_BACK);
-  glFrontFace (GL_CCW);
+  if (!frame_setup) {
+    glEnable (GL_LIGHT0);
+    glCullFace (GL_BACK);
+    glFrontFace (GL_CCW);
+  }
 
   // setup viewport
-  glViewport (0,0,width,height);
-  glMatrixMode (GL_PROJECTION);
-  glLoadIdentity();
-  const float vnear = 0.1f;
-  const float vfar = 100.0f;
-  const float k = 0.8f;     // view scale, 1 = +/- 45 degrees
-  if (width >= height) {
-    float k2 = float(height)/float(width);
-    glFrustum (-vnear*k,vnear*k,-vnear*k*k2,vnear*k*k2,vnear,vfar);
-  }
-  else {
-    float k2 = float(width)/float(height);
-    glFrustum (-vnear*k*k2,vnear*k*k2,-vnear*k,vnear*k,vnear,vfar);
+  if (width != frame_width || height != frame_height) {
+    glViewport (0,0,width,height);
+    glMatrixMode (GL_PROJECTION);
+    glLoadIdentity();
+    const float vnear = 0.1f;
+    const float vfar = 100.0f;
+    const float k = 0.8f;     // view scale, 1 = +/- 45 degrees
+    if (width >= height) {
+      float k2 = float(height)/float(width);
+      glFrustum (-vnear*k,vnear*k,-vnear*k*k2,vnear*k*k2,vnear,vfar);
+    }
+    else {
+      float k2 = float(width)/float(height);
+      glFrustum (-vnear*k*k2,vnear*k*k2,-vnear*k,vnear*k,vnear,vfar);
+    }
+    frame_width = width;
+    frame_height = height;
   }
 
   // setup lights. it makes a difference whether this is done in the
   // GL_PROJECTION matrix mode (lights are scene relative) or the
   // GL_MODELVIEW matrix mode (lights are camera relative, bad!).
-  static GLfloat light_ambient[] = { 0.5, 0.5, 0.5, 1.0 };
-  static GLfloat light_diffuse[] = { 1.0, 1.0, 1.0, 1.0 };
-  static GLfloat light_specular[] = { 1.0, 1.0, 1.0, 1.0 };
-  glLightfv (GL_LIGHT0, GL_AMBIENT, light_ambient);
-  glLightfv (GL_LIGHT0, GL_DIFFUSE, light_diffuse);
-  glLightfv (GL_LIGHT0, GL_SPECULAR, light_specular);
+  if (!frame_setup) {
+    static GLfloat light_ambient[] = { 0.5, 0.5, 0.5, 1.0 };
+    static GLfloat light_diffuse[] = { 1.0, 1.0, 1.0, 1.0 };
+    static GLfloat light_specular[] = { 1.0, 1.0, 1.0, 1.0 };
+    glLightfv (GL_LIGHT0, GL_AMBIENT, light_ambient);
+    glLightfv (GL_LIGHT0, GL_DIFFUSE, light_diffuse);
+    glLightfv (GL_LIGHT0, GL_SPECULAR, light_specular);
+    glClearColor (0.5,0.5,0.5,0);
+    frame_setup = 1;
+  }
   glColor3f (1.0, 1.0, 1.0);
 
   // clear the window
-  glClearColor (0.5,0.5,0.5,0);
   glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   // snapshot camera position (in MS Windows it is changed by the GUI thread)
@@ -1063,12 +1146,11 @@ void dsDrawFrame (int width, int height, dsFunctions *fn, int pause)
   static GLfloat light_position[] = { LIGHTX, LIGHTY, 1.0, 0.0 };
   glLightfv (GL_LIGHT0, GL_POSITION, light_position);
 
-  // draw the background (ground, sky etc)
+  // draw the background (ground, sky etc) and the little markers on
+  // the ground
+  compileBackground();
   drawSky (view2_xyz);
-  drawGround();
-
-  // draw the little markers on the ground
-  drawPyramidGrid();
+  glCallList (background_lists+1);
 
   // leave openGL in a known state - flat shaded white, no textures
   glEnable (GL_LIGHTING);
@@ -1085,7 +1167,13 @@ void dsDrawFrame (int width, int height, dsFunctions *fn, int pause)
   color[2] = 1;
   color[3] = 1;
   tnum = 0;
+  last_draw_calls = draw_calls;
+  last_state_changes = state_changes;
+  draw_calls = state_changes = 0;
   if (fn->step) fn->step (pause);
+
+  // draw the recorded objects
+  submitCommands();
 }
 
 
@@ -1177,6 +1265,282 @@ static void setShadowDrawingMode()
 }
 
 
+//***************************************************************************
+// command buffer
+
+// the dsDrawXXX() functions record commands with the current color and
+// texture instead of drawing. at the end of the frame the commands are
+// sorted by pass, texture, shape and color and submitted together, so the
+// drawing state changes only between runs of alike commands.
+
+#define SHAPE_BOX 0
+#define SHAPE_SPHERE 1
+#define SHAPE_CYLINDER 2
+#define SHAPE_CAPPED_CYLINDER 3
+#define SHAPE_TRIANGLE 4
+#define SHAPE_LINE 5
+
+// opaque objects are drawn first, then the shadows, then the transparent
+// objects over both.
+#define PASS_OPAQUE 0
+#define PASS_TRANSPARENT 1
+
+struct DrawCommand {
+  int pass;
+  int texture;
+  int shape;
+  float color[4];
+  float pos[3];		// position
+  float R[9];		// rotation, stored by row
+  union {
+    float size[3];	// box sides, sphere radius or cylinder length,radius
+    float v[9];		// triangle vertices or line end points
+  };
+  int solid;		// 1 if triangle is filled
+};
+
+static std::vector<DrawCommand> commands;
+static std::vector<int> command_order;
+
+static DrawCommand &addCommand (int shape, const float pos[3],
+				const float R[12], float size0,
+				float size1, float size2)
+{
+  if (current_state != 2) dsError ("drawing function called outside simulation loop");
+  commands.resize (commands.size()+1);
+  DrawCommand &c = commands.back();
+  c.pass = (color[3] < 1) ? PASS_TRANSPARENT : PASS_OPAQUE;
+  c.texture = tnum;
+  c.shape = shape;
+  for (int i=0; i<4; i++) c.color[i] = color[i];
+  for (int i=0; i<3; i++) {
+    c.pos[i] = pos[i];
+    c.R[i] = R[i];
+    c.R[3+i] = R[4+i];
+    c.R[6+i] = R[8+i];
+  }
+  c.size[0] = size0;
+  c.size[1] = size1;
+  c.size[2] = size2;
+  c.solid = 0;
+  return c;
+}
+
+
+struct DrawCommandLess {
+  const DrawCommand *commands;
+  bool operator() (int i, int j) const {
+    const DrawCommand &a = commands[i];
+    const DrawCommand &b = commands[j];
+    if (a.pass != b.pass) return a.pass < b.pass;
+    if (a.texture != b.texture) return a.texture < b.texture;
+    if (a.shape != b.shape) return a.shape < b.shape;
+    for (int k=0; k<4; k++) {
+      if (a.color[k] != b.color[k]) return a.color[k] < b.color[k];
+    }
+    return false;
+  }
+};
+
+
+// unit box display list
+
+static GLuint getBoxList()
+{
+  static GLuint listnum = 0;
+  if (listnum==0) {
+    static const float sides[3] = {1,1,1};
+    listnum = glGenLists (1);
+    glNewList (listnum,GL_COMPILE);
+    drawBox (sides);
+    glEndList();
+  }
+  return listnum;
+}
+
+
+// set the object texture coordinate planes, scaled by a box's sides so
+// that a unit box is textured as if drawn at full size.
+
+static void setTextureScale (float sx, float sy, float sz)
+{
+  GLfloat s_params[4] = {sx,sy,0.0f,1};
+  GLfloat t_params[4] = {0.817f*sx,-0.817f*sy,0.817f*sz,1};
+  glTexGenfv (GL_S,GL_OBJECT_PLANE,s_params);
+  glTexGenfv (GL_T,GL_OBJECT_PLANE,t_params);
+}
+
+
+// sets the lighting and shading for a shape, after setupDrawingMode()
+
+static void setShapeMode (int shape)
+{
+  if (shape == SHAPE_LINE) {
+    glDisable (GL_LIGHTING);
+    glColor3f (color[0],color[1],color[2]);
+    glLineWidth (2);
+  }
+  else {
+    glEnable (GL_LIGHTING);
+  }
+  if (shape == SHAPE_SPHERE || shape == SHAPE_CYLINDER ||
+      shape == SHAPE_CAPPED_CYLINDER) {
+    glShadeModel (GL_SMOOTH);
+  }
+  else {
+    glShadeModel (GL_FLAT);
+  }
+  if (shape != SHAPE_BOX && tnum && use_textures) setTextureScale (1,1,1);
+}
+
+
+// draw a command's geometry in its transform. GL_NORMALIZE must be enabled.
+
+static void drawCommand (const DrawCommand &c)
+{
+  GLfloat matrix[16];
+  matrix[0]=c.R[0];
+  matrix[1]=c.R[3];
+  matrix[2]=c.R[6];
+  matrix[3]=0;
+  matrix[4]=c.R[1];
+  matrix[5]=c.R[4];
+  matrix[6]=c.R[7];
+  matrix[7]=0;
+  matrix[8]=c.R[2];
+  matrix[9]=c.R[5];
+  matrix[10]=c.R[8];
+  matrix[11]=0;
+  matrix[12]=c.pos[0];
+  matrix[13]=c.pos[1];
+  matrix[14]=c.pos[2];
+  matrix[15]=1;
+  glPushMatrix();
+  glMultMatrixf (matrix);
+  switch (c.shape) {
+  case SHAPE_BOX:
+    glScalef (c.size[0],c.size[1],c.size[2]);
+    glCallList (getBoxList());
+    break;
+  case SHAPE_SPHERE:
+    glScalef (c.size[0],c.size[0],c.size[0]);
+    drawSphere();
+    break;
+  case SHAPE_CYLINDER:
+    drawCylinder (c.size[0],c.size[1],0);
+    break;
+  case SHAPE_CAPPED_CYLINDER:
+    drawCappedCylinder (c.size[0],c.size[1]);
+    break;
+  case SHAPE_TRIANGLE:
+    drawTriangle (c.v,c.v+3,c.v+6,c.solid);
+    break;
+  case SHAPE_LINE:
+    glBegin (GL_LINES);
+    glVertex3fv (c.v);
+    glVertex3fv (c.v+3);
+    glEnd();
+    break;
+  }
+  glPopMatrix();
+  draw_calls++;
+}
+
+
+// draw the sorted commands first to last-1, changing the drawing state
+// only between commands of different textures, colors or shapes.
+
+static void drawCommands (int first, int last)
+{
+  const DrawCommand *prev = 0;
+  for (int i=first; i<last; i++) {
+    const DrawCommand &c = commands[command_order[i]];
+    if (!prev || prev->texture != c.texture ||
+	memcmp (prev->color,c.color,sizeof(c.color)) != 0) {
+      tnum = c.texture;
+      for (int k=0; k<4; k++) color[k] = c.color[k];
+      setupDrawingMode();
+      setShapeMode (c.shape);
+      state_changes++;
+    }
+    else if (prev->shape != c.shape) {
+      setShapeMode (c.shape);
+      state_changes++;
+    }
+    if (c.shape == SHAPE_BOX && tnum && use_textures) {
+      setTextureScale (c.size[0],c.size[1],c.size[2]);
+    }
+    drawCommand (c);
+    prev = &c;
+  }
+}
+
+
+// draw the shadows of the boxes, spheres and cylinders
+
+static void drawShadows()
+{
+  int i,spheres = 0;
+
+  setShadowDrawingMode();
+  glShadeModel (GL_FLAT);
+  setShadowTransform();
+  state_changes++;
+  for (i=0; i<(int)commands.size(); i++) {
+    const DrawCommand &c = commands[i];
+    if (c.shape == SHAPE_SPHERE) spheres++;
+    else if (c.shape != SHAPE_TRIANGLE && c.shape != SHAPE_LINE) drawCommand (c);
+  }
+  glPopMatrix();
+
+  // sphere shadows are drawn directly on the ground
+  if (spheres) {
+    if (use_textures) {
+      glDisable (GL_TEXTURE_GEN_S);
+      glDisable (GL_TEXTURE_GEN_T);
+      glColor3f (SHADOW_INTENSITY,SHADOW_INTENSITY,SHADOW_INTENSITY);
+    }
+    state_changes++;
+    for (i=0; i<(int)commands.size(); i++) {
+      const DrawCommand &c = commands[i];
+      if (c.shape == SHAPE_SPHERE) {
+	drawSphereShadow (c.pos[0],c.pos[1],c.pos[2],c.size[0]);
+	draw_calls++;
+      }
+    }
+  }
+  glDepthRange (0,1);
+}
+
+
+// sort and draw the recorded commands
+
+static void submitCommands()
+{
+  int i,n = (int)commands.size();
+  if (n == 0) return;
+
+  command_order.resize (n);
+  for (i=0; i<n; i++) command_order[i] = i;
+  DrawCommandLess less;
+  less.commands = &commands[0];
+  std::stable_sort (command_order.begin(),command_order.end(),less);
+  for (i=0; i<n && commands[command_order[i]].pass == PASS_OPAQUE; i++);
+
+  // restore the frame state that the step function may have changed
+  // while drawing its own geometry, e.g. culling and two-sided lighting.
+  glEnable (GL_CULL_FACE);
+  glLightModeli (GL_LIGHT_MODEL_TWO_SIDE,0);
+  glEnable (GL_NORMALIZE);
+  drawCommands (0,i);
+  if (use_shadows) drawShadows();
+  drawCommands (i,n);
+  glDisable (GL_NORMALIZE);
+  glDisable (GL_BLEND);
+  commands.clear();
+}
+
+
 extern "C" void dsSimulationLoop (int argc, char **argv,
 				  int window_width, int window_height,
 				  dsFunctions *fn)
@@ -1267,58 +1631,14 @@ extern "C" void dsSetColorAlpha (float red, float green, float blue,
 extern "C" void dsDrawBox (const float pos[3], const float R[12],
 			   const float sides[3])
 {
-  if (current_state != 2) dsError ("drawing function called outside simulation loop");
-  setupDrawingMode();
-  glShadeModel (GL_FLAT);
-  setTransform (pos,R);
-  drawBox (sides);
-  glPopMatrix();
-
-  if (use_shadows) {
-    setShadowDrawingMode();
-    setShadowTransform();
-    setTransform (pos,R);
-    drawBox (sides);
-    glPopMatrix();
-    glPopMatrix();
-    glDepthRange (0,1);
-  }
+  addCommand (SHAPE_BOX,pos,R,sides[0],sides[1],sides[2]);
 }
 
 
 extern "C" void dsDrawSphere (const float pos[3], const float R[12],
 			      float radius)
 {
-  if (current_state != 2) dsError ("drawing function called outside simulation loop");
-  setupDrawingMode();
-  glEnable (GL_NORMALIZE);
-  glShadeModel (GL_SMOOTH);
-  setTransform (pos,R);
-  glScaled (radius,radius,radius);
-  drawSphere();
-  glPopMatrix();
-  glDisable (GL_NORMALIZE);
-
-  // draw shadows
-  if (use_shadows) {
-    glDisable (GL_LIGHTING);
-    if (use_textures) {
-      ground_texture->bind (1);
-      glEnable (GL_TEXTURE_2D);
-      glDisable (GL_TEXTURE_GEN_S);
-      glDisable (GL_TEXTURE_GEN_T);
-      glColor3f (SHADOW_INTENSITY,SHADOW_INTENSITY,SHADOW_INTENSITY);
-    }
-    else {
-      glDisable (GL_TEXTURE_2D);
-      glColor3f (GROUND_R*SHADOW_INTENSITY,GROUND_G*SHADOW_INTENSITY,
-		 GROUND_B*SHADOW_INTENSITY);
-    }
-    glShadeModel (GL_FLAT);
-    glDepthRange (0,0.9999);
-    drawSphereShadow (pos[0],pos[1],pos[2],radius);
-    glDepthRange (0,1);
-  }
+  addCommand (SHAPE_SPHERE,pos,R,radius,0,0);
 }
 
 
@@ -1326,70 +1646,39 @@ extern "C" void dsDrawTriangle (const float pos[3], const float R[12],
 				const float *v0, const float *v1,
 				const float *v2, int solid)
 {
-  if (current_state != 2) dsError ("drawing function called outside simulation loop");
-  setupDrawingMode();
-  glShadeModel (GL_FLAT);
-  setTransform (pos,R);
-  drawTriangle (v0, v1, v2, solid);
-  glPopMatrix();
+  DrawCommand &c = addCommand (SHAPE_TRIANGLE,pos,R,0,0,0);
+  for (int i=0; i<3; i++) {
+    c.v[i] = v0[i];
+    c.v[3+i] = v1[i];
+    c.v[6+i] = v2[i];
+  }
+  c.solid = solid;
 }
 
 
 extern "C" void dsDrawCylinder (const float pos[3], const float R[12],
 				float length, float radius)
 {
-  if (current_state != 2) dsError ("drawing function called outside simulation loop");
-  setupDrawingMode();
-  glShadeModel (GL_SMOOTH);
-  setTransform (pos,R);
-  drawCylinder (length,radius,0);
-  glPopMatrix();
-
-  if (use_shadows) {
-    setShadowDrawingMode();
-    setShadowTransform();
-    setTransform (pos,R);
-    drawCylinder (length,radius,0);
-    glPopMatrix();
-    glPopMatrix();
-    glDepthRange (0,1);
-  }
+  addCommand (SHAPE_CYLINDER,pos,R,length,radius,0);
 }
 
 
 extern "C" void dsDrawCappedCylinder (const float pos[3], const float R[12],
 				      float length, float radius)
 {
-  if (current_state != 2) dsError ("drawing function called outside simulation loop");
-  setupDrawingMode();
-  glShadeModel (GL_SMOOTH);
-  setTransform (pos,R);
-  drawCappedCylinder (length,radius);
-  glPopMatrix();
-
-  if (use_shadows) {
-    setShadowDrawingMode();
-    setShadowTransform();
-    setTransform (pos,R);
-    drawCappedCylinder (length,radius);
-    glPopMatrix();
-    glPopMatrix();
-    glDepthRange (0,1);
-  }
+  addCommand (SHAPE_CAPPED_CYLINDER,pos,R,length,radius,0);
 }
 
 
 void dsDrawLine (const float pos1[3], const float pos2[3])
 {
-  setupDrawingMode();
-  glColor3f (color[0],color[1],color[2]);
-  glDisable (GL_LIGHTING);
-  glLineWidth (2);
-  glShadeModel (GL_FLAT);
-  glBegin (GL_LINES);
-  glVertex3f (pos1[0],pos1[1],pos1[2]);
-  glVertex3f (pos2[0],pos2[1],pos2[2]);
-  glEnd();
+  static const float pos[3] = {0,0,0};
+  static const float R[12] = {1,0,0,0, 0,1,0,0, 0,0,1,0};
+  DrawCommand &c = addCommand (SHAPE_LINE,pos,R,0,0,0);
+  for (int i=0; i<3; i++) {
+    c.v[i] = pos1[i];
+    c.v[3+i] = pos2[i];
+  }
 }
 
 
@@ -1420,15 +1709,15 @@ void dsDrawTriangleD (const double pos[3], const double R[12],
 				 const double *v2, int solid)
 {
   int i;
-  float pos2[3],R2[12];
+  float pos2[3],R2[12],fv0[3],fv1[3],fv2[3];
   for (i=0; i<3; i++) pos2[i]=(float)pos[i];
   for (i=0; i<12; i++) R2[i]=(float)R[i];
-
-  setupDrawingMode();
-  glShadeModel (GL_FLAT);
-  setTransform (pos2,R2);
-  drawTriangleD (v0, v1, v2, solid);
-  glPopMatrix();
+  for (i=0; i<3; i++) {
+    fv0[i]=(float)v0[i];
+    fv1[i]=(float)v1[i];
+    fv2[i]=(float)v2[i];
+  }
+  dsDrawTriangle (pos2,R2,fv0,fv1,fv2,solid);
 }
 
 
@@ -1464,6 +1753,20 @@ void dsDrawLineD (const double _pos1[3], const double _pos2[3])
 }
 
 
+void dsDrawBatch()
+{
+  if (current_state != 2) dsError ("drawing function called outside simulation loop");
+  submitCommands();
+}
+
+
+void dsGetDrawStats (int *calls, int *changes)
+{
+  if (calls) *calls = last_draw_calls;
+  if (changes) *changes = last_state_changes;
+}
+
+
 void dsSetSphereQuality (int n)
 {
   sphere_quality = n;
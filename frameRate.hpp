@@ -5,15 +5,21 @@
 //* File Desc: Frame rate counter for any project, windows specific.        *//
 //* Rev. Date: 11/26/02                                                     *//
 //* Rev. Desc: Added frame rate independence and UNIX functionality (TEP)   *//
+//* Rev. Date: 10/18/26                                                     *//
+//* Rev. Desc: Monotonic nanosecond timer; speed factor updated per frame   *//
+//*            from a smoothed frame time                                   *//
 //*                                                                         *//
 //***************************************************************************//
 #ifndef __FRAMERATE_HPP__
 #define __FRAMERATE_HPP__
 
+#include <chrono>
 #ifdef WIN32
 #include <windows.h>
 #endif
-#include <time.h>
+
+// Weight of newest frame in smoothed frame time.
+#define FRAME_TIME_SMOOTHING 0.1
 
 class FrameRate
 {
@@ -23,48 +29,44 @@ class FrameRate
     float FPS;				// Current FPS.
 	float speedFactor;		// Frame rate independence speed factor.
 	static const float maxSpeedFactor;
+	long long frameTime;	// Last frame time (nanoseconds).
+	double avgFrameTime;	// Smoothed frame time (nanoseconds).
 
 	FrameRate(float targetFPS)
 	{
 		this->targetFPS = targetFPS;
-		FPS = targetFPS;
-		speedFactor = 1.0;
-		frameCount = 0;
-#ifdef UNIX
-		lastTime = time(NULL);
-#endif
-#ifdef WIN32
-		lastTime = GetTickCount();
-#endif
+		reset();
+	}
+
+	// Monotonic time in nanoseconds.
+	static long long getTime()
+	{
+		return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
 	}
 
 	// Update: call per frame.
 	void update()
 	{
-		int currentTime,delta;
+		long long currentTime;
 
-		// Count the frame.
-		frameCount++;
+		// Get the time delta: the first frame only starts timing.
+		currentTime = getTime();
+		frameTime = currentTime - lastTime;
+		if (lastTime == 0) frameTime = 0;
+		lastTime = currentTime;
+		if (frameTime <= 0) return;
 
-		// Get the time delta.
-#ifdef UNIX
-		currentTime = time(NULL);
-		delta = currentTime - lastTime;
-#else
-		currentTime = GetTickCount();
-		delta = (currentTime - lastTime) / 1000;
-#endif
-
-		// Has >= 1 second elapsed?
-		if (delta >= 1)
+		// Calculate new values.
+		if (avgFrameTime <= 0.0)
 		{
-			// Calculate new values.
-			FPS = (float)frameCount/(float)delta;
-			speedFactor = targetFPS / FPS;
-			if (speedFactor > maxSpeedFactor) speedFactor = maxSpeedFactor;
-			frameCount = 0;
-			lastTime = currentTime;
+			avgFrameTime = (double)frameTime;
+		} else {
+			avgFrameTime += ((double)frameTime - avgFrameTime) * FRAME_TIME_SMOOTHING;
 		}
+		FPS = (float)(1.0e9 / avgFrameTime);
+		speedFactor = targetFPS / FPS;
+		if (speedFactor > maxSpeedFactor) speedFactor = maxSpeedFactor;
 	}
 
 	// Reset.
@@ -72,18 +74,14 @@ class FrameRate
 	{
 		FPS = targetFPS;
 		speedFactor = 1.0;
-		frameCount = 0;
-#ifdef UNIX
-		lastTime = time(NULL);
-#else
-		lastTime = GetTickCount();
-#endif
+		frameTime = 0;
+		avgFrameTime = 0.0;
+		lastTime = 0;
 	}
 
   private:
 
-	int frameCount;
-    int lastTime;
+    long long lastTime;
 };
 
 // Maximum speed factor.
@@ -0,0 +1,148 @@
+//***************************************************************************//
+//* File Name: frustum.hpp                                                  *//
+//* Date Made: 10/18/26                                                     *//
+//* File Desc: View frustum for culling boxes before drawing.               *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __FRUSTUM_HPP__
+#define __FRUSTUM_HPP__
+
+#include <math.h>
+#include <GL/gl.h>
+
+// Clip mask of all frustum planes.
+#define FRUSTUM_ALL_PLANES 0x3f
+
+class Frustum
+{
+public:
+
+	// Planes: normal and distance, positive outside.
+	GLfloat planes[6][4];
+
+	// Constructor.
+	Frustum()
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			planes[i][0] = planes[i][1] = planes[i][2] = 0.0;
+			planes[i][3] = -1.0;
+		}
+	}
+
+	// Get planes from the current GL projection and modelview
+	// transforms: the planes are in modelview object coordinates.
+	void update()
+	{
+		GLfloat projection[16],modelview[16];
+
+		glGetFloatv(GL_PROJECTION_MATRIX, projection);
+		glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+		update(projection, modelview);
+	}
+
+	// Get planes from projection and modelview matrices.
+	void update(const GLfloat *projection, const GLfloat *modelview)
+	{
+		int i,j;
+		GLfloat m[16],length;
+
+		// m = projection * modelview (column-major).
+		for (i = 0; i < 4; i++)
+		{
+			for (j = 0; j < 4; j++)
+			{
+				m[(j*4)+i] = (projection[i] * modelview[j*4]) +
+					(projection[4+i] * modelview[(j*4)+1]) +
+					(projection[8+i] * modelview[(j*4)+2]) +
+					(projection[12+i] * modelview[(j*4)+3]);
+			}
+		}
+
+		// Left, right, bottom, top, near and far planes are the
+		// sums and differences of the last and other matrix rows,
+		// negated to face outward.
+		for (i = 0; i < 3; i++)
+		{
+			for (j = 0; j < 4; j++)
+			{
+				planes[i*2][j] = -(m[(j*4)+3] + m[(j*4)+i]);
+				planes[(i*2)+1][j] = -(m[(j*4)+3] - m[(j*4)+i]);
+			}
+		}
+		for (i = 0; i < 6; i++)
+		{
+			length = sqrt((planes[i][0] * planes[i][0]) +
+				(planes[i][1] * planes[i][1]) + (planes[i][2] * planes[i][2]));
+			if (length > 0.0)
+			{
+				for (j = 0; j < 4; j++) planes[i][j] /= length;
+			}
+		}
+	}
+
+	// Box overlaps frustum?
+	// As OPCODE's planes-AABB overlap test (after Ville Miettinen):
+	// the box is outside if its nearest vertex is outside a plane.
+	// The clip mask gives the planes to test, and returns those the
+	// box straddles, so boxes inside a box need only test those.
+	bool overlap(const GLfloat *center, const GLfloat *extents, unsigned int &clipMask)
+	{
+		unsigned int mask,outMask;
+		GLfloat NP,MP;
+		const GLfloat *p = planes[0];
+
+		outMask = 0;
+		for (mask = 1; mask <= clipMask; mask += mask, p += 4)
+		{
+			if (clipMask & mask)
+			{
+				NP = (extents[0] * fabs(p[0])) + (extents[1] * fabs(p[1])) +
+					(extents[2] * fabs(p[2]));
+				MP = (center[0] * p[0]) + (center[1] * p[1]) +
+					(center[2] * p[2]) + p[3];
+				if (NP < MP) return false;
+				if (-NP < MP) outMask |= mask;
+			}
+		}
+		clipMask = outMask;
+		return true;
+	}
+
+	// Axis-aligned box (min x, max x, min y, max y, min z, max z)
+	// overlaps frustum?
+	bool overlapAABB(const GLfloat *aabb)
+	{
+		GLfloat center[3],extents[3];
+		unsigned int clipMask = FRUSTUM_ALL_PLANES;
+
+		for (int i = 0; i < 3; i++)
+		{
+			center[i] = (aabb[i*2] + aabb[(i*2)+1]) * 0.5;
+			extents[i] = (aabb[(i*2)+1] - aabb[i*2]) * 0.5;
+		}
+		return overlap(center, extents, clipMask);
+	}
+
+	// Box transformed by matrix overlaps frustum?
+	// The box is bounded by the axis-aligned box of its transform.
+	bool overlap(const GLfloat *matrix, const GLfloat *center, const GLfloat *extents,
+		unsigned int &clipMask)
+	{
+		int i;
+		GLfloat c[3],e[3];
+
+		for (i = 0; i < 3; i++)
+		{
+			c[i] = (matrix[i] * center[0]) + (matrix[4+i] * center[1]) +
+				(matrix[8+i] * center[2]) + matrix[12+i];
+			e[i] = (fabs(matrix[i]) * extents[0]) + (fabs(matrix[4+i]) * extents[1]) +
+				(fabs(matrix[8+i]) * extents[2]);
+		}
+		return overlap(c, e, clipMask);
+	}
+};
+#endif
@@ -114,7 +114,11 @@ void dsSetTexture (int texture_number);
 void dsSetColor (float red, float green, float blue);
 void dsSetColorAlpha (float red, float green, float blue, float alpha);
 
-/* draw objects.
+/* draw objects. the objects are recorded with the current color and
+ * texture, and drawn at the end of the frame sorted by texture, shape and
+ * color, so that the drawing state changes only between runs of alike
+ * objects. transparent objects are drawn after the opaque ones and the
+ * shadows.
  *   - pos[] is the x,y,z of the center of the object.
  *   - R[] is a 3x3 rotation matrix for the object, stored by row like this:
  *        [ R11 R12 R13 0 ]
@@ -148,9 +152,20 @@ void dsDrawCappedCylinderD (const double pos[3], const double R[12],
 			    float length, float radius);
 void dsDrawLineD (const double pos1[3], const double pos2[3]);
 
+/* draw the objects recorded so far and their shadows, sorted the same way,
+ * instead of waiting for the end of the frame. use it to draw the recorded
+ * objects before anything the step function draws with OpenGL directly.
+ */
+void dsDrawBatch();
+
+/* get the number of draw calls and drawing state changes made drawing the
+ * last frame.
+ */
+void dsGetDrawStats (int *draw_calls, int *state_changes);
+
 /* Set the drawn quality of the objects. Higher numbers are higher quality,
- * but slower to draw. This must be set before the first objects are drawn to
- * be effective.
+ * but slower to draw. The meshes are built once per quality level (up to 15)
+ * and cached, so this can be changed at any time.
  */
 void dsSetSphereQuality (int n);		/* default = 1 */
 void dsSetCappedCylinderQuality (int n);	/* default = 3 */
@@ -0,0 +1,332 @@
+//***************************************************************************//
+//* File Name: profiler.hpp                                                 *//
+//* Date Made: 10/18/26                                                     *//
+//* File Desc: Frame phase profiler keeping rolling min/avg/p99 times,     *//
+//*            and span tracing to Chrome trace event JSON files.           *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <stdio.h>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include "frameRate.hpp"
+
+// Maximum phases and frames in rolling window.
+#define PROFILE_MAX_PHASES 32
+#define PROFILE_WINDOW 256
+
+// Phase statistics over the rolling window, in milliseconds.
+struct ProfileStats
+{
+	const char *name;
+	int frames;
+	double last,min,avg,p99;
+};
+
+// Profiler: phase times are summed over a frame, so a phase may be
+// timed several times per frame and from several threads.
+class Profiler
+{
+public:
+
+	// Constructor: phase names are indexed by phase.
+	Profiler(const char **names, int numPhases)
+	{
+		if (numPhases > PROFILE_MAX_PHASES) numPhases = PROFILE_MAX_PHASES;
+		this->numPhases = numPhases;
+		for (int i = 0; i < numPhases; i++)
+		{
+			phases[i].name = names[i];
+			phases[i].time = 0;
+			phases[i].count = phases[i].next = 0;
+		}
+	}
+
+	int getNumPhases() { return numPhases; }
+	const char *getPhaseName(int phase) { return phases[phase].name; }
+
+	// Add time to phase in current frame.
+	void add(int phase, long long nanoseconds)
+	{
+		phases[phase].time += nanoseconds;
+	}
+
+	// End frame: record phase times.
+	void endFrame()
+	{
+		Phase *phase;
+
+		for (int i = 0; i < numPhases; i++)
+		{
+			phase = &phases[i];
+			phase->samples[phase->next] = (double)phase->time.exchange(0) / 1.0e6;
+			phase->next = (phase->next + 1) % PROFILE_WINDOW;
+			if (phase->count < PROFILE_WINDOW) phase->count++;
+		}
+	}
+
+	// Get phase statistics: return false if no frames recorded.
+	bool getStats(int phase, ProfileStats &stats)
+	{
+		int i,n;
+		double sorted[PROFILE_WINDOW];
+		Phase *p = &phases[phase];
+
+		stats.name = p->name;
+		stats.frames = n = p->count;
+		stats.last = stats.min = stats.avg = stats.p99 = 0.0;
+		if (n == 0) return false;
+		for (i = 0; i < n; i++)
+		{
+			sorted[i] = p->samples[i];
+			stats.avg += sorted[i];
+		}
+		stats.avg /= (double)n;
+		stats.last = p->samples[(p->next + PROFILE_WINDOW - 1) % PROFILE_WINDOW];
+		stats.min = *std::min_element(sorted, sorted + n);
+		i = ((n * 99) + 99) / 100 - 1;
+		std::nth_element(sorted, sorted + i, sorted + n);
+		stats.p99 = sorted[i];
+		return true;
+	}
+
+	// Print statistics.
+	void print(FILE *fp)
+	{
+		ProfileStats stats;
+
+		fprintf(fp, "%-20s %9s %9s %9s %9s\n", "phase (ms)", "last", "min", "avg", "p99");
+		for (int i = 0; i < numPhases; i++)
+		{
+			getStats(i, stats);
+			fprintf(fp, "%-20s %9.3f %9.3f %9.3f %9.3f\n", stats.name,
+				stats.last, stats.min, stats.avg, stats.p99);
+		}
+	}
+
+private:
+
+	struct Phase
+	{
+		const char *name;
+		std::atomic<long long> time;
+		double samples[PROFILE_WINDOW];
+		int count,next;
+	};
+	Phase phases[PROFILE_MAX_PHASES];
+	int numPhases;
+};
+
+// Tracer: records spans with thread ids and frame numbers, written
+// per frame in the Chrome trace event JSON array format.
+class Tracer
+{
+public:
+
+	// Tracing enabled?
+	bool enabled;
+
+	// The tracer.
+	static Tracer &get()
+	{
+		static Tracer tracer;
+		return tracer;
+	}
+
+	// Open trace file and start tracing.
+	bool open(char *filename)
+	{
+		close();
+		if ((fp = fopen(filename, "w")) == NULL) return false;
+		fprintf(fp, "[");
+		first = true;
+		frame = 0;
+		startTime = FrameRate::getTime();
+		enabled = true;
+		return true;
+	}
+
+	// Stop tracing and close trace file.
+	void close()
+	{
+		if (fp == NULL) return;
+		enabled = false;
+		flush();
+		fprintf(fp, "\n]\n");
+		fclose(fp);
+		fp = NULL;
+	}
+
+	int getFrame() { return frame; }
+
+	// Record span: times in nanoseconds; negative arg is omitted.
+	void span(const char *name, const char *category,
+		long long start, long long end, int frame, int arg)
+	{
+		Event event;
+
+		event.name = name;
+		event.category = category;
+		event.start = start;
+		event.end = end;
+		event.thread = getThreadId();
+		event.frame = frame;
+		event.arg = arg;
+		std::lock_guard<std::mutex> lock(mutex);
+		events.push_back(event);
+	}
+
+	// End frame: write frame spans.
+	void endFrame()
+	{
+		if (!enabled) return;
+		flush();
+		frame++;
+	}
+
+	// Small id of calling thread.
+	static int getThreadId()
+	{
+		static std::atomic<int> next(0);
+		thread_local int id = ++next;
+		return id;
+	}
+
+private:
+
+	struct Event
+	{
+		const char *name;
+		const char *category;
+		long long start,end;
+		int thread,frame,arg;
+	};
+	std::vector<Event> events;
+	std::vector<Event> writing;
+	std::mutex mutex;
+	FILE *fp;
+	bool first;
+	int frame;
+	long long startTime;
+
+	Tracer()
+	{
+		enabled = false;
+		fp = NULL;
+		first = true;
+		frame = 0;
+		startTime = 0;
+	}
+
+	~Tracer()
+	{
+		close();
+	}
+
+	// Write buffered spans.
+	void flush()
+	{
+		Event *event;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			writing.swap(events);
+		}
+		for (int i = 0; i < (int)writing.size(); i++)
+		{
+			event = &writing[i];
+			fprintf(fp, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+				"\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%d",
+				first ? "" : ",", event->name, event->category,
+				(double)(event->start - startTime) / 1000.0,
+				(double)(event->end - event->start) / 1000.0,
+				event->thread, event->frame);
+			if (event->arg >= 0) fprintf(fp, ",\"index\":%d", event->arg);
+			fprintf(fp, "}}");
+			first = false;
+		}
+		writing.clear();
+		fflush(fp);
+	}
+};
+
+// Trace the enclosing scope as a span.
+class TraceScope
+{
+public:
+
+	TraceScope(const char *name, const char *category, int arg = -1)
+	{
+		Tracer &tracer = Tracer::get();
+
+		tracing = tracer.enabled;
+		if (!tracing) return;
+		this->name = name;
+		this->category = category;
+		this->arg = arg;
+		frame = tracer.getFrame();
+		start = FrameRate::getTime();
+	}
+
+	~TraceScope()
+	{
+		end();
+	}
+
+	// End the span before the end of the scope.
+	void end()
+	{
+		if (tracing)
+		{
+			Tracer::get().span(name, category, start, FrameRate::getTime(), frame, arg);
+			tracing = false;
+		}
+	}
+
+private:
+
+	bool tracing;
+	const char *name;
+	const char *category;
+	int arg,frame;
+	long long start;
+};
+
+// Time the enclosing scope as a phase, and trace it when tracing.
+class ProfileScope
+{
+public:
+
+	ProfileScope(Profiler &profiler, int phase) : profiler(profiler)
+	{
+		this->phase = phase;
+		frame = Tracer::get().getFrame();
+		start = FrameRate::getTime();
+	}
+
+	~ProfileScope()
+	{
+		long long end = FrameRate::getTime();
+		Tracer &tracer = Tracer::get();
+
+		profiler.add(phase, end - start);
+		if (tracer.enabled)
+		{
+			tracer.span(profiler.getPhaseName(phase), "phase", start, end, frame, -1);
+		}
+	}
+
+private:
+
+	Profiler &profiler;
+	int phase,frame;
+	long long start;
+};
+#endif
@@ -0,0 +1,590 @@
+//***************************************************************************//
+//* File Name: simplifier.hpp                                               *//
+//* Date Made: 10/18/26                                                     *//
+//* File Desc: Triangle mesh simplification by quadric edge collapse,       *//
+//*            used to make level-of-detail meshes.                         *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __SIMPLIFIER_HPP__
+#define __SIMPLIFIER_HPP__
+
+#include <vector>
+#include <queue>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <math.h>
+
+// Simplify an indexed triangle mesh by collapsing edges in order of
+// their quadric error (Garland and Heckbert). Vertices sharing a
+// position (seams in the normals or texture coordinates) collapse as
+// one, and a vertex collapses onto a neighbor, so the simplified mesh
+// indexes the original vertices. Positions on open borders and group
+// boundaries only collapse along the border, which is held by
+// constraint planes, so the mesh keeps its outline and materials.
+// Border corners and non-manifold edges are locked.
+class MeshSimplifier
+{
+public:
+
+	// Constructor: positions are the first three of each stride floats;
+	// triangles have groups (e.g. materials) that are kept.
+	MeshSimplifier(const float *vertices, int stride, int numVertices,
+		const unsigned int *indices, const int *groups, int numTriangles)
+	{
+		int i,j,t,a,b;
+		std::map<std::vector<float>,int> welds;
+		std::map<std::vector<float>,int>::iterator weldItr;
+		std::map<std::pair<int,int>,int> edges,edgeGroups;
+		std::map<std::pair<int,int>,int>::iterator edgeItr;
+		std::set<std::pair<int,int> > mixed;
+		std::pair<int,int> edge;
+		std::vector<float> p(3);
+
+		// Weld vertices into positions.
+		weld.resize(numVertices);
+		for (i = 0; i < numVertices; i++)
+		{
+			for (j = 0; j < 3; j++) p[j] = vertices[(i*stride)+j];
+			weldItr = welds.find(p);
+			if (weldItr == welds.end())
+			{
+				weld[i] = welds[p] = (int)positions.size() / 3;
+				positions.insert(positions.end(), p.begin(), p.end());
+			} else {
+				weld[i] = weldItr->second;
+			}
+		}
+		numPositions = (int)positions.size() / 3;
+		quadrics.assign(numPositions * 10, 0.0);
+		locked.assign(numPositions, false);
+		removed.assign(numPositions, false);
+		stamps.assign(numPositions, 0);
+		borderDegree.assign(numPositions, 0);
+		triangleMap.resize(numPositions);
+		remap.assign(numVertices, -1);
+
+		// Triangles and their plane quadrics.
+		this->numTriangles = numTriangles;
+		triangles.assign(indices, indices + (numTriangles * 3));
+		this->groups.assign(groups, groups + numTriangles);
+		alive.assign(numTriangles, true);
+		for (t = 0; t < numTriangles; t++)
+		{
+			addPlane(t);
+			for (j = 0; j < 3; j++)
+			{
+				a = corner(t, j);
+				triangleMap[a].push_back(t);
+				b = corner(t, (j+1)%3);
+				edge = makeEdge(a, b);
+				if (edges[edge]++ == 0) edgeGroups[edge] = groups[t];
+				else if (edgeGroups[edge] != groups[t]) mixed.insert(edge);
+			}
+		}
+
+		// Borders: open and group boundary edges. Lock non-manifold
+		// edges, and corners where borders meet or end.
+		for (edgeItr = edges.begin(); edgeItr != edges.end(); edgeItr++)
+		{
+			edge = edgeItr->first;
+			if (edgeItr->second == 2 && mixed.find(edge) == mixed.end()) continue;
+			borders.insert(edge);
+			borderDegree[edge.first]++;
+			borderDegree[edge.second]++;
+			if (edgeItr->second > 2) locked[edge.first] = locked[edge.second] = true;
+		}
+		for (i = 0; i < numPositions; i++)
+		{
+			if (borderDegree[i] != 0 && borderDegree[i] != 2) locked[i] = true;
+		}
+
+		// Border constraint planes.
+		for (t = 0; t < numTriangles; t++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				if (isBorder(corner(t, j), corner(t, (j+1)%3))) addBorderPlane(t, j);
+			}
+		}
+
+		// Queue collapses.
+		for (t = 0; t < numTriangles; t++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				a = corner(t, j);
+				b = corner(t, (j+1)%3);
+				pushCollapse(a, b);
+				pushCollapse(b, a);
+			}
+		}
+	}
+
+	// Collapse edges until no more than the target number of triangles
+	// remain or no valid collapse is left. Collapses rejected as
+	// invalid are retried after other collapses have changed their
+	// neighborhood. Successive calls continue simplifying. Returns the
+	// error: the largest distance, in model units, from an original
+	// position to the simplified surface.
+	float simplify(int targetTriangles)
+	{
+		int i;
+		bool collapsed;
+		Collapse c;
+
+		do
+		{
+			for (i = 0; i < (int)rejected.size(); i++)
+			{
+				c = rejected[i];
+				if (!removed[c.from] && !removed[c.to]) pushCollapse(c.from, c.to);
+			}
+			rejected.clear();
+			collapsed = false;
+			while (numTriangles > targetTriangles && !collapses.empty())
+			{
+				c = collapses.top();
+				collapses.pop();
+				if (removed[c.from] || removed[c.to] ||
+					c.fromStamp != stamps[c.from] || c.toStamp != stamps[c.to]) continue;
+				if (!isValid(c.from, c.to))
+				{
+					rejected.push_back(c);
+					continue;
+				}
+				collapse(c.from, c.to);
+				collapsed = true;
+			}
+		} while (collapsed && numTriangles > targetTriangles && rejected.size() > 0);
+		return getError();
+	}
+
+	// Get remaining triangles sorted by group.
+	void getTriangles(std::vector<unsigned int> &indices, std::vector<int> &groups)
+	{
+		int t,j;
+		std::vector<std::pair<int,int> > order;
+
+		for (t = 0; t < (int)alive.size(); t++)
+		{
+			if (alive[t]) order.push_back(std::make_pair(this->groups[t], t));
+		}
+		std::sort(order.begin(), order.end());
+		indices.clear();
+		groups.clear();
+		for (t = 0; t < (int)order.size(); t++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				indices.push_back(triangles[(order[t].second*3)+j]);
+			}
+			groups.push_back(order[t].first);
+		}
+	}
+
+	int getNumTriangles() { return numTriangles; }
+
+private:
+
+	// Collapse of position onto neighbor.
+	struct Collapse
+	{
+		double cost;
+		int from,to;
+		int fromStamp,toStamp;
+		bool operator<(const Collapse &c) const { return cost > c.cost; }
+	};
+
+	// Vertex positions with area weighted quadrics.
+	std::vector<int> weld;
+	std::vector<float> positions;
+	int numPositions;
+	std::vector<double> quadrics;
+	std::vector<bool> locked,removed;
+	std::vector<int> stamps;
+
+	// Border edges, as ordered position pairs, and border edges per
+	// position: a border position has two.
+	std::set<std::pair<int,int> > borders;
+	std::vector<int> borderDegree;
+	std::vector<std::vector<int> > triangleMap;
+	std::vector<int> remap;
+
+	// Triangles of vertex indices.
+	std::vector<unsigned int> triangles;
+	std::vector<int> groups;
+	std::vector<bool> alive;
+	int numTriangles;
+
+	std::priority_queue<Collapse> collapses;
+	std::vector<Collapse> rejected;
+
+	// Position of triangle corner.
+	int corner(int t, int j)
+	{
+		return weld[triangles[(t*3)+j]];
+	}
+
+	static std::pair<int,int> makeEdge(int a, int b)
+	{
+		return std::make_pair(std::min(a,b), std::max(a,b));
+	}
+
+	bool isBorder(int a, int b)
+	{
+		return borders.find(makeEdge(a, b)) != borders.end();
+	}
+
+	// Add plane of triangle to quadrics of its positions.
+	void addPlane(int t)
+	{
+		int i,j;
+		double n[3],area;
+		const float *p0 = &positions[corner(t, 0)*3];
+		const float *p1 = &positions[corner(t, 1)*3];
+		const float *p2 = &positions[corner(t, 2)*3];
+
+		getNormal(p0, p1, p2, n);
+		area = sqrt((n[0]*n[0]) + (n[1]*n[1]) + (n[2]*n[2]));
+		if (area == 0.0) return;
+		for (i = 0; i < 3; i++) n[i] /= area;
+		for (j = 0; j < 3; j++) addQuadric(corner(t, j), n, p0, area * 0.5);
+	}
+
+	// Add plane through the border edge of triangle from corner j,
+	// perpendicular to the triangle, to the quadrics of the edge ends.
+	// Weighted by the squared edge length, so a collapse that moves
+	// the border costs as much as one that moves the surface.
+	void addBorderPlane(int t, int j)
+	{
+		int i;
+		double e[3],f[3],n[3],length;
+		const float *p0 = &positions[corner(t, j)*3];
+		const float *p1 = &positions[corner(t, (j+1)%3)*3];
+		const float *p2 = &positions[corner(t, (j+2)%3)*3];
+
+		getNormal(p0, p1, p2, f);
+		for (i = 0; i < 3; i++) e[i] = p1[i] - p0[i];
+		n[0] = (e[1]*f[2]) - (e[2]*f[1]);
+		n[1] = (e[2]*f[0]) - (e[0]*f[2]);
+		n[2] = (e[0]*f[1]) - (e[1]*f[0]);
+		length = sqrt(dot(n, n));
+		if (length == 0.0) return;
+		for (i = 0; i < 3; i++) n[i] /= length;
+		addQuadric(corner(t, j), n, p0, dot(e, e));
+		addQuadric(corner(t, (j+1)%3), n, p0, dot(e, e));
+	}
+
+	// Add weighted quadric of plane with unit normal n through p.
+	void addQuadric(int position, const double *n, const float *p, double weight)
+	{
+		int i;
+		double d,q[10];
+
+		d = -((n[0]*p[0]) + (n[1]*p[1]) + (n[2]*p[2]));
+		q[0] = n[0]*n[0]; q[1] = n[0]*n[1]; q[2] = n[0]*n[2]; q[3] = n[0]*d;
+		q[4] = n[1]*n[1]; q[5] = n[1]*n[2]; q[6] = n[1]*d;
+		q[7] = n[2]*n[2]; q[8] = n[2]*d;
+		q[9] = d*d;
+		for (i = 0; i < 10; i++) quadrics[(position*10)+i] += q[i] * weight;
+	}
+
+	// Unnormalized triangle normal.
+	static void getNormal(const float *p0, const float *p1, const float *p2, double *n)
+	{
+		double u[3],v[3];
+
+		for (int i = 0; i < 3; i++)
+		{
+			u[i] = p1[i] - p0[i];
+			v[i] = p2[i] - p0[i];
+		}
+		n[0] = (u[1]*v[2]) - (u[2]*v[1]);
+		n[1] = (u[2]*v[0]) - (u[0]*v[2]);
+		n[2] = (u[0]*v[1]) - (u[1]*v[0]);
+	}
+
+	void pushCollapse(int from, int to)
+	{
+		int i;
+		double q[10],x,y,z;
+		Collapse c;
+
+		if (locked[from] || from == to) return;
+		if (borderDegree[from] > 0 && !isBorder(from, to)) return;
+
+		// Combined quadric error at the neighbor position.
+		for (i = 0; i < 10; i++)
+		{
+			q[i] = quadrics[(from*10)+i] + quadrics[(to*10)+i];
+		}
+		x = positions[to*3];
+		y = positions[(to*3)+1];
+		z = positions[(to*3)+2];
+		c.cost = (q[0]*x*x) + (2.0*q[1]*x*y) + (2.0*q[2]*x*z) + (2.0*q[3]*x) +
+			(q[4]*y*y) + (2.0*q[5]*y*z) + (2.0*q[6]*y) +
+			(q[7]*z*z) + (2.0*q[8]*z) + q[9];
+		if (c.cost < 0.0) c.cost = 0.0;
+		c.from = from;
+		c.to = to;
+		c.fromStamp = stamps[from];
+		c.toStamp = stamps[to];
+		collapses.push(c);
+	}
+
+	// Get positions adjacent to position.
+	void getNeighbors(int position, std::vector<int> &neighbors)
+	{
+		int i,j,t;
+
+		neighbors.clear();
+		for (i = 0; i < (int)triangleMap[position].size(); i++)
+		{
+			t = triangleMap[position][i];
+			for (j = 0; j < 3; j++)
+			{
+				if (corner(t, j) != position) neighbors.push_back(corner(t, j));
+			}
+		}
+		std::sort(neighbors.begin(), neighbors.end());
+		neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+	}
+
+	// A collapse is valid if it does not flip a triangle or join
+	// the surface across more than the collapsed edge.
+	bool isValid(int from, int to)
+	{
+		int i,j,t,k,shared;
+		double n0[3],n1[3];
+		const float *p[3];
+		std::vector<int> fromNeighbors,toNeighbors;
+
+		shared = 0;
+		for (i = 0; i < (int)triangleMap[from].size(); i++)
+		{
+			t = triangleMap[from][i];
+			if (corner(t, 0) == to || corner(t, 1) == to || corner(t, 2) == to)
+			{
+				shared++;
+				continue;
+			}
+			for (j = 0; j < 3; j++) p[j] = &positions[corner(t, j)*3];
+			getNormal(p[0], p[1], p[2], n0);
+			for (j = 0; j < 3; j++)
+			{
+				if (corner(t, j) == from) p[j] = &positions[to*3];
+			}
+			getNormal(p[0], p[1], p[2], n1);
+			if ((n0[0]*n1[0]) + (n0[1]*n1[1]) + (n0[2]*n1[2]) <= 0.0) return false;
+		}
+		if (shared == 0) return false;
+
+		// Link condition: the only common neighbors are those of the
+		// triangles on the collapsed edge.
+		getNeighbors(from, fromNeighbors);
+		getNeighbors(to, toNeighbors);
+		k = 0;
+		for (i = 0, j = 0; i < (int)fromNeighbors.size() && j < (int)toNeighbors.size(); )
+		{
+			if (fromNeighbors[i] < toNeighbors[j]) i++;
+			else if (fromNeighbors[i] > toNeighbors[j]) j++;
+			else
+			{
+				k++;
+				i++;
+				j++;
+			}
+		}
+		return k <= shared;
+	}
+
+	// Collapse position onto neighbor.
+	void collapse(int from, int to)
+	{
+		int i,j,t,v,fallback;
+		std::vector<int> &fromTriangles = triangleMap[from];
+		std::vector<int> &toTriangles = triangleMap[to];
+		std::vector<int> neighbors;
+
+		// Move the position's border edges to the neighbor.
+		if (borderDegree[from] > 0)
+		{
+			getNeighbors(from, neighbors);
+			for (i = 0; i < (int)neighbors.size(); i++)
+			{
+				v = neighbors[i];
+				if (!isBorder(from, v)) continue;
+				borders.erase(makeEdge(from, v));
+				borderDegree[from]--;
+				borderDegree[v]--;
+				if (v != to && borders.insert(makeEdge(to, v)).second)
+				{
+					borderDegree[to]++;
+					borderDegree[v]++;
+				}
+			}
+			if (borderDegree[to] != 0 && borderDegree[to] != 2) locked[to] = true;
+		}
+
+		// Map vertices at the position to vertices at the neighbor
+		// across the collapsed edge.
+		fallback = -1;
+		for (i = 0; i < (int)fromTriangles.size(); i++)
+		{
+			t = fromTriangles[i];
+			for (j = 0; j < 3 && corner(t, j) != to; j++) {}
+			if (j == 3) continue;
+			v = triangles[(t*3)+j];
+			if (fallback == -1) fallback = v;
+			for (j = 0; j < 3; j++)
+			{
+				if (corner(t, j) == from && remap[triangles[(t*3)+j]] == -1)
+				{
+					remap[triangles[(t*3)+j]] = v;
+				}
+			}
+		}
+
+		for (i = 0; i < (int)fromTriangles.size(); i++)
+		{
+			t = fromTriangles[i];
+			if (corner(t, 0) == to || corner(t, 1) == to || corner(t, 2) == to)
+			{
+				// Remove degenerate triangle.
+				alive[t] = false;
+				numTriangles--;
+				for (j = 0; j < 3; j++)
+				{
+					if (corner(t, j) != from) removeTriangle(corner(t, j), t);
+				}
+			} else {
+				for (j = 0; j < 3; j++)
+				{
+					v = triangles[(t*3)+j];
+					if (weld[v] == from)
+					{
+						triangles[(t*3)+j] = (remap[v] != -1 ? remap[v] : fallback);
+					}
+				}
+				toTriangles.push_back(t);
+			}
+		}
+		fromTriangles.clear();
+		removed[from] = true;
+		for (i = 0; i < 10; i++) quadrics[(to*10)+i] += quadrics[(from*10)+i];
+		stamps[to]++;
+
+		// Requeue collapses around the merged position.
+		getNeighbors(to, neighbors);
+		for (i = 0; i < (int)neighbors.size(); i++)
+		{
+			pushCollapse(to, neighbors[i]);
+			pushCollapse(neighbors[i], to);
+		}
+	}
+
+	// Get largest distance from an original position to the remaining
+	// triangles.
+	float getError()
+	{
+		int i,t;
+		double d,distance,error;
+
+		error = 0.0;
+		for (i = 0; i < numPositions; i++)
+		{
+			if (!removed[i]) continue;
+			distance = -1.0;
+			for (t = 0; t < (int)alive.size(); t++)
+			{
+				if (!alive[t]) continue;
+				d = getDistance(&positions[i*3], &positions[corner(t, 0)*3],
+					&positions[corner(t, 1)*3], &positions[corner(t, 2)*3]);
+				if (distance < 0.0 || d < distance) distance = d;
+			}
+			if (distance > error) error = distance;
+		}
+		return (float)sqrt(error);
+	}
+
+	// Squared distance from point to triangle, by the closest point
+	// in the triangle's vertex, edge or face region.
+	static double getDistance(const float *p, const float *a, const float *b, const float *c)
+	{
+		int i;
+		double ab[3],ac[3],ap[3],bp[3],cp[3],q[3];
+		double d1,d2,d3,d4,d5,d6,va,vb,vc,v,w,denom;
+
+		for (i = 0; i < 3; i++)
+		{
+			ab[i] = b[i] - a[i];
+			ac[i] = c[i] - a[i];
+			ap[i] = p[i] - a[i];
+			bp[i] = p[i] - b[i];
+			cp[i] = p[i] - c[i];
+		}
+		d1 = dot(ab, ap);
+		d2 = dot(ac, ap);
+		d3 = dot(ab, bp);
+		d4 = dot(ac, bp);
+		d5 = dot(ab, cp);
+		d6 = dot(ac, cp);
+		vc = (d1*d4) - (d3*d2);
+		vb = (d5*d2) - (d1*d6);
+		va = (d3*d6) - (d5*d4);
+		if (d1 <= 0.0 && d2 <= 0.0)
+		{
+			for (i = 0; i < 3; i++) q[i] = a[i];
+		}
+		else if (d3 >= 0.0 && d4 <= d3)
+		{
+			for (i = 0; i < 3; i++) q[i] = b[i];
+		}
+		else if (d6 >= 0.0 && d5 <= d6)
+		{
+			for (i = 0; i < 3; i++) q[i] = c[i];
+		}
+		else if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+		{
+			v = d1 / (d1 - d3);
+			for (i = 0; i < 3; i++) q[i] = a[i] + (v * ab[i]);
+		}
+		else if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+		{
+			w = d2 / (d2 - d6);
+			for (i = 0; i < 3; i++) q[i] = a[i] + (w * ac[i]);
+		}
+		else if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+		{
+			w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			for (i = 0; i < 3; i++) q[i] = b[i] + (w * (c[i] - b[i]));
+		}
+		else
+		{
+			denom = 1.0 / (va + vb + vc);
+			v = vb * denom;
+			w = vc * denom;
+			for (i = 0; i < 3; i++) q[i] = a[i] + (v * ab[i]) + (w * ac[i]);
+		}
+		for (i = 0; i < 3; i++) q[i] = p[i] - q[i];
+		return dot(q, q);
+	}
+
+	static double dot(const double *u, const double *v)
+	{
+		return (u[0]*v[0]) + (u[1]*v[1]) + (u[2]*v[2]);
+	}
+
+	void removeTriangle(int position, int t)
+	{
+		std::vector<int> &list = triangleMap[position];
+		std::vector<int>::iterator itr = std::find(list.begin(), list.end(), t);
+
+		if (itr != list.end()) list.erase(itr);
+	}
+};
+#endif
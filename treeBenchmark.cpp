@@ -0,0 +1,567 @@
+//***************************************************************************//
+//* File Name: treeBenchmark.cpp                                            *//
+//* Date Made: 10/18/26                                                     *//
+//* File Desc: Benchmark of the OPCODE collision tree splitting rules and  *//
+//*            tree layouts on the Cyd mesh and a terrain mesh. Built as    *//
+//*            the treeBenchmark console program with the OPCODE sources.   *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#include <windows.h>
+#include <GL/gl.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include "cyd_model.h"
+#include "Opcode.h"
+
+using namespace Opcode;
+
+// Splitting rules to compare.
+static const struct
+{
+	const char *name;
+	udword rules;
+} BenchmarkRules[] =
+{
+	{ "largest axis", SPLIT_LARGEST_AXIS },
+	{ "largest axis+center", SPLIT_LARGEST_AXIS | SPLIT_GEOM_CENTER },
+	{ "splatter points", SPLIT_SPLATTER_POINTS },
+	{ "splatter+center", SPLIT_SPLATTER_POINTS | SPLIT_GEOM_CENTER },
+	{ "best axis", SPLIT_BEST_AXIS },
+	{ "best axis+center", SPLIT_BEST_AXIS | SPLIT_GEOM_CENTER },
+	{ "balanced", SPLIT_BALANCED },
+	{ "balanced+center", SPLIT_BALANCED | SPLIT_GEOM_CENTER },
+	{ "fifty", SPLIT_FIFTY },
+	{ "SAH", SPLIT_SAH }
+};
+#define NUM_BENCHMARK_RULES (sizeof(BenchmarkRules) / sizeof(BenchmarkRules[0]))
+
+// Builds and queries per rule.
+#define BENCHMARK_BUILDS 5
+#define BENCHMARK_RAYS 20000
+#define BENCHMARK_SPHERES 20000
+#define BENCHMARK_BOXES 20000
+
+// Eye views for ray packets: eyes, view resolution and half width, and
+// tile size, a 2x2 tile of rays making a packet.
+#define BENCHMARK_EYES 5
+#define BENCHMARK_EYE_RESOLUTION 64
+#define BENCHMARK_EYE_HALF_WIDTH 0.25f
+#define BENCHMARK_EYE_TILE 2
+
+// Saved model file.
+#define BENCHMARK_MODEL_FILE "treeBenchmark.opc"
+
+// Query sphere radius and box half size as a fraction of the mesh size.
+#define BENCHMARK_SPHERE_RADIUS 0.05f
+
+// Terrain grid size and spacing.
+#define TERRAIN_SIZE 256
+#define TERRAIN_SPACING 0.125f
+
+// Tree layouts to compare, the first one being the reference.
+static const struct
+{
+	const char *name;
+	bool noLeaf;
+	bool quantized;
+	bool wide;
+} BenchmarkTrees[] =
+{
+	{ "quantized no-leaf", true, true, false },
+	{ "no-leaf", true, false, false },
+	{ "wide", true, false, true }
+};
+#define NUM_BENCHMARK_TREES (sizeof(BenchmarkTrees) / sizeof(BenchmarkTrees[0]))
+
+// Benchmark mesh.
+struct BenchmarkMesh
+{
+	const char *name;
+	std::vector<Point> vertices;
+	std::vector<IndexedTriangle> triangles;
+};
+
+// Monotonic time in nanoseconds.
+static long long getTime()
+{
+	return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Repeatable random number in [0,1).
+static udword RandomSeed;
+static float getRandom()
+{
+	RandomSeed = (RandomSeed * 1664525) + 1013904223;
+	return float(RandomSeed >> 8) / float(1 << 24);
+}
+
+// Get full resolution Cyd mesh, all components together.
+static bool getCydBenchmarkMesh(BenchmarkMesh &mesh)
+{
+	int i,j,stride,numVertices,numIndices;
+	const GLfloat *positions;
+	const GLuint *indices;
+	udword base;
+
+	mesh.name = "Cyd";
+	for (i = 0; i < CYD_NUM_COMPONENTS; i++)
+	{
+		if (!getCydMesh(i, 0, positions, stride, numVertices, indices, numIndices))
+		{
+			return false;
+		}
+		base = (udword)mesh.vertices.size();
+		for (j = 0; j < numVertices; j++, positions += stride)
+		{
+			mesh.vertices.push_back(Point(positions[0], positions[1], positions[2]));
+		}
+		for (j = 0; j < numIndices; j += 3)
+		{
+			mesh.triangles.push_back(IndexedTriangle(base + indices[j],
+				base + indices[j + 1], base + indices[j + 2]));
+		}
+	}
+	return true;
+}
+
+// Get rolling terrain mesh.
+static void getTerrainBenchmarkMesh(BenchmarkMesh &mesh)
+{
+	int i,j;
+	float x,y,z;
+	udword v;
+
+	mesh.name = "terrain";
+	for (i = 0; i < TERRAIN_SIZE; i++)
+	{
+		for (j = 0; j < TERRAIN_SIZE; j++)
+		{
+			x = float(i) * TERRAIN_SPACING;
+			y = float(j) * TERRAIN_SPACING;
+			z = (2.0f * sinf(x * 0.15f) * cosf(y * 0.1f)) + (0.5f * sinf((x + y) * 0.7f));
+			mesh.vertices.push_back(Point(x, y, z));
+		}
+	}
+	for (i = 0; i < TERRAIN_SIZE - 1; i++)
+	{
+		for (j = 0; j < TERRAIN_SIZE - 1; j++)
+		{
+			v = (i * TERRAIN_SIZE) + j;
+			mesh.triangles.push_back(IndexedTriangle(v, v + TERRAIN_SIZE, v + 1));
+			mesh.triangles.push_back(IndexedTriangle(v + 1, v + TERRAIN_SIZE, v + TERRAIN_SIZE + 1));
+		}
+	}
+}
+
+// Half surface area of box.
+static float getHalfArea(const AABB &box)
+{
+	Point d;
+
+	box.GetDiagonal(d);
+	return (d.x * d.y) + (d.y * d.z) + (d.z * d.x);
+}
+
+// Surface area heuristic cost of tree: the expected number of node
+// visits and primitive tests of a query hitting the root box, counting
+// each node in proportion to its area.
+struct TreeCost
+{
+	float rootArea;
+	float cost;
+};
+
+static bool addNodeCost(const AABBTreeNode *node, udword depth, void *data)
+{
+	TreeCost *treeCost = (TreeCost *)data;
+	float p = getHalfArea(*node->GetAABB()) / treeCost->rootArea;
+
+	treeCost->cost += p;
+	if (node->IsLeaf()) treeCost->cost += p * float(node->GetNbPrimitives());
+	return true;
+}
+
+// Same quantized no-leaf trees?
+static bool sameTrees(const BaseModel &a, const BaseModel &b)
+{
+	const AABBQuantizedNoLeafTree *treeA = (const AABBQuantizedNoLeafTree *)a.GetTree();
+	const AABBQuantizedNoLeafTree *treeB = (const AABBQuantizedNoLeafTree *)b.GetTree();
+
+	return treeA->GetNbNodes() == treeB->GetNbNodes() &&
+		treeA->mCenterCoeff == treeB->mCenterCoeff &&
+		treeA->mExtentsCoeff == treeB->mExtentsCoeff &&
+		memcmp(treeA->GetNodes(), treeB->GetNodes(), treeA->GetUsedBytes()) == 0;
+}
+
+// Models built with the same settings are identical?
+static bool sameModels(const Model &a, const Model &b)
+{
+	const AABBTree *sourceA = a.GetSourceTree();
+	const AABBTree *sourceB = b.GetSourceTree();
+
+	if (sourceA->GetNbNodes() != sourceB->GetNbNodes() ||
+		memcmp(sourceA->GetIndices(), sourceB->GetIndices(),
+		sourceA->GetNbPrimitives() * sizeof(udword)) != 0)
+	{
+		return false;
+	}
+	return sameTrees(a, b);
+}
+
+// Query costs of a model, and the hits of each query.
+struct QueryCost
+{
+	udword rayBVTests,rayPrimTests;
+	udword sphereBVTests,spherePrimTests;
+	udword boxBVTests,boxPrimTests;
+	long long rayTime,sphereTime,boxTime;
+	std::vector<udword> hits;	// Number and sum of hit indices
+};
+
+// Add hits of a query.
+static void addHits(QueryCost &queryCost, udword count, const udword *indices, udword stride)
+{
+	udword i,sum;
+
+	for (i = sum = 0; i < count; i++) sum += indices[i * stride];
+	queryCost.hits.push_back(count);
+	queryCost.hits.push_back(sum);
+}
+
+// Random rays, spheres and boxes on model.
+static void queryModel(const Model &model, const Point &center, const Point &extents, QueryCost &queryCost)
+{
+	int i;
+	long long start;
+	float halfSize;
+	Point origin,target;
+
+	queryCost.hits.clear();
+	halfSize = extents.Max() * BENCHMARK_SPHERE_RADIUS;
+
+	// Rays between random points around the mesh, through its box.
+	RayCollider rayCollider;
+	CollisionFaces faces;
+	rayCollider.SetFirstContact(false);
+	rayCollider.SetTemporalCoherence(false);
+	rayCollider.SetClosestHit(false);
+	rayCollider.SetCulling(false);
+	rayCollider.SetDestination(&faces);
+	queryCost.rayBVTests = queryCost.rayPrimTests = 0;
+	RandomSeed = 1;
+	start = getTime();
+	for (i = 0; i < BENCHMARK_RAYS; i++)
+	{
+		origin.Set(center.x + (extents.x * 4.0f * (getRandom() - 0.5f)),
+			center.y + (extents.y * 4.0f * (getRandom() - 0.5f)),
+			center.z + (extents.z * 4.0f * (getRandom() - 0.5f)));
+		target.Set(center.x + (extents.x * 2.0f * (getRandom() - 0.5f)),
+			center.y + (extents.y * 2.0f * (getRandom() - 0.5f)),
+			center.z + (extents.z * 2.0f * (getRandom() - 0.5f)));
+		Ray ray(origin, (target - origin).Normalize());
+		rayCollider.Collide(ray, model);
+		queryCost.rayBVTests += rayCollider.GetNbRayBVTests();
+		queryCost.rayPrimTests += rayCollider.GetNbRayPrimTests();
+		addHits(queryCost, faces.GetNbFaces(), faces.GetNbFaces() ? &faces.GetFaces()->mFaceID : NULL,
+			sizeof(CollisionFace) / sizeof(udword));
+	}
+	queryCost.rayTime = getTime() - start;
+
+	// Spheres at random points in the mesh box.
+	SphereCollider sphereCollider;
+	SphereCache sphereCache;
+	sphereCollider.SetFirstContact(false);
+	sphereCollider.SetTemporalCoherence(false);
+	queryCost.sphereBVTests = queryCost.spherePrimTests = 0;
+	RandomSeed = 1;
+	start = getTime();
+	for (i = 0; i < BENCHMARK_SPHERES; i++)
+	{
+		origin.Set(center.x + (extents.x * 2.0f * (getRandom() - 0.5f)),
+			center.y + (extents.y * 2.0f * (getRandom() - 0.5f)),
+			center.z + (extents.z * 2.0f * (getRandom() - 0.5f)));
+		Sphere sphere(origin, halfSize * 2.0f);
+		sphereCollider.Collide(sphereCache, sphere, model);
+		queryCost.sphereBVTests += sphereCollider.GetNbVolumeBVTests();
+		queryCost.spherePrimTests += sphereCollider.GetNbVolumePrimTests();
+		addHits(queryCost, sphereCollider.GetNbTouchedPrimitives(), sphereCollider.GetTouchedPrimitives(), 1);
+	}
+	queryCost.sphereTime = getTime() - start;
+
+	// Boxes at random points in the mesh box.
+	AABBCollider boxCollider;
+	AABBCache boxCache;
+	CollisionAABB queryBox;
+	boxCollider.SetFirstContact(false);
+	boxCollider.SetTemporalCoherence(false);
+	queryCost.boxBVTests = queryCost.boxPrimTests = 0;
+	RandomSeed = 1;
+	start = getTime();
+	for (i = 0; i < BENCHMARK_BOXES; i++)
+	{
+		queryBox.mCenter.Set(center.x + (extents.x * 2.0f * (getRandom() - 0.5f)),
+			center.y + (extents.y * 2.0f * (getRandom() - 0.5f)),
+			center.z + (extents.z * 2.0f * (getRandom() - 0.5f)));
+		queryBox.mExtents.Set(halfSize, halfSize, halfSize);
+		boxCollider.Collide(boxCache, queryBox, model);
+		queryCost.boxBVTests += boxCollider.GetNbVolumeBVTests();
+		queryCost.boxPrimTests += boxCollider.GetNbVolumePrimTests();
+		addHits(queryCost, boxCollider.GetNbTouchedPrimitives(), boxCollider.GetTouchedPrimitives(), 1);
+	}
+	queryCost.boxTime = getTime() - start;
+}
+
+// Eye views around the mesh, rays in tiles for coherent packets.
+static void getEyeRays(const Point &center, const Point &extents, std::vector<Ray> &rays)
+{
+	int i,j,k,x,y;
+	float u,v;
+	Point eye,target,forward,right,up;
+
+	rays.clear();
+	RandomSeed = 1;
+	for (i = 0; i < BENCHMARK_EYES; i++)
+	{
+		eye.Set(getRandom() - 0.5f, getRandom() - 0.5f, getRandom() - 0.5f);
+		eye = center + (eye.Normalize() * extents.Magnitude() * 1.5f);
+		target.Set(center.x + (extents.x * (getRandom() - 0.5f)),
+			center.y + (extents.y * (getRandom() - 0.5f)),
+			center.z + (extents.z * (getRandom() - 0.5f)));
+		forward = (target - eye).Normalize();
+		up = fabsf(forward.z) < 0.9f ? Point(0.0f, 0.0f, 1.0f) : Point(1.0f, 0.0f, 0.0f);
+		right = (forward ^ up).Normalize();
+		up = right ^ forward;
+		for (j = 0; j < BENCHMARK_EYE_RESOLUTION; j += BENCHMARK_EYE_TILE)
+		{
+			for (k = 0; k < BENCHMARK_EYE_RESOLUTION; k += BENCHMARK_EYE_TILE)
+			{
+				for (y = j; y < j + BENCHMARK_EYE_TILE; y++)
+				{
+					for (x = k; x < k + BENCHMARK_EYE_TILE; x++)
+					{
+						u = BENCHMARK_EYE_HALF_WIDTH * ((2.0f * float(x) / float(BENCHMARK_EYE_RESOLUTION - 1)) - 1.0f);
+						v = BENCHMARK_EYE_HALF_WIDTH * ((2.0f * float(y) / float(BENCHMARK_EYE_RESOLUTION - 1)) - 1.0f);
+						rays.push_back(Ray(eye, (forward + (right * u) + (up * v)).Normalize()));
+					}
+				}
+			}
+		}
+	}
+}
+
+// Closest hits of eye rays, one at a time and in packets: the hits must be the same.
+static bool queryEyeRays(const Model &model, const std::vector<Ray> &rays,
+	long long &rayTime, long long &packetTime)
+{
+	int i;
+	long long start;
+	bool same;
+
+	std::vector<CollisionFace> rayHits(rays.size());
+	RayCollider rayCollider;
+	CollisionFaces faces;
+	rayCollider.SetFirstContact(false);
+	rayCollider.SetTemporalCoherence(false);
+	rayCollider.SetClosestHit(true);
+	rayCollider.SetCulling(false);
+	rayCollider.SetDestination(&faces);
+	start = getTime();
+	for (i = 0; i < (int)rays.size(); i++)
+	{
+		rayCollider.Collide(rays[i], model);
+		if (faces.GetNbFaces())
+		{
+			rayHits[i] = *faces.GetFaces();
+		}
+		else
+		{
+			rayHits[i].mFaceID = INVALID_ID;
+		}
+	}
+	rayTime = getTime() - start;
+
+	std::vector<CollisionFace> packetHits(rays.size());
+	start = getTime();
+	rayCollider.Collide((udword)rays.size(), &rays[0], model, &packetHits[0]);
+	packetTime = getTime() - start;
+
+	// Rays through shared edges may hit either triangle at the same distance.
+	same = true;
+	for (i = 0; i < (int)rays.size(); i++)
+	{
+		if ((rayHits[i].mFaceID == INVALID_ID) != (packetHits[i].mFaceID == INVALID_ID) ||
+			(rayHits[i].mFaceID != INVALID_ID &&
+			fabsf(rayHits[i].mDistance - packetHits[i].mDistance) > 1.0e-4f * (1.0f + rayHits[i].mDistance)))
+		{
+			same = false;
+		}
+	}
+	return same;
+}
+
+// Benchmark splitting rules and tree layouts on mesh.
+static void benchmarkMesh(BenchmarkMesh &mesh)
+{
+	int i,j;
+	long long start,buildTime,parallelTime,loadTime,eyeTime,packetTime;
+	bool same;
+	std::vector<Ray> eyeRays;
+	MeshInterface meshInterface;
+	OPCODECREATE create;
+	QueryCost queryCost;
+	AABB box;
+	Point center,extents;
+
+	meshInterface.SetNbTriangles((udword)mesh.triangles.size());
+	meshInterface.SetNbVertices((udword)mesh.vertices.size());
+	meshInterface.SetPointers(&mesh.triangles[0], &mesh.vertices[0]);
+	create.mIMesh = &meshInterface;
+	create.mSettings.mLimit = 1;
+	create.mNoLeaf = true;
+	create.mQuantized = true;
+	create.mKeepOriginal = true;
+	create.mCanRemap = false;
+	ComputeAABB(box, &mesh.vertices[0], (udword)mesh.vertices.size());
+	box.GetCenter(center);
+	box.GetExtents(extents);
+
+	printf("%s: %d triangles, %d build threads\n", mesh.name, (int)mesh.triangles.size(),
+		(int)TaskPool(0).GetNbThreads());
+	printf("%-20s %9s %9s %9s %5s %9s %9s %9s %9s %9s %9s %9s\n", "rule", "build ms", "MT ms", "load ms",
+		"same", "SAH cost", "ray BV", "ray prim", "ray us", "sph BV", "sph prim", "sph us");
+	for (i = 0; i < (int)NUM_BENCHMARK_RULES; i++)
+	{
+		Model model;
+		create.mSettings.mRules = BenchmarkRules[i].rules;
+
+		// Build.
+		start = getTime();
+		for (j = 0; j < BENCHMARK_BUILDS; j++)
+		{
+			if (!model.Build(create))
+			{
+				printf("%-20s build failed\n", BenchmarkRules[i].name);
+				break;
+			}
+		}
+		if (j < BENCHMARK_BUILDS) continue;
+		buildTime = (getTime() - start) / BENCHMARK_BUILDS;
+
+		// Build on all threads: the model must be the same.
+		Model parallelModel;
+		create.mSettings.mNbThreads = 0;
+		start = getTime();
+		for (j = 0; j < BENCHMARK_BUILDS; j++)
+		{
+			parallelModel.Build(create);
+		}
+		parallelTime = (getTime() - start) / BENCHMARK_BUILDS;
+		create.mSettings.mNbThreads = 1;
+		same = sameModels(model, parallelModel);
+
+		// Save and load instead of building: the model must be the same.
+		Model loadedModel;
+		same = model.Save(BENCHMARK_MODEL_FILE) && same;
+		start = getTime();
+		same = loadedModel.Load(BENCHMARK_MODEL_FILE, &meshInterface) && same;
+		loadTime = getTime() - start;
+		same = same && sameTrees(model, loadedModel);
+
+		// Tree cost.
+		TreeCost treeCost;
+		const AABBTree *tree = model.GetSourceTree();
+		treeCost.rootArea = getHalfArea(*tree->GetAABB());
+		treeCost.cost = 0.0f;
+		tree->Walk(addNodeCost, &treeCost);
+
+		// Queries.
+		queryModel(model, center, extents, queryCost);
+
+		printf("%-20s %9.3f %9.3f %9.3f %5s %9.2f %9.2f %9.2f %9.3f %9.2f %9.2f %9.3f\n",
+			BenchmarkRules[i].name, (double)buildTime / 1.0e6, (double)parallelTime / 1.0e6,
+			(double)loadTime / 1.0e6, same ? "yes" : "NO", treeCost.cost,
+			(double)queryCost.rayBVTests / BENCHMARK_RAYS, (double)queryCost.rayPrimTests / BENCHMARK_RAYS,
+			(double)queryCost.rayTime / 1.0e3 / BENCHMARK_RAYS,
+			(double)queryCost.sphereBVTests / BENCHMARK_SPHERES,
+			(double)queryCost.spherePrimTests / BENCHMARK_SPHERES,
+			(double)queryCost.sphereTime / 1.0e3 / BENCHMARK_SPHERES);
+	}
+	remove(BENCHMARK_MODEL_FILE);
+
+	// Tree layouts with the default rules: the hits must be the same.
+	OPCODECREATE defaults;
+	QueryCost referenceCost;
+	create.mSettings.mRules = defaults.mSettings.mRules;
+	create.mKeepOriginal = false;
+	getEyeRays(center, extents, eyeRays);
+	printf("\n%-20s %9s %9s %9s %9s %9s %9s %9s %9s %9s %9s %5s\n", "tree", "nodes", "KB",
+		"ray BV", "ray us", "sph BV", "sph us", "box BV", "box us", "eye us", "pkt us", "same");
+	for (i = 0; i < (int)NUM_BENCHMARK_TREES; i++)
+	{
+		Model model;
+		create.mNoLeaf = BenchmarkTrees[i].noLeaf;
+		create.mQuantized = BenchmarkTrees[i].quantized;
+		create.mWide = BenchmarkTrees[i].wide;
+		if (!model.Build(create))
+		{
+			printf("%-20s build failed\n", BenchmarkTrees[i].name);
+			continue;
+		}
+		queryModel(model, center, extents, queryCost);
+		if (i == 0) referenceCost = queryCost;
+		same = queryEyeRays(model, eyeRays, eyeTime, packetTime);
+
+		printf("%-20s %9d %9.1f %9.2f %9.3f %9.2f %9.3f %9.2f %9.3f %9.3f %9.3f %5s\n",
+			BenchmarkTrees[i].name, (int)model.GetNbNodes(), (double)model.GetUsedBytes() / 1024.0,
+			(double)queryCost.rayBVTests / BENCHMARK_RAYS, (double)queryCost.rayTime / 1.0e3 / BENCHMARK_RAYS,
+			(double)queryCost.sphereBVTests / BENCHMARK_SPHERES,
+			(double)queryCost.sphereTime / 1.0e3 / BENCHMARK_SPHERES,
+			(double)queryCost.boxBVTests / BENCHMARK_BOXES, (double)queryCost.boxTime / 1.0e3 / BENCHMARK_BOXES,
+			(double)eyeTime / 1.0e3 / eyeRays.size(), (double)packetTime / 1.0e3 / eyeRays.size(),
+			same && queryCost.hits == referenceCost.hits ? "yes" : "NO");
+	}
+	create.mNoLeaf = true;
+	create.mQuantized = true;
+	create.mWide = false;
+	create.mKeepOriginal = true;
+	printf("\n");
+}
+
+// Run benchmark, printing build time and query costs of each rule,
+// then memory and query costs of each tree layout, including closest
+// hits of eye rays one at a time and in packets.
+// Usage: treeBenchmark [-model FILE]
+int main(int argc, char *argv[])
+{
+	char *modelFile = (char *)CYD_MODEL_FILE;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], "-model") == 0) modelFile = argv[i + 1];
+	}
+
+	InitOpcode();
+	{
+		BenchmarkMesh cyd;
+		if (loadCydModel(modelFile) && getCydBenchmarkMesh(cyd))
+		{
+			benchmarkMesh(cyd);
+		}
+		else
+		{
+			fprintf(stderr, "Cannot load Cyd model %s\n", modelFile);
+		}
+
+		BenchmarkMesh terrain;
+		getTerrainBenchmarkMesh(terrain);
+		benchmarkMesh(terrain);
+	}
+	CloseOpcode();
+	return 0;
+}
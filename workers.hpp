@@ -0,0 +1,143 @@
+//***************************************************************************//
+//* File Name: workers.hpp                                                  *//
+//* Date Made: 10/18/26                                                     *//
+//* File Desc: Pool of worker threads running batches of independent        *//
+//*            tasks, e.g. per-agent updates.                               *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __WORKERS_HPP__
+#define __WORKERS_HPP__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class WorkerPool
+{
+public:
+
+	// Task: called once per index in a batch.
+	typedef void (*Task)(int index, void *data);
+
+	// Constructor: a negative thread count uses one thread per
+	// additional hardware core.
+	WorkerPool(int numThreads = -1)
+	{
+		setNumThreads(numThreads);
+		started = quit = false;
+		generation = 0;
+		busy = 0;
+		task = 0;
+		data = 0;
+		count = 0;
+		next = 0;
+	}
+
+	// Destructor.
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (int i = 0; i < (int)threads.size(); i++)
+		{
+			threads[i].join();
+		}
+	}
+
+	// Set number of worker threads: effective before first batch.
+	void setNumThreads(int numThreads)
+	{
+		if (numThreads < 0)
+		{
+			numThreads = (int)std::thread::hardware_concurrency() - 1;
+		}
+		if (numThreads < 0) numThreads = 0;
+		this->numThreads = numThreads;
+	}
+
+	// Run task for indexes 0 to count-1 and wait for completion.
+	// The calling thread also takes part in the batch.
+	void run(int count, Task task, void *data)
+	{
+		int i;
+
+		if (numThreads == 0 || count <= 1)
+		{
+			for (i = 0; i < count; i++) task(i, data);
+			return;
+		}
+		if (!started)
+		{
+			started = true;
+			for (i = 0; i < numThreads; i++)
+			{
+				threads.push_back(std::thread(&WorkerPool::workerLoop, this));
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			this->task = task;
+			this->data = data;
+			this->count = count;
+			next = 0;
+			busy = (int)threads.size();
+			generation++;
+		}
+		wake.notify_all();
+		work();
+		std::unique_lock<std::mutex> lock(mutex);
+		while (busy > 0) done.wait(lock);
+	}
+
+private:
+
+	int numThreads;
+	bool started;
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake,done;
+	bool quit;
+	unsigned int generation;
+	int busy;
+
+	// Current batch.
+	Task task;
+	void *data;
+	int count;
+	std::atomic<int> next;
+
+	// Take tasks until the batch is exhausted.
+	void work()
+	{
+		int i;
+
+		while ((i = next++) < count) task(i, data);
+	}
+
+	// Worker thread.
+	void workerLoop()
+	{
+		unsigned int seen = 0;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			while (!quit && generation == seen) wake.wait(lock);
+			if (quit) return;
+			seen = generation;
+			lock.unlock();
+			work();
+			lock.lock();
+			if (--busy == 0) done.notify_one();
+		}
+	}
+};
+#endif